@@ -0,0 +1,143 @@
+/**
+ * @file    bench.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Cycle counter used by the microbenchmarks. On the Pi Pico it reads
+ *          SysTick running from the processor clock, the Cortex-M0+ has no
+ *          DWT cycle counter. On an x86 host it reads the time stamp counter
+ *          and anywhere else it falls back to nanoseconds.
+ *
+ *          SysTick is a 24 bit counter so on the Pico one measurement must be
+ *          shorter than 2^24 cycles (134 ms at 125 MHz); time a batch of
+ *          samples and divide rather than the whole run.
+ *
+ *          The synthetic inputs come from one repeatable generator, so a
+ *          seed gives the same data on every build.
+ *
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#if defined(LANDSLIDE_HAL_BACKEND_PICO)
+#include "hardware/structs/systick.h"
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// What bench_elapsed() counts in
+#if defined(LANDSLIDE_HAL_BACKEND_PICO) || defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIT  "cycles"
+#else
+#define BENCH_UNIT  "ns"
+#endif
+
+// Keeps the compiler from optimising away a result
+#define BENCH_KEEP(x)   do { bench_sink += (uint32_t)(x); } while (0)
+
+static volatile uint32_t bench_sink;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Starts the counter, call once before the first bench_now()
+ */
+static inline void bench_init(void)
+{
+#ifdef LANDSLIDE_HAL_BACKEND_PICO
+    // Processor clock, no interrupt, counting down from the top
+    systick_hw->csr = 0;
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;
+#endif
+}
+
+/**
+ * @brief Reads the counter
+ *
+ * @return uint64_t The count
+ */
+static inline uint64_t bench_now(void)
+{
+#if defined(LANDSLIDE_HAL_BACKEND_PICO)
+    return systick_hw->cvr;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Counts since an earlier bench_now()
+ *
+ * @param start The earlier count
+ * @return uint64_t The cycles (or ns) that have passed
+ */
+static inline uint64_t bench_elapsed(uint64_t start)
+{
+#ifdef LANDSLIDE_HAL_BACKEND_PICO
+    // SysTick counts down and wraps at 24 bits
+    return (start - bench_now()) & 0x00FFFFFF;
+#else
+    return bench_now() - start;
+#endif
+}
+
+/**
+ * @brief Steps the repeatable generator, a 32 bit LCG
+ *
+ * @param seed The generator's state, updated
+ * @return uint32_t 24 random bits
+ */
+static inline uint32_t bench_random(uint32_t *seed)
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return *seed >> 8;
+}
+
+/**
+ * @brief Gets a number from the generator, uniform in (0, 1]
+ *
+ * @param seed The generator's state, updated
+ * @return double The number
+ */
+static inline double bench_uniform(uint32_t *seed)
+{
+    return (bench_random(seed) % 1000000 + 1) / 1000000.0;
+}
+
+/**
+ * @brief Gets noise from the generator, uniform in -amp to amp
+ *
+ * @param seed The generator's state, updated
+ * @param amp The largest noise, in LSB
+ * @return int16_t The noise
+ */
+static inline int16_t bench_noise(uint32_t *seed, int16_t amp)
+{
+    bench_random(seed);
+    return (int16_t)((int32_t)((*seed >> 24) % (uint32_t)(2 * amp + 1)) - amp);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_H
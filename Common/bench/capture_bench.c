@@ -0,0 +1,198 @@
+/**
+ * @file    capture_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Microbenchmark of the waveform capture. Makes a trace of a second
+ *          of quiet noise and two seconds of shaking at the check's rate,
+ *          then reports for the quiet part, the shaking and the whole trace
+ *          what the blocks of waveform.h cost per sample to encode and
+ *          decode and how small they pack against the 6 raw bytes. Last it
+ *          feeds the whole trace through seismic_capture.h, triggered where
+ *          the shaking starts, and checks the capture decodes back to it.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "seismic_capture.h"
+#include "seismic_config.h"
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+#define BENCH_RATE_HZ   ADXL343_RATE_HZ(SEISMIC_FIFO_RATE)
+#define BENCH_QUIET     SEISMIC_CAPTURE_PRE
+#define BENCH_SAMPLES   (SEISMIC_CAPTURE_PRE + SEISMIC_CAPTURE_POST + 1)
+#define BENCH_RUNS      20
+
+static waveform_sample_t bench_trace[BENCH_SAMPLES];
+static waveform_sample_t bench_back[BENCH_SAMPLES];
+static uint8_t bench_blocks[(BENCH_SAMPLES / WAVEFORM_BLOCK_SAMPLES + 1) * WAVEFORM_BLOCK_MAX];
+
+
+// ############################## [ Local Functions ] ##############################
+
+// At rest with a few counts of noise, then a decaying shake of up to 1.5 g
+// with its main frequency sweeping down from 12 Hz
+static void bench_fill(void)
+{
+    uint32_t seed = 12345;
+
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int16_t noise[3];
+
+        for (int j = 0; j < 3; j++)
+        {
+            noise[j] = bench_noise(&seed, 4);
+        }
+
+        float shake[3] = { 0.0f, 0.0f, 0.0f };
+
+        if (i >= BENCH_QUIET)
+        {
+            float t = (float)(i - BENCH_QUIET) / BENCH_RATE_HZ;
+            float amp = 1.5f * SEISMIC_LSB_PER_G * expf(-1.2f * t);
+            float phase = 2.0f * (float)M_PI * (12.0f - 3.0f * t) * t;
+
+            shake[0] = amp * sinf(phase);
+            shake[1] = 0.6f * amp * sinf(1.7f * phase + 0.5f);
+            shake[2] = 0.4f * amp * sinf(0.8f * phase + 1.0f);
+        }
+
+        bench_trace[i].x = (int16_t)(noise[0] + shake[0]);
+        bench_trace[i].y = (int16_t)(noise[1] + shake[1]);
+        bench_trace[i].z = (int16_t)(SEISMIC_LSB_PER_G + noise[2] + shake[2]);
+    }
+}
+
+// Times encoding and decoding samples [first, first + n) in blocks, the best
+// run is the figure to compare
+static void bench_codec(const char *name, int first, int n)
+{
+    uint64_t encode = UINT64_MAX;
+    uint64_t decode = UINT64_MAX;
+    size_t len = 0;
+
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        uint64_t start = bench_now();
+        len = 0;
+
+        for (int i = 0; i < n; i += WAVEFORM_BLOCK_SAMPLES)
+        {
+            uint32_t count = n - i < WAVEFORM_BLOCK_SAMPLES ? n - i : WAVEFORM_BLOCK_SAMPLES;
+            len += waveform_block_encode(&bench_blocks[len], &bench_trace[first + i], count);
+        }
+
+        uint64_t elapsed = bench_elapsed(start);
+        encode = elapsed < encode ? elapsed : encode;
+
+        start = bench_now();
+        size_t at = 0;
+
+        for (int i = 0; i < n; i += WAVEFORM_BLOCK_SAMPLES)
+        {
+            size_t block_len = waveform_block_len(&bench_blocks[at]);
+            waveform_block_decode(&bench_blocks[at], &bench_back[i]);
+            at += block_len;
+        }
+
+        elapsed = bench_elapsed(start);
+        decode = elapsed < decode ? elapsed : decode;
+    }
+
+    bool same = memcmp(bench_back, &bench_trace[first], n * sizeof(waveform_sample_t)) == 0;
+
+    printf("%-8s %5d samples, %6u bytes, %5.2f bytes/sample (%4.1f%% of raw), %6.1f %s/sample to encode, "
+           "%6.1f to decode, %s\r\n", name, n, (unsigned)len, (double)len / n, 100.0 * len / (n * 6.0),
+           (double)encode / n, BENCH_UNIT, (double)decode / n, same ? "same back" : "WRONG BACK");
+}
+
+static void bench_check(void *ctx, uint32_t index, const waveform_sample_t *sample)
+{
+    uint32_t *wrong = ctx;
+
+    if (index >= BENCH_SAMPLES || memcmp(sample, &bench_trace[index], sizeof(*sample)) != 0)
+    {
+        (*wrong)++;
+    }
+}
+
+// Feeds the trace through the capture the way the risk check does
+static void bench_capture(void)
+{
+    seismic_capture_init(BENCH_RATE_HZ, SEISMIC_LSB_PER_G, SEISMIC_CAPTURE_PRE, SEISMIC_CAPTURE_POST);
+
+    uint64_t best = UINT64_MAX;
+    uint32_t added = 0;
+
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        seismic_capture_arm();
+        added = 0;
+
+        uint64_t start = bench_now();
+
+        for (uint32_t i = 0; i < BENCH_SAMPLES && seismic_capture_state() != SEISMIC_CAPTURE_DONE; i++)
+        {
+            adxl343_sample_t sample = { bench_trace[i].x, bench_trace[i].y, bench_trace[i].z };
+            seismic_capture_add(&sample);
+            added++;
+
+            if (i == BENCH_QUIET)
+            {
+                seismic_capture_trigger(i * 1000u / BENCH_RATE_HZ);
+            }
+        }
+
+        uint64_t elapsed = bench_elapsed(start);
+        best = elapsed < best ? elapsed : best;
+    }
+
+    size_t len = 0;
+    const uint8_t *capture = seismic_capture_get(&len);
+    waveform_header_t header = { 0 };
+    uint32_t wrong = 0;
+    int32_t count = capture != NULL ? waveform_decode(capture, len, &bench_check, &wrong, &header) : -1;
+
+    printf("capture  %5lu samples added, %6.1f %s/sample, %lu kept (%lu before the trigger, %.2f s), "
+           "%u bytes (%4.1f%% of raw), %s%s\r\n", (unsigned long)added, (double)best / added, BENCH_UNIT,
+           (unsigned long)header.samples, (unsigned long)header.pre, (double)header.pre / BENCH_RATE_HZ,
+           (unsigned)len, header.samples ? 100.0 * len / (header.samples * 6.0) : 0.0,
+           count == BENCH_SAMPLES && wrong == 0 ? "same back" : "WRONG BACK",
+           (header.flags & WAVEFORM_TRUNCATED) ? ", cut short" : "");
+}
+
+
+int main()
+{
+    // Initialize Pi Pico
+    hal_stdio_init();
+
+    bench_init();
+    bench_fill();
+
+    while (1)
+    {
+        printf("Waveform capture at %d Hz, %d byte ring\r\n", BENCH_RATE_HZ, SEISMIC_CAPTURE_BYTES);
+        bench_codec("quiet", 0, BENCH_QUIET);
+        bench_codec("shaking", BENCH_QUIET, BENCH_SAMPLES - BENCH_QUIET);
+        bench_codec("all", 0, BENCH_SAMPLES);
+        bench_capture();
+        hal_stdio_flush();
+
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+        // One run is enough on the host
+        break;
+#endif
+
+        hal_sleep_ms(5000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,403 @@
+/**
+ * @file    fusion_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host only replay of synthetic landslide scenarios through the
+ *          alert rules: each node raising from WATCH on its own sensor, and
+ *          the Zero's site fusion of the evidence the nodes send it
+ *          (node_telemetry_evidence()) raising from WATCH and from WARNING.
+ *          Prints for each the alerts raised, the false alerts, the slides
+ *          missed and the warning time, then the cost and size of the
+ *          fusion.
+ *
+ *          The synthetic record is 20 years in 10 minute steps. Storms come
+ *          every three days on average and are tipped into the rain node's
+ *          windows. The soil moisture rises 0.6 per mm of rain and drains
+ *          back to 25 with a 4 day time constant, and is read every step
+ *          with +-1 of noise. Vibration the sensor picks up, a road or
+ *          animals, is checked once a day on average with a dynamic peak of
+ *          50 mg to 1.6 g.
+ *
+ *          A slope that is wet (moisture over 54) and has had 15 mm of rain
+ *          in 6 hours may start to fail, a 2 % chance each step. It slides
+ *          2 to 6 hours later and creeps until then, the vibration sensor
+ *          firing every 20 minutes with a peak growing from 0.2 to 1.5 g.
+ *          An alert counts for a slide if it is in the day before it, any
+ *          other alert is false.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "fusion.h"
+#include "fusion_config.h"
+#include "rain_config.h"
+#include "rain_rate.h"
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Length of the record and its step (s)
+#define BENCH_YEARS         20
+#define BENCH_STEP_S        600
+#define BENCH_STEPS         (BENCH_YEARS * 365 * 24 * 3600 / BENCH_STEP_S)
+
+// Time before a slide an alert counts for it (s)
+#define BENCH_LEAD_S        (24 * 3600)
+
+// Most slides and vibration checks in one step
+#define BENCH_MAX_SLIDES    1024
+#define BENCH_MAX_CHECKS    4
+
+// One step of the record
+typedef struct
+{
+    uint16_t rain_um;
+    int8_t moisture;
+    uint8_t checks;
+    uint16_t peak_mg[BENCH_MAX_CHECKS];
+} bench_step_t;
+
+static bench_step_t bench_record[BENCH_STEPS];
+
+// Slides, the time they happen
+static uint32_t bench_slide_s[BENCH_MAX_SLIDES];
+static int bench_slides;
+
+// Alert rules
+typedef enum
+{
+    BENCH_ALONE,                // Each node on its own sensor, raising from WATCH
+    BENCH_SITE_WATCH,           // The site fusion of the nodes' evidence raising from WATCH
+    BENCH_SITE_WARNING,         // And from WARNING, only on combined evidence
+    BENCH_RULES
+} bench_rule_t;
+
+static const char *const bench_rule_name[BENCH_RULES] = { "alone", "site watch", "site warning" };
+
+// What a rule did over the record
+typedef struct
+{
+    uint32_t alerts;
+    uint32_t false_alerts;
+    uint32_t detected;
+    uint64_t lead_s;            // Total over the detected slides
+    uint32_t min_lead_s;
+} bench_result_t;
+
+static rain_rate_t bench_rate;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Builds the synthetic record
+static void bench_make_record(void)
+{
+    uint32_t seed = 2023;
+    int storm_left = 0;
+    double storm_mm_h = 0;
+    double moisture = 25;
+    double drain = exp(-(double)BENCH_STEP_S / (4 * 24 * 3600));
+    uint32_t recent_um[6 * 3600 / BENCH_STEP_S] = { 0 };
+    uint32_t recent_total = 0;
+    int slide_step = -1;
+    int creep_from = -1;
+    int quiet_until = 0;
+
+    memset(bench_record, 0, sizeof(bench_record));
+    bench_slides = 0;
+
+    for (int s = 0; s < BENCH_STEPS; s++)
+    {
+        bench_step_t *step = &bench_record[s];
+
+        // Rain, one storm every three days on average
+        if (storm_left == 0 && bench_random(&seed) % (3 * 24 * 3600 / BENCH_STEP_S) == 0)
+        {
+            storm_left = (int)(3 * pow(2, 6 * bench_uniform(&seed)));
+            storm_mm_h = fmin(0.8 / sqrt(bench_uniform(&seed)), 40);
+        }
+
+        if (storm_left > 0)
+        {
+            double mm_h = storm_mm_h * 2 * bench_uniform(&seed);
+            if (bench_random(&seed) % 20 == 0)
+            {
+                mm_h *= 4;
+            }
+
+            step->rain_um = (uint16_t)fmin(mm_h * 1000 * BENCH_STEP_S / 3600, 65535);
+            storm_left--;
+        }
+
+        // Soil moisture with the probe's noise
+        moisture = 25 + (moisture - 25) * drain + step->rain_um * 0.6 / 1000;
+        moisture = fmin(moisture, 70);
+        step->moisture = (int8_t)lround(moisture + (int)(bench_random(&seed) % 3) - 1);
+
+        // Rain over the last 6 hours
+        int slot = s % (int)(sizeof(recent_um) / sizeof(recent_um[0]));
+        recent_total += step->rain_um - recent_um[slot];
+        recent_um[slot] = step->rain_um;
+
+        // A wet slope may start to fail, and fails once in a while at most
+        if (slide_step < 0 && s >= quiet_until && moisture > 54 && recent_total >= 15000 &&
+            bench_random(&seed) % 50 == 0)
+        {
+            slide_step = s + (int)(2 * 3600 / BENCH_STEP_S + bench_random(&seed) % (4 * 3600 / BENCH_STEP_S));
+            creep_from = slide_step - 3 * 3600 / BENCH_STEP_S;
+        }
+
+        // Creep before the slide, the sensor fires every 20 minutes
+        if (slide_step >= 0 && s >= creep_from && (s - creep_from) % 2 == 0 && step->checks < BENCH_MAX_CHECKS)
+        {
+            double grown = (double)(s - creep_from) / (slide_step - creep_from);
+            step->peak_mg[step->checks++] = (uint16_t)(200 + 1300 * grown * bench_uniform(&seed));
+        }
+
+        if (s == slide_step)
+        {
+            if (bench_slides < BENCH_MAX_SLIDES)
+            {
+                bench_slide_s[bench_slides++] = (uint32_t)s * BENCH_STEP_S;
+            }
+
+            slide_step = -1;
+            quiet_until = s + 30 * 24 * 3600 / BENCH_STEP_S;
+        }
+
+        // Everything else that shakes the sensor, once a day on average
+        if (bench_random(&seed) % (24 * 3600 / BENCH_STEP_S) == 0 && step->checks < BENCH_MAX_CHECKS)
+        {
+            step->peak_mg[step->checks++] = (uint16_t)(50 * pow(2, 5 * bench_uniform(&seed)));
+        }
+    }
+}
+
+// Largest of the windows' depth over their threshold (%), as the rain node
+static uint32_t bench_rain_pct(void)
+{
+    uint32_t pct = 0;
+
+    for (uint8_t w = 0; w < bench_rate.config.windows; w++)
+    {
+        uint32_t warning = bench_rate.config.window[w].warning_tips;
+
+        if (warning != 0 && rain_rate_tips(&bench_rate, w) * 100 / warning > pct)
+        {
+            pct = rain_rate_tips(&bench_rate, w) * 100 / warning;
+        }
+    }
+
+    return pct;
+}
+
+// Scores an alert at a time
+static void bench_score(bench_result_t *result, uint8_t *seen, uint32_t now_s)
+{
+    result->alerts++;
+
+    for (int i = 0; i < bench_slides; i++)
+    {
+        if (now_s <= bench_slide_s[i] && bench_slide_s[i] - now_s <= BENCH_LEAD_S)
+        {
+            // The first alert gives the warning time
+            if (!seen[i])
+            {
+                uint32_t lead_s = bench_slide_s[i] - now_s;
+
+                seen[i] = 1;
+                result->detected++;
+                result->lead_s += lead_s;
+                result->min_lead_s = lead_s < result->min_lead_s ? lead_s : result->min_lead_s;
+            }
+            return;
+        }
+    }
+
+    result->false_alerts++;
+}
+
+// A node's assessment, scored as the node's alert or sent to the site
+// fusion when it has moved as node_telemetry_evidence() sends it
+static void bench_node(bench_rule_t rule, fusion_t *site, uint8_t *sent, fusion_channel_t ch,
+                       const fusion_alert_t *alert, uint32_t now_s, bench_result_t *result, uint8_t *seen)
+{
+    if (rule == BENCH_ALONE)
+    {
+        if (alert->raise)
+        {
+            bench_score(result, seen, now_s);
+        }
+        return;
+    }
+
+    int pct = alert->evidence[ch];
+    int last = sent[ch];
+    bool fresh = (alert->fresh & (1u << ch)) != 0;
+    bool moved = ch == FUSION_SEISMIC ? pct > last
+                                      : pct >= last + NODE_TELEMETRY_EVIDENCE_STEP ||
+                                        pct <= last - NODE_TELEMETRY_EVIDENCE_STEP;
+
+    // The vibration fades the same on both ends, so it is followed as it
+    // fades and only a rise, a new check, is sent
+    if (ch == FUSION_SEISMIC)
+    {
+        sent[ch] = (uint8_t)pct;
+    }
+
+    if (!fresh && !moved && (pct == 0) == (last == 0))
+    {
+        return;
+    }
+
+    sent[ch] = (uint8_t)pct;
+
+    fusion_alert_t site_alert;
+    fusion_report(site, now_s, ch, (uint32_t)pct, fresh);
+    fusion_assess(site, now_s, &site_alert);
+    if (site_alert.raise)
+    {
+        bench_score(result, seen, now_s);
+    }
+}
+
+// Runs the record through one rule
+static void bench_run(bench_rule_t rule, bench_result_t *result)
+{
+    static uint8_t seen[BENCH_MAX_SLIDES];
+    fusion_config_t config = FUSION_CONFIG;
+    rain_rate_config_t rain_config = RAIN_RATE_CONFIG;
+    fusion_t state[FUSION_CHANNELS];
+    fusion_t site;
+    uint8_t sent[FUSION_CHANNELS] = { 0 };
+    uint32_t bucket_um = 0;
+
+    memset(result, 0, sizeof(*result));
+    memset(seen, 0, sizeof(seen));
+    result->min_lead_s = UINT32_MAX;
+
+    // Every node raises from WATCH on its own sensor
+    for (int ch = 0; ch < FUSION_CHANNELS; ch++)
+    {
+        fusion_init(&state[ch], &config);
+    }
+
+    config.raise = rule == BENCH_SITE_WARNING ? FUSION_SITE_RAISE_GRADE : FUSION_WATCH;
+    fusion_init(&site, &config);
+
+    rain_rate_init(&bench_rate, &rain_config);
+
+    fusion_t *rain = &state[FUSION_RAIN];
+    fusion_t *soil = &state[FUSION_SOIL];
+    fusion_t *seismic = &state[FUSION_SEISMIC];
+
+    for (int s = 0; s < BENCH_STEPS; s++)
+    {
+        const bench_step_t *step = &bench_record[s];
+        uint32_t now_s = (uint32_t)s * BENCH_STEP_S;
+        fusion_alert_t alert;
+
+        // The rain node, tips spread over the step
+        bucket_um += step->rain_um;
+        uint32_t tips = bucket_um / RAIN_TIP_UM;
+        bucket_um %= RAIN_TIP_UM;
+
+        rain_rate_expire(&bench_rate, now_s * 1000);
+        for (uint32_t i = 0; i < tips; i++)
+        {
+            rain_rate_tip(&bench_rate, now_s * 1000 + (i + 1) * BENCH_STEP_S * 1000 / (tips + 1));
+        }
+
+        fusion_rain(rain, bench_rain_pct(), rain_rate_over(&bench_rate));
+        fusion_assess(rain, now_s, &alert);
+        bench_node(rule, &site, sent, FUSION_RAIN, &alert, now_s, result, seen);
+
+        // The soil node
+        fusion_soil(soil, now_s, step->moisture);
+        fusion_assess(soil, now_s, &alert);
+        bench_node(rule, &site, sent, FUSION_SOIL, &alert, now_s, result, seen);
+
+        // The seismic node
+        for (int c = 0; c < step->checks; c++)
+        {
+            fusion_seismic(seismic, now_s, step->peak_mg[c]);
+            fusion_assess(seismic, now_s, &alert);
+            bench_node(rule, &site, sent, FUSION_SEISMIC, &alert, now_s, result, seen);
+        }
+    }
+}
+
+static void bench_print(bench_rule_t rule, const bench_result_t *result)
+{
+    printf("  %-12s %7u alerts  %8.1f /year  false %5.1f%%  missed %u/%d  warning time mean %.1f h, least %.1f h\r\n",
+           bench_rule_name[rule], (unsigned)result->alerts, result->alerts / (double)BENCH_YEARS,
+           result->alerts > 0 ? 100.0 * result->false_alerts / result->alerts : 0.0,
+           (unsigned)(bench_slides - result->detected), bench_slides,
+           result->detected > 0 ? result->lead_s / 3600.0 / result->detected : 0.0,
+           result->detected > 0 ? result->min_lead_s / 3600.0 : 0.0);
+}
+
+// Times an update and an assessment of the fused state over the record
+static void bench_time(void)
+{
+    fusion_config_t config = FUSION_CONFIG;
+    fusion_t fusion;
+    uint64_t total = 0;
+    uint64_t worst = 0;
+    uint32_t calls = 0;
+
+    fusion_init(&fusion, &config);
+
+    for (int s = 0; s < BENCH_STEPS; s++)
+    {
+        const bench_step_t *step = &bench_record[s];
+        uint32_t now_s = (uint32_t)s * BENCH_STEP_S;
+        fusion_alert_t alert;
+
+        uint64_t t0 = bench_now();
+        fusion_soil(&fusion, now_s, step->moisture);
+        if (step->checks > 0)
+        {
+            fusion_seismic(&fusion, now_s, step->peak_mg[0]);
+        }
+        BENCH_KEEP(fusion_assess(&fusion, now_s, &alert));
+        uint64_t t = bench_elapsed(t0);
+
+        total += t;
+        worst = t > worst ? t : worst;
+        calls++;
+    }
+
+    printf("  fusion: %.1f %s per update and assessment mean, %llu %s slowest, %u bytes of state\r\n",
+           (double)total / calls, BENCH_UNIT, (unsigned long long)worst, BENCH_UNIT, (unsigned)sizeof(fusion_t));
+}
+
+
+int main(void)
+{
+    hal_stdio_init();
+    bench_init();
+
+    bench_make_record();
+
+    printf("Landslide alerts, %d years in %d s steps, %d slides, weights %u/%u/%u %%, grades %u/%u/%u %%\r\n",
+           BENCH_YEARS, BENCH_STEP_S, bench_slides,
+           FUSION_RAIN_WEIGHT, FUSION_SOIL_WEIGHT, FUSION_SEISMIC_WEIGHT,
+           FUSION_ADVISORY_PCT, FUSION_WATCH_PCT, FUSION_WARNING_PCT);
+
+    for (int rule = 0; rule < BENCH_RULES; rule++)
+    {
+        bench_result_t result;
+        bench_run((bench_rule_t)rule, &result);
+        bench_print((bench_rule_t)rule, &result);
+    }
+
+    bench_time();
+
+    return 0;
+}
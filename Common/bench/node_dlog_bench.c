@@ -0,0 +1,177 @@
+/**
+ * @file    node_dlog_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Microbenchmark of the deferred log against printf for each of the
+ *          hot path lines of dlog_format.h. For each one it reports
+ *
+ *            printf     formatting the line, timed with snprintf so nothing
+ *                       goes out, and the time the uart then takes to send
+ *                       it at BENCH_BAUD, which printf followed by
+ *                       hal_stdio_flush() waits for
+ *            NODE_DLOG  the call in the hot path
+ *            text       formatting the record when it is drained in
+ *                       NODE_DLOG_TEXT, the uart time is the same as printf
+ *            binary     framing the record when it is drained in
+ *                       NODE_DLOG_BINARY, and its uart time
+ *
+ *          The ring is emptied without sending between runs, so the bench
+ *          prints nothing but its results.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "node_dlog.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Baud of the default uart the lines go out on
+#define BENCH_BAUD      115200
+
+#define BENCH_CALLS     (NODE_DLOG_RECORDS / 2)
+#define BENCH_RUNS      20
+
+static char bench_text[256];
+static uint8_t bench_frame[DLOG_FRAME_MAX];
+
+
+// ############################## [ Local Functions ] ##############################
+
+static double bench_uart_us(size_t bytes)
+{
+    return bytes * 10 * 1e6 / BENCH_BAUD;
+}
+
+// Prints how a line does each way, dlog is the time of BENCH_CALLS
+// NODE_DLOG() calls
+static void bench_line(const char *name, const dlog_record_t *record, uint64_t dlog, int (*print)(char *, size_t))
+{
+    uint64_t printf_best = UINT64_MAX;
+    uint64_t text_best = UINT64_MAX;
+    uint64_t binary_best = UINT64_MAX;
+    int text_len = 0;
+    size_t frame_len = 0;
+
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        uint64_t start = bench_now();
+        for (int i = 0; i < BENCH_CALLS; i++)
+        {
+            BENCH_KEEP(print(bench_text, sizeof(bench_text)));
+        }
+        uint64_t elapsed = bench_elapsed(start);
+        printf_best = elapsed < printf_best ? elapsed : printf_best;
+
+        start = bench_now();
+        for (int i = 0; i < BENCH_CALLS; i++)
+        {
+            text_len = dlog_format(bench_text, sizeof(bench_text), record);
+        }
+        elapsed = bench_elapsed(start);
+        text_best = elapsed < text_best ? elapsed : text_best;
+
+        start = bench_now();
+        for (int i = 0; i < BENCH_CALLS; i++)
+        {
+            frame_len = dlog_frame_encode(bench_frame, record);
+            BENCH_KEEP(bench_frame[frame_len - 1]);
+        }
+        elapsed = bench_elapsed(start);
+        binary_best = elapsed < binary_best ? elapsed : binary_best;
+    }
+
+    char check[256];
+    int printf_len = print(check, sizeof(check));
+    bool same = text_len == printf_len && strcmp(check, bench_text) == 0;
+
+    printf("%-14s printf %6.0f %s + %7.0f us uart (%2d bytes), NODE_DLOG %4.0f %s, text drain %6.0f %s, "
+           "binary drain %4.0f %s + %6.0f us uart (%2u bytes), %s\r\n", name, (double)printf_best / BENCH_CALLS,
+           BENCH_UNIT, bench_uart_us(printf_len), printf_len, (double)dlog / BENCH_CALLS, BENCH_UNIT,
+           (double)text_best / BENCH_CALLS, BENCH_UNIT, (double)binary_best / BENCH_CALLS, BENCH_UNIT,
+           bench_uart_us(frame_len), (unsigned)frame_len, same ? "same text" : "DIFFERENT TEXT");
+}
+
+// The firmware's printf lines, with the values of a typical call
+static int bench_print_accel(char *dst, size_t cap)
+{
+    return snprintf(dst, cap, "Acceleration: %f g\r\n", 1.0039062f);
+}
+
+static int bench_print_check(char *dst, size_t cap)
+{
+    return snprintf(dst, cap, "Checked %lu samples in %lu reads, %llu us (%lu samples/s), peak %f g\r\n",
+                    (unsigned long)200, (unsigned long)8, (unsigned long long)250312, (unsigned long)799,
+                    1.8710938f);
+}
+
+static int bench_print_soil(char *dst, size_t cap)
+{
+    return snprintf(dst, cap, "[%llu.%03u] Soil Moisture: %d\r\n", (unsigned long long)1591315242, 66u, 35);
+}
+
+static dlog_record_t bench_record;
+
+// Keeps the record a call makes, to check its text against printf's
+static void bench_keep(uint16_t id, const uint32_t *args, uint32_t nargs)
+{
+    bench_record = (dlog_record_t){ .id = id, .nargs = (uint8_t)nargs };
+    memcpy(bench_record.args, args, nargs * sizeof(uint32_t));
+}
+
+// Times BENCH_CALLS calls of NODE_DLOG() into an empty ring, the best of the
+// runs, then the drains of the record it made
+#define BENCH_LOG(name, print, id, ...)                                                         \
+    do                                                                                          \
+    {                                                                                           \
+        uint64_t best = UINT64_MAX;                                                             \
+        for (int run = 0; run < BENCH_RUNS; run++)                                              \
+        {                                                                                       \
+            node_dlog_init();                                                                   \
+            uint64_t start = bench_now();                                                       \
+            for (int i = 0; i < BENCH_CALLS; i++)                                               \
+            {                                                                                   \
+                NODE_DLOG(id, __VA_ARGS__);                                                     \
+            }                                                                                   \
+            uint64_t elapsed = bench_elapsed(start);                                            \
+            best = elapsed < best ? elapsed : best;                                             \
+        }                                                                                       \
+        bench_keep((id), (const uint32_t[]){ __VA_ARGS__ },                                     \
+                   sizeof((const uint32_t[]){ __VA_ARGS__ }) / sizeof(uint32_t));               \
+        bench_line((name), &bench_record, best, (print));                                       \
+    } while (0)
+
+
+int main()
+{
+    // Initialize Pi Pico
+    hal_stdio_init();
+
+    bench_init();
+
+    while (1)
+    {
+        printf("Deferred log against printf, %d calls a run, uart at %d baud\r\n", BENCH_CALLS, BENCH_BAUD);
+
+        BENCH_LOG("accel", &bench_print_accel, DLOG_ACCEL, DLOG_F(1.0039062f));
+        BENCH_LOG("seismic check", &bench_print_check, DLOG_SEISMIC_CHECK, 200, 8, DLOG_U64(250312), 799,
+                  DLOG_F(1.8710938f));
+        BENCH_LOG("soil reading", &bench_print_soil, DLOG_SOIL_READING, DLOG_U64(1591315242), 66, 35);
+
+        node_dlog_init();
+        hal_stdio_flush();
+
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+        // One run is enough on the host
+        break;
+#endif
+
+        hal_sleep_ms(5000);
+    }
+
+    return 0;
+}
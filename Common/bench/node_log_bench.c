@@ -0,0 +1,132 @@
+/**
+ * @file    node_log_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host only run of the flash event log (node_log.h) on the
+ *          simulated flash, enough records to go round the ring three
+ *          times, flushed:
+ *
+ *            each   - after every record, as a log with no page buffer would
+ *            4      - after every 4 records
+ *            page   - only when a page fills, as the firmware does
+ *            resets - the same, but the node is reset every 1000 records
+ *                     with whatever is in the page buffer
+ *
+ *          Prints the page programs, sector erases and time the core is
+ *          stalled for each, how even the wear on the log's sectors is, and
+ *          checks every record the log still holds against what was
+ *          appended.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "hal_host.h"
+#include "node_config.h"
+#include "node_log.h"
+#include "bench.h"
+
+#include <stdio.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Records appended in each run, three times round the ring
+#define BENCH_LOG_RECORDS   (NODE_LOG_SIZE / EVENT_LOG_SECTOR_LEN * EVENT_LOG_RECORDS * 3)
+
+// Records between resets in the last run
+#define BENCH_RESET_EVERY   1000
+
+// What the read back found
+typedef struct
+{
+    uint32_t records;
+    uint32_t wrong;             // Out of order or not as appended
+    int32_t last;               // Value of the last rain record
+} bench_check_t;
+
+
+// ############################## [ Local Functions ] ##############################
+
+static void bench_check(void *ctx, const event_log_record_t *record)
+{
+    bench_check_t *check = ctx;
+
+    if (record->type != TELEMETRY_RAIN)
+    {
+        return;
+    }
+
+    // The values count up, but a reset loses what was in the page buffer
+    if (record->value <= check->last || record->stat != record->value * 3)
+    {
+        check->wrong++;
+    }
+
+    check->last = record->value;
+    check->records++;
+}
+
+static void bench_run(const char *name, uint32_t flush_every, uint32_t reset_every)
+{
+    hal_host_reset();
+    hal_host_flash_wipe();
+    node_log_init(TELEMETRY_KIND_RAIN);
+
+    uint64_t cycles = 0;
+
+    for (uint32_t i = 0; i < BENCH_LOG_RECORDS; i++)
+    {
+        uint64_t start = bench_now();
+        node_log_append(TELEMETRY_RAIN, 0, (int32_t)i, (int32_t)i * 3);
+        if (flush_every != 0 && (i + 1) % flush_every == 0)
+        {
+            node_log_flush();
+        }
+        cycles += bench_elapsed(start);
+
+        if (reset_every != 0 && (i + 1) % reset_every == 0)
+        {
+            node_log_init(TELEMETRY_KIND_RAIN);
+        }
+    }
+
+    node_log_flush();
+
+    // Wear of the log's sectors
+    const uint32_t *erases = hal_host_flash_erases();
+    uint32_t least = UINT32_MAX;
+    uint32_t most = 0;
+    for (uint32_t s = NODE_LOG_OFFSET / HAL_FLASH_SECTOR_SIZE; s < HAL_HOST_FLASH_SECTORS; s++)
+    {
+        least = erases[s] < least ? erases[s] : least;
+        most = erases[s] > most ? erases[s] : most;
+    }
+
+    bench_check_t check = { .last = -1 };
+    event_log_info_t info;
+    event_log_scan(hal_flash_read(NODE_LOG_OFFSET), NODE_LOG_SIZE, &bench_check, &check, &info);
+
+    const hal_host_stats_t *s = hal_host_stats();
+
+    printf("  %-6s %6u pages, %4u erases, wear %u to %u, %7.2f s stalled, %5.0f %s an append, "
+           "%5u records back (%u wrong, %u torn, %u boots)\r\n",
+           name, s->flash_pages, s->flash_erases, least, most, s->state_ns[HAL_HOST_RUN] / 1e9,
+           (double)cycles / BENCH_LOG_RECORDS, BENCH_UNIT, check.records, check.wrong, info.torn, info.boot);
+}
+
+
+int main()
+{
+    hal_stdio_init();
+    bench_init();
+
+    printf("Event log of %u kB, %u records a sector, %u records appended\r\n", NODE_LOG_SIZE / 1024,
+           EVENT_LOG_RECORDS, BENCH_LOG_RECORDS);
+
+    bench_run("each", 1, 0);
+    bench_run("4", 4, 0);
+    bench_run("page", 0, 0);
+    bench_run("resets", 0, BENCH_RESET_EVERY);
+
+    return 0;
+}
@@ -0,0 +1,425 @@
+/**
+ * @file    rain_rate_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host only replay of rainfall records through the rain node's
+ *          warnings: the tip counter it used before (a warning every 3 tips,
+ *          however long they took) and the sliding windows of rain_rate.h
+ *          set up by RAIN_RATE_CONFIG. Prints for each the warnings raised,
+ *          the false alarm rate (warnings outside any hazard) and the miss
+ *          rate (hazards without a warning), then the cost of a tip.
+ *
+ *          A hazard is rain over the intensity and duration curve of Caine
+ *          (1980), I = 14.82 D^-0.39 mm/h, for any duration D from 10 minutes
+ *          to a day in 10 minute steps. The minutes over it, with gaps of
+ *          under 6 hours joined, make one hazard, and a warning counts for a
+ *          hazard if it comes before it ends or within the hour after.
+ *
+ *          The synthetic record is 10 years of storms, one every three days
+ *          on average, from half an hour to 32 hours long, with heavy tailed
+ *          intensities and short bursts. On the command line any rainfall
+ *          records are replayed too, lines of "<time_s> <mm>" giving the rain
+ *          that fell from that time to the time of the next line (an hourly
+ *          gauge record, for example). Rain is tipped out in RAIN_TIP_UM
+ *          steps spread over each minute. Tip times are ms and wrap every 49
+ *          days, as they do on the node.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "rain_config.h"
+#include "rain_rate.h"
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Length of the synthetic record
+#define BENCH_YEARS         10
+
+// Longest record, in minutes
+#define BENCH_MAX_MINUTES   (BENCH_YEARS * 366 * 24 * 60)
+
+// Tips between warnings of the old counter, its RAIN_WARNING_TIPS default
+#define BENCH_LEGACY_TIPS   3
+
+// Gap joining the hazard minutes of one storm and the time after a hazard a
+// warning still counts for it (minutes)
+#define BENCH_HAZARD_GAP    (6 * 60)
+#define BENCH_HAZARD_GRACE  60
+
+// Rain in each minute (micrometres) and the running total before each
+static uint16_t bench_rain[BENCH_MAX_MINUTES];
+static uint32_t bench_total[BENCH_MAX_MINUTES + 1];
+static int bench_minutes;
+
+// Minutes over the curve
+static uint8_t bench_hazard[BENCH_MAX_MINUTES];
+
+// Rain over the curve for each duration in 10 minute steps (micrometres)
+static uint32_t bench_curve_um[24 * 6 + 1];
+
+// Hazards, first and last minute
+#define BENCH_MAX_HAZARDS   4096
+static int bench_hazard_start[BENCH_MAX_HAZARDS];
+static int bench_hazard_end[BENCH_MAX_HAZARDS];
+static int bench_hazards;
+
+// Time of every tip, for the timing runs
+#define BENCH_MAX_TIPS      (1 << 20)
+static uint32_t bench_tips[BENCH_MAX_TIPS];
+static int bench_tip_count;
+
+static rain_rate_t bench_rate;
+
+// What a warning rule did over the record
+typedef struct
+{
+    uint32_t warnings;
+    uint32_t false_alarms;
+    uint32_t detected;
+    uint64_t latency_min;       // Total over the detected hazards
+} bench_result_t;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Builds the synthetic record
+static void bench_make_record(void)
+{
+    uint32_t seed = 1980;
+    int storm_left = 0;
+    double storm_mm_h = 0;
+    double block_mm_h = 0;
+
+    bench_minutes = BENCH_YEARS * 365 * 24 * 60;
+
+    for (int m = 0; m < bench_minutes; m++)
+    {
+        if (storm_left == 0)
+        {
+            bench_rain[m] = 0;
+
+            // One storm every three days on average
+            if (bench_random(&seed) % (3 * 24 * 60) == 0)
+            {
+                storm_left = (int)(30 * pow(2, 6 * bench_uniform(&seed)));
+                storm_mm_h = fmin(0.8 / sqrt(bench_uniform(&seed)), 40);
+            }
+            continue;
+        }
+
+        // The rate changes every 10 minutes, now and then a burst of four times
+        if (m % 10 == 0)
+        {
+            block_mm_h = storm_mm_h * 2 * bench_uniform(&seed);
+            if (bench_random(&seed) % 20 == 0)
+            {
+                block_mm_h *= 4;
+            }
+        }
+
+        bench_rain[m] = (uint16_t)(block_mm_h * 1000 / 60 + 0.5);
+        storm_left--;
+    }
+}
+
+// Loads a rainfall record, returns the number of minutes or -1
+static int bench_load_record(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+    double last_s = -1;
+    double last_mm = 0;
+
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    memset(bench_rain, 0, sizeof(bench_rain));
+    bench_minutes = 0;
+
+    while (1)
+    {
+        double s;
+        double mm;
+        bool more = fgets(line, sizeof(line), file) != NULL;
+
+        if (more && sscanf(line, "%lf %lf", &s, &mm) != 2)
+        {
+            continue;
+        }
+
+        // Spread the last line's rain up to this one, over a minute at the end
+        if (last_s >= 0)
+        {
+            int from = (int)(last_s / 60);
+            int to = more ? (int)(s / 60) : from + 1;
+
+            if (to <= from)
+            {
+                to = from + 1;
+            }
+
+            for (int m = from; m < to && m < BENCH_MAX_MINUTES; m++)
+            {
+                bench_rain[m] = (uint16_t)fmin(bench_rain[m] + last_mm * 1000 / (to - from) + 0.5, 65535);
+            }
+
+            bench_minutes = to < BENCH_MAX_MINUTES ? to : BENCH_MAX_MINUTES;
+        }
+
+        if (!more)
+        {
+            break;
+        }
+
+        last_s = s;
+        last_mm = mm;
+    }
+
+    fclose(file);
+
+    // A day more for the windows to empty
+    bench_minutes += 24 * 60;
+    if (bench_minutes > BENCH_MAX_MINUTES)
+    {
+        bench_minutes = BENCH_MAX_MINUTES;
+    }
+
+    return bench_minutes;
+}
+
+// Marks the minutes over the curve and joins them into hazards
+static void bench_find_hazards(void)
+{
+    bench_total[0] = 0;
+    for (int m = 0; m < bench_minutes; m++)
+    {
+        bench_total[m + 1] = bench_total[m] + bench_rain[m];
+    }
+
+    bench_hazards = 0;
+
+    for (int m = 0; m < bench_minutes; m++)
+    {
+        bench_hazard[m] = 0;
+
+        for (int d = 1; d <= 24 * 6 && d * 10 <= m + 1; d++)
+        {
+            if (bench_total[m + 1] - bench_total[m + 1 - d * 10] >= bench_curve_um[d])
+            {
+                bench_hazard[m] = 1;
+                break;
+            }
+        }
+
+        if (!bench_hazard[m])
+        {
+            continue;
+        }
+
+        if (bench_hazards > 0 && m - bench_hazard_end[bench_hazards - 1] <= BENCH_HAZARD_GAP)
+        {
+            bench_hazard_end[bench_hazards - 1] = m;
+        }
+        else if (bench_hazards < BENCH_MAX_HAZARDS)
+        {
+            bench_hazard_start[bench_hazards] = m;
+            bench_hazard_end[bench_hazards] = m;
+            bench_hazards++;
+        }
+    }
+}
+
+// Scores a warning at a minute
+static void bench_score(bench_result_t *result, uint8_t *seen, int minute)
+{
+    result->warnings++;
+
+    for (int h = 0; h < bench_hazards; h++)
+    {
+        if (minute >= bench_hazard_start[h] && minute <= bench_hazard_end[h] + BENCH_HAZARD_GRACE)
+        {
+            if (!seen[h])
+            {
+                seen[h] = 1;
+                result->detected++;
+                result->latency_min += minute > bench_hazard_start[h] ? minute - bench_hazard_start[h] : 0;
+            }
+            return;
+        }
+
+        if (bench_hazard_start[h] > minute)
+        {
+            break;
+        }
+    }
+
+    result->false_alarms++;
+}
+
+// Tips the record out and scores both warning rules
+static void bench_run(bench_result_t *legacy, bench_result_t *windows)
+{
+    static uint8_t legacy_seen[BENCH_MAX_HAZARDS];
+    static uint8_t windows_seen[BENCH_MAX_HAZARDS];
+    rain_rate_config_t config = RAIN_RATE_CONFIG;
+    uint32_t bucket_um = 0;
+    uint32_t count = 0;
+    uint32_t over = 0;
+
+    memset(legacy, 0, sizeof(*legacy));
+    memset(windows, 0, sizeof(*windows));
+    memset(legacy_seen, 0, sizeof(legacy_seen));
+    memset(windows_seen, 0, sizeof(windows_seen));
+
+    rain_rate_init(&bench_rate, &config);
+    bench_tip_count = 0;
+
+    for (int m = 0; m < bench_minutes; m++)
+    {
+        bucket_um += bench_rain[m];
+        uint32_t tips = bucket_um / RAIN_TIP_UM;
+        bucket_um %= RAIN_TIP_UM;
+
+        for (uint32_t i = 0; i < tips; i++)
+        {
+            uint32_t now_ms = (uint32_t)((uint64_t)m * 60000 + (i + 1) * 60000 / (tips + 1));
+
+            if (bench_tip_count < BENCH_MAX_TIPS)
+            {
+                bench_tips[bench_tip_count++] = now_ms;
+            }
+
+            // The old counter
+            if (++count >= BENCH_LEGACY_TIPS)
+            {
+                bench_score(legacy, legacy_seen, m);
+                count = 0;
+            }
+
+            // The windows, warning as the rain node does when one goes over
+            uint32_t now = rain_rate_tip(&bench_rate, now_ms);
+            if (now & ~over)
+            {
+                bench_score(windows, windows_seen, m);
+            }
+            over = now;
+        }
+    }
+}
+
+static void bench_print(const char *name, const bench_result_t *result, double years)
+{
+    printf("  %-8s %6u warnings  %7.1f /year  false alarms %5.1f%%  missed %u/%d (%.1f%%)  latency mean %.0f min\r\n",
+           name, (unsigned)result->warnings, result->warnings / years,
+           result->warnings > 0 ? 100.0 * result->false_alarms / result->warnings : 0.0,
+           (unsigned)(bench_hazards - result->detected), bench_hazards,
+           bench_hazards > 0 ? 100.0 * (bench_hazards - result->detected) / bench_hazards : 0.0,
+           result->detected > 0 ? (double)result->latency_min / result->detected : 0.0);
+}
+
+// Times rain_rate_tip() over the tips of the record
+static void bench_time_tips(void)
+{
+    rain_rate_config_t config = RAIN_RATE_CONFIG;
+    uint64_t total = 0;
+    uint64_t worst = 0;
+    int runs = 20;
+
+    if (bench_tip_count == 0)
+    {
+        return;
+    }
+
+    for (int r = 0; r < runs; r++)
+    {
+        rain_rate_init(&bench_rate, &config);
+
+        uint64_t t0 = bench_now();
+        for (int i = 0; i < bench_tip_count; i++)
+        {
+            BENCH_KEEP(rain_rate_tip(&bench_rate, bench_tips[i]));
+        }
+        total += bench_elapsed(t0);
+    }
+
+    // The slowest single tip, the one after a gap that empties full windows
+    rain_rate_init(&bench_rate, &config);
+    for (int i = 0; i < bench_tip_count; i++)
+    {
+        uint64_t t0 = bench_now();
+        BENCH_KEEP(rain_rate_tip(&bench_rate, bench_tips[i]));
+        uint64_t t = bench_elapsed(t0);
+
+        if (t > worst)
+        {
+            worst = t;
+        }
+    }
+
+    printf("  rain_rate_tip: %.1f %s/tip mean, %llu %s slowest, %u tips dropped from a full buffer\r\n",
+           (double)total / runs / bench_tip_count, BENCH_UNIT,
+           (unsigned long long)worst, BENCH_UNIT, (unsigned)bench_rate.overflows);
+}
+
+static void bench_replay(const char *name)
+{
+    bench_result_t legacy;
+    bench_result_t windows;
+    double years = bench_minutes / (365.0 * 24 * 60);
+
+    bench_find_hazards();
+    bench_run(&legacy, &windows);
+
+    printf("%s, %.2f years, %.0f mm, %u tips, %d hazards\r\n",
+           name, years, bench_total[bench_minutes] / 1000.0, (unsigned)bench_tip_count, bench_hazards);
+
+    bench_print("counter", &legacy, years);
+    bench_print("windows", &windows, years);
+    bench_time_tips();
+}
+
+
+int main(int argc, char **argv)
+{
+    hal_stdio_init();
+    bench_init();
+
+    // Caine's curve at each duration
+    for (int d = 1; d <= 24 * 6; d++)
+    {
+        double hours = d / 6.0;
+        bench_curve_um[d] = (uint32_t)(14.82 * pow(hours, -0.39) * hours * 1000);
+    }
+
+    printf("Rain warnings, %u um tips, every %u tips before, windows of %u/%u/%u s at %u/%u/%u um now\r\n",
+           RAIN_TIP_UM, BENCH_LEGACY_TIPS,
+           RAIN_SHORT_WINDOW_S, RAIN_HOUR_WINDOW_S, RAIN_DAY_WINDOW_S,
+           RAIN_SHORT_WARNING_UM, RAIN_HOUR_WARNING_UM, RAIN_DAY_WARNING_UM);
+
+    bench_make_record();
+    bench_replay("synthetic record");
+
+    // Rainfall records named on the command line
+    for (int i = 1; i < argc; i++)
+    {
+        if (bench_load_record(argv[i]) < 0)
+        {
+            fprintf(stderr, "Could not read %s\n", argv[i]);
+            return 1;
+        }
+
+        const char *base = strrchr(argv[i], '/');
+        bench_replay(base != NULL ? base + 1 : argv[i]);
+    }
+
+    return 0;
+}
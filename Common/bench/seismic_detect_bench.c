@@ -0,0 +1,151 @@
+/**
+ * @file    seismic_detect_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Microbenchmark of the seismic detection kernels. Runs the original
+ *          float/sqrt check and each kernel in seismic_detect.h over a window
+ *          of SEISMIC_RISK_WINDOW samples, the number checked after every
+ *          wake, and prints the cost per sample. Built for the host it reports
+ *          TSC cycles, on the Pi Pico it reports processor cycles over the
+ *          usb/uart stdio every few seconds.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "seismic_detect.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <math.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Samples in a window and the number of windows timed
+#define BENCH_WINDOW    SEISMIC_RISK_WINDOW
+#define BENCH_RUNS      500
+
+// Window of samples at rest with some noise and a few knocks under 2 g, so
+// every kernel has to look at every sample
+static adxl343_sample_t bench_samples[BENCH_WINDOW];
+
+// Constants from the original accelerometer_read(), now from the site profile
+static const float SENSITIVITY_2G = 1.0f / SEISMIC_LSB_PER_G;  // (g/LSB)
+static const float THRESHOLD_G = SEISMIC_THRESHOLD_MG / 1000.0f;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// The original check, for comparison
+static int bench_float_sqrt(const adxl343_sample_t *sample)
+{
+    float acc_x_f = sample->x * SENSITIVITY_2G;
+    float acc_y_f = sample->y * SENSITIVITY_2G;
+    float acc_z_f = sample->z * SENSITIVITY_2G;
+
+    float acc_mag = sqrt(acc_x_f * acc_x_f + acc_y_f * acc_y_f + acc_z_f * acc_z_f);
+
+    return acc_mag > THRESHOLD_G;
+}
+
+static int bench_magnitude(const adxl343_sample_t *sample)
+{
+    return seismic_detect_magnitude(sample);
+}
+
+static int bench_axis(const adxl343_sample_t *sample)
+{
+    return seismic_detect_axis(sample);
+}
+
+static seismic_hp_t bench_hp;
+
+static int bench_hp_kernel(const adxl343_sample_t *sample)
+{
+    return seismic_detect_hp(&bench_hp, sample);
+}
+
+// Fills the window with a repeatable pseudo random signal
+static void bench_fill(void)
+{
+    uint32_t seed = 12345;
+
+    for (int i = 0; i < BENCH_WINDOW; i++)
+    {
+        int16_t noise[3];
+
+        for (int j = 0; j < 3; j++)
+        {
+            noise[j] = bench_noise(&seed, 8);
+        }
+
+        // A knock of about 1.5 g every 50 samples
+        int16_t knock = (i % 50 == 25) ? 384 : 0;
+
+        bench_samples[i].x = noise[0] + knock / 2;
+        bench_samples[i].y = noise[1];
+        bench_samples[i].z = 256 + noise[2] + knock / 2;
+    }
+}
+
+// Times one kernel, the best window is the figure to compare as it is the
+// least disturbed by interrupts and the host scheduler
+static void bench_run(const char *name, int (*kernel)(const adxl343_sample_t *))
+{
+    uint64_t best = UINT64_MAX;
+    uint64_t total = 0;
+
+    seismic_hp_reset(&bench_hp);
+
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        uint32_t hits = 0;
+        uint64_t start = bench_now();
+
+        for (int i = 0; i < BENCH_WINDOW; i++)
+        {
+            hits += kernel(&bench_samples[i]);
+        }
+
+        uint64_t elapsed = bench_elapsed(start);
+        BENCH_KEEP(hits);
+
+        total += elapsed;
+        if (elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+
+    printf("%-12s best %8.2f  mean %8.2f %s/sample\r\n", name,
+           (double)best / BENCH_WINDOW, (double)total / ((uint64_t)BENCH_RUNS * BENCH_WINDOW), BENCH_UNIT);
+}
+
+
+int main()
+{
+    // Initialize Pi Pico
+    hal_stdio_init();
+
+    bench_init();
+    bench_fill();
+
+    while (1)
+    {
+        printf("Seismic detection kernels, %d samples per window\r\n", BENCH_WINDOW);
+        bench_run("float sqrt", &bench_float_sqrt);
+        bench_run("magnitude", &bench_magnitude);
+        bench_run("per axis", &bench_axis);
+        bench_run("high pass", &bench_hp_kernel);
+        hal_stdio_flush();
+
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+        // One run is enough on the host
+        break;
+#endif
+
+        hal_sleep_ms(5000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,337 @@
+/**
+ * @file    sensor_codec_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host only benchmark of the sensor batch compression of
+ *          sensor_codec.h on each kind of reading. Encodes each record into
+ *          batches of up to BENCH_BATCH bytes, decodes them and checks every
+ *          reading comes back, then prints the bytes against the raw
+ *          readings (6 bytes an accelerometer sample, a 4 byte time and
+ *          moisture for soil, a 4 byte tip time for rain) and the cost of a
+ *          reading each way.
+ *
+ *          The synthetic records are
+ *
+ *            accel  a minute at 800 Hz: noise of a few LSB at rest, with a
+ *                   3 s decaying shake every 20 s
+ *            soil   120 days of a reading every 30 minutes, every 5 while
+ *                   the moisture moves, with up to 40 ms of wake jitter and
+ *                   a count of probe noise
+ *            rain   a year of storms, one every three days on average, with
+ *                   tips from a few seconds to minutes apart
+ *
+ *          On the command line any simulator traces are encoded too: their
+ *          acc lines held at 800 Hz, their soil lines and their pulse lines
+ *          as tips.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "sensor_codec.h"
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+#define BENCH_RATE_HZ       800
+#define BENCH_BATCH         4096
+
+#define BENCH_MAX_ACCEL     (10 * 60 * BENCH_RATE_HZ)
+#define BENCH_MAX_SOIL      (1 << 16)
+#define BENCH_MAX_RAIN      (1 << 18)
+
+static waveform_sample_t bench_accel[BENCH_MAX_ACCEL];
+static sensor_soil_t bench_soil[BENCH_MAX_SOIL];
+static uint32_t bench_rain[BENCH_MAX_RAIN];
+static int bench_accel_len;
+static int bench_soil_len;
+static int bench_rain_len;
+
+// The batches of a record, one after the other
+static uint8_t bench_batches[BENCH_MAX_ACCEL * 8];
+static size_t bench_batch_len[BENCH_MAX_ACCEL / SENSOR_CODEC_BLOCK + 1];
+
+// What the decoder gave back
+typedef struct
+{
+    sensor_codec_kind_t kind;
+    int next;                   // Reading it should be
+    uint32_t wrong;
+} bench_check_t;
+
+
+// ############################## [ Local Functions ] ##############################
+
+static void bench_make_accel(void)
+{
+    uint32_t seed = 12345;
+
+    bench_accel_len = 60 * BENCH_RATE_HZ;
+
+    for (int i = 0; i < bench_accel_len; i++)
+    {
+        float t = (float)(i % (20 * BENCH_RATE_HZ)) / BENCH_RATE_HZ - 10.0f;
+        float shake[3] = { 0.0f, 0.0f, 0.0f };
+
+        if (t >= 0.0f && t < 3.0f)
+        {
+            float amp = 1.5f * 256 * expf(-1.2f * t);
+            float phase = 2.0f * (float)M_PI * (12.0f - 3.0f * t) * t;
+
+            shake[0] = amp * sinf(phase);
+            shake[1] = 0.6f * amp * sinf(1.7f * phase + 0.5f);
+            shake[2] = 0.4f * amp * sinf(0.8f * phase + 1.0f);
+        }
+
+        bench_accel[i].x = (int16_t)((int)(bench_random(&seed) % 9) - 4 + shake[0]);
+        bench_accel[i].y = (int16_t)((int)(bench_random(&seed) % 9) - 4 + shake[1]);
+        bench_accel[i].z = (int16_t)(256 + (int)(bench_random(&seed) % 9) - 4 + shake[2]);
+    }
+}
+
+static void bench_make_soil(void)
+{
+    uint32_t seed = 2024;
+    float moisture = 25;
+    int storm_left = 0;
+    float storm_rate = 0;
+    uint32_t time_ms = 0;
+    int last = 25;
+
+    bench_soil_len = 0;
+
+    while (time_ms < 120u * 24 * 60 * 60 * 1000 && bench_soil_len < BENCH_MAX_SOIL)
+    {
+        int value = (int)(moisture + 0.5f) + (int)(bench_random(&seed) % 3) - 1;
+        int minutes = abs(value - last) > 1 ? 5 : 30;
+
+        bench_soil[bench_soil_len++] = (sensor_soil_t){ .time_ms = time_ms, .moisture = value };
+        last = value;
+        time_ms += minutes * 60 * 1000 + bench_random(&seed) % 40;
+
+        for (int m = 0; m < minutes; m++)
+        {
+            // One storm every five days on average
+            if (storm_left == 0 && bench_random(&seed) % (5 * 24 * 60) == 0)
+            {
+                storm_left = 120 + bench_random(&seed) % 600;
+                storm_rate = (1 + bench_random(&seed) % 6) / 2000.0f;
+            }
+
+            if (storm_left > 0)
+            {
+                moisture += (80 - moisture) * storm_rate;
+                storm_left--;
+            }
+            else
+            {
+                moisture -= (moisture - 15) / (3 * 24 * 60);
+            }
+        }
+    }
+}
+
+static void bench_make_rain(void)
+{
+    uint32_t seed = 1980;
+    uint64_t time_ms = 0;
+
+    bench_rain_len = 0;
+
+    while (time_ms < 365ull * 24 * 60 * 60 * 1000 && bench_rain_len < BENCH_MAX_RAIN)
+    {
+        // Dry for about three days, then a storm of half an hour to a day
+        time_ms += (uint64_t)(bench_random(&seed) % (6 * 24 * 60)) * 60 * 1000;
+        uint64_t end = time_ms + (30 + bench_random(&seed) % (24 * 60 - 30)) * 60 * 1000ull;
+        uint32_t mean_ms = 3000 + bench_random(&seed) % 120000;
+
+        while (time_ms < end && bench_rain_len < BENCH_MAX_RAIN)
+        {
+            // Tip times wrap as they do on the node
+            time_ms += 500 + bench_random(&seed) % (2 * mean_ms);
+            bench_rain[bench_rain_len++] = (uint32_t)time_ms;
+        }
+    }
+}
+
+// Loads the acc, soil and pulse lines of a simulator trace
+static int bench_load_trace(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+    waveform_sample_t value = { 0, 0, 256 };
+
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    bench_accel_len = 0;
+    bench_soil_len = 0;
+    bench_rain_len = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        double ms;
+        int x, y, z;
+
+        if (sscanf(line, "%lf acc %d %d %d", &ms, &x, &y, &z) == 4)
+        {
+            int at = (int)(ms * BENCH_RATE_HZ / 1000);
+            while (bench_accel_len < at && bench_accel_len < BENCH_MAX_ACCEL)
+            {
+                bench_accel[bench_accel_len++] = value;
+            }
+
+            value = (waveform_sample_t){ (int16_t)x, (int16_t)y, (int16_t)z };
+        }
+        else if (sscanf(line, "%lf soil %d", &ms, &x) == 2 && bench_soil_len < BENCH_MAX_SOIL)
+        {
+            bench_soil[bench_soil_len++] = (sensor_soil_t){ .time_ms = (uint32_t)ms, .moisture = x };
+        }
+        else if (sscanf(line, "%lf pulse %d", &ms, &x) == 2 && bench_rain_len < BENCH_MAX_RAIN)
+        {
+            bench_rain[bench_rain_len++] = (uint32_t)ms;
+        }
+    }
+
+    // Two more seconds after the last change
+    for (int i = 0; i < 2 * BENCH_RATE_HZ && bench_accel_len > 0 && bench_accel_len < BENCH_MAX_ACCEL; i++)
+    {
+        bench_accel[bench_accel_len++] = value;
+    }
+
+    fclose(file);
+    return 0;
+}
+
+static bool bench_add(sensor_codec_t *codec, sensor_codec_kind_t kind, int i)
+{
+    switch (kind)
+    {
+        case SENSOR_CODEC_ACCEL:
+            return sensor_codec_accel(codec, &bench_accel[i]);
+        case SENSOR_CODEC_SOIL:
+            return sensor_codec_soil(codec, bench_soil[i].time_ms, bench_soil[i].moisture);
+        default:
+            return sensor_codec_rain(codec, bench_rain[i]);
+    }
+}
+
+static void bench_check(void *ctx, uint32_t index, const sensor_value_t *value)
+{
+    bench_check_t *check = ctx;
+    int i = check->next++;
+    bool same;
+
+    (void)index;
+
+    switch (check->kind)
+    {
+        case SENSOR_CODEC_ACCEL:
+            same = memcmp(&value->accel, &bench_accel[i], sizeof(value->accel)) == 0;
+            break;
+        case SENSOR_CODEC_SOIL:
+            same = value->soil.time_ms == bench_soil[i].time_ms && value->soil.moisture == bench_soil[i].moisture;
+            break;
+        default:
+            same = value->tip_ms == bench_rain[i];
+            break;
+    }
+
+    check->wrong += !same;
+}
+
+// Encodes and decodes one record and prints how it went
+static void bench_run(const char *name, sensor_codec_kind_t kind, int len, size_t raw)
+{
+    if (len == 0)
+    {
+        return;
+    }
+
+    sensor_codec_t codec;
+    size_t total = 0;
+    int batches = 0;
+    uint64_t encode = 0;
+    uint64_t decode = 0;
+
+    for (int i = 0; i < len; batches++)
+    {
+        uint64_t start = bench_now();
+
+        sensor_codec_init(&codec, kind, &bench_batches[total], BENCH_BATCH);
+        while (i < len && bench_add(&codec, kind, i))
+        {
+            i++;
+        }
+
+        bench_batch_len[batches] = sensor_codec_finish(&codec);
+        encode += bench_elapsed(start);
+
+        total += bench_batch_len[batches];
+    }
+
+    bench_check_t check = { .kind = kind };
+    int32_t decoded = 0;
+    size_t at = 0;
+
+    for (int b = 0; b < batches; b++)
+    {
+        uint64_t start = bench_now();
+        int32_t n = sensor_codec_decode(&bench_batches[at], bench_batch_len[b], &bench_check, &check, NULL);
+        decode += bench_elapsed(start);
+
+        decoded = n < 0 || decoded < 0 ? -1 : decoded + n;
+        at += bench_batch_len[b];
+    }
+
+    bool same = decoded == len && check.wrong == 0;
+
+    printf("  %-6s %7d readings in %4d batches, %8zu bytes against %9zu raw (%5.1f%%), %6.2f bits/reading, "
+           "%7.1f %s/reading to encode, %6.1f to decode, %s\r\n", name, len, batches, total, len * raw,
+           100.0 * total / (len * raw), 8.0 * total / len, (double)encode / len, BENCH_UNIT,
+           (double)decode / len, same ? "same back" : "WRONG BACK");
+}
+
+static void bench_all(const char *name)
+{
+    printf("%s\r\n", name);
+    bench_run("accel", SENSOR_CODEC_ACCEL, bench_accel_len, 6);
+    bench_run("soil", SENSOR_CODEC_SOIL, bench_soil_len, 8);
+    bench_run("rain", SENSOR_CODEC_RAIN, bench_rain_len, 4);
+}
+
+
+int main(int argc, char **argv)
+{
+    // Initialize Pi Pico
+    hal_stdio_init();
+
+    bench_init();
+
+    bench_make_accel();
+    bench_make_soil();
+    bench_make_rain();
+    bench_all("Synthetic records");
+
+    // Recorded traces named on the command line
+    for (int i = 1; i < argc; i++)
+    {
+        if (bench_load_trace(argv[i]) != 0)
+        {
+            fprintf(stderr, "could not read %s\n", argv[i]);
+            return 1;
+        }
+
+        bench_all(argv[i]);
+    }
+
+    hal_stdio_flush();
+    return 0;
+}
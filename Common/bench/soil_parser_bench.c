@@ -0,0 +1,344 @@
+/**
+ * @file    soil_parser_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Runs the soil probe parser over a long stream of probe answers,
+ *          next to the parser the soil nodes used before (look for the '=',
+ *          copy up to 4 characters and atoi them). Prints the cost per byte
+ *          of each, and the values each one read that the probe never sent.
+ *
+ *          The stream is made like the simulated probe makes it: values of
+ *          0 to 100, with every 8th answer faulty in turn dropped, cut short,
+ *          garbled or after a line of noise. It is 4 MB on the host and
+ *          32 KB on the Pico. On the host any files named on the command
+ *          line, for example probe output recorded with a serial terminal,
+ *          are parsed too.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "soil_parser.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Size of the stream
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+#define BENCH_STREAM_BYTES  (4 * 1024 * 1024)
+#else
+#define BENCH_STREAM_BYTES  (32 * 1024)
+#endif
+
+// Every nth answer is faulty
+#define BENCH_FAULT_EVERY   8
+
+// Bytes timed in one go, short enough for SysTick on the Pico
+#define BENCH_BATCH         1024
+
+// Answers are at most 16 bytes, so this bounds the values in the stream
+#define BENCH_MAX_VALUES    (BENCH_STREAM_BYTES / 12)
+
+static uint8_t bench_stream[BENCH_STREAM_BYTES];
+static size_t bench_len;
+
+// Values of the good answers in the stream, in order
+static uint16_t bench_sent[BENCH_MAX_VALUES];
+static int bench_sent_count;
+
+// Values read in one batch, checked once the batch is timed
+static int bench_values[BENCH_BATCH];
+
+// What a parser read
+typedef struct
+{
+    uint64_t cycles;
+    int values;
+    int wrong;
+} bench_result_t;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Builds the stream of answers
+static void bench_make_stream(void)
+{
+    uint32_t seed = 7;
+    int n = 0;
+
+    bench_len = 0;
+    bench_sent_count = 0;
+
+    while (1)
+    {
+        char answer[48];
+        int value = bench_random(&seed) % 101;
+        int len = snprintf(answer, sizeof(answer), "Moisture=%d\r\n", value);
+        bool good = true;
+
+        // Faults cycle through drop, truncate, garble and noise like the
+        // simulated probe's
+        if (++n % BENCH_FAULT_EVERY == 0)
+        {
+            good = false;
+
+            switch ((n / BENCH_FAULT_EVERY) % 4)
+            {
+                case 0:
+                    len = 0;
+                    break;
+
+                case 1:
+                    len -= 3;
+                    break;
+
+                case 2:
+                    answer[len - 3] = 'O';
+                    break;
+
+                default:
+                    len = snprintf(answer, sizeof(answer), "\x7f=\xfe#\r\nMoisture=%d\r\n", value);
+                    good = true;
+                    break;
+            }
+        }
+
+        if (bench_len + len > BENCH_STREAM_BYTES)
+        {
+            break;
+        }
+
+        memcpy(&bench_stream[bench_len], answer, len);
+        bench_len += len;
+
+        if (good)
+        {
+            bench_sent[bench_sent_count++] = value;
+        }
+    }
+}
+
+// Counts a value read, it is wrong if it is not the next value sent (or
+// one of the few after it, when answers in between were lost)
+static void bench_check(bench_result_t *result, int value, int *next_sent)
+{
+    result->values++;
+
+    if (bench_sent_count == 0)
+    {
+        return;
+    }
+
+    for (int i = *next_sent; i < bench_sent_count && i < *next_sent + 4; i++)
+    {
+        if (bench_sent[i] == value)
+        {
+            *next_sent = i + 1;
+            return;
+        }
+    }
+
+    result->wrong++;
+}
+
+static bench_result_t bench_parser(const uint8_t *buf, size_t len)
+{
+    bench_result_t result = {0};
+    soil_parser_t parser;
+    int next_sent = 0;
+
+    soil_parser_init(&parser);
+
+    for (size_t start = 0; start < len; start += BENCH_BATCH)
+    {
+        size_t end = start + BENCH_BATCH < len ? start + BENCH_BATCH : len;
+        int count = 0;
+
+        // Only the parser is timed
+        uint64_t t0 = bench_now();
+        for (size_t i = start; i < end; )
+        {
+            soil_parse_status_t status;
+            i += soil_parser_feed_buf(&parser, &buf[i], end - i, &status);
+
+            if (status == SOIL_PARSE_OK)
+            {
+                bench_values[count++] = soil_parser_value(&parser);
+            }
+        }
+        result.cycles += bench_elapsed(t0);
+
+        for (int i = 0; i < count; i++)
+        {
+            bench_check(&result, bench_values[i], &next_sent);
+        }
+    }
+
+    return result;
+}
+
+// The parser the soil nodes used before, reading from a buffer instead of
+// the UART. Past the end it reads newlines.
+static int bench_old_getc(const uint8_t *buf, size_t len, size_t *pos)
+{
+    return *pos < len ? buf[(*pos)++] : '\n';
+}
+
+static int bench_old_parse(const uint8_t *buf, size_t len, size_t *pos)
+{
+    char soil_moisture[8];
+
+    // Keep reading until a "=" is found
+    while (*pos < len && bench_old_getc(buf, len, pos) != '=')
+    {
+        // Do nothing
+    }
+
+    soil_moisture[0] = bench_old_getc(buf, len, pos);
+    soil_moisture[1] = bench_old_getc(buf, len, pos);
+    if (soil_moisture[1] == '\n')
+    {
+        soil_moisture[1] = '\0';
+        return atoi(soil_moisture);
+    }
+
+    soil_moisture[2] = bench_old_getc(buf, len, pos);
+    if (soil_moisture[2] == '\n')
+    {
+        soil_moisture[2] = '\0';
+        return atoi(soil_moisture);
+    }
+    else if (soil_moisture[2] == '0')
+    {
+        soil_moisture[3] = '\0';
+        return atoi(soil_moisture);
+    }
+
+    soil_moisture[3] = bench_old_getc(buf, len, pos);
+    if (soil_moisture[3] == '\n')
+    {
+        soil_moisture[3] = '\0';
+        return atoi(soil_moisture);
+    }
+
+    return -1;
+}
+
+static bench_result_t bench_old(const uint8_t *buf, size_t len)
+{
+    bench_result_t result = {0};
+    size_t pos = 0;
+    int next_sent = 0;
+
+    while (pos < len)
+    {
+        size_t end = pos + BENCH_BATCH;
+        int count = 0;
+
+        uint64_t t0 = bench_now();
+        while (pos < len && pos < end)
+        {
+            bench_values[count++] = bench_old_parse(buf, len, &pos);
+        }
+        result.cycles += bench_elapsed(t0);
+
+        for (int i = 0; i < count; i++)
+        {
+            if (bench_values[i] >= 0)
+            {
+                bench_check(&result, bench_values[i], &next_sent);
+            }
+        }
+    }
+
+    return result;
+}
+
+static void bench_print(const char *name, const char *parser, size_t len, const bench_result_t *result)
+{
+    printf("%-24s %-5s %8u bytes  %7d values  ", name, parser, (unsigned)len, result->values);
+    if (bench_sent_count > 0)
+    {
+        printf("%6d wrong  ", result->wrong);
+    }
+    else
+    {
+        printf("%6s wrong  ", "-");
+    }
+    printf("%.2f %s/byte\r\n", (double)result->cycles / len, BENCH_UNIT);
+}
+
+static void bench_run(const char *name, const uint8_t *buf, size_t len)
+{
+    bench_result_t result = bench_parser(buf, len);
+    bench_print(name, "table", len, &result);
+
+    result = bench_old(buf, len);
+    bench_print(name, "atoi", len, &result);
+}
+
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+// Loads a file of probe output into the stream buffer, returns its length
+static long bench_load_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    size_t len = fread(bench_stream, 1, sizeof(bench_stream), file);
+    fclose(file);
+    return (long)len;
+}
+#endif
+
+
+int main(int argc, char **argv)
+{
+    // Initialize Pi Pico
+    hal_stdio_init();
+
+    bench_init();
+
+    printf("Soil probe parser, %u bytes of state, every %dth answer faulty\r\n", (unsigned)sizeof(soil_parser_t), BENCH_FAULT_EVERY);
+
+    bench_make_stream();
+
+    while (1)
+    {
+        bench_run("synthetic", bench_stream, bench_len);
+
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+        // Recorded probe output named on the command line, nothing is
+        // known about the values sent
+        bench_sent_count = 0;
+
+        for (int i = 1; i < argc; i++)
+        {
+            long len = bench_load_file(argv[i]);
+            if (len < 0)
+            {
+                fprintf(stderr, "Could not read %s\n", argv[i]);
+                return 1;
+            }
+
+            const char *base = strrchr(argv[i], '/');
+            bench_run(base != NULL ? base + 1 : argv[i], bench_stream, len);
+        }
+
+        break;
+#else
+        (void)argc;
+        (void)argv;
+        hal_stdio_flush();
+        hal_sleep_ms(5000);
+#endif
+    }
+
+    return 0;
+}
@@ -0,0 +1,317 @@
+/**
+ * @file    soil_parser_fuzz.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host only fuzzer for the soil probe parser. Builds lines from good
+ *          answers broken in random ways (bytes flipped, dropped, doubled,
+ *          cut short, runs of noise or digits, stray 'M's and line ends) and
+ *          random bytes, feeds them to the parser in chunks of random size
+ *          and checks every line end against a plain reference of the frame
+ *          rules written with string functions:
+ *
+ *            - the frame is whatever follows the last 'M' of the line
+ *            - "Moisture=" then 1 to 4 digits, then an optional '\r', is a
+ *              value; 5 digits or more is an overflow
+ *            - a line of only '\r's (or nothing) is ignored
+ *            - anything else is malformed
+ *
+ *          Usage: soil_parser_fuzz [seed] [lines], exits with 1 and dumps the
+ *          line on the first difference.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "soil_parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Longest line made
+#define FUZZ_MAX_LINE       64
+
+// Lines fed to the parser in one go
+#define FUZZ_BLOCK_LINES    256
+
+static const char fuzz_key[] = "Moisture=";
+
+static uint32_t fuzz_seed;
+
+// What a line should end with
+typedef struct
+{
+    soil_parse_status_t status;     // SOIL_PARSE_MORE if the line is ignored
+    uint16_t value;
+} fuzz_expect_t;
+
+// A block of lines, each ending with '\n'
+static uint8_t fuzz_block[FUZZ_BLOCK_LINES * (FUZZ_MAX_LINE + 1)];
+static size_t fuzz_line_start[FUZZ_BLOCK_LINES];
+static fuzz_expect_t fuzz_expect[FUZZ_BLOCK_LINES];
+
+
+// ############################## [ Local Functions ] ##############################
+
+static uint32_t fuzz_random(uint32_t n)
+{
+    // xorshift32
+    fuzz_seed ^= fuzz_seed << 13;
+    fuzz_seed ^= fuzz_seed >> 17;
+    fuzz_seed ^= fuzz_seed << 5;
+    return fuzz_seed % n;
+}
+
+// Makes one line without its '\n', returns its length
+static size_t fuzz_make_line(uint8_t *line)
+{
+    static const char noise[] = "M=0123456789\r\xff\x7fMoisture";
+    size_t len;
+
+    // One in 16 lines is random bytes, the rest start as a good answer
+    if (fuzz_random(16) == 0)
+    {
+        len = fuzz_random(FUZZ_MAX_LINE / 2);
+        for (size_t i = 0; i < len; i++)
+        {
+            line[i] = (uint8_t)fuzz_random(256);
+            if (line[i] == '\n')
+            {
+                line[i] = 'M';
+            }
+        }
+        return len;
+    }
+
+    len = (size_t)snprintf((char *)line, FUZZ_MAX_LINE, "Moisture=%u", (unsigned)fuzz_random(10000));
+    if (fuzz_random(4) != 0)
+    {
+        line[len++] = '\r';
+    }
+
+    // Zero to three breakages
+    int breaks = fuzz_random(8) < 4 ? 0 : fuzz_random(4);
+    for (int b = 0; b < breaks; b++)
+    {
+        size_t at = len > 0 ? fuzz_random((uint32_t)len) : 0;
+
+        switch (fuzz_random(7))
+        {
+            // Flip a byte to one of the bytes the parser cares about
+            case 0:
+                if (len > 0)
+                {
+                    line[at] = (uint8_t)noise[fuzz_random(sizeof(noise) - 1)];
+                }
+                break;
+
+            // Drop a byte
+            case 1:
+                if (len > 0)
+                {
+                    memmove(&line[at], &line[at + 1], len - at - 1);
+                    len--;
+                }
+                break;
+
+            // Double a byte
+            case 2:
+                if (len > 0 && len < FUZZ_MAX_LINE)
+                {
+                    memmove(&line[at + 1], &line[at], len - at);
+                    len++;
+                }
+                break;
+
+            // Cut it short
+            case 3:
+                len = at;
+                break;
+
+            // Run of noise in front
+            case 4:
+            {
+                size_t run = fuzz_random(8);
+                if (len + run <= FUZZ_MAX_LINE)
+                {
+                    memmove(&line[run], line, len);
+                    for (size_t i = 0; i < run; i++)
+                    {
+                        line[i] = (uint8_t)noise[fuzz_random(sizeof(noise) - 1)];
+                    }
+                    len += run;
+                }
+                break;
+            }
+
+            // Extra digits on the end
+            case 5:
+                while (len < FUZZ_MAX_LINE && fuzz_random(3) != 0)
+                {
+                    line[len++] = (uint8_t)('0' + fuzz_random(10));
+                }
+                break;
+
+            // Random byte anywhere
+            default:
+                if (len > 0)
+                {
+                    line[at] = (uint8_t)fuzz_random(256);
+                    if (line[at] == '\n')
+                    {
+                        line[at] = '\r';
+                    }
+                }
+                break;
+        }
+    }
+
+    return len;
+}
+
+// The frame rules, on one whole line without its '\n'
+static fuzz_expect_t fuzz_reference(const uint8_t *line, size_t len)
+{
+    fuzz_expect_t expect = {SOIL_PARSE_MALFORMED, 0};
+    const uint8_t *frame = NULL;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (line[i] == 'M')
+        {
+            frame = &line[i];
+        }
+    }
+
+    if (frame == NULL)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            if (line[i] != '\r')
+            {
+                return expect;
+            }
+        }
+
+        expect.status = SOIL_PARSE_MORE;
+        return expect;
+    }
+
+    size_t frame_len = len - (size_t)(frame - line);
+    size_t key_len = sizeof(fuzz_key) - 1;
+
+    if (frame_len < key_len || memcmp(frame, fuzz_key, key_len) != 0)
+    {
+        return expect;
+    }
+
+    size_t digits = 0;
+    unsigned value = 0;
+    while (key_len + digits < frame_len && frame[key_len + digits] >= '0' && frame[key_len + digits] <= '9')
+    {
+        value = value * 10 + (frame[key_len + digits] - '0');
+        digits++;
+    }
+
+    size_t rest = frame_len - key_len - digits;
+
+    if (digits > SOIL_PARSER_MAX_DIGITS)
+    {
+        expect.status = SOIL_PARSE_OVERFLOW;
+    }
+    else if (digits > 0 && (rest == 0 || (rest == 1 && frame[frame_len - 1] == '\r')))
+    {
+        expect.status = SOIL_PARSE_OK;
+        expect.value = (uint16_t)value;
+    }
+
+    return expect;
+}
+
+static void fuzz_dump(const uint8_t *line, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        fprintf(stderr, "%02x ", line[i]);
+    }
+    fprintf(stderr, "\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    uint32_t seed = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 1;
+    unsigned long lines = argc > 2 ? strtoul(argv[2], NULL, 0) : 1000000;
+    unsigned long counts[4] = {0};
+    soil_parser_t parser;
+
+    fuzz_seed = seed != 0 ? seed : 1;
+    soil_parser_init(&parser);
+
+    for (unsigned long done = 0; done < lines; done += FUZZ_BLOCK_LINES)
+    {
+        size_t block_len = 0;
+
+        // Make a block of lines and what each should end with
+        for (int i = 0; i < FUZZ_BLOCK_LINES; i++)
+        {
+            size_t len = fuzz_make_line(&fuzz_block[block_len]);
+
+            fuzz_line_start[i] = block_len;
+            fuzz_expect[i] = fuzz_reference(&fuzz_block[block_len], len);
+            block_len += len;
+            fuzz_block[block_len++] = '\n';
+        }
+
+        // Feed it in chunks of random size, every line end has to match
+        size_t pos = 0;
+        int line = 0;
+        while (pos < block_len)
+        {
+            size_t chunk = 1 + fuzz_random(3 * FUZZ_MAX_LINE);
+            if (chunk > block_len - pos)
+            {
+                chunk = block_len - pos;
+            }
+
+            soil_parse_status_t status;
+            size_t used = soil_parser_feed_buf(&parser, &fuzz_block[pos], chunk, &status);
+
+            // Every line end used has to match. feed_buf() stops after a
+            // line that ends with a status, so any before the last one were
+            // ignored lines.
+            for (size_t i = pos; i < pos + used; i++)
+            {
+                if (fuzz_block[i] != '\n')
+                {
+                    continue;
+                }
+
+                const fuzz_expect_t *expect = &fuzz_expect[line];
+                soil_parse_status_t got = i + 1 == pos + used ? status : SOIL_PARSE_MORE;
+
+                if (got != expect->status || (got == SOIL_PARSE_OK && soil_parser_value(&parser) != expect->value))
+                {
+                    fprintf(stderr, "Line %lu (seed %u): expected %d value %u, parser gave %d value %u\n",
+                            done + line, (unsigned)seed, expect->status, expect->value,
+                            got, soil_parser_value(&parser));
+                    fuzz_dump(&fuzz_block[fuzz_line_start[line]], i + 1 - fuzz_line_start[line]);
+                    return 1;
+                }
+
+                counts[got]++;
+                line++;
+            }
+
+            pos += used;
+        }
+    }
+
+    printf("%lu lines from seed %u match: %lu ok, %lu malformed, %lu overflow, %lu ignored (%u resyncs)\n",
+           lines, (unsigned)seed, counts[SOIL_PARSE_OK], counts[SOIL_PARSE_MALFORMED],
+           counts[SOIL_PARSE_OVERFLOW], counts[SOIL_PARSE_MORE], (unsigned)parser.resyncs);
+
+    return 0;
+}
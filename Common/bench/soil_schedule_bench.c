@@ -0,0 +1,269 @@
+/**
+ * @file    soil_schedule_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host only replay of a season of soil moisture through the soil
+ *          node's wake schedules: the fixed SOIL_SLEEP_S interval the node
+ *          used before and the adaptive one from soil_schedule.h. Prints for
+ *          each the wakes, the time awake and how long after the moisture
+ *          went over the threshold the node first read it (the detection
+ *          latency), and the risk episodes it never saw.
+ *
+ *          The synthetic season is 120 days at one value every 10 s: the
+ *          soil dries slowly toward 15, and storms of 2 to 12 hours every
+ *          five days or so wet it toward 80. On the command line any
+ *          simulator traces, their soil lines held until the next, are
+ *          replayed too.
+ *
+ *          Each wake is charged SOIL_READINGS_PER_WAKE readings (one if it
+ *          is over the threshold) of BENCH_READ_MS, the probe's 50 ms
+ *          response and its 13 byte answer at 9600 baud.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "soil_config.h"
+#include "soil_schedule.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Length of the synthetic season
+#define BENCH_DAYS          120
+
+// Time between values of the season (s)
+#define BENCH_STEP_S        10
+
+// Longest season, in steps
+#define BENCH_MAX_STEPS     (366 * 24 * 60 * 60 / BENCH_STEP_S)
+
+// Time awake for one reading (ms)
+#define BENCH_READ_MS       64
+
+// Moisture every step
+static int16_t bench_season[BENCH_MAX_STEPS];
+static int bench_steps;
+
+// What a schedule did over the season
+typedef struct
+{
+    uint32_t wakes;
+    uint64_t awake_ms;
+    uint32_t episodes;          // Times the moisture went over the threshold
+    uint32_t detected;
+    uint32_t missed;            // Episodes over before a wake saw them
+    uint64_t latency_s;         // Total over the detected episodes
+    uint32_t max_latency_s;
+} bench_result_t;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Builds the synthetic season
+static void bench_make_season(void)
+{
+    uint32_t seed = 2024;
+    float moisture = 25;
+    int storm_left = 0;
+    float storm_rate = 0;
+
+    bench_steps = BENCH_DAYS * 24 * 60 * 60 / BENCH_STEP_S;
+
+    for (int i = 0; i < bench_steps; i++)
+    {
+        // One storm every five days on average, rates are per minute
+        if (storm_left == 0 && bench_random(&seed) % (5 * 24 * 60 * 60 / BENCH_STEP_S) == 0)
+        {
+            storm_left = (120 + bench_random(&seed) % 600) * 60 / BENCH_STEP_S;
+            storm_rate = (1 + bench_random(&seed) % 6) / 2000.0f * BENCH_STEP_S / 60;
+        }
+
+        if (storm_left > 0)
+        {
+            // Wets toward 80, slower as the soil fills up
+            moisture += (80 - moisture) * storm_rate;
+            storm_left--;
+        }
+        else
+        {
+            // Dries toward 15 over a few days
+            moisture -= (moisture - 15) * BENCH_STEP_S / (3 * 24 * 60 * 60);
+        }
+
+        bench_season[i] = (int16_t)(moisture + 0.5f);
+    }
+}
+
+// Loads the soil lines of a simulator trace, holding each value until the
+// next one, returns the number of steps
+static int bench_load_trace(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+    int value = 0;
+    int len = 0;
+
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        double ms;
+        int soil;
+
+        if (sscanf(line, "%lf soil %d", &ms, &soil) != 2)
+        {
+            continue;
+        }
+
+        int at = (int)(ms / (BENCH_STEP_S * 1000));
+        while (len < at && len < BENCH_MAX_STEPS)
+        {
+            bench_season[len++] = (int16_t)value;
+        }
+
+        value = soil;
+    }
+
+    // An hour more after the last change
+    for (int i = 0; i < 60 * 60 / BENCH_STEP_S && len < BENCH_MAX_STEPS; i++)
+    {
+        bench_season[len++] = (int16_t)value;
+    }
+
+    fclose(file);
+    return len;
+}
+
+// Replays the season through one schedule
+static bench_result_t bench_run(const soil_schedule_config_t *config)
+{
+    bench_result_t result = {0};
+    soil_schedule_t sched;
+    uint64_t end_s = (uint64_t)bench_steps * BENCH_STEP_S;
+    uint64_t t = 0;
+    int step = 0;
+    int episode_start = -1;     // Step the current episode started
+    bool episode_seen = false;
+
+    soil_schedule_init(&sched, config);
+
+    while (1)
+    {
+        t += soil_schedule_interval(&sched);
+        if (t >= end_s)
+        {
+            break;
+        }
+
+        // Walk the episodes up to this wake
+        for (; step <= (int)(t / BENCH_STEP_S); step++)
+        {
+            bool over = bench_season[step] > config->threshold;
+
+            if (over && episode_start < 0)
+            {
+                episode_start = step;
+                episode_seen = false;
+                result.episodes++;
+            }
+            else if (!over && episode_start >= 0)
+            {
+                result.missed += !episode_seen;
+                episode_start = -1;
+            }
+        }
+
+        int moisture = bench_season[t / BENCH_STEP_S];
+        bool over = moisture > config->threshold;
+
+        result.wakes++;
+        result.awake_ms += (over ? 1 : SOIL_READINGS_PER_WAKE) * BENCH_READ_MS;
+
+        if (over && !episode_seen)
+        {
+            uint32_t latency = (uint32_t)(t - (uint64_t)episode_start * BENCH_STEP_S);
+
+            episode_seen = true;
+            result.detected++;
+            result.latency_s += latency;
+            if (latency > result.max_latency_s)
+            {
+                result.max_latency_s = latency;
+            }
+        }
+
+        soil_schedule_next(&sched, moisture);
+    }
+
+    // An episode still going at the end counts as missed if unseen
+    if (episode_start >= 0 && !episode_seen)
+    {
+        result.missed++;
+    }
+
+    return result;
+}
+
+static void bench_print(const char *name, const bench_result_t *result)
+{
+    double days = bench_steps * BENCH_STEP_S / (24.0 * 60 * 60);
+
+    printf("  %-10s %8u wakes  %7.0f wakes/day  %8.1f s awake  %6.1f s/day  ",
+           name, (unsigned)result->wakes, result->wakes / days,
+           result->awake_ms / 1000.0, result->awake_ms / 1000.0 / days);
+    printf("%u/%u risks seen, latency mean %.0f s max %u s\r\n",
+           (unsigned)result->detected, (unsigned)result->episodes,
+           result->detected > 0 ? (double)result->latency_s / result->detected : 0.0,
+           (unsigned)result->max_latency_s);
+}
+
+static void bench_compare(const char *name)
+{
+    soil_schedule_config_t adaptive = SOIL_SCHEDULE_CONFIG;
+    soil_schedule_config_t fixed = adaptive;
+    fixed.max_s = fixed.min_s;
+
+    printf("%s, %.1f days\r\n", name, bench_steps * BENCH_STEP_S / (24.0 * 60 * 60));
+
+    bench_result_t result = bench_run(&fixed);
+    bench_print("fixed", &result);
+
+    result = bench_run(&adaptive);
+    bench_print("adaptive", &result);
+}
+
+
+int main(int argc, char **argv)
+{
+    hal_stdio_init();
+
+    printf("Soil wake schedules, %u s fixed, %u to %u s adaptive with a step of %u, threshold %d\r\n",
+           SOIL_SLEEP_S, SOIL_SLEEP_S, SOIL_SLEEP_MAX_S, SOIL_SCHEDULE_STEP, SOIL_MOISTURE_THRESHOLD);
+
+    bench_make_season();
+    bench_compare("synthetic season");
+
+    // Simulator traces named on the command line
+    for (int i = 1; i < argc; i++)
+    {
+        bench_steps = bench_load_trace(argv[i]);
+        if (bench_steps < 0)
+        {
+            fprintf(stderr, "Could not read %s\n", argv[i]);
+            return 1;
+        }
+
+        const char *base = strrchr(argv[i], '/');
+        bench_compare(base != NULL ? base + 1 : argv[i]);
+    }
+
+    return 0;
+}
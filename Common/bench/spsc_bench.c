@@ -0,0 +1,251 @@
+/**
+ * @file    spsc_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host only benchmark of the lock free queue of spsc_queue.h, with
+ *          a producer and a consumer thread standing in for core 1 and
+ *          core 0. The producer pushes BENCH_ELEMENTS samples stamped with
+ *          the cycle counter as fast as it can, the consumer pops them and
+ *          takes the time each spent in the queue. A side that finds the
+ *          queue full or empty yields its thread, as the cores would idle.
+ *
+ *          It reports the throughput and the latency percentiles for a few
+ *          capacities, against a ring under a mutex with condition
+ *          variables, the way the queue would be written with locks.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "adxl343.h"
+#include "spsc_queue.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// ############################# [ Global Variables ] #############################
+
+#define BENCH_ELEMENTS      (1u << 21)
+#define BENCH_MAX_CAPACITY  4096
+
+// One latency is kept out of this many
+#define BENCH_LATENCY_EVERY 16
+
+// What main_basic.c hands from core 1 to core 0
+typedef struct
+{
+    uint64_t time;
+    adxl343_sample_t sample;
+} bench_element_t;
+
+// The ring under a lock
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t capacity;
+} bench_locked_t;
+
+// One run, either queue
+typedef struct
+{
+    bool locked;
+    uint32_t capacity;
+    spsc_queue_t spsc;
+    bench_locked_t ring;
+    bench_element_t slots[BENCH_MAX_CAPACITY];
+    uint32_t full;              // Pushes that found the locked ring full
+    uint64_t sum;               // Of what was popped, to check nothing was lost
+} bench_run_t;
+
+static bench_run_t bench_run;
+static uint64_t bench_latency[BENCH_ELEMENTS / BENCH_LATENCY_EVERY];
+
+
+// ############################## [ Local Functions ] ##############################
+
+static double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_locked_push(bench_locked_t *ring, const bench_element_t *element)
+{
+    pthread_mutex_lock(&ring->lock);
+
+    while (ring->head - ring->tail == ring->capacity)
+    {
+        bench_run.full++;
+        pthread_cond_wait(&ring->not_full, &ring->lock);
+    }
+
+    bench_run.slots[ring->head++ % ring->capacity] = *element;
+
+    pthread_cond_signal(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static void bench_locked_pop(bench_locked_t *ring, bench_element_t *element)
+{
+    pthread_mutex_lock(&ring->lock);
+
+    while (ring->head == ring->tail)
+    {
+        pthread_cond_wait(&ring->not_empty, &ring->lock);
+    }
+
+    *element = bench_run.slots[ring->tail++ % ring->capacity];
+
+    pthread_cond_signal(&ring->not_full);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static void *bench_producer(void *arg)
+{
+    (void)arg;
+
+    for (uint32_t i = 0; i < BENCH_ELEMENTS; i++)
+    {
+        bench_element_t element = { 0, { (int16_t)i, (int16_t)(i >> 16), 256 } };
+
+        if (bench_run.locked)
+        {
+            element.time = bench_now();
+            bench_locked_push(&bench_run.ring, &element);
+            continue;
+        }
+
+        // Unlike core 1 it waits rather than drop, so every run moves the same samples
+        while (element.time = bench_now(), !spsc_push(&bench_run.spsc, &element))
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *bench_consumer(void *arg)
+{
+    (void)arg;
+
+    for (uint32_t i = 0; i < BENCH_ELEMENTS; i++)
+    {
+        bench_element_t element;
+
+        if (bench_run.locked)
+        {
+            bench_locked_pop(&bench_run.ring, &element);
+        }
+        else
+        {
+            while (!spsc_pop(&bench_run.spsc, &element))
+            {
+                sched_yield();
+            }
+        }
+
+        if (i % BENCH_LATENCY_EVERY == 0)
+        {
+            bench_latency[i / BENCH_LATENCY_EVERY] = bench_now() - element.time;
+        }
+
+        bench_run.sum += (uint16_t)element.sample.x | (uint32_t)(uint16_t)element.sample.y << 16;
+    }
+
+    return NULL;
+}
+
+static int bench_compare(const void *x, const void *y)
+{
+    uint64_t a = *(const uint64_t *)x;
+    uint64_t b = *(const uint64_t *)y;
+    return (a > b) - (a < b);
+}
+
+static void bench_queue(const char *name, bool locked, uint32_t capacity)
+{
+    pthread_t producer;
+    pthread_t consumer;
+
+    bench_run.locked = locked;
+    bench_run.capacity = capacity;
+    bench_run.full = 0;
+    bench_run.sum = 0;
+
+    if (locked)
+    {
+        pthread_mutex_init(&bench_run.ring.lock, NULL);
+        pthread_cond_init(&bench_run.ring.not_empty, NULL);
+        pthread_cond_init(&bench_run.ring.not_full, NULL);
+        bench_run.ring.head = 0;
+        bench_run.ring.tail = 0;
+        bench_run.ring.capacity = capacity;
+    }
+    else
+    {
+        spsc_init(&bench_run.spsc, bench_run.slots, capacity, sizeof(bench_element_t));
+    }
+
+    double start = bench_seconds();
+
+    pthread_create(&consumer, NULL, &bench_consumer, NULL);
+    pthread_create(&producer, NULL, &bench_producer, NULL);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    double elapsed = bench_seconds() - start;
+
+    if (locked)
+    {
+        pthread_mutex_destroy(&bench_run.ring.lock);
+        pthread_cond_destroy(&bench_run.ring.not_empty);
+        pthread_cond_destroy(&bench_run.ring.not_full);
+    }
+
+    // Each element's x and y are the low and high half of its number
+    uint64_t expected = (uint64_t)BENCH_ELEMENTS * (BENCH_ELEMENTS - 1) / 2;
+    size_t n = BENCH_ELEMENTS / BENCH_LATENCY_EVERY;
+    uint32_t full = locked ? bench_run.full : bench_run.spsc.dropped;
+
+    qsort(bench_latency, n, sizeof(bench_latency[0]), &bench_compare);
+
+    printf("  %-6s %5lu slots: %6.2f M/s, latency %s p50 %8llu p99 %9llu max %10llu, %8lu full, %s\r\n",
+           name, (unsigned long)capacity, BENCH_ELEMENTS / elapsed / 1e6, BENCH_UNIT,
+           (unsigned long long)bench_latency[n / 2], (unsigned long long)bench_latency[n * 99 / 100],
+           (unsigned long long)bench_latency[n - 1], (unsigned long)full,
+           bench_run.sum == expected ? "all through" : "LOST SOME");
+}
+
+
+int main()
+{
+    // Initialize Pi Pico
+    hal_stdio_init();
+
+    bench_init();
+
+    printf("Queue from core 1 to core 0, %u elements of %u bytes, %ld host cpus\r\n", BENCH_ELEMENTS,
+           (unsigned)sizeof(bench_element_t), sysconf(_SC_NPROCESSORS_ONLN));
+
+    static const uint32_t capacities[] = { 16, 64, 256, 4096 };
+
+    for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++)
+    {
+        bench_queue("spsc", false, capacities[i]);
+        bench_queue("mutex", true, capacities[i]);
+    }
+
+    hal_stdio_flush();
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file    sta_lta_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Runs the STA/LTA detector with the seismic set up over synthetic
+ *          100 Hz signals, and on the host over any trace files given on the
+ *          command line, next to the old single 2 g threshold. Prints the
+ *          events each rule finds and the cost per sample of the detector.
+ *
+ *          Synthetic signals (all at rest with +-4 LSB of noise):
+ *            quiet   nothing else
+ *            knock   one 2.2 g sample, should not be an event
+ *            tremor  3 s of 0.5 g shaking at 5 Hz, never over 2 g
+ *            shake   1 s step to 2.2 g, the seismic_event trace
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "seismic_detect.h"
+#include "sta_lta.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Sample rate of the signals
+#define BENCH_RATE_HZ       100
+
+// Longest signal, 20 s at 100 Hz on the Pico and 100 s for traces on the host
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+#define BENCH_MAX_SAMPLES   10000
+#else
+#define BENCH_MAX_SAMPLES   2000
+#endif
+
+// Samples timed in one go, short enough for SysTick on the Pico
+#define BENCH_BATCH         250
+
+static adxl343_sample_t bench_signal[BENCH_MAX_SAMPLES];
+
+static sta_lta_t bench_detector;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Builds one of the synthetic signals, returns its length
+static int bench_synthetic(const char *name)
+{
+    uint32_t seed = 42;
+    int len = 20 * BENCH_RATE_HZ;
+
+    for (int i = 0; i < len; i++)
+    {
+        float t = (float)i / BENCH_RATE_HZ;
+        adxl343_sample_t *s = &bench_signal[i];
+
+        s->x = bench_noise(&seed, 4);
+        s->y = bench_noise(&seed, 4);
+        s->z = 256 + bench_noise(&seed, 4);
+
+        if (strcmp(name, "knock") == 0 && i == 10 * BENCH_RATE_HZ)
+        {
+            s->x += 500;
+        }
+        else if (strcmp(name, "tremor") == 0 && t >= 10 && t < 13)
+        {
+            s->x += (int16_t)(128 * sinf(2 * (float)M_PI * 5 * t));
+        }
+        else if (strcmp(name, "shake") == 0 && t >= 10 && t < 11)
+        {
+            s->x += 400;
+            s->y += 300;
+        }
+    }
+
+    return len;
+}
+
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+// Loads the acc lines of a simulator trace, holding each value until the
+// next one, returns the number of samples
+static int bench_load_trace(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+    adxl343_sample_t value = {0, 0, 256};
+    int len = 0;
+
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        double ms;
+        int x, y, z;
+
+        if (sscanf(line, "%lf acc %d %d %d", &ms, &x, &y, &z) != 4)
+        {
+            continue;
+        }
+
+        int at = (int)(ms * BENCH_RATE_HZ / 1000);
+        while (len < at && len < BENCH_MAX_SAMPLES)
+        {
+            bench_signal[len++] = value;
+        }
+
+        value.x = x;
+        value.y = y;
+        value.z = z;
+    }
+
+    // Two more seconds after the last change
+    for (int i = 0; i < 2 * BENCH_RATE_HZ && len < BENCH_MAX_SAMPLES; i++)
+    {
+        bench_signal[len++] = value;
+    }
+
+    fclose(file);
+    return len;
+}
+#endif
+
+// Runs both rules over the signal and prints what they found
+static void bench_run(const char *name, int len)
+{
+    sta_lta_config_t config = SEISMIC_STA_LTA_CONFIG;
+    seismic_hp_t hp = {0};
+    int threshold_hits = 0;
+    int events = 0;
+    float first_event_s = -1;
+    uint64_t cycles = 0;
+
+    sta_lta_init(&bench_detector, &config);
+
+    for (int start = 0; start < len; start += BENCH_BATCH)
+    {
+        int end = start + BENCH_BATCH < len ? start + BENCH_BATCH : len;
+        uint8_t triggered[BENCH_BATCH];
+
+        // Only the detector is timed
+        uint64_t t0 = bench_now();
+        for (int i = start; i < end; i++)
+        {
+            triggered[i - start] = sta_lta_update(&bench_detector, seismic_hp_energy(&hp, &bench_signal[i])) == STA_LTA_TRIGGER;
+        }
+        cycles += bench_elapsed(t0);
+
+        for (int i = start; i < end; i++)
+        {
+            threshold_hits += seismic_detect_magnitude(&bench_signal[i]);
+
+            if (triggered[i - start])
+            {
+                if (events++ == 0)
+                {
+                    first_event_s = (float)i / BENCH_RATE_HZ;
+                }
+            }
+        }
+    }
+
+    printf("%-28s %5d samples  2g rule %4d warnings  sta/lta %2d events", name, len, threshold_hits, events);
+    if (events > 0)
+    {
+        printf(" (first at %.2f s)", first_event_s);
+    }
+    printf("  %.1f %s/sample\r\n", (double)cycles / len, BENCH_UNIT);
+}
+
+
+int main(int argc, char **argv)
+{
+    static const char *signals[] = {"quiet", "knock", "tremor", "shake"};
+
+    // Initialize Pi Pico
+    hal_stdio_init();
+
+    bench_init();
+
+    printf("STA/LTA detector, %u bytes of state, samples at %d Hz\r\n", (unsigned)sizeof(sta_lta_t), BENCH_RATE_HZ);
+
+    while (1)
+    {
+        for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++)
+        {
+            bench_run(signals[i], bench_synthetic(signals[i]));
+        }
+
+#ifdef LANDSLIDE_HAL_BACKEND_HOST
+        // Recorded traces named on the command line
+        for (int i = 1; i < argc; i++)
+        {
+            int len = bench_load_trace(argv[i]);
+            if (len < 0)
+            {
+                fprintf(stderr, "Could not read %s\n", argv[i]);
+                return 1;
+            }
+
+            const char *base = strrchr(argv[i], '/');
+            bench_run(base != NULL ? base + 1 : argv[i], len);
+        }
+
+        break;
+#else
+        (void)argc;
+        (void)argv;
+        hal_stdio_flush();
+        hal_sleep_ms(5000);
+#endif
+    }
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * @file    telemetry_bench.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host only test of both ends of the telemetry link on one Linux
+ *          box. First the cost of encoding and decoding a frame and its time
+ *          on the Zero's I2C bus, then a sender process writing frames into
+ *          a pseudo terminal and the gateway's receiver (telemetry_rx.h)
+ *          reading them out of the other end:
+ *
+ *            bulk   - frames of 8 events back to back, the throughput
+ *            paced  - a frame every 500 us, the latency from the write to
+ *                     the receiver passing the frame on
+ *            noisy  - random bytes, stray sync bytes among them, between the
+ *                     frames and one frame in 50 with a byte flipped. Every
+ *                     other frame has to come through, none of the broken
+ *                     ones, and the lost ones show as gaps.
+ *
+ *          Each frame's events carry a pattern from its sequence number that
+ *          the receiver checks, and the first event the time it was sent.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#define _GNU_SOURCE
+
+#include "landslide_hal.h"
+#include "node_config.h"
+#include "telemetry_frame.h"
+#include "telemetry_rx.h"
+#include "bench.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Frames each codec timing runs over
+#define BENCH_CODEC_FRAMES  100000
+
+// Frames sent in each loopback run
+#define BENCH_BULK_FRAMES   20000
+#define BENCH_PACED_FRAMES  4000
+#define BENCH_NOISY_FRAMES  20000
+
+// Time between the paced frames (us)
+#define BENCH_PACE_US       500
+
+// One frame in this many is broken in the noisy run
+#define BENCH_BREAK_EVERY   50
+
+// Receiver gives up after this long without a byte (ms)
+#define BENCH_IDLE_MS       1000
+
+// What a loopback run saw
+typedef struct
+{
+    uint32_t frames;
+    uint32_t wrong;             // Frames passed on with the wrong contents
+    uint32_t *latency_us;       // Of each frame
+    uint64_t first_us;
+    uint64_t last_us;
+} bench_rx_t;
+
+
+// ############################## [ Local Functions ] ##############################
+
+static uint64_t bench_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+// Fills a frame with the pattern for its sequence number
+static void bench_fill(telemetry_frame_t *frame, uint16_t seq, uint8_t count)
+{
+    frame->node = TELEMETRY_NODE(5, TELEMETRY_KIND_SEISMIC);
+    frame->seq = seq;
+    frame->time_ms = seq * 10u;
+    frame->count = count;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        frame->events[i].type = TELEMETRY_SEISMIC;
+        frame->events[i].arg = i;
+        frame->events[i].time_ms = seq * 10u + i;
+        frame->events[i].value = (int32_t)(seq * 8u + i);
+    }
+}
+
+static uint32_t bench_wire_us(size_t len)
+{
+    // Each byte and the address are 9 clocks, plus the start and stop
+    return (uint32_t)(((len + 1) * 9 + 2) * 1000000ull / NODE_ZERO_I2C_BAUD);
+}
+
+static void bench_count(void *ctx, const telemetry_frame_t *frame)
+{
+    BENCH_KEEP(frame->events[frame->count - 1].value);
+    (void)ctx;
+}
+
+// Times encoding and decoding frames of count events
+static void bench_codec(uint8_t count)
+{
+    static uint8_t stream[BENCH_CODEC_FRAMES / 100 * TELEMETRY_FRAME_MAX];
+    telemetry_frame_t frame;
+    telemetry_decoder_t dec;
+    size_t len = 0;
+    uint64_t encode = 0;
+    uint64_t decode = 0;
+
+    telemetry_decoder_init(&dec);
+
+    // In batches of 1000 frames, encoded into one stream then decoded
+    for (int batch = 0; batch < 100; batch++)
+    {
+        size_t at = 0;
+
+        uint64_t start = bench_now();
+        for (int i = 0; i < BENCH_CODEC_FRAMES / 100; i++)
+        {
+            bench_fill(&frame, (uint16_t)i, count);
+            at += telemetry_frame_encode(stream + at, &frame);
+        }
+        encode += bench_elapsed(start);
+
+        start = bench_now();
+        telemetry_decoder_feed(&dec, stream, at, &bench_count, NULL);
+        decode += bench_elapsed(start);
+
+        len = at / (BENCH_CODEC_FRAMES / 100);
+    }
+
+    printf("  %u event%s: %3u bytes, %4.1f bytes/event, %5.0f %s to encode, %5.0f %s to decode, "
+           "%5u us on the wire at %u kHz (%u decoded)\r\n",
+           count, count == 1 ? " " : "s", (unsigned)len, (double)len / count,
+           (double)encode / BENCH_CODEC_FRAMES, BENCH_UNIT, (double)decode / BENCH_CODEC_FRAMES, BENCH_UNIT,
+           bench_wire_us(len), NODE_ZERO_I2C_BAUD / 1000, dec.frames);
+}
+
+// Sender process: writes the frames into the pseudo terminal and exits
+static void bench_send(int fd, int frames, bool paced, bool noisy)
+{
+    uint8_t buf[TELEMETRY_FRAME_MAX + 16];
+    telemetry_frame_t frame;
+    unsigned seed = 1;
+
+    for (int i = 0; i < frames; i++)
+    {
+        size_t at = 0;
+
+        if (noisy)
+        {
+            int junk = rand_r(&seed) % 17;
+            for (int j = 0; j < junk; j++)
+            {
+                int r = rand_r(&seed) % 8;
+                buf[at++] = r == 0 ? TELEMETRY_SYNC0 : r == 1 ? TELEMETRY_SYNC1 : (uint8_t)rand_r(&seed);
+            }
+        }
+
+        // Sleeping rather than spinning leaves the core to the receiver
+        if (paced)
+        {
+            struct timespec pace = { .tv_nsec = BENCH_PACE_US * 1000 };
+            nanosleep(&pace, NULL);
+        }
+
+        bench_fill(&frame, (uint16_t)i, TELEMETRY_MAX_EVENTS);
+        frame.events[0].value = (int32_t)(uint32_t)bench_us();
+
+        size_t len = telemetry_frame_encode(buf + at, &frame);
+
+        if (noisy && i % BENCH_BREAK_EVERY == BENCH_BREAK_EVERY - 1)
+        {
+            buf[at + 2 + rand_r(&seed) % (len - 2)] ^= (uint8_t)(1 + rand_r(&seed) % 255);
+        }
+
+        at += len;
+
+        for (size_t done = 0; done < at;)
+        {
+            ssize_t n = write(fd, buf + done, at - done);
+            if (n <= 0)
+            {
+                _exit(1);
+            }
+            done += (size_t)n;
+        }
+    }
+
+    _exit(0);
+}
+
+// Receiver: checks each frame against the pattern and times it
+static void bench_receive(void *ctx, const telemetry_frame_t *frame)
+{
+    bench_rx_t *rx = ctx;
+    uint64_t now = bench_us();
+    telemetry_frame_t expected;
+
+    bench_fill(&expected, frame->seq, TELEMETRY_MAX_EVENTS);
+
+    bool right = frame->count == expected.count && frame->node == expected.node && frame->time_ms == expected.time_ms;
+    for (uint8_t i = 1; right && i < frame->count; i++)
+    {
+        const telemetry_event_t *ev = &frame->events[i];
+        const telemetry_event_t *want = &expected.events[i];
+
+        right = ev->type == want->type && ev->arg == want->arg && ev->time_ms == want->time_ms && ev->value == want->value;
+    }
+
+    if (!right)
+    {
+        rx->wrong++;
+        return;
+    }
+
+    if (rx->frames == 0)
+    {
+        rx->first_us = now;
+    }
+
+    rx->last_us = now;
+    rx->latency_us[rx->frames++] = (uint32_t)now - (uint32_t)frame->events[0].value;
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Sends frames through a pseudo terminal and prints what came out
+static int bench_loopback(const char *name, int frames, bool paced, bool noisy)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    struct termios tio;
+
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        perror("pty");
+        return -1;
+    }
+
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0 || tcgetattr(slave, &tio) != 0)
+    {
+        perror("pty");
+        return -1;
+    }
+
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    bench_rx_t result = { 0 };
+    result.latency_us = calloc(frames, sizeof(uint32_t));
+
+    telemetry_rx_t rx;
+    telemetry_rx_init(&rx, master, &bench_receive, &result);
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(master);
+        bench_send(slave, frames, paced, noisy);
+    }
+
+    close(slave);
+
+    // Until the sender has gone and the last byte is read
+    bool sent = false;
+    while (1)
+    {
+        int got = telemetry_rx_poll(&rx, BENCH_IDLE_MS);
+
+        if (got < 0 || (got == 0 && (sent = waitpid(pid, NULL, WNOHANG) != 0)))
+        {
+            break;
+        }
+    }
+
+    if (!sent)
+    {
+        waitpid(pid, NULL, 0);
+    }
+
+    close(master);
+
+    double secs = (result.last_us - result.first_us) / 1e6;
+    qsort(result.latency_us, result.frames, sizeof(uint32_t), &bench_compare);
+
+    printf("  %-5s %5u/%u frames, %u wrong, %u gaps, %u bad, %llu bytes skipped, ", name, result.frames,
+           frames, result.wrong, rx.gaps, rx.decoder.crc_errors + rx.decoder.bad_headers,
+           (unsigned long long)rx.decoder.skipped);
+
+    if (paced)
+    {
+        printf("latency %u/%u/%u us p50/p99/max\r\n", result.latency_us[result.frames / 2],
+               result.latency_us[result.frames * 99 / 100], result.latency_us[result.frames - 1]);
+    }
+    else
+    {
+        printf("%.0f frames/s, %.0f events/s, %.2f MB/s\r\n", result.frames / secs,
+               result.frames * (double)TELEMETRY_MAX_EVENTS / secs, rx.bytes / secs / 1e6);
+    }
+
+    free(result.latency_us);
+    return 0;
+}
+
+
+int main()
+{
+    hal_stdio_init();
+    bench_init();
+
+    printf("Telemetry frames, %u byte header and CRC, %u bytes an event\r\n",
+           TELEMETRY_HEADER_LEN + TELEMETRY_CRC_LEN, TELEMETRY_EVENT_LEN);
+
+    bench_codec(1);
+    bench_codec(TELEMETRY_MAX_EVENTS);
+
+    printf("Pseudo terminal loopback, %u events a frame\r\n", TELEMETRY_MAX_EVENTS);
+
+    if (bench_loopback("bulk", BENCH_BULK_FRAMES, false, false) < 0 ||
+        bench_loopback("paced", BENCH_PACED_FRAMES, true, false) < 0 ||
+        bench_loopback("noisy", BENCH_NOISY_FRAMES, false, true) < 0)
+    {
+        return 1;
+    }
+
+    return 0;
+}
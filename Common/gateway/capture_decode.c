@@ -0,0 +1,82 @@
+/**
+ * @file    capture_decode.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Decodes a waveform capture written by telemetry_rx --captures into
+ *          CSV, one sample a line with its time from the trigger in ms and
+ *          the three axes in g, with the capture's header on stderr:
+ *
+ *            capture_decode <capture>
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "waveform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ############################## [ Local Functions ] ##############################
+
+static void decode_sample(void *ctx, uint32_t index, const waveform_sample_t *sample)
+{
+    const waveform_header_t *header = ctx;
+    double g = header->lsb_per_g;
+
+    printf("%.3f,%.4f,%.4f,%.4f\n", ((double)index - header->pre) * 1000.0 / header->rate_hz, sample->x / g,
+           sample->y / g, sample->z / g);
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: capture_decode <capture>\n");
+        return 2;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+
+    uint8_t *capture = malloc(size > 0 ? (size_t)size : 1);
+    if (capture == NULL || size < 0 || fread(capture, 1, (size_t)size, f) != (size_t)size)
+    {
+        fprintf(stderr, "could not read %s\n", argv[1]);
+        return 1;
+    }
+
+    fclose(f);
+
+    // The header is needed for the times before the samples are decoded
+    waveform_header_t header;
+    if (!waveform_header_decode(capture, (size_t)size, &header) || header.rate_hz == 0 || header.lsb_per_g == 0)
+    {
+        fprintf(stderr, "%s is not a whole capture\n", argv[1]);
+        return 1;
+    }
+
+    printf("t_ms,x_g,y_g,z_g\n");
+
+    if (waveform_decode(capture, (size_t)size, &decode_sample, &header, NULL) < 0)
+    {
+        fprintf(stderr, "%s has bad blocks\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(stderr, "%u samples at %u Hz, %u before the trigger at %.3f s, %ld bytes (%.1f%% of raw)%s\n",
+            header.samples, header.rate_hz, header.pre, header.trigger_ms / 1000.0, size,
+            header.samples ? 100.0 * size / (header.samples * 6.0) : 0.0,
+            (header.flags & WAVEFORM_TRUNCATED) ? ", cut short" : "");
+
+    free(capture);
+    return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file    capture_rx.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Waveform captures put back together from telemetry frames, see
+ *          capture_rx.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "capture_rx.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ############################## [ Local Functions ] ##############################
+
+static void capture_drop(capture_rx_t *rx, capture_rx_node_t *node)
+{
+    if (node->len > 0)
+    {
+        rx->broken++;
+    }
+
+    node->len = 0;
+    node->want = 0;
+}
+
+// Adds a piece, passing the capture on once it is all there
+static void capture_add(capture_rx_t *rx, uint8_t id, capture_rx_node_t *node, const uint8_t *src, size_t len)
+{
+    if (node->len + len > CAPTURE_RX_MAX)
+    {
+        capture_drop(rx, node);
+        return;
+    }
+
+    memcpy(node->buf + node->len, src, len);
+    node->len += len;
+
+    if (node->want == 0 && node->len >= WAVEFORM_HEADER_LEN)
+    {
+        node->want = waveform_capture_len(node->buf);
+
+        if (node->want == 0 || node->want > CAPTURE_RX_MAX)
+        {
+            capture_drop(rx, node);
+            return;
+        }
+    }
+
+    if (node->want == 0 || node->len < node->want)
+    {
+        return;
+    }
+
+    waveform_header_t header;
+    if (node->len != node->want || !waveform_header_decode(node->buf, node->len, &header))
+    {
+        capture_drop(rx, node);
+        return;
+    }
+
+    rx->captures++;
+    if (rx->fn != NULL)
+    {
+        rx->fn(rx->ctx, id, node->buf, node->len);
+    }
+
+    node->len = 0;
+    node->want = 0;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void capture_rx_init(capture_rx_t *rx, capture_rx_fn_t fn, void *ctx)
+{
+    memset(rx, 0, sizeof(*rx));
+
+    rx->fn = fn;
+    rx->ctx = ctx;
+}
+
+void capture_rx_frame(capture_rx_t *rx, const telemetry_frame_t *frame)
+{
+    capture_rx_node_t *node = &rx->nodes[frame->node];
+
+    // A capture goes in frames one after the other
+    if (node->len > 0 && frame->seq != (uint16_t)(node->seq + 1))
+    {
+        capture_drop(rx, node);
+    }
+
+    for (uint8_t i = 0; i < frame->count; i++)
+    {
+        uint8_t bytes[TELEMETRY_BLOB_BYTES];
+        size_t len = telemetry_blob_unpack(&frame->events[i], bytes);
+
+        if (len == 0)
+        {
+            capture_drop(rx, node);
+            continue;
+        }
+
+        if (node->buf == NULL && (node->buf = malloc(CAPTURE_RX_MAX)) == NULL)
+        {
+            rx->broken++;
+            return;
+        }
+
+        capture_add(rx, frame->node, node, bytes, len);
+    }
+
+    node->seq = frame->seq;
+}
+
+void capture_rx_free(capture_rx_t *rx)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        free(rx->nodes[i].buf);
+        rx->nodes[i].buf = NULL;
+    }
+}
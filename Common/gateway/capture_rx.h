@@ -0,0 +1,85 @@
+/**
+ * @file    capture_rx.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Puts the waveform captures of waveform.h back together from the
+ *          TELEMETRY_CAPTURE events of the frames a telemetry_rx_t passes
+ *          on. Each node has its own capture in progress. A frame missing
+ *          from a node's sequence, or another event in the middle of a
+ *          capture, throws the capture in progress away, as does a CRC that
+ *          does not match once it is all there.
+ *
+*/
+
+#ifndef CAPTURE_RX_H
+#define CAPTURE_RX_H
+
+// ################################# [ Includes ] #################################
+
+#include "telemetry_frame.h"
+#include "waveform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Longest capture taken, the firmware's ring can be up to 64 kB
+#define CAPTURE_RX_MAX      (WAVEFORM_HEADER_LEN + 65536 + WAVEFORM_CRC_LEN)
+
+// Called with each capture that came through whole
+typedef void (*capture_rx_fn_t)(void *ctx, uint8_t node, const uint8_t *capture, size_t len);
+
+// A node's capture in progress
+typedef struct
+{
+    uint8_t *buf;               // CAPTURE_RX_MAX bytes, taken at its first capture
+    size_t len;
+    size_t want;                // Length of the whole capture, once the header is in
+    uint16_t seq;               // Frame the last piece came in
+} capture_rx_node_t;
+
+typedef struct
+{
+    capture_rx_node_t nodes[256];
+
+    capture_rx_fn_t fn;
+    void *ctx;
+
+    uint32_t captures;          // Captures passed on
+    uint32_t broken;            // Captures thrown away
+} capture_rx_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up a reassembler
+ *
+ * @param rx The reassembler
+ * @param fn Called with each capture
+ * @param ctx Passed to fn
+ */
+void capture_rx_init(capture_rx_t *rx, capture_rx_fn_t fn, void *ctx);
+
+/**
+ * @brief Takes the capture pieces out of a frame
+ *
+ * @param rx The reassembler
+ * @param frame A new frame from telemetry_rx_t
+ */
+void capture_rx_frame(capture_rx_t *rx, const telemetry_frame_t *frame);
+
+/**
+ * @brief Frees the buffers of the nodes
+ *
+ * @param rx The reassembler
+ */
+void capture_rx_free(capture_rx_t *rx);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAPTURE_RX_H
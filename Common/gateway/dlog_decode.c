@@ -0,0 +1,121 @@
+/**
+ * @file    dlog_decode.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Turns what a node built with NODE_DLOG_MODE NODE_DLOG_BINARY
+ *          sends over its uart back into text. Text the firmware printed
+ *          goes through as it is, each deferred log frame is printed as its
+ *          format's text with the time it was logged in front:
+ *
+ *            dlog_decode [capture]
+ *
+ *          It reads the capture, or stdin if there is none, so it can sit on
+ *          the end of a pipe from the serial port or the simulator.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "dlog_format.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Bytes waiting to be a whole frame
+static uint8_t decode_buf[DLOG_FRAME_MAX];
+static size_t decode_len;
+
+static unsigned long decode_frames;
+static unsigned long decode_lost;
+
+
+// ############################## [ Local Functions ] ##############################
+
+static void decode_record(const dlog_record_t *record)
+{
+    char text[256];
+
+    if (record->lost != 0)
+    {
+        printf("[%u log records lost]\n", (unsigned)record->lost);
+        decode_lost += record->lost;
+    }
+
+    dlog_format(text, sizeof(text), record);
+    printf("[%10.6f] %s", record->time_us / 1e6, text);
+    decode_frames++;
+}
+
+// Takes what is buffered as far as it goes, a byte that does not start a
+// frame is text
+static void decode_take(bool end)
+{
+    size_t at = 0;
+
+    while (at < decode_len)
+    {
+        dlog_record_t record;
+        int32_t frame = dlog_frame_decode(&decode_buf[at], decode_len - at, &record);
+
+        if (frame > 0)
+        {
+            decode_record(&record);
+            at += (size_t)frame;
+        }
+        else if (frame == 0 && !end)
+        {
+            break;
+        }
+        else
+        {
+            putchar(decode_buf[at++]);
+        }
+    }
+
+    memmove(decode_buf, &decode_buf[at], decode_len - at);
+    decode_len -= at;
+}
+
+
+int main(int argc, char *argv[])
+{
+    FILE *f = stdin;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: dlog_decode [capture]\n");
+        return 2;
+    }
+
+    if (argc == 2 && (f = fopen(argv[1], "rb")) == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    int c;
+    while ((c = getc(f)) != EOF)
+    {
+        // Text goes straight through, only a frame is held back
+        if (decode_len == 0 && c != DLOG_FRAME_START)
+        {
+            putchar(c);
+            continue;
+        }
+
+        decode_buf[decode_len++] = (uint8_t)c;
+        decode_take(false);
+    }
+
+    decode_take(true);
+
+    fprintf(stderr, "%lu log records, %lu lost on the node\n", decode_frames, decode_lost);
+
+    if (f != stdin)
+    {
+        fclose(f);
+    }
+
+    return 0;
+}
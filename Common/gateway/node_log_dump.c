@@ -0,0 +1,92 @@
+/**
+ * @file    node_log_dump.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Dumps the event log out of an image of a node's flash as CSV, one
+ *          record a line, oldest first, with what it found and how worn the
+ *          log's sectors are at the end on stderr:
+ *
+ *            node_log_dump <image> [offset length]
+ *
+ *          The image is the file a host simulation leaves with
+ *          LANDSLIDE_FLASH, or the whole flash read off a Pico in BOOTSEL
+ *          mode:
+ *
+ *            picotool save -r 0x10000000 0x10200000 flash.bin
+ *
+ *          Sectors without a log header are skipped, so the whole image can
+ *          be given; an offset and length narrow it down to the log.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "event_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ############################## [ Local Functions ] ##############################
+
+static void dump_record(void *ctx, const event_log_record_t *record)
+{
+    (void)ctx;
+
+    printf("%u,%lu,%s,%u,%ld,%ld\n", record->boot, (unsigned long)record->time_ms, telemetry_type_name(record->type),
+           record->arg, (long)record->value, (long)record->stat);
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2 && argc != 4)
+    {
+        fprintf(stderr, "usage: node_log_dump <image> [offset length]\n");
+        return 2;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+
+    uint8_t *image = malloc(size > 0 ? (size_t)size : 1);
+    if (image == NULL || size < 0 || fread(image, 1, (size_t)size, f) != (size_t)size)
+    {
+        fprintf(stderr, "could not read %s\n", argv[1]);
+        return 1;
+    }
+
+    fclose(f);
+
+    size_t offset = 0;
+    size_t len = (size_t)size;
+
+    if (argc == 4)
+    {
+        offset = strtoul(argv[2], NULL, 0);
+        len = strtoul(argv[3], NULL, 0);
+
+        if (offset % EVENT_LOG_SECTOR_LEN != 0 || offset > (size_t)size || len > (size_t)size - offset)
+        {
+            fprintf(stderr, "the log has to be whole sectors inside the image\n");
+            return 1;
+        }
+    }
+
+    event_log_info_t info;
+
+    printf("boot,time_ms,type,arg,value,stat\n");
+    event_log_scan(image + offset, len, &dump_record, NULL, &info);
+
+    fprintf(stderr, "%u records in %u sectors, %u torn, %u boots\n", info.records, info.sectors, info.torn, info.boot);
+    fprintf(stderr, "sector erases %u to %u\n", info.min_erases, info.max_erases);
+
+    free(image);
+    return 0;
+}
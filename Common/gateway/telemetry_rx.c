@@ -0,0 +1,161 @@
+/**
+ * @file    telemetry_rx.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Linux receiver for the telemetry link, see telemetry_rx.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "telemetry_rx.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Bytes read at a time, a few frames
+#define RX_READ_LEN     512
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Follows the node's sequence and passes the frame on if it is new
+static void rx_frame(void *ctx, const telemetry_frame_t *frame)
+{
+    telemetry_rx_t *rx = ctx;
+    uint8_t node = frame->node;
+    bool seen = (rx->seen[node / 8] >> (node % 8)) & 1;
+
+    if (seen && frame->seq == rx->seq[node])
+    {
+        rx->repeats++;
+        return;
+    }
+
+    // Sequence 0 after anything but 65535 is a node that started again
+    if (seen && frame->seq == 0 && rx->seq[node] != 0xFFFF)
+    {
+        rx->restarts++;
+    }
+    else if (seen)
+    {
+        rx->gaps += (uint16_t)(frame->seq - rx->seq[node] - 1);
+    }
+
+    rx->seq[node] = frame->seq;
+    rx->seen[node / 8] |= (uint8_t)(1u << (node % 8));
+
+    rx->frames++;
+    rx->events += frame->count;
+
+    if (rx->fn != NULL)
+    {
+        rx->fn(rx->ctx, frame);
+    }
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void telemetry_rx_init(telemetry_rx_t *rx, int fd, telemetry_frame_fn_t fn, void *ctx)
+{
+    *rx = (telemetry_rx_t){0};
+
+    rx->fd = fd;
+    rx->fn = fn;
+    rx->ctx = ctx;
+    telemetry_decoder_init(&rx->decoder);
+
+    // A terminal would otherwise change or swallow some of the bytes
+    struct termios tio;
+    if (fd >= 0 && tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+}
+
+int telemetry_rx_open(telemetry_rx_t *rx, const char *path, telemetry_frame_fn_t fn, void *ctx)
+{
+    int fd = open(path, O_RDONLY | O_NOCTTY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    telemetry_rx_init(rx, fd, fn, ctx);
+    rx->own_fd = true;
+
+    return 0;
+}
+
+int telemetry_rx_poll(telemetry_rx_t *rx, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = rx->fd, .events = POLLIN };
+    uint8_t buf[RX_READ_LEN];
+
+    int ready = poll(&pfd, 1, timeout_ms);
+    if (ready < 0)
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    if (ready == 0)
+    {
+        return 0;
+    }
+
+    ssize_t len = read(rx->fd, buf, sizeof(buf));
+    if (len < 0 && (errno == EINTR || errno == EAGAIN))
+    {
+        return 0;
+    }
+
+    if (len <= 0)
+    {
+        return -1;
+    }
+
+    return telemetry_rx_feed(rx, buf, (size_t)len);
+}
+
+int telemetry_rx_feed(telemetry_rx_t *rx, const uint8_t *src, size_t len)
+{
+    uint32_t frames = rx->frames;
+
+    rx->bytes += len;
+    telemetry_decoder_feed(&rx->decoder, src, len, &rx_frame, rx);
+
+    return (int)(rx->frames - frames);
+}
+
+void telemetry_rx_close(telemetry_rx_t *rx)
+{
+    if (rx->own_fd && rx->fd >= 0)
+    {
+        close(rx->fd);
+    }
+
+    rx->fd = -1;
+    rx->own_fd = false;
+}
+
+const char *telemetry_rx_kind_name(uint8_t kind)
+{
+    switch (kind)
+    {
+        case TELEMETRY_KIND_RAIN:
+            return "rain";
+        case TELEMETRY_KIND_SOIL:
+            return "soil";
+        case TELEMETRY_KIND_SEISMIC:
+            return "seismic";
+        default:
+            return "unknown";
+    }
+}
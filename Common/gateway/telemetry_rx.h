@@ -0,0 +1,119 @@
+/**
+ * @file    telemetry_rx.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Linux receiver for the Zero's end of the telemetry link. It reads
+ *          the bytes of the link from a file descriptor (a serial port, the
+ *          I2C slave's device, a pseudo terminal or a file), decodes the
+ *          frames of telemetry_frame.h and passes each new one on.
+ *
+ *          The sequence numbers are followed for each node: a frame with the
+ *          last one seen is a repeat the node sent again because its ack
+ *          was lost, and is dropped; a jump counts the frames lost between.
+ *          Sequence 0 after anything but 65535 is a node that started again.
+ *
+ *          Bytes that come some other way, a pigpio BSC transfer for
+ *          example, go in with telemetry_rx_feed().
+ *
+*/
+
+#ifndef TELEMETRY_RX_H
+#define TELEMETRY_RX_H
+
+// ################################# [ Includes ] #################################
+
+#include "telemetry_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Receiver of one link, any number of nodes can share it
+typedef struct
+{
+    int fd;
+    bool own_fd;                // Opened by telemetry_rx_open(), closed with it
+    telemetry_decoder_t decoder;
+
+    telemetry_frame_fn_t fn;
+    void *ctx;
+
+    // Last sequence number of each node byte, and which have been seen
+    uint16_t seq[256];
+    uint8_t seen[256 / 8];
+
+    uint64_t bytes;             // Bytes read
+    uint32_t frames;            // New frames passed on
+    uint32_t events;            // Events in them
+    uint32_t repeats;           // Frames dropped as repeats
+    uint32_t gaps;              // Frames missing from the sequence
+    uint32_t restarts;          // Nodes that started again
+} telemetry_rx_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up a receiver on a file descriptor that is already open, a
+ * terminal is put in raw mode
+ *
+ * @param rx The receiver
+ * @param fd The file descriptor, -1 for bytes from telemetry_rx_feed() only
+ * @param fn Called with each new frame
+ * @param ctx Passed to fn
+ */
+void telemetry_rx_init(telemetry_rx_t *rx, int fd, telemetry_frame_fn_t fn, void *ctx);
+
+/**
+ * @brief Opens a device or file and sets up a receiver on it
+ *
+ * @param rx The receiver
+ * @param path The device or file
+ * @param fn Called with each new frame
+ * @param ctx Passed to fn
+ * @return int 0 if successful -1 if it could not be opened, errno says why
+ */
+int telemetry_rx_open(telemetry_rx_t *rx, const char *path, telemetry_frame_fn_t fn, void *ctx);
+
+/**
+ * @brief Waits for bytes and decodes what comes
+ *
+ * @param rx The receiver
+ * @param timeout_ms Longest time to wait for the first byte, -1 for ever
+ * @return int The number of new frames, 0 on a timeout, -1 at the end of the
+ * stream or on an error
+ */
+int telemetry_rx_poll(telemetry_rx_t *rx, int timeout_ms);
+
+/**
+ * @brief Decodes bytes that came some other way
+ *
+ * @param rx The receiver
+ * @param src The bytes
+ * @param len The number of bytes
+ * @return int The number of new frames
+ */
+int telemetry_rx_feed(telemetry_rx_t *rx, const uint8_t *src, size_t len);
+
+/**
+ * @brief Closes the file descriptor if telemetry_rx_open() opened it
+ *
+ * @param rx The receiver
+ */
+void telemetry_rx_close(telemetry_rx_t *rx);
+
+/**
+ * @brief Gets a name for a node kind
+ *
+ * @param kind The kind, TELEMETRY_NODE_KIND() of a node byte
+ * @return const char* The name
+ */
+const char *telemetry_rx_kind_name(uint8_t kind);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_RX_H
@@ -0,0 +1,291 @@
+/**
+ * @file    telemetry_rx_main.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Prints the events coming over a telemetry link, one line each,
+ *          and the link counters at the end:
+ *
+ *            telemetry_rx [--captures <dir>] <device or file>
+ *            telemetry_rx [--captures <dir>] --pty
+ *
+ *          The pieces of a waveform capture are not printed, the capture is
+ *          put back together and gets one line once it is all in. The same
+ *          goes for a phase's timing statistics, which get two. With
+ *          --captures each one is also written to <dir> as
+ *          capture-<node>-<trigger ms>.bin, for capture_decode.
+ *
+ *          The evidence the nodes send goes into the site fusion, which has
+ *          every channel, so combined evidence can reach the site's raise
+ *          grade (FUSION_SITE_RAISE_GRADE) that no node reaches alone. An
+ *          alert it raises gets a [site] line. It runs on the Zero's own
+ *          clock, the nodes' clocks do not agree with each other.
+ *
+ *          With --pty it makes a pseudo terminal and prints its name, so a
+ *          host simulation of a node can be pointed at it to try both ends
+ *          of the link on one machine:
+ *
+ *            telemetry_rx --pty
+ *            LANDSLIDE_ZERO_LINK=/dev/pts/N LANDSLIDE_TRACE=... <firmware>
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#define _GNU_SOURCE
+
+#include "capture_rx.h"
+#include "fusion_config.h"
+#include "phase_stats.h"
+#include "telemetry_rx.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// ############################# [ Global Variables ] #############################
+
+static volatile sig_atomic_t rx_stop;
+
+// Captures being put back together, and where to keep them
+static capture_rx_t rx_captures;
+static const char *rx_capture_dir;
+
+// Phase statistics being put back together, for each node
+static phase_stats_rx_t rx_phases[256];
+
+// Names of the fusion grades an alert carries
+static const char *const rx_grades[] = { "none", "advisory", "watch", "warning" };
+
+// The evidence of every node, graded together
+static fusion_t rx_site;
+static const char *const rx_channels[] = { "rain", "soil", "seismic" };
+
+
+// ############################## [ Local Functions ] ##############################
+
+static void rx_signal(int sig)
+{
+    (void)sig;
+    rx_stop = 1;
+}
+
+static void rx_capture(void *ctx, uint8_t node, const uint8_t *capture, size_t len)
+{
+    (void)ctx;
+    waveform_header_t header;
+
+    waveform_header_decode(capture, len, &header);
+
+    printf("[node %u %-7s] capture of %u samples at %u Hz, %u before the trigger at %.3f s, "
+           "%zu bytes (%.1f%% of raw)%s\n", TELEMETRY_NODE_ID(node),
+           telemetry_rx_kind_name(TELEMETRY_NODE_KIND(node)), header.samples, header.rate_hz, header.pre,
+           header.trigger_ms / 1000.0, len, header.samples ? 100.0 * len / (header.samples * 6.0) : 0.0,
+           (header.flags & WAVEFORM_TRUNCATED) ? ", cut short" : "");
+
+    if (rx_capture_dir == NULL)
+    {
+        return;
+    }
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/capture-%u-%u.bin", rx_capture_dir, node, header.trigger_ms);
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL || fwrite(capture, 1, len, f) != len)
+    {
+        perror(path);
+    }
+
+    if (f != NULL)
+    {
+        fclose(f);
+    }
+}
+
+static uint32_t rx_now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec;
+}
+
+// Takes a node's evidence into the site fusion and prints the alert it raises
+static void rx_evidence(const telemetry_event_t *ev)
+{
+    uint32_t now_s = rx_now_s();
+    fusion_alert_t alert;
+
+    fusion_report(&rx_site, now_s, (fusion_channel_t)(ev->arg & 0x7F), (uint32_t)ev->value, (ev->arg & 0x80) != 0);
+    fusion_assess(&rx_site, now_s, &alert);
+
+    if (alert.raise)
+    {
+        printf("[site] %s, %u%% confidence (rain %u%%, soil %u%%, seismic %u%%)\n",
+               fusion_grade_name(alert.grade), alert.confidence, alert.evidence[FUSION_RAIN],
+               alert.evidence[FUSION_SOIL], alert.evidence[FUSION_SEISMIC]);
+    }
+}
+
+static void rx_print(void *ctx, const telemetry_frame_t *frame)
+{
+    (void)ctx;
+
+    capture_rx_frame(&rx_captures, frame);
+
+    for (uint8_t i = 0; i < frame->count; i++)
+    {
+        const telemetry_event_t *ev = &frame->events[i];
+        uint32_t value = (uint32_t)ev->value;
+
+        if (ev->type == TELEMETRY_CAPTURE)
+        {
+            continue;
+        }
+
+        if (ev->type == TELEMETRY_PHASE)
+        {
+            phase_stats_t stats;
+            int phase = phase_stats_take(&rx_phases[frame->node], ev, &stats);
+
+            if (phase >= 0)
+            {
+                char prefix[48];
+                snprintf(prefix, sizeof(prefix), "[node %u %-7s] phase ", TELEMETRY_NODE_ID(frame->node),
+                         telemetry_rx_kind_name(TELEMETRY_NODE_KIND(frame->node)));
+                phase_stats_print(stdout, prefix, (uint32_t)phase, &stats);
+            }
+
+            continue;
+        }
+
+        printf("[node %u %-7s] #%-5u %10.3f s  %-7s ", TELEMETRY_NODE_ID(frame->node),
+               telemetry_rx_kind_name(TELEMETRY_NODE_KIND(frame->node)), frame->seq,
+               ev->time_ms / 1000.0, telemetry_type_name(ev->type));
+
+        switch (ev->type)
+        {
+            case TELEMETRY_ALERT:
+                printf("%s, %u%% confidence (rain %u%%, soil %u%%, seismic %u%%)\n",
+                       ev->arg < 4 ? rx_grades[ev->arg] : "?", value & 0xFF,
+                       (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24);
+                break;
+            case TELEMETRY_RAIN:
+                printf("%d tips, windows over 0x%02x\n", ev->value, ev->arg);
+                break;
+            case TELEMETRY_SOIL:
+                printf("moisture %d\n", ev->value);
+                break;
+            case TELEMETRY_SEISMIC:
+                printf("peak %d mg, wake %u\n", ev->value, ev->arg);
+                break;
+            case TELEMETRY_LOST:
+                printf("%d events dropped\n", ev->value);
+                break;
+            case TELEMETRY_EVIDENCE:
+                printf("%s %d%%%s\n", (ev->arg & 0x7F) < FUSION_CHANNELS ? rx_channels[ev->arg & 0x7F] : "?",
+                       ev->value, (ev->arg & 0x80) ? ", at its threshold" : "");
+                rx_evidence(ev);
+                break;
+            default:
+                printf("arg %u value %d\n", ev->arg, ev->value);
+                break;
+        }
+    }
+
+    fflush(stdout);
+}
+
+// Makes a pseudo terminal in raw mode, returns its master end. The slave end
+// is kept open so the master does not see a hang up between writers.
+static int rx_open_pty(void)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        return -1;
+    }
+
+    const char *name = ptsname(master);
+    int slave = name != NULL ? open(name, O_RDWR | O_NOCTTY) : -1;
+    struct termios tio;
+
+    if (slave < 0 || tcgetattr(slave, &tio) != 0)
+    {
+        close(master);
+        return -1;
+    }
+
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    fprintf(stderr, "listening on %s\n", name);
+    return master;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int main(int argc, char **argv)
+{
+    telemetry_rx_t rx;
+
+    if (argc == 4 && strcmp(argv[1], "--captures") == 0)
+    {
+        rx_capture_dir = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s [--captures <dir>] <device or file> | --pty\n", argv[0]);
+        return 2;
+    }
+
+    capture_rx_init(&rx_captures, &rx_capture, NULL);
+
+    fusion_config_t site_config = FUSION_CONFIG;
+    site_config.raise = FUSION_SITE_RAISE_GRADE;
+    fusion_init(&rx_site, &site_config);
+
+    if (strcmp(argv[1], "--pty") == 0)
+    {
+        int fd = rx_open_pty();
+        if (fd < 0)
+        {
+            perror("pty");
+            return 1;
+        }
+
+        telemetry_rx_init(&rx, fd, &rx_print, NULL);
+    }
+    else if (telemetry_rx_open(&rx, argv[1], &rx_print, NULL) != 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    // Ctrl-C stops the wait so the counters still get printed
+    struct sigaction sa = { .sa_handler = &rx_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    while (!rx_stop && telemetry_rx_poll(&rx, -1) >= 0)
+    {
+    }
+
+    fprintf(stderr, "%llu bytes, %u frames, %u events, %u repeats, %u lost frames, %u restarts, "
+            "%u bad frames, %llu bytes skipped\n",
+            (unsigned long long)rx.bytes, rx.frames, rx.events, rx.repeats, rx.gaps, rx.restarts,
+            rx.decoder.crc_errors + rx.decoder.bad_headers, (unsigned long long)rx.decoder.skipped);
+    fprintf(stderr, "%u captures, %u broken\n", rx_captures.captures, rx_captures.broken);
+
+    telemetry_rx_close(&rx);
+    capture_rx_free(&rx_captures);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file    adxl343.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Register map and constants for the ADXL343 accelerometer, shared by
+ *          the seismic firmware and the host simulator.
+ *
+*/
+
+#ifndef ADXL343_H
+#define ADXL343_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// I2C address of the accelerometer with ALT ADDRESS low
+#define ADXL343_I2C_ADDR        0x53
+
+// Registers Locations on the accelerometer
+#define ADXL343_REG_DEVID         0x00
+#define ADXL343_REG_THRESH_ACT    0x24
+#define ADXL343_REG_THRESH_INACT  0x25
+#define ADXL343_REG_TIME_INACT    0x26
+#define ADXL343_REG_ACT_INACT_CTL 0x27
+#define ADXL343_REG_BW_RATE       0x2C
+#define ADXL343_REG_POWER_CTL     0x2D
+#define ADXL343_REG_INT_ENABLE    0x2E
+#define ADXL343_REG_INT_MAP       0x2F
+#define ADXL343_REG_INT_SOURCE    0x30
+#define ADXL343_REG_DATA_FORMAT   0x31
+#define ADXL343_REG_DATAX0        0x32
+#define ADXL343_REG_DATAZ1        0x37
+#define ADXL343_REG_FIFO_CTL      0x38
+#define ADXL343_REG_FIFO_STATUS   0x39
+
+// Value of the DEVID register
+#define ADXL343_DEVID           0xE5
+
+// Bits in POWER_CTL. With LINK set activity is only looked for after
+// inactivity and the other way round. AUTO_SLEEP, which needs LINK, drops
+// to the wake up rate in bits 1:0 once inactive, SLEEP drops to it now.
+#define ADXL343_POWER_CTL_LINK        (1 << 5)
+#define ADXL343_POWER_CTL_AUTO_SLEEP  (1 << 4)
+#define ADXL343_POWER_CTL_MEASURE     (1 << 3)
+#define ADXL343_POWER_CTL_SLEEP       (1 << 2)
+#define ADXL343_POWER_CTL_WAKEUP_MASK 0x03
+
+// Wake up rates in sleep
+#define ADXL343_WAKEUP_8HZ          0
+#define ADXL343_WAKEUP_4HZ          1
+#define ADXL343_WAKEUP_2HZ          2
+#define ADXL343_WAKEUP_1HZ          3
+#define ADXL343_WAKEUP_HZ(code)     (8 >> (code))
+
+// Low power bit in BW_RATE, for rates from 12.5 to 400 Hz
+#define ADXL343_BW_LOW_POWER        (1 << 4)
+
+// Bits in INT_ENABLE, INT_MAP and INT_SOURCE. A bit set in INT_MAP sends
+// that interrupt to the INT2 pin instead of INT1
+#define ADXL343_INT_DATA_READY      (1 << 7)
+#define ADXL343_INT_ACTIVITY        (1 << 4)
+#define ADXL343_INT_INACTIVITY      (1 << 3)
+#define ADXL343_INT_WATERMARK       (1 << 1)
+#define ADXL343_INT_OVERRUN         (1 << 0)
+
+// ACT_INACT_CTL fields. AC coupled activity compares each axis with where it
+// was when activity detection started, AC coupled inactivity with where it
+// last moved to, DC coupled both compare the acceleration itself
+#define ADXL343_ACT_AC              (1 << 7)
+#define ADXL343_ACT_XYZ             (7 << 4)
+#define ADXL343_INACT_AC            (1 << 3)
+#define ADXL343_INACT_XYZ           (7 << 0)
+
+// THRESH_ACT and THRESH_INACT count 62.5 mg, 16 LSB in the +-2 g range
+#define ADXL343_THRESH(mg)          ((uint8_t)(((mg) * 2 + 62) / 125))
+#define ADXL343_THRESH_LSB          16
+
+// FIFO_CTL fields, the mode in bits 7:6, the pin that triggers trigger mode
+// in bit 5 and the watermark (or samples kept before a trigger) in bits 4:0
+#define ADXL343_FIFO_BYPASS         (0 << 6)
+#define ADXL343_FIFO_FIFO           (1 << 6)
+#define ADXL343_FIFO_STREAM         (2 << 6)
+#define ADXL343_FIFO_TRIGGER        (3 << 6)
+#define ADXL343_FIFO_MODE_MASK      (3 << 6)
+#define ADXL343_FIFO_TRIGGER_INT2   (1 << 5)
+#define ADXL343_FIFO_SAMPLES_MASK   0x1F
+
+// FIFO_STATUS fields
+#define ADXL343_FIFO_STATUS_TRIG    (1 << 7)
+#define ADXL343_FIFO_ENTRIES_MASK   0x3F
+
+// Entries the FIFO holds
+#define ADXL343_FIFO_DEPTH          32
+
+// BW_RATE rate codes and the output data rate they give, 800 Hz is the
+// fastest rate the datasheet recommends with a 400 kHz I2C bus
+#define ADXL343_RATE_12HZ5      0x07
+#define ADXL343_RATE_100HZ      0x0A
+#define ADXL343_RATE_400HZ      0x0C
+#define ADXL343_RATE_800HZ      0x0D
+
+// Output data rate of a rate code from 6 (6.25 Hz, rounded down) to 15 (3200 Hz)
+#define ADXL343_RATE_HZ(code)   (3200 >> (15 - (code)))
+
+// Bytes in one x, y, z sample
+#define ADXL343_SAMPLE_BYTES    6
+
+// One x, y, z sample in LSB
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} adxl343_sample_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Converts the six data register bytes into a sample
+ *
+ * @param data DATAX0 to DATAZ1
+ * @param sample Filled in with the x, y, z values
+ */
+static inline void adxl343_unpack(const uint8_t *data, adxl343_sample_t *sample)
+{
+    sample->x = (int16_t)((data[1] << 8) | data[0]);
+    sample->y = (int16_t)((data[3] << 8) | data[2]);
+    sample->z = (int16_t)((data[5] << 8) | data[4]);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADXL343_H
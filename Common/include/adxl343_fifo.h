@@ -0,0 +1,120 @@
+/**
+ * @file    adxl343_fifo.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   FIFO acquisition engine for the ADXL343. The accelerometer fills
+ *          its own 32 entry FIFO at the output data rate in stream or trigger
+ *          mode and raises the watermark interrupt on INT1 once it holds
+ *          enough samples. The GPIO interrupt then empties the FIFO with a
+ *          single DMA job and the samples are handed to the core through a
+ *          ring buffer, so the core wakes once per watermark instead of once
+ *          per sample.
+ *
+ *          The ADXL343 pops one FIFO entry per read of DATAX0 to DATAZ1, so
+ *          on the wire each entry is still its own 6 byte read, but they all
+ *          go out back to back from one hal_i2c_read_dma_repeat() call.
+ *
+ *          The power manager (adxl343_power.h) starts measuring at the rate
+ *          wanted and goes back to the node's rest mode after, so it must
+ *          be set up first.
+ *
+*/
+
+#ifndef ADXL343_FIFO_H
+#define ADXL343_FIFO_H
+
+// ################################# [ Includes ] #################################
+
+#include "adxl343.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Samples the ring buffer holds, must be a power of two
+#define ADXL343_FIFO_RING_SIZE      64
+
+// Default watermark, emptying 28 entries at 400 kHz takes about 6 ms which is
+// under 5 new samples at 800 Hz, so the FIFO never fills while it is read
+#define ADXL343_FIFO_WATERMARK      28
+
+// How the engine sets up the accelerometer
+typedef struct
+{
+    uint8_t rate;           // BW_RATE rate code
+    uint8_t mode;           // ADXL343_FIFO_STREAM or ADXL343_FIFO_TRIGGER
+    uint8_t watermark;      // Entries read each time the watermark interrupt fires, 1 to 32
+    uint int_pin;           // Pico pin wired to INT1
+} adxl343_fifo_config_t;
+
+// Counters for the last acquisition
+typedef struct
+{
+    uint32_t samples;       // Samples read from the accelerometer, dropped ones too
+    uint32_t reads;         // DMA jobs used to read them
+    uint32_t overruns;      // Samples dropped because the ring buffer was full
+    uint64_t start_us;      // Time the acquisition was started
+    uint64_t end_us;        // Time the last sample was taken out of the ring
+} adxl343_fifo_stats_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the engine and puts the accelerometer in its rest mode until
+ * adxl343_fifo_start() is called
+ *
+ * @param i2c The I2C bus the accelerometer is on
+ * @param addr The address of the accelerometer
+ * @param config How to set up the FIFO
+ * @return int 1 if successful 0 if failed
+ */
+int adxl343_fifo_init(hal_i2c_t i2c, uint8_t addr, const adxl343_fifo_config_t *config);
+
+/**
+ * @brief Empties the FIFO, starts the accelerometer measuring and reads
+ * samples in the background until count have arrived
+ *
+ * @param count The number of samples to read
+ * @return int 1 if successful 0 if failed
+ */
+int adxl343_fifo_start(uint32_t count);
+
+/**
+ * @brief Takes the next sample out of the ring buffer, sleeping until one
+ * arrives. Puts the accelerometer back in its rest mode once every sample
+ * has been taken.
+ *
+ * @param sample Filled in with the sample
+ * @return true if there was a sample, false once the acquisition is over
+ */
+bool adxl343_fifo_next(adxl343_sample_t *sample);
+
+/**
+ * @brief Tells whether samples were dropped because the ring buffer was full
+ * just before the sample adxl343_fifo_next() last gave, or once it has
+ * returned false, after the last one it gave
+ *
+ * @return true if there is a hole in the timeline there
+ */
+bool adxl343_fifo_lost(void);
+
+/**
+ * @brief Ends the acquisition early and puts the accelerometer in its rest mode
+ */
+void adxl343_fifo_stop(void);
+
+/**
+ * @brief Gets the counters for the last acquisition
+ *
+ * @return const adxl343_fifo_stats_t* The counters
+ */
+const adxl343_fifo_stats_t *adxl343_fifo_stats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADXL343_FIFO_H
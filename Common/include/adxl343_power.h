@@ -0,0 +1,143 @@
+/**
+ * @file    adxl343_power.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Power manager for the ADXL343. The firmware moves the
+ *          accelerometer between three modes as its own state changes:
+ *
+ *            ADXL343_POWER_STANDBY   Not measuring, about 0.1 uA, for while
+ *                                    something else wakes the node
+ *            ADXL343_POWER_WATCH     Measuring at a low power rate and
+ *                                    looking for activity and inactivity,
+ *                                    linked. With auto sleep it drops to the
+ *                                    wake up rate once inactive, until the
+ *                                    next activity.
+ *            ADXL343_POWER_MEASURE   Measuring at a normal power rate with
+ *                                    the interrupts an acquisition wants
+ *
+ *          An acquisition ends with adxl343_power_rest(), which goes back to
+ *          the mode the node rests in. The manager keeps a copy of the
+ *          registers it writes and only sends those a change of mode alters.
+ *          THRESH_ACT to ACT_INACT_CTL go in one write and BW_RATE to INT_MAP
+ *          in another, in that order, so the thresholds are in place before
+ *          the part measures. Going into a mode it is already in costs
+ *          nothing. Leaving auto sleep passes through standby first, as the
+ *          datasheet asks. FIFO_CTL is left to the acquisition.
+ *
+*/
+
+#ifndef ADXL343_POWER_H
+#define ADXL343_POWER_H
+
+// ################################# [ Includes ] #################################
+
+#include "adxl343.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+typedef enum
+{
+    ADXL343_POWER_STANDBY,
+    ADXL343_POWER_WATCH,
+    ADXL343_POWER_MEASURE,
+    ADXL343_POWER_MODES
+} adxl343_power_mode_t;
+
+// How the manager sets up the accelerometer
+typedef struct
+{
+    adxl343_power_mode_t rest;  // Mode between acquisitions, STANDBY or WATCH
+    uint8_t watch_rate;         // BW_RATE rate code while watching, 12.5 to 400 Hz
+    uint8_t act_thresh;         // THRESH_ACT, see ADXL343_THRESH()
+    uint8_t inact_thresh;       // THRESH_INACT
+    uint8_t inact_s;            // TIME_INACT (s)
+    uint8_t act_inact_ctl;      // ACT_INACT_CTL
+    uint8_t watch_ints;         // Interrupts on INT1 while watching
+    bool auto_sleep;            // Drop to the wake up rate once inactive
+    uint8_t wakeup;             // ADXL343_WAKEUP_* rate in sleep
+} adxl343_power_config_t;
+
+// Counters since adxl343_power_init()
+typedef struct
+{
+    uint32_t changes[ADXL343_POWER_MODES];  // Times each mode was gone into
+    uint32_t writes;                        // I2C writes it took
+    uint32_t bytes;                         // Register bytes written
+    uint32_t failed;                        // Writes the part did not ack
+} adxl343_power_stats_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the manager and puts the accelerometer in standby with every
+ * register it manages written, the I2C bus must already be set up
+ *
+ * @param i2c The I2C bus the accelerometer is on
+ * @param addr The address of the accelerometer
+ * @param config How to set it up, copied
+ * @return int 1 if successful 0 if failed
+ */
+int adxl343_power_init(hal_i2c_t i2c, uint8_t addr, const adxl343_power_config_t *config);
+
+/**
+ * @brief Stops measuring with the interrupts off
+ *
+ * @return int 1 if successful 0 if failed
+ */
+int adxl343_power_standby(void);
+
+/**
+ * @brief Watches for activity and inactivity at the low power rate
+ *
+ * @return int 1 if successful 0 if failed
+ */
+int adxl343_power_watch(void);
+
+/**
+ * @brief Measures at a normal power rate
+ *
+ * @param rate BW_RATE rate code
+ * @param ints Interrupts on INT1
+ * @return int 1 if successful 0 if failed
+ */
+int adxl343_power_measure(uint8_t rate, uint8_t ints);
+
+/**
+ * @brief Goes back to the mode the node rests in between acquisitions
+ *
+ * @return int 1 if successful 0 if failed
+ */
+int adxl343_power_rest(void);
+
+/**
+ * @brief Gets the mode the accelerometer was last put in
+ *
+ * @return adxl343_power_mode_t The mode
+ */
+adxl343_power_mode_t adxl343_power_mode(void);
+
+/**
+ * @brief Gets the name of a mode
+ *
+ * @param mode The mode
+ * @return const char* The name
+ */
+const char *adxl343_power_mode_name(adxl343_power_mode_t mode);
+
+/**
+ * @brief Gets the counters since adxl343_power_init()
+ *
+ * @return const adxl343_power_stats_t* The counters
+ */
+const adxl343_power_stats_t *adxl343_power_stats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADXL343_POWER_H
@@ -0,0 +1,182 @@
+/**
+ * @file    bitpack.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Bit level writing and reading for the compact encodings of
+ *          waveform.h and sensor_codec.h. Bits go from the low bit of each
+ *          byte up. Values are zigzagged so small changes either way are
+ *          small numbers, and either packed at a fixed width or Rice coded:
+ *          the value shifted down by k in unary, then its low k bits. A
+ *          quotient of BITS_RICE_ESCAPE or more is written as that many ones,
+ *          the value's width less one in 5 bits and the value itself, so a
+ *          stray large value costs at most 53 bits instead of billions.
+ *
+ *          The reader stops at the end it is given and reads zeros past it,
+ *          setting over, so a broken stream can not run it off its buffer.
+ *
+*/
+
+#ifndef BITPACK_H
+#define BITPACK_H
+
+// ################################# [ Includes ] #################################
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+#define BITS_RICE_ESCAPE    16
+
+// Most bits a Rice coded value can take
+#define BITS_RICE_MAX       (BITS_RICE_ESCAPE + 5 + 32)
+
+typedef struct
+{
+    uint8_t *dst;
+    uint64_t acc;
+    uint32_t bits;
+} bits_writer_t;
+
+typedef struct
+{
+    const uint8_t *src;
+    const uint8_t *end;
+    uint64_t acc;
+    uint32_t bits;
+    bool over;                  // Read past the end
+} bits_reader_t;
+
+
+// ############################## [ Functions ] ####################################
+
+// 0, -1, 1, -2 ... to 0, 1, 2, 3 ...
+static inline uint32_t bits_zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t bits_unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Fewest bits that hold the value
+static inline uint32_t bits_width(uint32_t value)
+{
+    return value != 0 ? 32 - (uint32_t)__builtin_clz(value) : 0;
+}
+
+static inline void bits_writer_init(bits_writer_t *w, uint8_t *dst)
+{
+    w->dst = dst;
+    w->acc = 0;
+    w->bits = 0;
+}
+
+// Up to 32 bits at a time
+static inline void bits_write(bits_writer_t *w, uint32_t value, uint32_t width)
+{
+    w->acc |= (uint64_t)value << w->bits;
+    w->bits += width;
+
+    while (w->bits >= 8)
+    {
+        *w->dst++ = (uint8_t)w->acc;
+        w->acc >>= 8;
+        w->bits -= 8;
+    }
+}
+
+// Writes out the last part byte, returns the end of what was written
+static inline uint8_t *bits_flush(bits_writer_t *w)
+{
+    if (w->bits > 0)
+    {
+        *w->dst++ = (uint8_t)w->acc;
+        w->acc = 0;
+        w->bits = 0;
+    }
+
+    return w->dst;
+}
+
+static inline void bits_write_rice(bits_writer_t *w, uint32_t value, uint32_t k)
+{
+    uint32_t q = value >> k;
+
+    if (q < BITS_RICE_ESCAPE)
+    {
+        // q ones and a zero, then the low bits
+        bits_write(w, (1u << q) - 1, q + 1);
+        bits_write(w, value & ((1u << k) - 1), k);
+        return;
+    }
+
+    uint32_t width = bits_width(value);
+
+    bits_write(w, (1u << BITS_RICE_ESCAPE) - 1, BITS_RICE_ESCAPE);
+    bits_write(w, width - 1, 5);
+    bits_write(w, value, width);
+}
+
+static inline void bits_reader_init(bits_reader_t *r, const uint8_t *src, const uint8_t *end)
+{
+    r->src = src;
+    r->end = end;
+    r->acc = 0;
+    r->bits = 0;
+    r->over = false;
+}
+
+// Up to 32 bits at a time
+static inline uint32_t bits_read(bits_reader_t *r, uint32_t width)
+{
+    while (r->bits < width)
+    {
+        if (r->src < r->end)
+        {
+            r->acc |= (uint64_t)*r->src++ << r->bits;
+        }
+        else
+        {
+            r->over = true;
+        }
+
+        r->bits += 8;
+    }
+
+    uint32_t value = (uint32_t)(r->acc & ((1ull << width) - 1));
+    r->acc >>= width;
+    r->bits -= width;
+
+    return value;
+}
+
+static inline uint32_t bits_read_rice(bits_reader_t *r, uint32_t k)
+{
+    uint32_t q = 0;
+
+    while (q < BITS_RICE_ESCAPE && bits_read(r, 1))
+    {
+        q++;
+    }
+
+    if (q == BITS_RICE_ESCAPE)
+    {
+        return bits_read(r, bits_read(r, 5) + 1);
+    }
+
+    return (q << k) | bits_read(r, k);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITPACK_H
@@ -0,0 +1,145 @@
+/**
+ * @file    dlog_format.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Records of the deferred log (node_dlog.h) and the frames they go
+ *          over the uart in, with the table of formats both ends share. A
+ *          hot path logs a format's id and its arguments as 32 bit words,
+ *          the text is only made when the log is drained, on the node or by
+ *          the Zero's dlog_decode.
+ *
+ *          Each conversion in a format takes one word: %d %i as int32_t,
+ *          %u %x %o %c as uint32_t, %f %e %g as the bits of a float
+ *          (DLOG_F). A conversion with ll takes two words, the low one first
+ *          (DLOG_U64). %s has nothing to point at on the Zero and is not
+ *          allowed.
+ *
+ *          A binary frame, little endian:
+ *
+ *            0      1    DLOG_FRAME_START, which never appears in the text
+ *            1      1    format id
+ *            2      1    words of arguments, n
+ *            3      1    records lost just before this one, up to 255
+ *            4      4    hal_time_us_64() when it was logged, low 32 bits
+ *            8      4n   the arguments
+ *
+ *          A frame whose id or word count does not match the table is taken
+ *          as text, so a reader that joins part way through finds the next
+ *          frame. Nothing here uses the HAL, the Zero's tools build it as it
+ *          is.
+ *
+*/
+
+#ifndef DLOG_FORMAT_H
+#define DLOG_FORMAT_H
+
+// ################################# [ Includes ] #################################
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Every format the firmware logs, ids are never reused so old captures decode
+#define DLOG_FORMATS(X)                                                                                   \
+    X(DLOG_ACCEL,           "Acceleration: %f g\r\n")                                                     \
+    X(DLOG_SEISMIC_CHECK,   "Checked %lu samples in %lu reads, %llu us (%lu samples/s), peak %f g\r\n")   \
+    X(DLOG_SOIL_READING,    "[%llu.%03u] Soil Moisture: %d\r\n")                                         \
+    X(DLOG_SEISMIC_ACTIVITY, "Activity: %lu samples round it, peak %f g\r\n")                          \
+    X(DLOG_ACCEL_AXES,      "Acceleration: %d, %d, %d LSB\r\n")
+
+#define DLOG_ID(name, format)   name,
+
+typedef enum
+{
+    DLOG_FORMATS(DLOG_ID)
+    DLOG_NUM_FORMATS
+} dlog_id_t;
+
+#define DLOG_MAX_ARGS       6
+#define DLOG_FRAME_START    0x1E
+#define DLOG_FRAME_HEADER   8
+#define DLOG_FRAME_MAX      (DLOG_FRAME_HEADER + 4 * DLOG_MAX_ARGS)
+
+// A logged call
+typedef struct
+{
+    uint32_t time_us;
+    uint16_t id;
+    uint8_t nargs;
+    uint8_t lost;
+    uint32_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+// Arguments that are not a 32 bit integer
+#define DLOG_U64(x)     (uint32_t)(uint64_t)(x), (uint32_t)((uint64_t)(x) >> 32)
+#define DLOG_F(x)       dlog_float(x)
+
+static inline uint32_t dlog_float(float value)
+{
+    uint32_t word;
+    memcpy(&word, &value, sizeof(word));
+    return word;
+}
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Gets the format of an id
+ *
+ * @param id The id
+ * @return const char* The format, NULL if there is none
+ */
+const char *dlog_format_of(uint32_t id);
+
+/**
+ * @brief Counts the words of arguments a format takes
+ *
+ * @param format The format
+ * @return uint32_t The words
+ */
+uint32_t dlog_words(const char *format);
+
+/**
+ * @brief Makes the text of a record
+ *
+ * @param dst Where to write it, always terminated
+ * @param cap Bytes at dst
+ * @param record The record
+ * @return int The length of the text, -1 if the id is unknown or the words do
+ * not match its format
+ */
+int dlog_format(char *dst, size_t cap, const dlog_record_t *record);
+
+/**
+ * @brief Puts a record in a binary frame
+ *
+ * @param dst Where to write it, at least DLOG_FRAME_MAX bytes
+ * @param record The record
+ * @return size_t The length of the frame
+ */
+size_t dlog_frame_encode(uint8_t *dst, const dlog_record_t *record);
+
+/**
+ * @brief Reads a binary frame
+ *
+ * @param src Bytes from DLOG_FRAME_START on
+ * @param len Bytes at src
+ * @param record Set to the record
+ * @return int32_t The length of the frame, 0 if more bytes are needed, -1 if
+ * it is not a frame
+ */
+int32_t dlog_frame_decode(const uint8_t *src, size_t len, dlog_record_t *record);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DLOG_FORMAT_H
@@ -0,0 +1,158 @@
+/**
+ * @file    event_log.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Layout of the event log a node keeps in its flash (node_log.h),
+ *          and a reader for it. The log is a ring of 4 kB sectors, written
+ *          one after the other and erased one at a time as the ring comes
+ *          round, so every sector wears the same. Each sector starts with a
+ *          header and holds 255 records after it. All fields are little
+ *          endian:
+ *
+ *            header, slot 0 of a sector
+ *              0      4    magic, EVENT_LOG_MAGIC
+ *              4      4    sequence number, one more for each sector opened
+ *              8      4    times this sector has been erased
+ *             12      2    boot the sector was opened in
+ *             14      2    CRC-16/CCITT-FALSE of bytes 0 to 13
+ *
+ *            record, slots 1 to 255
+ *              0      1    type, telemetry_type_t
+ *              1      1    arg, as in telemetry_type_t
+ *              2      2    CRC-16/CCITT-FALSE of bytes 4 to 15 then 0 to 1
+ *              4      4    node time of the event (ms since its boot)
+ *              8      4    value, as in telemetry_type_t (the peak)
+ *             12      4    stat, a summary of what led to it
+ *
+ *          Erased flash reads 0xFF, so a slot of all 0xFF is free and the
+ *          first free slot of the newest sector is where the log carries on
+ *          after a reset. A record cut short by a reset fails its CRC and is
+ *          skipped, as is a sector whose erase was. A TELEMETRY_BOOT record
+ *          holds the boot number in its value, so every record can be put
+ *          in its boot.
+ *
+ *          Nothing here uses the HAL, the dump tool in Common/gateway builds
+ *          it as it is and reads images saved off the Pico's flash.
+ *
+*/
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+// ################################# [ Includes ] #################################
+
+#include "telemetry_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// "LSLG"
+#define EVENT_LOG_MAGIC         0x474C534Cu
+
+// A sector of the Pico's flash, and the slots in it
+#define EVENT_LOG_SECTOR_LEN    4096
+#define EVENT_LOG_RECORD_LEN    16
+#define EVENT_LOG_SLOTS         (EVENT_LOG_SECTOR_LEN / EVENT_LOG_RECORD_LEN)
+#define EVENT_LOG_RECORDS       (EVENT_LOG_SLOTS - 1)
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t erases;
+    uint16_t boot;
+} event_log_header_t;
+
+typedef struct
+{
+    uint8_t type;               // telemetry_type_t
+    uint8_t arg;
+    uint16_t boot;              // Not stored, the reader works it out
+    uint32_t time_ms;
+    int32_t value;
+    int32_t stat;
+} event_log_record_t;
+
+// Called by the reader with each record, oldest first
+typedef void (*event_log_fn_t)(void *ctx, const event_log_record_t *record);
+
+// What the reader found
+typedef struct
+{
+    uint32_t sectors;           // Sectors with a good header
+    uint32_t records;           // Records read
+    uint32_t torn;              // Slots that failed their CRC
+    uint32_t newest;            // Sector written last, UINT32_MAX if none
+    uint32_t newest_seq;        // Its sequence number
+    uint32_t next_slot;         // First free slot in it, EVENT_LOG_SLOTS if full
+    uint16_t boot;              // Boot of the last record
+    uint32_t min_erases;        // Of the sectors with a good header
+    uint32_t max_erases;
+} event_log_info_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Encodes a sector header
+ *
+ * @param dst Where to write it, EVENT_LOG_RECORD_LEN bytes
+ * @param header The header
+ */
+void event_log_encode_header(uint8_t *dst, const event_log_header_t *header);
+
+/**
+ * @brief Decodes a sector header
+ *
+ * @param src The first EVENT_LOG_RECORD_LEN bytes of the sector
+ * @param header Where to put it
+ * @return true If it is a header with a good CRC
+ */
+bool event_log_decode_header(const uint8_t *src, event_log_header_t *header);
+
+/**
+ * @brief Encodes a record, the boot is left out
+ *
+ * @param dst Where to write it, EVENT_LOG_RECORD_LEN bytes
+ * @param record The record
+ */
+void event_log_encode_record(uint8_t *dst, const event_log_record_t *record);
+
+/**
+ * @brief Decodes a record, leaving its boot as it is
+ *
+ * @param src The slot
+ * @param record Where to put it
+ * @return true If it is a record with a good CRC
+ */
+bool event_log_decode_record(const uint8_t *src, event_log_record_t *record);
+
+/**
+ * @brief Checks if a slot has never been written since its sector was erased
+ *
+ * @param src The slot
+ * @return true If every byte is 0xFF
+ */
+bool event_log_slot_free(const uint8_t *src);
+
+/**
+ * @brief Reads the log out of a region of flash, oldest record first.
+ * Sectors without a good header are skipped, so the region can be the whole
+ * flash with the firmware in it.
+ *
+ * @param region The region, a whole number of sectors
+ * @param len Its length
+ * @param fn Called with each record, NULL to only fill in info
+ * @param ctx Passed to fn
+ * @param info Where to put what was found
+ * @return uint32_t The number of records
+ */
+uint32_t event_log_scan(const uint8_t *region, size_t len, event_log_fn_t fn, void *ctx, event_log_info_t *info);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_LOG_H
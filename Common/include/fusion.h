@@ -0,0 +1,197 @@
+/**
+ * @file    fusion.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Combines the rain, soil and seismic evidence into one graded
+ *          landslide alert with a confidence, instead of each sensor
+ *          deciding alone. The state is a few words per site: the rain
+ *          windows' level, the moisture and its trend, and vibration energy
+ *          that fades with a half life. Each channel gives an evidence level
+ *          from 0 to 100 %, 100 % being the sensor's own warning threshold,
+ *          and they are combined as a noisy OR:
+ *
+ *            confidence = 1 - (1 - w_rain e_rain)(1 - w_soil e_soil)(1 - w_seismic e_seismic)
+ *
+ *          With every weight under the WARNING confidence one sensor on its
+ *          own tops out at WATCH, so only combined evidence reaches WARNING.
+ *          A node only has its own sensor, so WARNING is graded where the
+ *          evidence meets: each node sends the evidence of its channel
+ *          (TELEMETRY_EVIDENCE), and the Zero's site fusion takes it in with
+ *          fusion_report() in place of the readings. Reported seismic
+ *          evidence goes on fading with the half life from when it came.
+ *
+ *          An alert is raised when the grade reaches the raise grade, goes
+ *          up from there, or a sensor reaches its own threshold again (the
+ *          moisture or a rain window going back over, another check over
+ *          it). Every
+ *          call is O(1) with integers only, and nothing is allocated.
+ *
+ *          The soil evidence is the moisture between dry and full, plus half
+ *          of its rise per hour over trend_full. The seismic evidence is the
+ *          energy of the checks' dynamic peaks (mg^2) over that of one peak
+ *          at full_mg. The rain evidence is passed in by the rain node, the
+ *          largest of its windows' depth over their thresholds.
+ *
+*/
+
+#ifndef FUSION_H
+#define FUSION_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Evidence channels
+typedef enum
+{
+    FUSION_RAIN,
+    FUSION_SOIL,
+    FUSION_SEISMIC,
+    FUSION_CHANNELS
+} fusion_channel_t;
+
+// Alert grades, in order
+typedef enum
+{
+    FUSION_NONE,
+    FUSION_ADVISORY,            // Some evidence
+    FUSION_WATCH,               // One sensor at its threshold
+    FUSION_WARNING,             // Combined evidence
+    FUSION_GRADES
+} fusion_grade_t;
+
+// Weights and scales
+typedef struct
+{
+    uint8_t weight[FUSION_CHANNELS];    // Confidence of each channel at 100 % alone (%)
+    uint8_t grade[FUSION_GRADES];       // Confidence each grade starts at (%), grade[0] unused
+
+    int16_t soil_dry;                   // Moisture the soil evidence starts from
+    int16_t soil_full;                  // Moisture giving 100 %
+    uint16_t soil_trend_full;           // Rise per hour adding 50 %
+    uint32_t soil_trend_min_s;          // Shortest time a rise is measured over
+
+    uint16_t seismic_full_mg;           // Dynamic peak giving 100 % in one check
+    uint32_t seismic_half_s;            // Half life of the vibration energy
+
+    fusion_grade_t raise;               // Grade an alert is raised at
+} fusion_config_t;
+
+// Risk state of a site
+typedef struct
+{
+    fusion_config_t config;
+    uint32_t seismic_full;              // Energy of one check at seismic_full_mg
+
+    uint8_t rain_pct;                   // Last rain evidence
+    uint32_t rain_over;                 // Windows over their threshold with it
+
+    int16_t moisture;                   // Last reading
+    int16_t trend_moisture;             // Reading the trend was last measured from
+    uint32_t trend_s;                   // And when
+    int32_t trend;                      // Smoothed rise per hour
+    bool soil_seen;
+    bool soil_armed;                    // Going over 100 % is new again
+
+    uint32_t energy;                    // Vibration energy at energy_s
+    uint32_t energy_s;
+
+    uint8_t fresh;                      // Channels that reached 100 % since the last assessment
+    fusion_grade_t raised;              // Highest grade raised since it was last under the raise grade
+
+    uint8_t reported;                   // Channels whose evidence a node reports, one bit each
+    uint8_t report_pct[FUSION_CHANNELS];
+    uint32_t report_s[FUSION_CHANNELS]; // When it was reported
+} fusion_t;
+
+// An assessment
+typedef struct
+{
+    fusion_grade_t grade;
+    uint8_t confidence;                 // %
+    uint8_t evidence[FUSION_CHANNELS];  // %
+    uint8_t channels;                   // Channels with any evidence
+    uint8_t fresh;                      // Channels that reached 100 % since the last assessment, one bit each
+    bool raise;                         // The alert should be sent to the Zero
+} fusion_alert_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up a risk state with no evidence
+ *
+ * @param fusion The state
+ * @param config Weights and scales
+ * @return int 1 if successful 0 if the config is not usable
+ */
+int fusion_init(fusion_t *fusion, const fusion_config_t *config);
+
+/**
+ * @brief Sets the rain evidence
+ *
+ * @param fusion The state
+ * @param pct The largest of the rain windows' depth over their threshold (%)
+ * @param over The windows over their threshold, one bit each
+ */
+void fusion_rain(fusion_t *fusion, uint32_t pct, uint32_t over);
+
+/**
+ * @brief Adds a soil moisture reading
+ *
+ * @param fusion The state
+ * @param now_s Time of the reading
+ * @param moisture The reading
+ */
+void fusion_soil(fusion_t *fusion, uint32_t now_s, int moisture);
+
+/**
+ * @brief Adds the result of a seismic check
+ *
+ * @param fusion The state
+ * @param now_s Time of the check
+ * @param peak_mg Largest acceleration seen with gravity taken off (mg)
+ */
+void fusion_seismic(fusion_t *fusion, uint32_t now_s, uint32_t peak_mg);
+
+/**
+ * @brief Sets a channel's evidence to what the node that has the sensor
+ * worked out, the channel's readings are not used from then on
+ *
+ * @param fusion The state
+ * @param now_s Time it came
+ * @param channel The channel
+ * @param pct The evidence (%)
+ * @param fresh The sensor has just reached its own threshold
+ */
+void fusion_report(fusion_t *fusion, uint32_t now_s, fusion_channel_t channel, uint32_t pct, bool fresh);
+
+/**
+ * @brief Grades the evidence as it is now
+ *
+ * @param fusion The state
+ * @param now_s The time
+ * @param alert Filled in with the grade, confidence and evidence
+ * @return fusion_grade_t The grade
+ */
+fusion_grade_t fusion_assess(fusion_t *fusion, uint32_t now_s, fusion_alert_t *alert);
+
+/**
+ * @brief Gets a name for a grade
+ *
+ * @param grade The grade
+ * @return const char* The name
+ */
+const char *fusion_grade_name(fusion_grade_t grade);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSION_H
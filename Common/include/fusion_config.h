@@ -0,0 +1,157 @@
+/**
+ * @file    fusion_config.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Build time configuration of the evidence fusion (fusion.h): the
+ *          weight of each sensor, the confidence of each alert grade and the
+ *          grade that raises an alert. The sensor scales default to the
+ *          node types' own thresholds, so 100 % evidence is where each node
+ *          used to warn on its own.
+ *
+ *          A node only sees its own sensor, which on its own reaches WATCH,
+ *          so alerts are raised from WATCH and every node warns where it did
+ *          before. The evidence of all three meets in the Zero's site fusion
+ *          (telemetry_rx), which raises from FUSION_SITE_RAISE_GRADE, WARNING
+ *          by default. Both raise grades are checked at build time against
+ *          the confidence the weights can reach where they are graded.
+ *
+*/
+
+#ifndef FUSION_CONFIG_H
+#define FUSION_CONFIG_H
+
+// ################################# [ Includes ] #################################
+
+#include "node_config.h"
+#include "soil_config.h"
+#include "seismic_config.h"
+#include "fusion.h"
+
+// ################################## [ Types ] ###################################
+
+// ---------------------------- [ Weights ] ----------------------------
+
+// Confidence each sensor gives at 100 % evidence on its own (%)
+#ifndef FUSION_RAIN_WEIGHT
+#define FUSION_RAIN_WEIGHT          60
+#endif
+
+#ifndef FUSION_SOIL_WEIGHT
+#define FUSION_SOIL_WEIGHT          60
+#endif
+
+#ifndef FUSION_SEISMIC_WEIGHT
+#define FUSION_SEISMIC_WEIGHT       60
+#endif
+
+// ---------------------------- [ Grades ] -----------------------------
+
+// Confidence each grade starts at (%)
+#ifndef FUSION_ADVISORY_PCT
+#define FUSION_ADVISORY_PCT         20
+#endif
+
+#ifndef FUSION_WATCH_PCT
+#define FUSION_WATCH_PCT            60
+#endif
+
+#ifndef FUSION_WARNING_PCT
+#define FUSION_WARNING_PCT          80
+#endif
+
+// Grade an alert is sent to the Zero at
+#ifndef FUSION_RAISE_GRADE
+#define FUSION_RAISE_GRADE          FUSION_WATCH
+#endif
+
+// Grade the Zero's site fusion, which has every channel, raises at
+#ifndef FUSION_SITE_RAISE_GRADE
+#define FUSION_SITE_RAISE_GRADE     FUSION_WARNING
+#endif
+
+// ---------------------------- [ Soil ] -------------------------------
+
+// Moisture the soil evidence starts from and the one giving 100 %
+#ifndef FUSION_SOIL_DRY
+#define FUSION_SOIL_DRY             30
+#endif
+
+#ifndef FUSION_SOIL_FULL
+#define FUSION_SOIL_FULL            (SOIL_MOISTURE_THRESHOLD + 1)
+#endif
+
+// Moisture rise per hour that adds 50 %, and the shortest time it is
+// measured over (s)
+#ifndef FUSION_SOIL_TREND_FULL
+#define FUSION_SOIL_TREND_FULL      5
+#endif
+
+#ifndef FUSION_SOIL_TREND_MIN_S
+#define FUSION_SOIL_TREND_MIN_S     3600
+#endif
+
+// ---------------------------- [ Seismic ] ----------------------------
+
+// Dynamic peak of one check giving 100 %, the threshold less gravity (mg)
+#ifndef FUSION_SEISMIC_FULL_MG
+#define FUSION_SEISMIC_FULL_MG      (SEISMIC_THRESHOLD_MG - 1000)
+#endif
+
+// Half life of the vibration energy (s)
+#ifndef FUSION_SEISMIC_HALF_S
+#define FUSION_SEISMIC_HALF_S       600
+#endif
+
+// Initialiser for a fusion_config_t
+#define FUSION_CONFIG {                                                         \
+    .weight = { FUSION_RAIN_WEIGHT, FUSION_SOIL_WEIGHT, FUSION_SEISMIC_WEIGHT },\
+    .grade = { 0, FUSION_ADVISORY_PCT, FUSION_WATCH_PCT, FUSION_WARNING_PCT },  \
+    .soil_dry = FUSION_SOIL_DRY,                                                \
+    .soil_full = FUSION_SOIL_FULL,                                              \
+    .soil_trend_full = FUSION_SOIL_TREND_FULL,                                  \
+    .soil_trend_min_s = FUSION_SOIL_TREND_MIN_S,                                \
+    .seismic_full_mg = FUSION_SEISMIC_FULL_MG,                                  \
+    .seismic_half_s = FUSION_SEISMIC_HALF_S,                                    \
+    .raise = FUSION_RAISE_GRADE                                                 \
+}
+
+// ---------------------------- [ Checks ] -----------------------------
+
+#if FUSION_RAIN_WEIGHT > 100 || FUSION_SOIL_WEIGHT > 100 || FUSION_SEISMIC_WEIGHT > 100
+#error "The fusion weights must be at most 100"
+#endif
+
+#if FUSION_ADVISORY_PCT < 1 || FUSION_WATCH_PCT <= FUSION_ADVISORY_PCT || \
+    FUSION_WARNING_PCT <= FUSION_WATCH_PCT || FUSION_WARNING_PCT > 100
+#error "The fusion grades must go up from 1 to 100"
+#endif
+
+#if FUSION_SOIL_FULL <= FUSION_SOIL_DRY
+#error "FUSION_SOIL_FULL must be over FUSION_SOIL_DRY"
+#endif
+
+#if FUSION_SOIL_TREND_FULL < 1 || FUSION_SEISMIC_FULL_MG < 1 || FUSION_SEISMIC_HALF_S < 1
+#error "The fusion scales must be at least 1"
+#endif
+
+// Confidence a grade starts at (%)
+#define FUSION_GRADE_PCT(grade)                                                 \
+    ((grade) == FUSION_WARNING ? FUSION_WARNING_PCT :                           \
+     (grade) == FUSION_WATCH ? FUSION_WATCH_PCT :                               \
+     (grade) == FUSION_ADVISORY ? FUSION_ADVISORY_PCT : 0)
+
+// Confidence three channels at 100 % reach, rounded as fusion_assess() does (%)
+#define FUSION_REACH_PCT(a, b, c)                                               \
+    ((10000 - 10000 * (100 - (a)) / 100 * (100 - (b)) / 100 * (100 - (c)) / 100) / 100)
+
+// The raise grades are enums, so they are checked by the compiler rather
+// than the preprocessor. A node only has its own channel
+_Static_assert(FUSION_RAIN_WEIGHT >= FUSION_GRADE_PCT(FUSION_RAISE_GRADE) &&
+               FUSION_SOIL_WEIGHT >= FUSION_GRADE_PCT(FUSION_RAISE_GRADE) &&
+               FUSION_SEISMIC_WEIGHT >= FUSION_GRADE_PCT(FUSION_RAISE_GRADE),
+               "A node's own channel can not reach FUSION_RAISE_GRADE");
+
+_Static_assert(FUSION_REACH_PCT(FUSION_RAIN_WEIGHT, FUSION_SOIL_WEIGHT, FUSION_SEISMIC_WEIGHT) >=
+               FUSION_GRADE_PCT(FUSION_SITE_RAISE_GRADE),
+               "The channels together can not reach FUSION_SITE_RAISE_GRADE");
+
+#endif // FUSION_CONFIG_H
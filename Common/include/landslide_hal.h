@@ -0,0 +1,560 @@
+/**
+ * @file    landslide_hal.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Hardware abstraction layer shared by every sensor node firmware.
+ *          It wraps the parts of the Pico SDK that the subsystems use (GPIO,
+ *          I2C, UART, sleep, RTC, the timer, a PIO pulse counter and the
+ *          flash) so that
+ *          the same firmware can be built for the Pi Pico or for a Linux host.
+ *
+ *          The backend is chosen at build time with the LANDSLIDE_HAL_BACKEND
+ *          CMake option which defines either LANDSLIDE_HAL_BACKEND_PICO or
+ *          LANDSLIDE_HAL_BACKEND_HOST. The host backend runs the firmware
+ *          against a simulated board driven by a scripted sensor trace, see
+ *          hal_host.h.
+ *
+*/
+
+#ifndef LANDSLIDE_HAL_H
+#define LANDSLIDE_HAL_H
+
+// ################################# [ Includes ] #################################
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+#ifdef LANDSLIDE_HAL_BACKEND_PICO
+#include "pico/types.h"
+#else
+typedef unsigned int uint;
+#endif
+
+// Bus numbers, these map onto i2c0/i2c1 and uart0/uart1 on the Pico
+typedef uint hal_i2c_t;
+typedef uint hal_uart_t;
+
+#define HAL_I2C0    0
+#define HAL_I2C1    1
+#define HAL_UART0   0
+#define HAL_UART1   1
+
+// Error codes returned by the bus functions, same values as the Pico SDK
+#define HAL_ERROR_GENERIC   -1
+#define HAL_ERROR_TIMEOUT   -2
+
+// GPIO directions and functions
+#define HAL_GPIO_IN     false
+#define HAL_GPIO_OUT    true
+
+// GPIO edges that can raise an interrupt, can be or'ed together
+#define HAL_GPIO_EDGE_RISE  1
+#define HAL_GPIO_EDGE_FALL  2
+
+typedef enum
+{
+    HAL_GPIO_FUNC_I2C,
+    HAL_GPIO_FUNC_UART,
+    HAL_GPIO_FUNC_SIO
+} hal_gpio_function_t;
+
+// Date and time held by the RTC, same layout as the Pico SDK datetime_t
+typedef struct
+{
+    int16_t year;   // 0..4095
+    int8_t month;   // 1..12
+    int8_t day;     // 1..28,29,30,31 depending on month
+    int8_t dotw;    // 0..6, 0 is Sunday
+    int8_t hour;    // 0..23
+    int8_t min;     // 0..59
+    int8_t sec;     // 0..59
+} hal_datetime_t;
+
+// Function called when the RTC alarm wakes the Pico from sleep
+typedef void (*hal_rtc_callback_t)(void);
+
+// Function called from an interrupt handler by the timers and DMA reads
+typedef void (*hal_irq_callback_t)(void *ctx);
+
+// Number of periodic timers that can run at once
+#define HAL_NUM_TIMERS  4
+
+// Most bytes a background I2C read can move, enough for the 32 entry FIFO of
+// the ADXL343
+#define HAL_I2C_DMA_MAX_LEN 192
+
+// The Pico's 2 MB QSPI flash: erased a 4 kB sector at a time, programmed a
+// 256 byte page at a time
+#define HAL_FLASH_SIZE          (2 * 1024 * 1024)
+#define HAL_FLASH_SECTOR_SIZE   4096
+#define HAL_FLASH_PAGE_SIZE     256
+
+// How a PIO state machine joins its FIFOs, same values as the Pico SDK
+#define HAL_PIO_FIFO_JOIN_NONE  0
+#define HAL_PIO_FIFO_JOIN_TX    1
+#define HAL_PIO_FIFO_JOIN_RX    2
+
+// The pulse counter's join. Its threshold goes in through the tx FIFO, which
+// a join to rx switches off, and rx only ever holds one count.
+#define HAL_PULSE_COUNTER_FIFO_JOIN HAL_PIO_FIFO_JOIN_NONE
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+// ---------------------------------- [ stdio ] ----------------------------------
+
+/**
+ * @brief Initialises stdio (usb and uart) on the Pico. On the host this loads
+ * the sensor trace named by the LANDSLIDE_TRACE environment variable.
+ */
+void hal_stdio_init(void);
+
+/**
+ * @brief Blocks until everything printed so far has been sent over the
+ * default uart, replaces uart_default_tx_wait_blocking()
+ */
+void hal_stdio_flush(void);
+
+/**
+ * @brief Sends bytes over stdio as they are, without the \n to \r\n
+ * translation printf gets
+ *
+ * @param src The bytes
+ * @param len How many
+ */
+void hal_stdio_write_raw(const uint8_t *src, size_t len);
+
+// ---------------------------------- [ GPIO ] -----------------------------------
+
+/**
+ * @brief Initialises a GPIO pin as an input driven low
+ *
+ * @param pin The GPIO pin number
+ */
+void hal_gpio_init(uint pin);
+
+/**
+ * @brief Sets the direction of a GPIO pin
+ *
+ * @param pin The GPIO pin number
+ * @param out HAL_GPIO_OUT for an output, HAL_GPIO_IN for an input
+ */
+void hal_gpio_set_dir(uint pin, bool out);
+
+/**
+ * @brief Hands a GPIO pin to one of the peripherals
+ *
+ * @param pin The GPIO pin number
+ * @param fn The peripheral function to use
+ */
+void hal_gpio_set_function(uint pin, hal_gpio_function_t fn);
+
+/**
+ * @brief Drives a GPIO output pin
+ *
+ * @param pin The GPIO pin number
+ * @param value 1 for high 0 for low
+ */
+void hal_gpio_put(uint pin, bool value);
+
+/**
+ * @brief Reads the level of a GPIO pin
+ *
+ * @param pin The GPIO pin number
+ * @return true if the pin is high false if it is low
+ */
+bool hal_gpio_get(uint pin);
+
+/**
+ * @brief Calls a function from the GPIO interrupt when a pin changes level
+ *
+ * @param pin The GPIO pin number
+ * @param edges HAL_GPIO_EDGE_RISE and/or HAL_GPIO_EDGE_FALL, 0 to disable
+ * @param callback The function to call
+ * @param ctx Passed to the function
+ */
+void hal_gpio_set_irq(uint pin, uint edges, hal_irq_callback_t callback, void *ctx);
+
+// ----------------------------------- [ I2C ] -----------------------------------
+
+/**
+ * @brief Initialises an I2C bus
+ *
+ * @param i2c The bus to initialise, HAL_I2C0 or HAL_I2C1
+ * @param baudrate The bus speed in Hz
+ */
+void hal_i2c_init(hal_i2c_t i2c, uint baudrate);
+
+/**
+ * @brief Writes bytes to a device on the I2C bus
+ *
+ * @param i2c The bus to use
+ * @param addr The 7 bit address of the device
+ * @param src The bytes to send
+ * @param len The number of bytes to send
+ * @param nostop true to keep control of the bus for a following read
+ * @return int the number of bytes written or HAL_ERROR_GENERIC
+ */
+int hal_i2c_write_blocking(hal_i2c_t i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+
+/**
+ * @brief Same as hal_i2c_write_blocking() but gives up once the write has
+ * taken a time, so a device holding the bus can not hang the Pico
+ *
+ * @param i2c The bus to use
+ * @param addr The 7 bit address of the device
+ * @param src The bytes to send
+ * @param len The number of bytes to send
+ * @param nostop true to keep control of the bus for a following read
+ * @param timeout_us The longest the write may take in microseconds
+ * @return int the number of bytes written, HAL_ERROR_GENERIC or
+ * HAL_ERROR_TIMEOUT
+ */
+int hal_i2c_write_timeout_us(hal_i2c_t i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop,
+                             uint timeout_us);
+
+/**
+ * @brief Reads bytes from a device on the I2C bus
+ *
+ * @param i2c The bus to use
+ * @param addr The 7 bit address of the device
+ * @param dst The buffer to read into
+ * @param len The number of bytes to read
+ * @param nostop true to keep control of the bus for a following transfer
+ * @return int the number of bytes read or HAL_ERROR_GENERIC
+ */
+int hal_i2c_read_blocking(hal_i2c_t i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+/**
+ * @brief Starts a register read from a device on the I2C bus that runs in the
+ * background using DMA. The register address is written then len bytes are
+ * read into dst, and the callback is called from the DMA interrupt when they
+ * have arrived. Only one background read can run at a time.
+ *
+ * @param i2c The bus to use
+ * @param addr The 7 bit address of the device
+ * @param reg The register to start reading from
+ * @param dst The buffer to read into, must stay valid until the callback
+ * @param len The number of bytes to read, at most HAL_I2C_DMA_MAX_LEN
+ * @param callback Called from the interrupt handler when the read is done
+ * @param ctx Passed to the callback
+ * @return true if the read was started, false if one is already running
+ */
+bool hal_i2c_read_dma(hal_i2c_t i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                      hal_irq_callback_t callback, void *ctx);
+
+/**
+ * @brief Same as hal_i2c_read_dma() but repeats the register read a number of
+ * times, each one its own transaction, and packs the results one after the
+ * other into dst. Used to empty a sensor FIFO that pops one entry per read of
+ * its data registers with a single DMA job.
+ *
+ * @param i2c The bus to use
+ * @param addr The 7 bit address of the device
+ * @param reg The register each read starts from
+ * @param dst The buffer to read into, must stay valid until the callback
+ * @param len The number of bytes in each read
+ * @param count The number of reads, len * count at most HAL_I2C_DMA_MAX_LEN
+ * @param callback Called from the interrupt handler when the last read is done
+ * @param ctx Passed to the callback
+ * @return true if the reads were started, false if one is already running
+ */
+bool hal_i2c_read_dma_repeat(hal_i2c_t i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                             size_t count, hal_irq_callback_t callback, void *ctx);
+
+// ----------------------------------- [ UART ] ----------------------------------
+
+/**
+ * @brief Initialises a UART bus
+ *
+ * @param uart The bus to initialise, HAL_UART0 or HAL_UART1
+ * @param baudrate The bus speed in baud
+ */
+void hal_uart_init(hal_uart_t uart, uint baudrate);
+
+/**
+ * @brief Sends a single byte over a UART bus without any translation
+ *
+ * @param uart The bus to use
+ * @param c The byte to send
+ */
+void hal_uart_putc_raw(hal_uart_t uart, char c);
+
+/**
+ * @brief Waits for and reads a single byte from a UART bus
+ *
+ * @param uart The bus to use
+ * @return char The byte received
+ */
+char hal_uart_getc(hal_uart_t uart);
+
+/**
+ * @brief Checks if there is a byte waiting on a UART bus
+ *
+ * @param uart The bus to use
+ * @return true if hal_uart_getc() will return straight away
+ */
+bool hal_uart_is_readable(hal_uart_t uart);
+
+/**
+ * @brief Calls a function from the UART interrupt when received bytes are
+ * waiting, the function should read every one of them with hal_uart_getc()
+ *
+ * @param uart The bus to use
+ * @param callback The function to call, NULL to turn the interrupt off
+ * @param ctx Passed to the function
+ */
+void hal_uart_set_irq(hal_uart_t uart, hal_irq_callback_t callback, void *ctx);
+
+// ------------------------------- [ Sleep / Time ] ------------------------------
+
+/**
+ * @brief Waits for a number of milliseconds, letting the core idle
+ *
+ * @param ms The number of milliseconds to wait
+ */
+void hal_sleep_ms(uint32_t ms);
+
+/**
+ * @brief Waits for a number of milliseconds with the core spinning, safe to
+ * use inside interrupt handlers
+ *
+ * @param ms The number of milliseconds to wait
+ */
+void hal_busy_wait_ms(uint32_t ms);
+
+/**
+ * @brief Waits for a number of milliseconds using hal_sleep_ms() or, when
+ * called from an interrupt handler, hal_busy_wait_ms()
+ *
+ * @param ms The number of milliseconds to wait
+ */
+void hal_wait_ms(uint32_t ms);
+
+/**
+ * @brief Checks if the code is running inside an interrupt handler
+ *
+ * @return true if called from an interrupt handler
+ */
+bool hal_in_irq(void);
+
+/**
+ * @brief Gets the time since boot
+ *
+ * @return uint64_t The time since boot in microseconds
+ */
+uint64_t hal_time_us_64(void);
+
+/**
+ * @brief Waits with the core idling until hal_time_us_64() reaches a time
+ *
+ * @param us The time since boot to wait for, in microseconds
+ */
+void hal_sleep_until_us(uint64_t us);
+
+/**
+ * @brief Waits with the core idling until the next interrupt
+ */
+void hal_wfi(void);
+
+/**
+ * @brief Starts a timer that calls a function from its interrupt handler
+ * every period_us microseconds
+ *
+ * @param period_us The time between calls
+ * @param callback The function to call
+ * @param ctx Passed to the function
+ * @return int The timer number for hal_timer_stop() or -1 if all timers are
+ * in use
+ */
+int hal_timer_start(uint32_t period_us, hal_irq_callback_t callback, void *ctx);
+
+/**
+ * @brief Stops a timer started with hal_timer_start()
+ *
+ * @param timer The timer number
+ */
+void hal_timer_stop(int timer);
+
+/**
+ * @brief Switches the clocks to the crystal oscillator so the Pico can go
+ * into dormant or sleep mode
+ */
+void hal_sleep_run_from_xosc(void);
+
+/**
+ * @brief Puts the Pico into dormant mode until a GPIO pin goes high
+ *
+ * @param pin The pin to wake up on
+ */
+void hal_sleep_goto_dormant_until_level_high(uint pin);
+
+/**
+ * @brief Puts the Pico into dormant mode until a GPIO pin goes from low to
+ * high, a pin already high does not wake it
+ *
+ * @param pin The pin to wake up on
+ */
+void hal_sleep_goto_dormant_until_edge_high(uint pin);
+
+/**
+ * @brief Puts the Pico to sleep until the RTC reaches the given time, then
+ * calls the callback
+ *
+ * @param alarm The time to wake up at
+ * @param callback The function to call on wake up
+ */
+void hal_sleep_goto_sleep_until(const hal_datetime_t *alarm, hal_rtc_callback_t callback);
+
+/**
+ * @brief Puts the Pico to sleep until the RTC reaches the given time or an
+ * interrupt comes. Unlike hal_sleep_goto_sleep_until() the GPIO and PIO
+ * clocks keep running, so the pulse counter keeps counting and it or a pin
+ * interrupt wakes the Pico. The timer stops as in any sleep.
+ *
+ * The flag is checked with interrupts off just before the Pico sleeps, so an
+ * interrupt that sets it after the caller last looked still wakes it at
+ * once instead of at the alarm.
+ *
+ * @param alarm The time to wake up at
+ * @param woken Set from the interrupt the caller waits for, or NULL
+ * @return true if the alarm woke it, false if another interrupt did or the
+ * flag was already set
+ */
+bool hal_sleep_goto_sleep_until_irq(const hal_datetime_t *alarm, const volatile bool *woken);
+
+/**
+ * @brief Gets the time the timer counted across the last dormant or sleep
+ * wait. The timer stops in both modes, so this is the clocks stopping and
+ * coming back, most of it the crystal oscillator starting after dormant mode.
+ *
+ * @return uint32_t The time (us), 0 before the first wait
+ */
+uint32_t hal_sleep_wake_us(void);
+
+// ------------------------------- [ Pulse counter ] -----------------------------
+
+/**
+ * @brief Starts counting pulses on an input pin without the core, on a PIO
+ * state machine on the Pico. A pulse counts once the pin has stayed high for
+ * debounce_us, and the pin must then be low for debounce_us before the next,
+ * so contact bounce is never counted. There is one counter. It needs the
+ * system clock, so start it after hal_sleep_run_from_xosc(). It stops in
+ * dormant mode, but a pulse that wakes the Pico from dormant mode is still
+ * counted.
+ *
+ * @param pin The GPIO pin number
+ * @param debounce_us The time the pin must hold a level
+ * @return int 1 if successful 0 if no state machine is free or the time is
+ * out of range
+ */
+int hal_pulse_counter_init(uint pin, uint32_t debounce_us);
+
+/**
+ * @brief Reads the pulses counted since the counter started
+ *
+ * @return uint32_t The count
+ */
+uint32_t hal_pulse_counter_read(void);
+
+/**
+ * @brief Calls a function from the counter's interrupt once a number of
+ * pulses more have been counted, and again every time that many more are
+ *
+ * @param pulses The pulses between calls, 0 to turn the interrupt off
+ * @param callback The function to call
+ * @param ctx Passed to the function
+ */
+void hal_pulse_counter_set_irq(uint32_t pulses, hal_irq_callback_t callback, void *ctx);
+
+// ---------------------------------- [ Flash ] ----------------------------------
+
+/**
+ * @brief Erases whole sectors of the flash to 0xFF. The core stalls with
+ * interrupts off until it is done, tens of ms a sector.
+ *
+ * @param offset Where to start, from the start of the flash, a multiple of
+ * HAL_FLASH_SECTOR_SIZE
+ * @param len The bytes to erase, a multiple of HAL_FLASH_SECTOR_SIZE
+ */
+void hal_flash_erase(uint32_t offset, size_t len);
+
+/**
+ * @brief Programs whole pages of the flash. Programming can only clear bits,
+ * so 0xFF bytes leave what is there and a page can be programmed again to
+ * fill in more of it. The core stalls with interrupts off until it is done.
+ *
+ * @param offset Where to start, from the start of the flash, a multiple of
+ * HAL_FLASH_PAGE_SIZE
+ * @param src The bytes to program
+ * @param len The number of bytes, a multiple of HAL_FLASH_PAGE_SIZE
+ */
+void hal_flash_program(uint32_t offset, const uint8_t *src, size_t len);
+
+/**
+ * @brief Gets the flash contents, it is mapped into memory
+ *
+ * @param offset From the start of the flash
+ * @return const uint8_t* The contents from there
+ */
+const uint8_t *hal_flash_read(uint32_t offset);
+
+// -------------------------------- [ Multicore ] --------------------------------
+
+/**
+ * @brief Starts core 1 running a function. Core 1 must keep to its own buses
+ * and pins, share memory with core 0 only through spsc_queue.h and leave the
+ * flash alone, as erasing it stalls whatever core 1 runs from it.
+ *
+ * @param entry The function, it never returns
+ */
+void hal_core1_launch(void (*entry)(void));
+
+/**
+ * @brief Waits with the core idling until the other core calls
+ * hal_core_signal() or an interrupt comes. It can also return early, so the
+ * caller checks what it waits for and waits again.
+ */
+void hal_core_wait(void);
+
+/**
+ * @brief Wakes the other core from hal_core_wait()
+ */
+void hal_core_signal(void);
+
+// ----------------------------------- [ RTC ] -----------------------------------
+
+/**
+ * @brief Starts the real time clock
+ */
+void hal_rtc_init(void);
+
+/**
+ * @brief Sets the real time clock
+ *
+ * @param t The date and time to set
+ * @return true if the date and time were valid
+ */
+bool hal_rtc_set_datetime(const hal_datetime_t *t);
+
+/**
+ * @brief Reads the real time clock
+ *
+ * @param t Filled in with the current date and time
+ * @return true if the RTC is running
+ */
+bool hal_rtc_get_datetime(hal_datetime_t *t);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANDSLIDE_HAL_H
@@ -0,0 +1,64 @@
+/**
+ * @file    landslide_node.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Helpers that every sensor node firmware shares: the register
+ *          read/write functions for I2C devices and the LED/warning/ack pin
+ *          setup for the warning handshake with the Zero (node_warning.h).
+ *          Waking on a trigger pin is in node_wake.h.
+ *
+*/
+
+#ifndef LANDSLIDE_NODE_H
+#define LANDSLIDE_NODE_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the LED and warning pins as outputs and the ack pin as an
+ * input, and the warning handshake on them with the policy from
+ * node_config.h.
+ *
+ * @param LED_PIN The LED pin of the Pi Pico
+ * @param WARNING_PIN The pin to send the warning signal on
+ * @param ACK_PIN The pin to wait for the acknowledge signal on
+ */
+void node_setup_pins(uint LED_PIN, uint WARNING_PIN, uint ACK_PIN);
+
+/**
+ * @brief Allows the user to write to a register of a device on the I2C bus
+ *
+ * @param i2c The I2C bus to use, will be either HAL_I2C0 or HAL_I2C1
+ * @param addr The address of the device to write to
+ * @param reg The register to write to
+ * @param buf Pointer to the data to write
+ * @param nbytes The number of bytes to write
+ * @return int check if the write was successful 0 if fail 1 if success
+*/
+int reg_write(hal_i2c_t i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes);
+
+/**
+ * @brief Allows the user to read from a register of a device on the I2C bus
+ *
+ * @param i2c The I2C bus to use, will be either HAL_I2C0 or HAL_I2C1
+ * @param addr The address of the device to read from
+ * @param reg The register to read from
+ * @param buf Pointer to the buffer to store the data in
+ * @param nbytes The number of bytes to read
+ * @return int the number of bytes read or 0 if it failed
+ */
+int reg_read(hal_i2c_t i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANDSLIDE_NODE_H
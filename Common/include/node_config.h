@@ -0,0 +1,239 @@
+/**
+ * @file    node_config.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Build time configuration shared by every sensor node: the pins to
+ *          the LED and the Zero, the warning handshake timings, the
+ *          telemetry link and the event log in flash. The node types add their own tables in
+ *          seismic_config.h, rain_config.h and soil_config.h.
+ *
+ *          Every value is a macro with a default here, so the compiler folds
+ *          it straight into the code that uses it. A deployment site changes
+ *          them with a profile in Common/profiles, picked with the
+ *          LANDSLIDE_SITE CMake option, which is included before any default
+ *          is set:
+ *
+ *            cmake -S . -B build -DLANDSLIDE_SITE=steep_slope
+ *
+*/
+
+#ifndef NODE_CONFIG_H
+#define NODE_CONFIG_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+// The site profile, set by landslide_hal in Common/CMakeLists.txt
+#ifdef LANDSLIDE_SITE_PROFILE
+#include LANDSLIDE_SITE_PROFILE
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Name of the site profile, set by the build from LANDSLIDE_SITE. Only the
+// host simulation prints it, in its report.
+#ifndef LANDSLIDE_SITE_NAME
+#define LANDSLIDE_SITE_NAME         "default"
+#endif
+
+// ---------------------------- [ Pi Pico ] ----------------------------
+
+// LED Pin for the Pi Pico
+#ifndef NODE_LED_PIN
+#define NODE_LED_PIN                25
+#endif
+
+// Time the RTC starts from at power up, until the real time is set with
+// node_time_set(). Seconds since 1970-01-01, this is 2020-06-05 00:00:00.
+#ifndef NODE_TIME_START_UNIX
+#define NODE_TIME_START_UNIX        1591315200
+#endif
+
+// ---------------------------- [ Zero ] -------------------------------
+
+// Warning Pin for the Zero
+#ifndef NODE_WARNING_PIN
+#define NODE_WARNING_PIN            3
+#endif
+
+// Acknowledge Pin for the Zero
+#ifndef NODE_ACK_PIN
+#define NODE_ACK_PIN                2
+#endif
+
+// I2C bus and pins for the Zero
+#ifndef NODE_ZERO_I2C
+#define NODE_ZERO_I2C               HAL_I2C1
+#endif
+
+#ifndef NODE_ZERO_SDA_PIN
+#define NODE_ZERO_SDA_PIN           18
+#endif
+
+#ifndef NODE_ZERO_SCL_PIN
+#define NODE_ZERO_SCL_PIN           19
+#endif
+
+// Speed of the Zero's I2C bus and the address the Zero listens on
+#ifndef NODE_ZERO_I2C_BAUD
+#define NODE_ZERO_I2C_BAUD          (100 * 1000)
+#endif
+
+#ifndef NODE_ZERO_I2C_ADDR
+#define NODE_ZERO_I2C_ADDR          0x42
+#endif
+
+// Longest a frame to the Zero may take before it is given up on and sent
+// again on the next flush, so a Zero holding the bus can not hang the node
+// (us)
+#ifndef NODE_ZERO_I2C_TIMEOUT_US
+#define NODE_ZERO_I2C_TIMEOUT_US    25000
+#endif
+
+// ---------------------------- [ Telemetry ] --------------------------
+
+// Id of the node on its site (0 to 15), sent with its kind in every frame
+#ifndef NODE_TELEMETRY_ID
+#define NODE_TELEMETRY_ID           0
+#endif
+
+// Events waiting to be sent, the oldest that is not an alert is dropped when
+// it is full
+#ifndef NODE_TELEMETRY_QUEUE
+#define NODE_TELEMETRY_QUEUE        32
+#endif
+
+// Change in a node's evidence that is sent to the Zero's site fusion (%)
+#ifndef NODE_TELEMETRY_EVIDENCE_STEP
+#define NODE_TELEMETRY_EVIDENCE_STEP 5
+#endif
+
+// ---------------------------- [ Event log ] --------------------------
+
+// Flash kept for the event log, a whole number of sectors at the end of the
+// flash. 256 kB holds over 16000 records and leaves 1.75 MB to the firmware.
+#ifndef NODE_LOG_SIZE
+#define NODE_LOG_SIZE               (256 * 1024)
+#endif
+
+#ifndef NODE_LOG_OFFSET
+#define NODE_LOG_OFFSET             (HAL_FLASH_SIZE - NODE_LOG_SIZE)
+#endif
+
+// ---------------------------- [ Deferred log ] -----------------------
+
+// What node_dlog_drain() does with the hot paths' log records
+#define NODE_DLOG_OFF               0   // Nothing, NODE_DLOG() compiles away
+#define NODE_DLOG_TEXT              1   // Prints their text, as printf would have
+#define NODE_DLOG_BINARY            2   // Sends binary frames for dlog_decode
+
+#ifndef NODE_DLOG_MODE
+#define NODE_DLOG_MODE              NODE_DLOG_TEXT
+#endif
+
+// Records kept until the next drain, a power of two of 32 bytes each
+#ifndef NODE_DLOG_RECORDS
+#define NODE_DLOG_RECORDS           64
+#endif
+
+// ---------------------------- [ Phase timing ] -----------------------
+
+// Times the phases of each wake (node_phase.h), 0 compiles every
+// NODE_PHASE_*() away
+#ifndef NODE_PHASE_ENABLE
+#define NODE_PHASE_ENABLE           1
+#endif
+
+// Time between sending the phase statistics to the Zero (s), 0 for only
+// when the firmware calls node_phase_export()
+#ifndef NODE_PHASE_EXPORT_S
+#define NODE_PHASE_EXPORT_S         (24 * 60 * 60)
+#endif
+
+// Supply current of the Pico board in each state (uA), for the estimates of
+// the charge used a day and the host simulation's battery life. Idle is the
+// core waiting for an interrupt with the clocks running, I2C, UART and the
+// LED are on top of running, the LED's is while it is lit.
+#ifndef NODE_CURRENT_RUN_UA
+#define NODE_CURRENT_RUN_UA         24000
+#endif
+
+#ifndef NODE_CURRENT_IDLE_UA
+#define NODE_CURRENT_IDLE_UA        14000
+#endif
+
+#ifndef NODE_CURRENT_SLEEP_UA
+#define NODE_CURRENT_SLEEP_UA       1300
+#endif
+
+#ifndef NODE_CURRENT_DORMANT_UA
+#define NODE_CURRENT_DORMANT_UA     800
+#endif
+
+#ifndef NODE_CURRENT_I2C_UA
+#define NODE_CURRENT_I2C_UA         500
+#endif
+
+#ifndef NODE_CURRENT_UART_UA
+#define NODE_CURRENT_UART_UA        300
+#endif
+
+#ifndef NODE_CURRENT_LED_UA
+#define NODE_CURRENT_LED_UA         5000
+#endif
+
+// Usable charge of the node's battery (mAh), the host simulation works out
+// the battery life from it
+#ifndef NODE_BATTERY_MAH
+#define NODE_BATTERY_MAH            2600
+#endif
+
+// ---------------------------- [ Warning handshake ] ------------------
+
+// LED half period while a warning waits for the ack (ms)
+#ifndef NODE_WARNING_BLINK_MS
+#define NODE_WARNING_BLINK_MS       500
+#endif
+
+// Time each attempt waits for the ack (ms)
+#ifndef NODE_WARNING_TIMEOUT_MS
+#define NODE_WARNING_TIMEOUT_MS     30000
+#endif
+
+// Time the warning pin is dropped before the next attempt (ms)
+#ifndef NODE_WARNING_RETRY_MS
+#define NODE_WARNING_RETRY_MS       60000
+#endif
+
+// Attempts after the first one before giving up
+#ifndef NODE_WARNING_RETRIES
+#define NODE_WARNING_RETRIES        2
+#endif
+
+// ---------------------------- [ Checks ] -----------------------------
+
+#if NODE_TELEMETRY_ID < 0 || NODE_TELEMETRY_ID > 15
+#error "NODE_TELEMETRY_ID must be from 0 to 15"
+#endif
+
+#if NODE_TELEMETRY_QUEUE < 1
+#error "NODE_TELEMETRY_QUEUE must be at least 1"
+#endif
+
+#if NODE_DLOG_MODE < NODE_DLOG_OFF || NODE_DLOG_MODE > NODE_DLOG_BINARY
+#error "NODE_DLOG_MODE must be NODE_DLOG_OFF, NODE_DLOG_TEXT or NODE_DLOG_BINARY"
+#endif
+
+#if NODE_DLOG_RECORDS < 1 || (NODE_DLOG_RECORDS & (NODE_DLOG_RECORDS - 1)) != 0
+#error "NODE_DLOG_RECORDS must be a power of two"
+#endif
+
+#if NODE_LOG_SIZE % HAL_FLASH_SECTOR_SIZE != 0 || NODE_LOG_OFFSET % HAL_FLASH_SECTOR_SIZE != 0
+#error "NODE_LOG_SIZE and NODE_LOG_OFFSET must be whole flash sectors"
+#endif
+
+#if NODE_LOG_SIZE < 2 * HAL_FLASH_SECTOR_SIZE || NODE_LOG_OFFSET + NODE_LOG_SIZE > HAL_FLASH_SIZE
+#error "The event log needs at least 2 sectors inside the flash"
+#endif
+
+#endif // NODE_CONFIG_H
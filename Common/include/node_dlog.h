@@ -0,0 +1,89 @@
+/**
+ * @file    node_dlog.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Deferred log for the hot paths. NODE_DLOG() stores a format id
+ *          from dlog_format.h and its arguments in a fixed size record and
+ *          returns, it does not format anything or wait for the uart. The
+ *          records wait in the lock free ring of spsc_queue.h until the
+ *          firmware is about to idle or sleep anyway and calls
+ *          node_dlog_drain(), which sends them the way NODE_DLOG_MODE says:
+ *
+ *            NODE_DLOG_TEXT    the text printf would have printed
+ *            NODE_DLOG_BINARY  binary frames, 40 to 70% of the bytes, that the
+ *                              Zero's dlog_decode turns back into the text
+ *            NODE_DLOG_OFF     nothing, NODE_DLOG() compiles to nothing and
+ *                              its arguments are not evaluated
+ *
+ *          A full ring drops the new record, and the next record that fits
+ *          says how many were lost. Only one context may log, the main loop
+ *          of one core, and the same one drains.
+ *
+ *              NODE_DLOG(DLOG_ACCEL, DLOG_F(acc_mag));
+ *              ...
+ *              node_dlog_drain();
+ *
+*/
+
+#ifndef NODE_DLOG_H
+#define NODE_DLOG_H
+
+// ################################# [ Includes ] #################################
+
+#include "dlog_format.h"
+#include "landslide_hal.h"
+#include "node_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Logs a format and its arguments, each a 32 bit word or DLOG_U64() / DLOG_F()
+#if NODE_DLOG_MODE == NODE_DLOG_OFF
+#define NODE_DLOG(id, ...)  ((void)0)
+#else
+#define NODE_DLOG(id, ...)                                                                      \
+    node_dlog_write((id), (const uint32_t[]){ __VA_ARGS__ },                                    \
+                    sizeof((const uint32_t[]){ __VA_ARGS__ }) / sizeof(uint32_t))
+#endif
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Empties the ring, call once before the first NODE_DLOG()
+ */
+void node_dlog_init(void);
+
+/**
+ * @brief Stores a record, use NODE_DLOG() rather than calling this
+ *
+ * @param id The format
+ * @param args Its arguments
+ * @param nargs Words of arguments, up to DLOG_MAX_ARGS
+ * @return bool false if the ring was full and the record was dropped
+ */
+bool node_dlog_write(uint16_t id, const uint32_t *args, uint32_t nargs);
+
+/**
+ * @brief Sends every waiting record and waits for stdio to go out, the place
+ * for it is just before the firmware idles or sleeps
+ *
+ * @return uint32_t The records sent
+ */
+uint32_t node_dlog_drain(void);
+
+/**
+ * @brief Gets the records dropped from a full ring since node_dlog_init()
+ *
+ * @return uint32_t The records
+ */
+uint32_t node_dlog_lost(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NODE_DLOG_H
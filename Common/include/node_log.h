@@ -0,0 +1,97 @@
+/**
+ * @file    node_log.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Keeps a log of what a node measured and decided in its own flash,
+ *          in the layout of event_log.h, so the numbers survive a Zero that
+ *          never answered and a node that was reset. The log takes the last
+ *          NODE_LOG_SIZE bytes of the flash, past the firmware.
+ *
+ *          Records wait in a page buffer in RAM and a page is programmed
+ *          once 16 of them fill it, or when the firmware flushes (an alert
+ *          is flushed straight away), so the flash sees one program per
+ *          page instead of one per record. Programming a page again only
+ *          fills in its free slots, so a flush part way through a page
+ *          costs nothing later. A sector is erased only when the ring comes
+ *          round to it, once for every 255 records.
+ *
+ *          The core stalls with interrupts off while the flash is busy,
+ *          about 1 ms a page and 45 ms a sector erase, so only the main loop
+ *          may append and flush.
+ *
+*/
+
+#ifndef NODE_LOG_H
+#define NODE_LOG_H
+
+// ################################# [ Includes ] #################################
+
+#include "event_log.h"
+#include "fusion.h"
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Counters since node_log_init()
+typedef struct
+{
+    uint16_t boot;              // This boot's number
+    uint32_t found;             // Records already in the log at boot
+    uint32_t appended;          // Records appended
+    uint32_t pages;             // Page programs
+    uint32_t erases;            // Sector erases
+} node_log_stats_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Finds where the log left off, starting it if the flash has none,
+ * and appends a TELEMETRY_BOOT record with the next boot number
+ *
+ * @param kind What the node measures, telemetry_kind_t
+ * @return int 1 if successful 0 if failed
+ */
+int node_log_init(uint8_t kind);
+
+/**
+ * @brief Appends a record stamped with the current time, it reaches the
+ * flash once its page is full or the log is flushed
+ *
+ * @param type The record type
+ * @param arg The record's arg, see telemetry_type_t
+ * @param value The record's value, see telemetry_type_t
+ * @param stat A summary of what led to it
+ */
+void node_log_append(telemetry_type_t type, uint8_t arg, int32_t value, int32_t stat);
+
+/**
+ * @brief Appends a TELEMETRY_ALERT record with the grade, confidence and
+ * evidence of an assessment, and the number of channels with evidence as its
+ * stat, and flushes it
+ *
+ * @param alert The assessment
+ */
+void node_log_alert(const fusion_alert_t *alert);
+
+/**
+ * @brief Programs the records waiting in the page buffer
+ */
+void node_log_flush(void);
+
+/**
+ * @brief Gets the log counters
+ *
+ * @return const node_log_stats_t* The counters
+ */
+const node_log_stats_t *node_log_stats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NODE_LOG_H
@@ -0,0 +1,149 @@
+/**
+ * @file    node_phase.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Times the phases of a node's wake cycle with the microsecond
+ *          timer and keeps the statistics of phase_stats.h for each in RAM,
+ *          to see where the battery goes. There are two ways to time one:
+ *
+ *            NODE_PHASE_BEGIN() / NODE_PHASE_END()
+ *                  In the main loop, which runs in one phase at a time. A
+ *                  phase begun inside another stops the outer one's time
+ *                  until it ends, so these times never overlap and their
+ *                  supply current takes the place of the run current.
+ *            NODE_PHASE_START() / NODE_PHASE_STOP()
+ *                  Something that goes on beside the main loop, in
+ *                  interrupts or on core 1, one at a time for each phase.
+ *                  Its current is on top of whatever the core is doing.
+ *
+ *          A dormant or sleep wait ends with NODE_PHASE_WAKE(), which puts
+ *          the clocks coming back (hal_sleep_wake_us()) in
+ *          PHASE_CLOCK_RESTORE. The timer stops in dormant and sleep mode,
+ *          so on the Pico those two phases count the waits but only the
+ *          host simulation can time them.
+ *
+ *          The statistics go to the Zero in TELEMETRY_PHASE events every
+ *          NODE_PHASE_EXPORT_S from NODE_PHASE_POLL(), or whenever the
+ *          firmware calls node_phase_export(). The host simulation prints
+ *          node_phase_report() at the end, with the charge a day the
+ *          NODE_CURRENT_* figures of node_config.h come to.
+ *
+ *          With NODE_PHASE_ENABLE 0 every NODE_PHASE_*() compiles to nothing
+ *          and its arguments are not evaluated.
+ *
+ *              NODE_PHASE_BEGIN(PHASE_DETECT);
+ *              ...
+ *              NODE_PHASE_END(PHASE_DETECT);
+ *
+*/
+
+#ifndef NODE_PHASE_H
+#define NODE_PHASE_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+#include "node_config.h"
+#include "phase_stats.h"
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+#if NODE_PHASE_ENABLE
+#define NODE_PHASE_BEGIN(phase)     node_phase_begin(phase)
+#define NODE_PHASE_END(phase)       node_phase_end(phase)
+#define NODE_PHASE_WAKE(phase)      node_phase_wake(phase)
+#define NODE_PHASE_START(phase)     node_phase_start(phase)
+#define NODE_PHASE_STOP(phase)      node_phase_stop(phase)
+#define NODE_PHASE_POLL()           node_phase_poll()
+#else
+#define NODE_PHASE_BEGIN(phase)     ((void)0)
+#define NODE_PHASE_END(phase)       ((void)0)
+#define NODE_PHASE_WAKE(phase)      ((void)0)
+#define NODE_PHASE_START(phase)     ((void)0)
+#define NODE_PHASE_STOP(phase)      ((void)0)
+#define NODE_PHASE_POLL()           ((void)0)
+#endif
+
+// Phases open inside each other at most, a deeper one is not timed
+#define NODE_PHASE_DEPTH    4
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Begins a phase of the main loop, use NODE_PHASE_BEGIN()
+ *
+ * @param phase The phase
+ */
+void node_phase_begin(phase_id_t phase);
+
+/**
+ * @brief Ends the phase begun last, use NODE_PHASE_END()
+ *
+ * @param phase The phase, nothing is timed if it is not the one begun last
+ */
+void node_phase_end(phase_id_t phase);
+
+/**
+ * @brief Ends a dormant or sleep wait begun last, use NODE_PHASE_WAKE()
+ *
+ * @param phase PHASE_DORMANT or PHASE_SLEEP
+ */
+void node_phase_wake(phase_id_t phase);
+
+/**
+ * @brief Starts a phase beside the main loop, use NODE_PHASE_START()
+ *
+ * @param phase The phase
+ */
+void node_phase_start(phase_id_t phase);
+
+/**
+ * @brief Stops a phase started with node_phase_start(), use NODE_PHASE_STOP()
+ *
+ * @param phase The phase, nothing is timed if it was not started
+ */
+void node_phase_stop(phase_id_t phase);
+
+/**
+ * @brief Sends the statistics to the Zero if NODE_PHASE_EXPORT_S has passed
+ * since they were last sent, use NODE_PHASE_POLL() in the main loop
+ */
+void node_phase_poll(void);
+
+/**
+ * @brief Sends the statistics of every phase timed so far to the Zero
+ *
+ * @return int 1 if the Zero has them all 0 if some are left to send
+ */
+int node_phase_export(void);
+
+/**
+ * @brief Gets a phase's statistics since power up
+ *
+ * @param phase The phase
+ * @return const phase_stats_t* The statistics
+ */
+const phase_stats_t *node_phase_stats(phase_id_t phase);
+
+/**
+ * @brief Prints the statistics of every phase timed so far, and the mean
+ * current and charge a day they come to with the NODE_CURRENT_* figures.
+ * The time in no phase of the main loop is charged at the run current.
+ *
+ * @param out Where to print
+ * @param prefix Put in front of each line
+ */
+void node_phase_report(FILE *out, const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NODE_PHASE_H
@@ -0,0 +1,144 @@
+/**
+ * @file    node_telemetry.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Sends what a node measures and decides to the Zero over the I2C
+ *          link, in the frames of telemetry_frame.h. Events are queued with
+ *          their time and go out in batches of up to TELEMETRY_MAX_EVENTS
+ *          per I2C write, once a frame's worth is waiting or when the
+ *          firmware flushes (before raising a warning, so the Zero has the
+ *          numbers by the time it sees the warning pin).
+ *
+ *          The Pico is the bus master and writes each frame to the Zero at
+ *          NODE_ZERO_I2C_ADDR. A frame the Zero does not ack is kept and
+ *          sent again, with the same sequence number, on the next flush, so
+ *          the Zero can tell a repeat from a lost frame. A write is given
+ *          up on after NODE_ZERO_I2C_TIMEOUT_US, so a Zero holding the bus
+ *          can not hang the node, and the frame is kept the same way. When
+ *          the queue is full the oldest event that is not an alert is
+ *          dropped, and the next frame starts with a TELEMETRY_LOST event
+ *          saying how many. Alerts are never dropped, with a queue full of
+ *          them the new event is.
+ *
+ *          Only the main loop may post and flush, not interrupts.
+ *
+*/
+
+#ifndef NODE_TELEMETRY_H
+#define NODE_TELEMETRY_H
+
+// ################################# [ Includes ] #################################
+
+#include "fusion.h"
+#include "landslide_hal.h"
+#include "telemetry_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Counters since node_telemetry_init()
+typedef struct
+{
+    uint32_t posted;            // Events queued
+    uint32_t sent;              // Events the Zero acked
+    uint32_t lost;              // Events dropped from a full queue
+    uint32_t frames;            // Frames the Zero acked
+    uint32_t retries;           // Writes the Zero did not ack
+    uint32_t timeouts;          // Writes given up on because the bus was held
+    uint32_t blobs;             // Blobs the Zero acked all of
+    uint64_t bytes;             // Bytes of the acked frames
+} node_telemetry_stats_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the I2C bus to the Zero and queues a TELEMETRY_BOOT event
+ *
+ * @param i2c The bus the Zero is on
+ * @param sda_pin The SDA pin to use
+ * @param scl_pin The SCL pin to use
+ * @param addr The address the Zero listens on
+ * @param node The node byte of every frame, TELEMETRY_NODE(id, kind)
+ * @return int 1 if successful 0 if failed
+ */
+int node_telemetry_init(hal_i2c_t i2c, uint sda_pin, uint scl_pin, uint8_t addr, uint8_t node);
+
+/**
+ * @brief Queues an event stamped with the current time, and sends the queue
+ * once it fills a frame
+ *
+ * @param type The event type
+ * @param arg The event's arg, see telemetry_type_t
+ * @param value The event's value, see telemetry_type_t
+ */
+void node_telemetry_post(telemetry_type_t type, uint8_t arg, int32_t value);
+
+/**
+ * @brief Queues a TELEMETRY_ALERT event with the grade, confidence and
+ * evidence of an assessment and sends the queue
+ *
+ * @param alert The assessment
+ * @return int 1 if the Zero has it 0 if it is left to send
+ */
+int node_telemetry_alert(const fusion_alert_t *alert);
+
+/**
+ * @brief Sends the evidence of the node's own channel to the Zero's site
+ * fusion when it has moved NODE_TELEMETRY_EVIDENCE_STEP from what was last
+ * sent, gone to or from 0, or the sensor has just reached its threshold. The
+ * vibration evidence is sent whenever it goes up, the Zero fades it itself.
+ *
+ * @param channel The node's channel
+ * @param alert The assessment
+ * @return int 1 if the Zero has it or there was nothing to send 0 if it is
+ * left to send
+ */
+int node_telemetry_evidence(fusion_channel_t channel, const fusion_alert_t *alert);
+
+/**
+ * @brief Sends a blob, a waveform capture, in TELEMETRY_CAPTURE events after
+ * the events already queued. It takes a frame for every 64 bytes, 8.5 ms each
+ * at 100 kHz.
+ *
+ * @param src The blob
+ * @param len Its length
+ * @return int 1 if the Zero has it all 0 if it stopped acking, the frame it
+ * did not ack is left to send and the rest of the blob is not, so the whole
+ * blob has to be sent again
+ */
+int node_telemetry_blob(const uint8_t *src, size_t len);
+
+/**
+ * @brief Queues events that are already filled in, their time included, and
+ * sends the queue
+ *
+ * @param events The events
+ * @param count How many
+ * @return int 1 if the Zero has them all 0 if some are left to send
+ */
+int node_telemetry_send(const telemetry_event_t *events, size_t count);
+
+/**
+ * @brief Sends every queued event, stopping at the first frame the Zero does
+ * not ack
+ *
+ * @return int 1 if the queue is empty 0 if a frame is left to send
+ */
+int node_telemetry_flush(void);
+
+/**
+ * @brief Gets the link counters
+ *
+ * @return const node_telemetry_stats_t* The counters
+ */
+const node_telemetry_stats_t *node_telemetry_stats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NODE_TELEMETRY_H
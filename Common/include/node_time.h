@@ -0,0 +1,108 @@
+/**
+ * @file    node_time.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Time base of the sensor node, kept by the RTC so it carries on
+ *          through sleep. The RTC is started once at power up, from
+ *          NODE_TIME_START_UNIX in node_config.h until something sets the
+ *          real time, and is never set again to make an alarm: the alarm
+ *          is the current time plus the sleep, worked out through Unix time
+ *          so minutes, hours, days, months and years roll over.
+ *
+ *          node_time_ms() gives a timestamp for each sample that the other
+ *          nodes' samples can be lined up against. Its seconds are the
+ *          RTC's and its milliseconds count from the first read in that
+ *          second, so it only ever goes forward, even across node_time_set().
+ *
+ *          The RTC stops in dormant mode, so this is for the nodes that
+ *          sleep on the RTC alarm or not at all. node_time_sleep_until_irq()
+ *          is that sleep with the pins and the pulse counter still able to
+ *          wake the node, for waits on a sensor that also have a deadline.
+ *
+*/
+
+#ifndef NODE_TIME_H
+#define NODE_TIME_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Starts the RTC, call once at power up
+ *
+ * @param unix_s The time to start from, seconds since 1970-01-01 00:00:00
+ * @return int 1 if successful 0 if the time could not be set
+ */
+int node_time_init(int64_t unix_s);
+
+/**
+ * @brief Sets the RTC to the real time, timestamps from node_time_ms() hold
+ * still until they catch up if it moves back
+ *
+ * @param unix_s The time, seconds since 1970-01-01 00:00:00
+ * @return int 1 if successful 0 if the time could not be set
+ */
+int node_time_set(int64_t unix_s);
+
+/**
+ * @brief Reads the RTC
+ *
+ * @return int64_t Seconds since 1970-01-01 00:00:00, 0 if the RTC is not running
+ */
+int64_t node_time_unix(void);
+
+/**
+ * @brief Gets a timestamp for a sample, never less than the last one
+ *
+ * @return uint64_t Milliseconds since 1970-01-01 00:00:00
+ */
+uint64_t node_time_ms(void);
+
+/**
+ * @brief Sleeps until the RTC alarm a number of seconds from now, then
+ * calls the callback
+ *
+ * @param seconds The time to sleep
+ * @param callback The function to call on wake up
+ */
+void node_time_sleep(uint32_t seconds, hal_rtc_callback_t callback);
+
+/**
+ * @brief Sleeps until the RTC reaches a time or an interrupt comes first, the
+ * pin interrupts and the pulse counter keep running
+ *
+ * @param unix_s The time to wake at, seconds since 1970-01-01 00:00:00
+ * @param woken Set from the interrupt waited for, it does not sleep once set
+ * even if that was just before, or NULL (hal_sleep_goto_sleep_until_irq())
+ * @return int 1 if the time has been reached, 0 if an interrupt woke it first
+ */
+int node_time_sleep_until_irq(int64_t unix_s, const volatile bool *woken);
+
+/**
+ * @brief Converts a date and time to Unix time
+ *
+ * @param t The date and time
+ * @return int64_t Seconds since 1970-01-01 00:00:00
+ */
+int64_t node_time_to_unix(const hal_datetime_t *t);
+
+/**
+ * @brief Converts Unix time to a date and time, including the day of the week
+ *
+ * @param unix_s Seconds since 1970-01-01 00:00:00
+ * @param t Filled in with the date and time
+ */
+void node_time_from_unix(int64_t unix_s, hal_datetime_t *t);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NODE_TIME_H
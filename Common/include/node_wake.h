@@ -0,0 +1,117 @@
+/**
+ * @file    node_wake.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Edge triggered wake on a trigger pin (rain gauge, vibration
+ *          sensor) with debounce and hold-off, so one physical event costs
+ *          one wake. Waking on a high level woke the Pico again at once
+ *          while the line was still high, and again on every bounce of a
+ *          chattering contact.
+ *
+ *          A wait first holds off: the line must have been low for the
+ *          hold-off time, a rising edge in it starts it again. The Pico then
+ *          sleeps until a rising edge, and the line must still be high the
+ *          debounce time later, otherwise it was a glitch and the Pico goes
+ *          back to sleep. A line that does not settle in the settle time, a
+ *          stuck contact or a long shake, returns anyway so the node can
+ *          still look at its sensor.
+ *
+ *              HOLD OFF ---> SLEEP ---> DEBOUNCE ---> EDGE
+ *               |    ^        ^            |
+ *               +----+ edge   +------------+ glitch
+ *               |
+ *               +---> UNSETTLED
+ *
+ *          Every wait fills in a wake record: why it returned, when, and the
+ *          wakes, glitches and hold-off restarts it took to get there.
+ *
+*/
+
+#ifndef NODE_WAKE_H
+#define NODE_WAKE_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Why a wait returned
+typedef enum
+{
+    NODE_WAKE_NONE,             // Not waited yet
+    NODE_WAKE_EDGE,             // A debounced rising edge
+    NODE_WAKE_TIMEOUT,          // The time given to the wait ran out
+    NODE_WAKE_UNSETTLED,        // The hold-off did not end in the settle time
+    NODE_WAKE_ACTIVITY,         // The accelerometer saw activity
+    NODE_WAKE_INACTIVITY        // The accelerometer has been at rest
+} node_wake_reason_t;
+
+// Pin and timings
+typedef struct
+{
+    uint pin;
+    uint32_t debounce_us;       // Time the line must stay high after the edge
+    uint32_t holdoff_ms;        // Time the line must be low before an edge counts
+    uint32_t settle_ms;         // Longest time the hold-off may take, 0 for no limit
+} node_wake_config_t;
+
+// The wake record
+typedef struct
+{
+    node_wake_config_t config;
+    volatile bool edge;         // Set from the pin's interrupt
+
+    // The last wait
+    node_wake_reason_t reason;
+    uint64_t at_us;             // Time it returned
+    uint32_t last_wakes;        // Times the core woke on the pin
+    uint32_t last_glitches;     // Edges the debounce turned down
+    uint32_t last_holdoffs;     // Times an edge started the hold-off again
+
+    // Since node_wake_init()
+    uint32_t events;            // Waits that returned NODE_WAKE_EDGE
+    uint32_t wakes;
+    uint32_t glitches;
+    uint32_t holdoffs;
+} node_wake_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up a wake record, the pin must already be an input
+ *
+ * @param wake The record
+ * @param config Pin and timings
+ */
+void node_wake_init(node_wake_t *wake, const node_wake_config_t *config);
+
+/**
+ * @brief Waits for the next event on the pin. With no timeout the Pico goes
+ * into dormant mode unless a warning is waiting for its ack, with one it
+ * idles with the clocks running.
+ *
+ * @param wake The record, filled in
+ * @param timeout_ms Longest time to wait, 0 for no limit
+ * @return node_wake_reason_t Why it returned
+ */
+node_wake_reason_t node_wake_wait(node_wake_t *wake, uint32_t timeout_ms);
+
+/**
+ * @brief Gets a name for a wake reason
+ *
+ * @param reason The reason
+ * @return const char* The name
+ */
+const char *node_wake_reason_name(node_wake_reason_t reason);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NODE_WAKE_H
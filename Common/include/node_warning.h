@@ -0,0 +1,115 @@
+/**
+ * @file    node_warning.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Event driven warning handshake with the Zero. Raising a warning
+ *          drives the warning pin high and returns straight away, a timer
+ *          interrupt flashes the LED and the ack pin's rising edge interrupt
+ *          ends the handshake, so the firmware keeps sensing (or sleeps)
+ *          while it waits instead of spinning.
+ *
+ *          If no ack comes within the timeout the warning pin is dropped for
+ *          a while and raised again, so the Zero sees a fresh warning. After
+ *          the last retry the handshake gives up until the next warning.
+ *
+ *              IDLE -> RAISED -> ACKED
+ *                        |  ^
+ *                timeout v  | retry
+ *                      BACKOFF -> FAILED (no retries left)
+ *
+ *          The timings come from node_config.h.
+ *
+*/
+
+#ifndef NODE_WARNING_H
+#define NODE_WARNING_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Where the handshake is
+typedef enum
+{
+    NODE_WARNING_IDLE,          // No warning raised yet
+    NODE_WARNING_RAISED,        // Warning pin high, waiting for the ack
+    NODE_WARNING_BACKOFF,       // Timed out, warning pin low until the retry
+    NODE_WARNING_ACKED,         // The Zero acknowledged the warning
+    NODE_WARNING_FAILED         // Gave up after the last retry
+} node_warning_state_t;
+
+// Timeout and retry policy
+typedef struct
+{
+    uint32_t blink_ms;          // LED half period while the warning is raised
+    uint32_t timeout_ms;        // Time each attempt waits for the ack
+    uint32_t retry_ms;          // Time the warning pin stays low between attempts
+    uint8_t retries;            // Attempts after the first one
+} node_warning_config_t;
+
+// Counters since node_warning_init()
+typedef struct
+{
+    uint32_t raised;            // Handshakes started
+    uint32_t attempts;          // Times the warning pin went high
+    uint32_t acked;             // Handshakes the Zero acknowledged
+    uint32_t timeouts;          // Attempts that got no ack
+    uint32_t failed;            // Handshakes given up on
+} node_warning_stats_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the handshake, the pins must already be set up by
+ * node_setup_pins()
+ *
+ * @param WARNING_PIN The pin to send the warning signal on
+ * @param ACK_PIN The pin the Zero acknowledges on
+ * @param LED_PIN The LED flashed while the warning is raised
+ * @param config The timeout and retry policy, NULL for the node_config.h one
+ * @return int 1 if successful 0 if failed
+ */
+int node_warning_init(uint WARNING_PIN, uint ACK_PIN, uint LED_PIN, const node_warning_config_t *config);
+
+/**
+ * @brief Raises a warning and returns without waiting for the ack. Does
+ * nothing if a warning is already waiting for one.
+ *
+ * @return int 1 if the warning is raised 0 if the timer could not be started
+ */
+int node_warning_raise(void);
+
+/**
+ * @brief Gets where the handshake is
+ *
+ * @return node_warning_state_t The state
+ */
+node_warning_state_t node_warning_state(void);
+
+/**
+ * @brief Checks if a warning is raised or waiting to be retried, the timer
+ * interrupt has to keep running until it is not
+ *
+ * @return true while in NODE_WARNING_RAISED or NODE_WARNING_BACKOFF
+ */
+bool node_warning_pending(void);
+
+/**
+ * @brief Gets the handshake counters
+ *
+ * @return const node_warning_stats_t* The counters
+ */
+const node_warning_stats_t *node_warning_stats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NODE_WARNING_H
@@ -0,0 +1,159 @@
+/**
+ * @file    phase_stats.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Timing statistics of the phases of a node's wake cycle, kept by
+ *          node_phase.h on the node, and the TELEMETRY_PHASE events they go
+ *          to the Zero in. Each phase keeps its count, total, shortest and
+ *          longest time and a histogram of its times in powers of 4 us:
+ *
+ *            bucket 0   0 us
+ *            bucket b   4^(b-1) to 4^b - 1 us
+ *            bucket 15  from 4^14 us, 268 s, up
+ *
+ *          A phase's statistics take PHASE_STATS_LEN bytes, little endian:
+ *
+ *            0      8    total time (us)
+ *            8      4    count
+ *           12      4    shortest (us)
+ *           16      4    longest (us)
+ *           20     32    the histogram, 16 counts of 16 bits that stop at
+ *                        65535
+ *
+ *          which go in PHASE_STATS_PARTS TELEMETRY_PHASE events, arg
+ *          phase << 3 | part, 8 bytes each in time then value like the
+ *          pieces of a capture. The Zero puts a phase back together once it
+ *          has every part of it. Nothing here uses the HAL, the Zero's tools
+ *          build it as it is.
+ *
+*/
+
+#ifndef PHASE_STATS_H
+#define PHASE_STATS_H
+
+// ################################# [ Includes ] #################################
+
+#include "telemetry_frame.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Every phase timed, ids are never reused so old exports still decode
+#define PHASE_LIST(X)                                                                   \
+    X(PHASE_DORMANT,        "dormant")          /* Waiting on a pin in dormant mode */  \
+    X(PHASE_SLEEP,          "sleep")            /* Waiting on the RTC in sleep mode */  \
+    X(PHASE_IDLE,           "idle")             /* Waiting with the clocks running */   \
+    X(PHASE_CLOCK_RESTORE,  "clock restore")    /* Clocks coming back after either */   \
+    X(PHASE_I2C_READ,       "i2c read")         /* Reading the accelerometer */         \
+    X(PHASE_PROBE,          "probe read")       /* Asking the soil probe */             \
+    X(PHASE_DETECT,         "detection")        /* Deciding on a risk */                \
+    X(PHASE_UART_DRAIN,     "uart drain")       /* Sending the deferred log */          \
+    X(PHASE_LINK,           "link")             /* Writing frames to the Zero */        \
+    X(PHASE_HANDSHAKE,      "handshake")        /* Warning raised until it ends */
+
+#define PHASE_ID(name, text)    name,
+
+typedef enum
+{
+    PHASE_LIST(PHASE_ID)
+    PHASE_COUNT
+} phase_id_t;
+
+#define PHASE_STATS_BUCKETS     16
+#define PHASE_STATS_LEN         52
+#define PHASE_STATS_PARTS       ((PHASE_STATS_LEN + TELEMETRY_BLOB_BYTES - 1) / TELEMETRY_BLOB_BYTES)
+
+// Phase and part of a TELEMETRY_PHASE event's arg
+#define PHASE_EVENT_ARG(phase, part)    ((uint8_t)((phase) << 3 | (part)))
+#define PHASE_EVENT_PHASE(arg)          ((arg) >> 3)
+#define PHASE_EVENT_PART(arg)           ((arg) & 0x07)
+
+typedef struct
+{
+    uint64_t total_us;
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint16_t hist[PHASE_STATS_BUCKETS];
+} phase_stats_t;
+
+// The parts of each phase the Zero has so far
+typedef struct
+{
+    uint8_t bytes[PHASE_COUNT][PHASE_STATS_PARTS * TELEMETRY_BLOB_BYTES];
+    uint8_t have[PHASE_COUNT];
+} phase_stats_rx_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Gets the name of a phase
+ *
+ * @param phase The phase
+ * @return const char* The name, "unknown" if there is none
+ */
+const char *phase_name(uint32_t phase);
+
+/**
+ * @brief Gets the histogram bucket of a time
+ *
+ * @param us The time
+ * @return uint32_t The bucket
+ */
+uint32_t phase_stats_bucket(uint32_t us);
+
+/**
+ * @brief Adds a time to a phase's statistics, one over 71 minutes counts in
+ * full in the total but stops at UINT32_MAX as the shortest or longest
+ *
+ * @param stats The statistics
+ * @param us The time
+ */
+void phase_stats_add(phase_stats_t *stats, uint64_t us);
+
+/**
+ * @brief Fills in the events that carry a phase's statistics
+ *
+ * @param events PHASE_STATS_PARTS events, their time is overwritten
+ * @param phase The phase
+ * @param stats Its statistics
+ */
+void phase_stats_pack(telemetry_event_t *events, uint8_t phase, const phase_stats_t *stats);
+
+/**
+ * @brief Takes a TELEMETRY_PHASE event, and when it is the last part of its
+ * phase puts the phase back together
+ *
+ * @param rx The parts so far, zeroed to start
+ * @param ev The event
+ * @param stats Set to the phase's statistics when they are all in
+ * @return int The phase when it is all in, -1 if it is not yet or the event
+ * is not one
+ */
+int phase_stats_take(phase_stats_rx_t *rx, const telemetry_event_t *ev, phase_stats_t *stats);
+
+/**
+ * @brief Prints a phase's statistics, a line of its times then a line of
+ * the histogram buckets that are not empty
+ *
+ * @param out Where to print
+ * @param prefix Put in front of each line
+ * @param phase The phase
+ * @param stats Its statistics
+ */
+void phase_stats_print(FILE *out, const char *prefix, uint32_t phase, const phase_stats_t *stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHASE_STATS_H
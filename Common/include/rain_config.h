@@ -0,0 +1,158 @@
+/**
+ * @file    rain_config.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Build time configuration of the rain node: the rain gauge pin, the
+ *          size of a bucket tip, how the tips are counted and the rainfall
+ *          windows with the rain in each that raises a warning. A site profile can change any of them
+ *          (see node_config.h).
+ *
+ *          The default thresholds lie on the rainfall intensity and duration
+ *          curve of Caine (1980), I = 14.82 D^-0.39 mm/h, above which shallow
+ *          landslides have been seen: 5 mm in 10 minutes, 15 mm in an hour
+ *          and 100 mm in a day.
+ *
+*/
+
+#ifndef RAIN_CONFIG_H
+#define RAIN_CONFIG_H
+
+// ################################# [ Includes ] #################################
+
+#include "node_config.h"
+#include "rain_rate.h"
+
+// ################################## [ Types ] ###################################
+
+// ---------------------------- [ Gauge ] ------------------------------
+
+// Pin the rain gauge pulses high on each bucket tip
+#ifndef RAIN_TRIGGER_PIN
+#define RAIN_TRIGGER_PIN            10
+#endif
+
+// Rain per bucket tip (micrometres)
+#ifndef RAIN_TIP_UM
+#define RAIN_TIP_UM                 200
+#endif
+
+// LED flash period while the gauge pin is high (ms)
+#ifndef RAIN_FLASH_MS
+#define RAIN_FLASH_MS               100
+#endif
+
+// 1 to count the tips with the pulse counter, so the interrupt variant only
+// wakes every RAIN_IDLE_CHECK_MS or when a window could go over its
+// threshold, 0 to wake on every tip
+#ifndef RAIN_PULSE_COUNTER
+#define RAIN_PULSE_COUNTER          1
+#endif
+
+// Time the gauge's reed switch must hold a level for the counter to take
+// it, longer than its contact bounce and shorter than half a tip (us)
+#ifndef RAIN_DEBOUNCE_US
+#define RAIN_DEBOUNCE_US            5000
+#endif
+
+// Time the gauge pin must be low after a tip before the next edge wakes the
+// node, longer than the bounce of the switch opening (ms)
+#ifndef RAIN_HOLDOFF_MS
+#define RAIN_HOLDOFF_MS             50
+#endif
+
+// Longest the node waits for the pin to go low after a tip, a bucket stuck
+// closed only wakes it this often (ms)
+#ifndef RAIN_SETTLE_MS
+#define RAIN_SETTLE_MS              60000
+#endif
+
+// ---------------------------- [ Windows ] ----------------------------
+
+// Burst window and the rain in it that raises a warning (s, micrometres)
+#ifndef RAIN_SHORT_WINDOW_S
+#define RAIN_SHORT_WINDOW_S         600
+#endif
+
+#ifndef RAIN_SHORT_WARNING_UM
+#define RAIN_SHORT_WARNING_UM       5000
+#endif
+
+// Hourly window
+#ifndef RAIN_HOUR_WINDOW_S
+#define RAIN_HOUR_WINDOW_S          3600
+#endif
+
+#ifndef RAIN_HOUR_WARNING_UM
+#define RAIN_HOUR_WARNING_UM        15000
+#endif
+
+// Antecedent window, the rain that has already soaked the slope
+#ifndef RAIN_DAY_WINDOW_S
+#define RAIN_DAY_WINDOW_S           86400
+#endif
+
+#ifndef RAIN_DAY_WARNING_UM
+#define RAIN_DAY_WARNING_UM         100000
+#endif
+
+// Time between checks for tips leaving the windows while the node idles
+// with rain in them (ms)
+#ifndef RAIN_IDLE_CHECK_MS
+#define RAIN_IDLE_CHECK_MS          60000
+#endif
+
+// Bucket tips that make up some rain, rounded up
+#define RAIN_TIPS(um)               (((um) + RAIN_TIP_UM - 1) / RAIN_TIP_UM)
+
+// Initialiser for the rain node's rain_rate_config_t
+#define RAIN_RATE_CONFIG {                                                      \
+    .tip_um = RAIN_TIP_UM,                                                      \
+    .windows = 3,                                                               \
+    .window = {                                                                 \
+        { RAIN_SHORT_WINDOW_S, RAIN_TIPS(RAIN_SHORT_WARNING_UM) },              \
+        { RAIN_HOUR_WINDOW_S, RAIN_TIPS(RAIN_HOUR_WARNING_UM) },                \
+        { RAIN_DAY_WINDOW_S, RAIN_TIPS(RAIN_DAY_WARNING_UM) }                   \
+    }                                                                           \
+}
+
+// Initialiser for the gauge pin's node_wake_config_t
+#define RAIN_WAKE_CONFIG {                      \
+    .pin = RAIN_TRIGGER_PIN,                    \
+    .debounce_us = RAIN_DEBOUNCE_US,            \
+    .holdoff_ms = RAIN_HOLDOFF_MS,              \
+    .settle_ms = RAIN_SETTLE_MS                 \
+}
+
+// ---------------------------- [ Checks ] -----------------------------
+
+#if RAIN_TIP_UM < 1
+#error "RAIN_TIP_UM must be at least 1"
+#endif
+
+#if RAIN_SHORT_WINDOW_S < 1 || RAIN_HOUR_WINDOW_S < 1 || RAIN_DAY_WINDOW_S < 1
+#error "The rain windows must be at least 1 s"
+#endif
+
+#if RAIN_DAY_WINDOW_S >= 24 * 24 * 60 * 60
+#error "The rain windows must be shorter than 24 days"
+#endif
+
+// The buffer has to hold every tip up to the largest threshold
+#if RAIN_TIPS(RAIN_SHORT_WARNING_UM) > RAIN_RATE_MAX_TIPS || \
+    RAIN_TIPS(RAIN_HOUR_WARNING_UM) > RAIN_RATE_MAX_TIPS || \
+    RAIN_TIPS(RAIN_DAY_WARNING_UM) > RAIN_RATE_MAX_TIPS
+#error "A rain warning threshold needs more tips than RAIN_RATE_MAX_TIPS holds"
+#endif
+
+#if RAIN_DEBOUNCE_US < 1
+#error "RAIN_DEBOUNCE_US must be at least 1"
+#endif
+
+#if RAIN_IDLE_CHECK_MS < 1 || RAIN_IDLE_CHECK_MS > 4000000
+#error "RAIN_IDLE_CHECK_MS must be from 1 to 4000000"
+#endif
+
+#if RAIN_SETTLE_MS != 0 && (RAIN_SETTLE_MS <= RAIN_HOLDOFF_MS || RAIN_SETTLE_MS > 4000000)
+#error "RAIN_SETTLE_MS must be 0 or from RAIN_HOLDOFF_MS to 4000000"
+#endif
+
+#endif // RAIN_CONFIG_H
@@ -0,0 +1,157 @@
+/**
+ * @file    rain_rate.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Rainfall intensity from the tipping bucket over several sliding
+ *          time windows at once (for example 10 min, 1 h and a 24 h
+ *          antecedent window). Each tip's time goes into one circular
+ *          buffer shared by every window, and each window keeps the index
+ *          of its oldest tip. A tip moves each window's index past the tips
+ *          that have left it, so every tip is added once and dropped once
+ *          per window, O(1) per tip however many tips a window holds.
+ *
+ *          A window warns when the rain in it reaches its threshold, so a
+ *          few tips spread over a week no longer raise the same warning as
+ *          a few in a minute.
+ *
+ *          The buffer holds RAIN_RATE_MAX_TIPS tips (4 KB with the default
+ *          1024). If a window holds more than that its oldest tips are
+ *          dropped early and counted in overflows. Times are in ms and may
+ *          wrap, windows must be shorter than 24 days. The rain node's set
+ *          up is RAIN_RATE_CONFIG in rain_config.h.
+ *
+*/
+
+#ifndef RAIN_RATE_H
+#define RAIN_RATE_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Most windows
+#define RAIN_RATE_MAX_WINDOWS   4
+
+// Tips the buffer holds, must be a power of two
+#ifndef RAIN_RATE_MAX_TIPS
+#define RAIN_RATE_MAX_TIPS      1024
+#endif
+
+// One window
+typedef struct
+{
+    uint32_t len_s;             // Length of the window
+    uint32_t warning_tips;      // Tips in the window that raise a warning, 0 for never
+} rain_window_config_t;
+
+// Bucket size and windows
+typedef struct
+{
+    uint32_t tip_um;            // Rain per bucket tip (micrometres)
+    uint8_t windows;            // Windows used, at most RAIN_RATE_MAX_WINDOWS
+    rain_window_config_t window[RAIN_RATE_MAX_WINDOWS];
+} rain_rate_config_t;
+
+// Estimator state
+typedef struct
+{
+    rain_rate_config_t config;
+
+    uint32_t tips[RAIN_RATE_MAX_TIPS];          // Time of each tip (ms)
+    uint32_t head;                              // Tips recorded
+    uint32_t tail[RAIN_RATE_MAX_WINDOWS];       // Oldest tip still in each window
+    uint32_t overflows;                         // Tips dropped early from a full buffer
+} rain_rate_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up an estimator with no tips
+ *
+ * @param rate The estimator
+ * @param config Bucket size and windows
+ * @return int 1 if successful 0 if there are no windows, too many or one is
+ * empty
+ */
+int rain_rate_init(rain_rate_t *rate, const rain_rate_config_t *config);
+
+/**
+ * @brief Adds a bucket tip
+ *
+ * @param rate The estimator
+ * @param now_ms The time of the tip, never before the last one
+ * @return uint32_t Bit n set if window n is at or over its warning threshold
+ */
+uint32_t rain_rate_tip(rain_rate_t *rate, uint32_t now_ms);
+
+/**
+ * @brief Checks which windows are at or over their warning threshold
+ *
+ * @param rate The estimator
+ * @return uint32_t Bit n set if window n is
+ */
+uint32_t rain_rate_over(const rain_rate_t *rate);
+
+/**
+ * @brief Drops the tips that have left each window by now, call before
+ * reading the windows if time has passed since the last tip
+ *
+ * @param rate The estimator
+ * @param now_ms The time now
+ */
+void rain_rate_expire(rain_rate_t *rate, uint32_t now_ms);
+
+/**
+ * @brief Gets the number of tips in a window
+ *
+ * @param rate The estimator
+ * @param window The window
+ * @return uint32_t The tips
+ */
+static inline uint32_t rain_rate_tips(const rain_rate_t *rate, uint8_t window)
+{
+    return rate->head - rate->tail[window];
+}
+
+/**
+ * @brief Gets the rain in a window
+ *
+ * @param rate The estimator
+ * @param window The window
+ * @return uint32_t The rain (micrometres)
+ */
+static inline uint32_t rain_rate_depth_um(const rain_rate_t *rate, uint8_t window)
+{
+    return rain_rate_tips(rate, window) * rate->config.tip_um;
+}
+
+/**
+ * @brief Gets the mean intensity over a window
+ *
+ * @param rate The estimator
+ * @param window The window
+ * @return uint32_t The intensity (micrometres per hour)
+ */
+uint32_t rain_rate_intensity_um_h(const rain_rate_t *rate, uint8_t window);
+
+/**
+ * @brief Checks if every window is empty, nothing then depends on how much
+ * time passes until the next tip
+ *
+ * @param rate The estimator
+ * @return true if no window holds a tip
+ */
+bool rain_rate_empty(const rain_rate_t *rate);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RAIN_RATE_H
@@ -0,0 +1,124 @@
+/**
+ * @file    seismic_capture.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Keeps the accelerometer waveform around a trigger. Every sample
+ *          the acquisition reads goes in, in the blocks of waveform.h, and
+ *          while nothing has triggered the oldest blocks are dropped once
+ *          pre_samples are kept. After the trigger post_samples more go in,
+ *          then the capture is closed into one contiguous capture of
+ *          waveform.h, ready to send to the Zero, and nothing more goes in
+ *          until it is armed again.
+ *
+ *          Samples wait in RAM until a block of WAVEFORM_BLOCK_SAMPLES is
+ *          full and are encoded then, so the cost is a few hundred cycles a
+ *          block. The encoded blocks go round a byte ring of
+ *          SEISMIC_CAPTURE_BYTES. If a shake packs so badly that the ring
+ *          fills, the pre trigger part is shortened first and then the post
+ *          trigger part is cut short, which the capture's flags say.
+ *
+*/
+
+#ifndef SEISMIC_CAPTURE_H
+#define SEISMIC_CAPTURE_H
+
+// ################################# [ Includes ] #################################
+
+#include "adxl343.h"
+#include "waveform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+typedef enum
+{
+    SEISMIC_CAPTURE_ARMED,      // Keeping the samples before a trigger
+    SEISMIC_CAPTURE_TRIGGERED,  // Keeping the samples after it
+    SEISMIC_CAPTURE_DONE        // Closed, waiting to be read
+} seismic_capture_state_t;
+
+// Counters since seismic_capture_init()
+typedef struct
+{
+    uint32_t captures;          // Captures closed
+    uint32_t shortened;         // Pre trigger blocks dropped to make room
+    uint32_t truncated;         // Captures cut short after the trigger
+} seismic_capture_stats_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the capture and arms it
+ *
+ * @param rate_hz The sample rate, kept in the capture
+ * @param lsb_per_g The sensitivity, kept in the capture
+ * @param pre_samples Samples to keep before the trigger
+ * @param post_samples Samples to keep after the trigger
+ */
+void seismic_capture_init(uint16_t rate_hz, uint16_t lsb_per_g, uint32_t pre_samples, uint32_t post_samples);
+
+/**
+ * @brief Empties the capture and waits for the next trigger
+ */
+void seismic_capture_arm(void);
+
+/**
+ * @brief Adds a sample, it is dropped once the capture is done
+ *
+ * @param sample The sample
+ * @return seismic_capture_state_t The state after it
+ */
+seismic_capture_state_t seismic_capture_add(const adxl343_sample_t *sample);
+
+/**
+ * @brief Makes the last sample added the trigger sample, if the capture is
+ * armed
+ *
+ * @param now_ms Node time of the trigger sample
+ */
+void seismic_capture_trigger(uint32_t now_ms);
+
+/**
+ * @brief Closes a triggered capture before all the post trigger samples
+ * have come, as if they had
+ */
+void seismic_capture_close(void);
+
+/**
+ * @brief Closes a triggered capture where it is, flagged WAVEFORM_TRUNCATED,
+ * because the samples after the last one added were lost
+ */
+void seismic_capture_cut(void);
+
+/**
+ * @brief Gets the state of the capture
+ *
+ * @return seismic_capture_state_t The state
+ */
+seismic_capture_state_t seismic_capture_state(void);
+
+/**
+ * @brief Gets a closed capture
+ *
+ * @param len Set to its length
+ * @return const uint8_t* The capture in the layout of waveform.h, NULL if it
+ * is not closed
+ */
+const uint8_t *seismic_capture_get(size_t *len);
+
+/**
+ * @brief Gets the capture counters
+ *
+ * @return const seismic_capture_stats_t* The counters
+ */
+const seismic_capture_stats_t *seismic_capture_stats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SEISMIC_CAPTURE_H
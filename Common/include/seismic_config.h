@@ -0,0 +1,282 @@
+/**
+ * @file    seismic_config.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Build time configuration of the seismic node: accelerometer bus and
+ *          pins, detection thresholds, the window checked after each wake, the
+ *          waveform capture around a trigger, the STA/LTA set up and the
+ *          accelerometer's own activity trigger. Defaults are the values the node was first
+ *          built with, a site profile can change any of them (see
+ *          node_config.h).
+ *
+*/
+
+#ifndef SEISMIC_CONFIG_H
+#define SEISMIC_CONFIG_H
+
+// ################################# [ Includes ] #################################
+
+#include "node_config.h"
+#include "adxl343.h"
+#include "waveform.h"
+
+// ################################## [ Types ] ###################################
+
+// ---------------------------- [ Accelerometer ] ----------------------
+
+// I2C bus, speed and pins for the accelerometer
+#ifndef SEISMIC_I2C
+#define SEISMIC_I2C                 HAL_I2C0
+#endif
+
+#ifndef SEISMIC_I2C_BAUD
+#define SEISMIC_I2C_BAUD            (400 * 1000)
+#endif
+
+#ifndef SEISMIC_SDA_PIN
+#define SEISMIC_SDA_PIN             4
+#endif
+
+#ifndef SEISMIC_SCL_PIN
+#define SEISMIC_SCL_PIN             5
+#endif
+
+// I2C address of the accelerometer
+#ifndef SEISMIC_ADXL343_ADDR
+#define SEISMIC_ADXL343_ADDR        ADXL343_I2C_ADDR
+#endif
+
+// INT1 Pin of the accelerometer
+#ifndef SEISMIC_INT_PIN
+#define SEISMIC_INT_PIN             6
+#endif
+
+// Trigger Pin for the Vibration Sensor
+#ifndef SEISMIC_TRIGGER_PIN
+#define SEISMIC_TRIGGER_PIN         10
+#endif
+
+// ---------------------------- [ Wake ] -------------------------------
+
+// Time the vibration sensor's output must stay high after an edge for it to
+// wake the node, longer than a spike on the line (us)
+#ifndef SEISMIC_WAKE_DEBOUNCE_US
+#define SEISMIC_WAKE_DEBOUNCE_US    2000
+#endif
+
+// Time the output must be quiet after a check before an edge wakes the node
+// again, so the rest of a shake that was just checked does not (ms)
+#ifndef SEISMIC_WAKE_HOLDOFF_MS
+#define SEISMIC_WAKE_HOLDOFF_MS     500
+#endif
+
+// Longest the node waits for the output to go quiet, so a long shake is
+// still checked this often (ms)
+#ifndef SEISMIC_WAKE_SETTLE_MS
+#define SEISMIC_WAKE_SETTLE_MS      5000
+#endif
+
+// Initialiser for the trigger pin's node_wake_config_t
+#define SEISMIC_WAKE_CONFIG {                   \
+    .pin = SEISMIC_TRIGGER_PIN,                 \
+    .debounce_us = SEISMIC_WAKE_DEBOUNCE_US,    \
+    .holdoff_ms = SEISMIC_WAKE_HOLDOFF_MS,      \
+    .settle_ms = SEISMIC_WAKE_SETTLE_MS         \
+}
+
+// ---------------------------- [ Detection ] --------------------------
+
+// Kernels, SEISMIC_DETECTOR picks the one the risk check uses
+#define SEISMIC_DETECT_MAGNITUDE    0
+#define SEISMIC_DETECT_AXIS         1
+#define SEISMIC_DETECT_HP           2
+
+#ifndef SEISMIC_DETECTOR
+#define SEISMIC_DETECTOR            SEISMIC_DETECT_MAGNITUDE
+#endif
+
+// Sensitivity of the accelerometer in the +-2 g range (LSB/g)
+#ifndef SEISMIC_LSB_PER_G
+#define SEISMIC_LSB_PER_G           256
+#endif
+
+// Acceleration above which there is a landslide risk (mg)
+#ifndef SEISMIC_THRESHOLD_MG
+#define SEISMIC_THRESHOLD_MG        2000
+#endif
+
+// Acceleration with gravity removed above which there is a landslide risk
+// for the high pass kernel (mg)
+#ifndef SEISMIC_HP_THRESHOLD_MG
+#define SEISMIC_HP_THRESHOLD_MG     1000
+#endif
+
+// Running average of the high pass kernel follows gravity with a time
+// constant of 2^SEISMIC_HP_SHIFT samples
+#ifndef SEISMIC_HP_SHIFT
+#define SEISMIC_HP_SHIFT            6
+#endif
+
+// ---------------------------- [ Risk check ] -------------------------
+
+// Samples checked after each trigger
+#ifndef SEISMIC_RISK_WINDOW
+#define SEISMIC_RISK_WINDOW         200
+#endif
+
+// Output data rate and FIFO watermark used for the check
+#ifndef SEISMIC_FIFO_RATE
+#define SEISMIC_FIFO_RATE           ADXL343_RATE_800HZ
+#endif
+
+#ifndef SEISMIC_FIFO_WATERMARK
+#define SEISMIC_FIFO_WATERMARK      28
+#endif
+
+// ---------------------------- [ Capture ] ----------------------------
+
+// Keep the waveform around a risk check's trigger and send it to the Zero
+// (seismic_capture.h), 0 to leave it out
+#ifndef SEISMIC_CAPTURE
+#define SEISMIC_CAPTURE             1
+#endif
+
+// Waveform kept before and after the trigger sample (ms)
+#ifndef SEISMIC_CAPTURE_PRE_MS
+#define SEISMIC_CAPTURE_PRE_MS      1000
+#endif
+
+#ifndef SEISMIC_CAPTURE_POST_MS
+#define SEISMIC_CAPTURE_POST_MS     2000
+#endif
+
+// RAM for the encoded waveform. 3 s at 800 Hz is 14.4 kB raw, encoded it
+// takes about 1.5 bytes a sample in a shake and half that at rest.
+#ifndef SEISMIC_CAPTURE_BYTES
+#define SEISMIC_CAPTURE_BYTES       8192
+#endif
+
+// Samples before and after the trigger at the risk check's rate
+#define SEISMIC_CAPTURE_PRE         ((uint32_t)SEISMIC_CAPTURE_PRE_MS * ADXL343_RATE_HZ(SEISMIC_FIFO_RATE) / 1000)
+#define SEISMIC_CAPTURE_POST        ((uint32_t)SEISMIC_CAPTURE_POST_MS * ADXL343_RATE_HZ(SEISMIC_FIFO_RATE) / 1000)
+
+// ---------------------------- [ STA/LTA ] ----------------------------
+
+// Windows (samples at 100 Hz) and ratios of the continuous detector. The
+// defaults give a 500 ms short window and 5 s long window, events over 3x
+// the background ending under 1.5x, with a floor of a 0.18 g shake (45 LSB
+// rms). A single 2 g knock averaged over the short window stays under the
+// trigger, 0.5 g of shaking for half a second goes over it.
+#ifndef SEISMIC_STA_LEN
+#define SEISMIC_STA_LEN             50
+#endif
+
+#ifndef SEISMIC_LTA_LEN
+#define SEISMIC_LTA_LEN             500
+#endif
+
+#ifndef SEISMIC_STA_LTA_TRIGGER
+#define SEISMIC_STA_LTA_TRIGGER     3.0
+#endif
+
+#ifndef SEISMIC_STA_LTA_DETRIGGER
+#define SEISMIC_STA_LTA_DETRIGGER   1.5
+#endif
+
+#ifndef SEISMIC_STA_LTA_FLOOR
+#define SEISMIC_STA_LTA_FLOOR       2048
+#endif
+
+// Initialiser for an sta_lta_config_t, needs sta_lta.h
+#define SEISMIC_STA_LTA_CONFIG { \
+    .sta_len = SEISMIC_STA_LEN,                             \
+    .lta_len = SEISMIC_LTA_LEN,                             \
+    .trigger = STA_LTA_RATIO(SEISMIC_STA_LTA_TRIGGER),      \
+    .detrigger = STA_LTA_RATIO(SEISMIC_STA_LTA_DETRIGGER),  \
+    .lta_floor = SEISMIC_STA_LTA_FLOOR                      \
+}
+
+// ---------------------------- [ Activity trigger ] ------------------
+
+// Change from where the accelerometer came to rest that wakes the trigger
+// variant, AC coupled so gravity is left out. The default is the risk
+// threshold less the 1 g of gravity in it (mg, counted in 62.5 mg steps).
+#ifndef SEISMIC_ACT_MG
+#define SEISMIC_ACT_MG              (SEISMIC_THRESHOLD_MG - 1000)
+#endif
+
+// The accelerometer is at rest again once it stays within this of where it
+// last moved to for SEISMIC_INACT_S (mg, s)
+#ifndef SEISMIC_INACT_MG
+#define SEISMIC_INACT_MG            250
+#endif
+
+#ifndef SEISMIC_INACT_S
+#define SEISMIC_INACT_S             5
+#endif
+
+// Low power output data rate it watches at
+#ifndef SEISMIC_ACT_RATE
+#define SEISMIC_ACT_RATE            ADXL343_RATE_100HZ
+#endif
+
+// Drop to SEISMIC_SLEEP_WAKEUP once at rest, until the next activity. At
+// 1 Hz the part draws 23 uA, half of what it does at 8 Hz, and a shake that
+// lasts a second is still seen.
+#ifndef SEISMIC_AUTO_SLEEP
+#define SEISMIC_AUTO_SLEEP          1
+#endif
+
+#ifndef SEISMIC_SLEEP_WAKEUP
+#define SEISMIC_SLEEP_WAKEUP        ADXL343_WAKEUP_1HZ
+#endif
+
+// Initialiser for the accelerometer's adxl343_power_config_t, needs
+// adxl343_power.h. rest is the mode between acquisitions.
+#define SEISMIC_POWER_CONFIG(rest_mode) {                                                     \
+    .rest = (rest_mode),                                                                      \
+    .watch_rate = SEISMIC_ACT_RATE,                                                           \
+    .act_thresh = ADXL343_THRESH(SEISMIC_ACT_MG),                                             \
+    .inact_thresh = ADXL343_THRESH(SEISMIC_INACT_MG),                                         \
+    .inact_s = SEISMIC_INACT_S,                                                               \
+    .act_inact_ctl = ADXL343_ACT_AC | ADXL343_ACT_XYZ | ADXL343_INACT_AC | ADXL343_INACT_XYZ, \
+    .watch_ints = ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY,                              \
+    .auto_sleep = SEISMIC_AUTO_SLEEP,                                                         \
+    .wakeup = SEISMIC_SLEEP_WAKEUP                                                            \
+}
+
+// ---------------------------- [ Checks ] -----------------------------
+
+#if SEISMIC_FIFO_WATERMARK < 1 || SEISMIC_FIFO_WATERMARK >= ADXL343_FIFO_DEPTH
+#error "SEISMIC_FIFO_WATERMARK must be from 1 to 31"
+#endif
+
+#if SEISMIC_CAPTURE && (SEISMIC_CAPTURE_BYTES < 4 * WAVEFORM_BLOCK_MAX || SEISMIC_CAPTURE_BYTES > 65536)
+#error "SEISMIC_CAPTURE_BYTES must be from 4 * WAVEFORM_BLOCK_MAX to 65536"
+#endif
+
+#if SEISMIC_ACT_MG < 63 || SEISMIC_ACT_MG > 15937 || SEISMIC_INACT_MG < 63 || SEISMIC_INACT_MG > 15937
+#error "SEISMIC_ACT_MG and SEISMIC_INACT_MG must be from 63 to 15937"
+#endif
+
+#if SEISMIC_INACT_S < 1 || SEISMIC_INACT_S > 255
+#error "SEISMIC_INACT_S must be from 1 to 255"
+#endif
+
+#if SEISMIC_ACT_RATE < ADXL343_RATE_12HZ5 || SEISMIC_ACT_RATE > ADXL343_RATE_400HZ
+#error "SEISMIC_ACT_RATE must be a low power rate, ADXL343_RATE_12HZ5 to ADXL343_RATE_400HZ"
+#endif
+
+#if SEISMIC_SLEEP_WAKEUP < ADXL343_WAKEUP_8HZ || SEISMIC_SLEEP_WAKEUP > ADXL343_WAKEUP_1HZ
+#error "SEISMIC_SLEEP_WAKEUP must be one of the ADXL343_WAKEUP_* rates"
+#endif
+
+#if SEISMIC_STA_LEN < 1 || SEISMIC_STA_LEN > SEISMIC_LTA_LEN
+#error "SEISMIC_STA_LEN must be from 1 to SEISMIC_LTA_LEN"
+#endif
+
+#if SEISMIC_WAKE_SETTLE_MS != 0 && \
+    (SEISMIC_WAKE_SETTLE_MS <= SEISMIC_WAKE_HOLDOFF_MS || SEISMIC_WAKE_SETTLE_MS > 4000000)
+#error "SEISMIC_WAKE_SETTLE_MS must be 0 or from SEISMIC_WAKE_HOLDOFF_MS to 4000000"
+#endif
+
+#endif // SEISMIC_CONFIG_H
@@ -0,0 +1,147 @@
+/**
+ * @file    seismic_detect.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Integer detection kernels for the seismic hot loop. The RP2040 has
+ *          no FPU, so instead of converting each axis to g and taking a
+ *          square root, the squared magnitude in LSB is compared against a
+ *          squared threshold worked out at compile time from the range and
+ *          sensitivity.
+ *
+ *          Three kernels are provided:
+ *            magnitude  x^2 + y^2 + z^2 > T^2, the same rule as |a| > T
+ *            per axis   any of |x|, |y|, |z| > T, no multiplies at all
+ *            high pass  the magnitude rule on the acceleration with gravity
+ *                       removed by a running average of each axis
+ *
+*/
+
+#ifndef SEISMIC_DETECT_H
+#define SEISMIC_DETECT_H
+
+// ################################# [ Includes ] #################################
+
+#include "adxl343.h"
+#include "seismic_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Thresholds from seismic_config.h in LSB and squared LSB, worked out at
+// compile time. A full scale int16 sample squared and summed over three axes
+// fits in 32 bits unsigned.
+#define SEISMIC_THRESHOLD_LSB       ((SEISMIC_THRESHOLD_MG * SEISMIC_LSB_PER_G) / 1000)
+#define SEISMIC_THRESHOLD_SQ        ((uint32_t)SEISMIC_THRESHOLD_LSB * SEISMIC_THRESHOLD_LSB)
+#define SEISMIC_HP_THRESHOLD_LSB    ((SEISMIC_HP_THRESHOLD_MG * SEISMIC_LSB_PER_G) / 1000)
+#define SEISMIC_HP_THRESHOLD_SQ     ((uint32_t)SEISMIC_HP_THRESHOLD_LSB * SEISMIC_HP_THRESHOLD_LSB)
+
+// Running average of each axis for the high pass kernel, in LSB scaled up by
+// 2^SEISMIC_HP_SHIFT
+typedef struct
+{
+    int32_t gravity[3];
+    bool primed;
+} seismic_hp_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Squared magnitude of a sample
+ *
+ * @param sample The sample
+ * @return uint32_t x^2 + y^2 + z^2 in LSB^2
+ */
+static inline uint32_t seismic_magnitude_sq(const adxl343_sample_t *sample)
+{
+    return (uint32_t)((int32_t)sample->x * sample->x) + (uint32_t)((int32_t)sample->y * sample->y) +
+           (uint32_t)((int32_t)sample->z * sample->z);
+}
+
+/**
+ * @brief Checks the magnitude of a sample against the threshold
+ *
+ * @param sample The sample
+ * @return int 1 if there is a landslide risk 0 if there is not
+ */
+static inline int seismic_detect_magnitude(const adxl343_sample_t *sample)
+{
+    return seismic_magnitude_sq(sample) > SEISMIC_THRESHOLD_SQ;
+}
+
+/**
+ * @brief Checks each axis of a sample against the threshold
+ *
+ * @param sample The sample
+ * @return int 1 if there is a landslide risk 0 if there is not
+ */
+static inline int seismic_detect_axis(const adxl343_sample_t *sample)
+{
+    return sample->x > SEISMIC_THRESHOLD_LSB || sample->x < -SEISMIC_THRESHOLD_LSB ||
+           sample->y > SEISMIC_THRESHOLD_LSB || sample->y < -SEISMIC_THRESHOLD_LSB ||
+           sample->z > SEISMIC_THRESHOLD_LSB || sample->z < -SEISMIC_THRESHOLD_LSB;
+}
+
+/**
+ * @brief Forgets the gravity estimate of the high pass kernel, the next
+ * sample is taken as gravity
+ *
+ * @param hp The kernel state
+ */
+static inline void seismic_hp_reset(seismic_hp_t *hp)
+{
+    hp->primed = false;
+}
+
+/**
+ * @brief Removes gravity from a sample using a running average of each axis
+ *
+ * @param hp The kernel state
+ * @param sample The sample
+ * @return uint32_t The squared magnitude of what is left in LSB^2
+ */
+static inline uint32_t seismic_hp_energy(seismic_hp_t *hp, const adxl343_sample_t *sample)
+{
+    int32_t axis[3] = {sample->x, sample->y, sample->z};
+    uint32_t mag_sq = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (!hp->primed)
+        {
+            hp->gravity[i] = axis[i] * (1 << SEISMIC_HP_SHIFT);
+        }
+
+        // Move the average 1/2^shift of the way towards the sample
+        hp->gravity[i] += axis[i] - (hp->gravity[i] >> SEISMIC_HP_SHIFT);
+
+        int32_t dynamic = axis[i] - (hp->gravity[i] >> SEISMIC_HP_SHIFT);
+        uint32_t size = dynamic < 0 ? (uint32_t)-dynamic : (uint32_t)dynamic;
+        mag_sq += size * size;
+    }
+
+    hp->primed = true;
+
+    return mag_sq;
+}
+
+/**
+ * @brief Removes gravity from a sample and checks the magnitude of what is
+ * left against the high pass threshold
+ *
+ * @param hp The kernel state
+ * @param sample The sample
+ * @return int 1 if there is a landslide risk 0 if there is not
+ */
+static inline int seismic_detect_hp(seismic_hp_t *hp, const adxl343_sample_t *sample)
+{
+    return seismic_hp_energy(hp, sample) > SEISMIC_HP_THRESHOLD_SQ;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SEISMIC_DETECT_H
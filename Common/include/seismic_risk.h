@@ -0,0 +1,89 @@
+/**
+ * @file    seismic_risk.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   The "is there a landslide risk" check shared by the seismic
+ *          firmware variants that are woken by a trigger. It reads a window
+ *          of samples through the ADXL343 FIFO engine (adxl343_fifo.h) and
+ *          checks each one against the risk threshold. The window, rate and
+ *          threshold are set in seismic_config.h. Every sample also goes
+ *          through the high pass of seismic_detect.h, whichever kernel
+ *          decides, so the report has the peak with gravity taken off on any
+ *          mount.
+ *
+ *          With SEISMIC_CAPTURE on, every sample also goes to the waveform
+ *          capture (seismic_capture.h). The check returns at the decision,
+ *          and a risk keeps the acquisition going in the background, so the
+ *          warning can be raised at once. seismic_risk_finish() then takes
+ *          the samples after the trigger into the capture, which takes up to
+ *          SEISMIC_CAPTURE_POST_MS. It has to be called before anything that
+ *          stops the interrupts for long, as only the accelerometer's FIFO
+ *          fills then, 40 ms of samples, less than a flash erase of the
+ *          event log takes.
+ *
+*/
+
+#ifndef SEISMIC_RISK_H
+#define SEISMIC_RISK_H
+
+// ################################# [ Includes ] #################################
+
+#include "adxl343_fifo.h"
+#include "seismic_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// What happened during one check
+typedef struct
+{
+    uint32_t samples;       // Samples read from the accelerometer
+    uint32_t checked;       // Samples checked, the rest are only captured
+    uint32_t reads;         // DMA jobs used up to the decision
+    float peak_g;           // Largest acceleration seen in g
+    uint32_t dynamic_mg;    // Largest acceleration with gravity taken off by the high pass in mg
+    uint64_t awake_us;      // Time from the start of the check to the decision
+} seismic_risk_report_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the FIFO engine for risk checks, the I2C bus must already
+ * be set up
+ *
+ * @param i2c The I2C bus the accelerometer is on
+ * @param addr The address of the accelerometer
+ * @param int_pin The Pico pin wired to INT1 on the accelerometer
+ * @return int 1 if successful 0 if failed
+ */
+int seismic_risk_init(hal_i2c_t i2c, uint8_t addr, uint int_pin);
+
+/**
+ * @brief Reads up to a window of samples and checks them for a landslide
+ * risk, stopping at the first sample over the threshold. With SEISMIC_CAPTURE
+ * on a risk leaves the acquisition going for the capture, see
+ * seismic_risk_finish().
+ *
+ * @param window The number of samples to check
+ * @param report Filled in with what happened up to the decision, can be NULL
+ * @return int 1 if there is a landslide risk 0 if there is not
+ */
+int seismic_risk_check(uint32_t window, seismic_risk_report_t *report);
+
+/**
+ * @brief Takes the rest of the samples after the trigger into the capture
+ * and ends the acquisition, does nothing if the last check left none to take
+ *
+ * @return uint32_t The samples taken
+ */
+uint32_t seismic_risk_finish(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SEISMIC_RISK_H
@@ -0,0 +1,182 @@
+/**
+ * @file    sensor_codec.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Lossless compression of batches of sensor readings, for sending
+ *          them to the Zero or keeping them in flash, with the Zero's
+ *          decoder. Each kind of reading has its own coding, picked for how
+ *          it changes:
+ *
+ *            accel  x y z samples, in the blocks of waveform.h. The changes
+ *                   of a block are packed at one width per axis, as noise
+ *                   and shaking spread them evenly.
+ *            soil   moisture readings and their times. The time goes as the
+ *                   change in the interval since the last reading, which is
+ *                   0 while the wake interval holds, the moisture as its
+ *                   change. Both are zigzagged and Rice coded.
+ *            rain   tip times. They go as the interval since the last tip,
+ *                   Rice coded, as the intervals run from seconds in a storm
+ *                   to weeks between them.
+ *
+ *          The encoder takes one reading at a time and encodes them in blocks
+ *          of SENSOR_CODEC_BLOCK, so it needs no more RAM than a block. Every
+ *          soil and rain block picks the Rice parameters that pack its own
+ *          values smallest, so a batch follows the rain from drizzle to
+ *          downpour.
+ *          Values that do not fit the block's parameter escape to their own
+ *          width (bitpack.h). A batch starts from zero, so it can be decoded
+ *          alone. All fields are little endian:
+ *
+ *            batch
+ *              0      1    kind, sensor_codec_kind_t
+ *              1      2    readings in the batch, n
+ *              3      -    accel: waveform blocks, one after the other
+ *                          soil, rain: one stream of bits, from the low bit
+ *                          of each byte up. Each block of up to
+ *                          SENSOR_CODEC_BLOCK readings starts with its Rice
+ *                          parameters in 5 bits each (soil: time then
+ *                          moisture), then for each reading its values
+ *                          (soil: time then moisture)
+ *
+ *          Nothing here uses the HAL, the Zero's tools build it as it is.
+ *
+*/
+
+#ifndef SENSOR_CODEC_H
+#define SENSOR_CODEC_H
+
+// ################################# [ Includes ] #################################
+
+#include "bitpack.h"
+#include "waveform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+#define SENSOR_CODEC_HEADER     3
+#define SENSOR_CODEC_BLOCK      WAVEFORM_BLOCK_SAMPLES
+#define SENSOR_CODEC_MAX        0xFFFF
+
+// Longest soil block, every value escaped, the longest of any kind
+#define SENSOR_CODEC_BLOCK_MAX  ((10 + SENSOR_CODEC_BLOCK * 2 * BITS_RICE_MAX + 7) / 8)
+
+typedef enum
+{
+    SENSOR_CODEC_ACCEL = 1,
+    SENSOR_CODEC_SOIL = 2,
+    SENSOR_CODEC_RAIN = 3
+} sensor_codec_kind_t;
+
+// A soil reading
+typedef struct
+{
+    uint32_t time_ms;
+    int32_t moisture;
+} sensor_soil_t;
+
+// A decoded reading, of the batch's kind
+typedef union
+{
+    waveform_sample_t accel;
+    sensor_soil_t soil;
+    uint32_t tip_ms;
+} sensor_value_t;
+
+// Called with each decoded reading, oldest first
+typedef void (*sensor_value_fn_t)(void *ctx, uint32_t index, const sensor_value_t *value);
+
+// An encoder and the batch it is filling
+typedef struct
+{
+    sensor_codec_kind_t kind;
+    uint8_t *dst;
+    size_t cap;
+    uint32_t count;             // Readings taken
+
+    // Readings waiting to fill a block
+    union
+    {
+        waveform_sample_t accel[SENSOR_CODEC_BLOCK];
+        sensor_soil_t soil[SENSOR_CODEC_BLOCK];
+        uint32_t tip_ms[SENSOR_CODEC_BLOCK];
+    } stage;
+    uint32_t staged;
+
+    // Where the blocks go, and the last reading the changes are from
+    bits_writer_t w;
+    uint32_t last_ms;
+    uint32_t last_interval;
+    int32_t last_moisture;
+} sensor_codec_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Starts a batch
+ *
+ * @param codec The encoder
+ * @param kind What the batch holds
+ * @param dst Where to encode it
+ * @param cap Bytes at dst, at least SENSOR_CODEC_HEADER
+ */
+void sensor_codec_init(sensor_codec_t *codec, sensor_codec_kind_t kind, uint8_t *dst, size_t cap);
+
+/**
+ * @brief Adds an accelerometer sample to an accel batch
+ *
+ * @param codec The encoder
+ * @param sample The sample
+ * @return true if it was taken, false if the batch is full or not accel
+ */
+bool sensor_codec_accel(sensor_codec_t *codec, const waveform_sample_t *sample);
+
+/**
+ * @brief Adds a moisture reading to a soil batch
+ *
+ * @param codec The encoder
+ * @param time_ms Node time of the reading
+ * @param moisture The reading
+ * @return true if it was taken, false if the batch is full or not soil
+ */
+bool sensor_codec_soil(sensor_codec_t *codec, uint32_t time_ms, int32_t moisture);
+
+/**
+ * @brief Adds a tip time to a rain batch, tips come in time order and may
+ * wrap round 2^32 ms
+ *
+ * @param codec The encoder
+ * @param tip_ms Node time of the tip
+ * @return true if it was taken, false if the batch is full or not rain
+ */
+bool sensor_codec_rain(sensor_codec_t *codec, uint32_t tip_ms);
+
+/**
+ * @brief Encodes the readings still waiting and closes the batch
+ *
+ * @param codec The encoder
+ * @return size_t The length of the batch at dst
+ */
+size_t sensor_codec_finish(sensor_codec_t *codec);
+
+/**
+ * @brief Decodes a batch
+ *
+ * @param src The batch
+ * @param len Its length
+ * @param fn Called with each reading, can be NULL
+ * @param ctx Passed to fn
+ * @param kind Set to what the batch holds, can be NULL
+ * @return int32_t The readings in it, -1 if it is broken
+ */
+int32_t sensor_codec_decode(const uint8_t *src, size_t len, sensor_value_fn_t fn, void *ctx,
+                            sensor_codec_kind_t *kind);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_CODEC_H
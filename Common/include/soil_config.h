@@ -0,0 +1,114 @@
+/**
+ * @file    soil_config.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Build time configuration of the soil node: the probe UART, its
+ *          timings, the moisture threshold, the readings taken on each wake
+ *          and the limits of the adaptive wake interval. A site profile can
+ *          change any of them (see node_config.h).
+ *
+*/
+
+#ifndef SOIL_CONFIG_H
+#define SOIL_CONFIG_H
+
+// ################################# [ Includes ] #################################
+
+#include "node_config.h"
+
+// ################################## [ Types ] ###################################
+
+// ---------------------------- [ Probe ] ------------------------------
+
+// UART bus, speed and pins for the soil sensor
+#ifndef SOIL_UART
+#define SOIL_UART                   HAL_UART1
+#endif
+
+#ifndef SOIL_UART_BAUD
+#define SOIL_UART_BAUD              9600
+#endif
+
+// UART TX Pin, wired to the RX pin of the soil sensor
+#ifndef SOIL_UART_TX_PIN
+#define SOIL_UART_TX_PIN            4
+#endif
+
+// UART RX Pin, wired to the TX pin of the soil sensor
+#ifndef SOIL_UART_RX_PIN
+#define SOIL_UART_RX_PIN            5
+#endif
+
+// Time the probe takes to boot after power up (ms)
+#ifndef SOIL_PROBE_BOOT_MS
+#define SOIL_PROBE_BOOT_MS          2000
+#endif
+
+// Longest time to wait for the answer to a reading command (ms), the probe
+// usually answers in about 100 ms
+#ifndef SOIL_PROBE_TIMEOUT_MS
+#define SOIL_PROBE_TIMEOUT_MS       500
+#endif
+
+// Times a reading is asked for before it is skipped
+#ifndef SOIL_PROBE_ATTEMPTS
+#define SOIL_PROBE_ATTEMPTS         3
+#endif
+
+// ---------------------------- [ Readings ] ---------------------------
+
+// Moisture above which there is a landslide risk
+#ifndef SOIL_MOISTURE_THRESHOLD
+#define SOIL_MOISTURE_THRESHOLD     50
+#endif
+
+// Readings taken each time the node wakes
+#ifndef SOIL_READINGS_PER_WAKE
+#define SOIL_READINGS_PER_WAKE      10
+#endif
+
+// ---------------------------- [ Wake interval ] ----------------------
+
+// Shortest time asleep between wakes of the power saving variant, used
+// while the moisture is changing fast or is over the threshold (s)
+#ifndef SOIL_SLEEP_S
+#define SOIL_SLEEP_S                10
+#endif
+
+// Longest time asleep, reached while the moisture stays still (s). Set it
+// to SOIL_SLEEP_S for a fixed interval.
+#ifndef SOIL_SLEEP_MAX_S
+#define SOIL_SLEEP_MAX_S            1800
+#endif
+
+// Moisture change aimed for between wakes, smaller wakes more often
+#ifndef SOIL_SCHEDULE_STEP
+#define SOIL_SCHEDULE_STEP          2
+#endif
+
+// Initialiser for a soil_schedule_config_t, needs soil_schedule.h
+#define SOIL_SCHEDULE_CONFIG {                  \
+    .min_s = SOIL_SLEEP_S,                      \
+    .max_s = SOIL_SLEEP_MAX_S,                  \
+    .step = SOIL_SCHEDULE_STEP,                 \
+    .threshold = SOIL_MOISTURE_THRESHOLD        \
+}
+
+// ---------------------------- [ Checks ] -----------------------------
+
+#if SOIL_READINGS_PER_WAKE < 1
+#error "SOIL_READINGS_PER_WAKE must be at least 1"
+#endif
+
+#if SOIL_PROBE_ATTEMPTS < 1 || SOIL_PROBE_ATTEMPTS > 255
+#error "SOIL_PROBE_ATTEMPTS must be from 1 to 255"
+#endif
+
+#if SOIL_SLEEP_S < 1 || SOIL_SLEEP_MAX_S < SOIL_SLEEP_S
+#error "SOIL_SLEEP_S must be at least 1 s and at most SOIL_SLEEP_MAX_S"
+#endif
+
+#if SOIL_SCHEDULE_STEP < 1
+#error "SOIL_SCHEDULE_STEP must be at least 1"
+#endif
+
+#endif // SOIL_CONFIG_H
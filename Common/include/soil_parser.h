@@ -0,0 +1,113 @@
+/**
+ * @file    soil_parser.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Streaming parser for the soil probe's answers. The probe answers a
+ *          'w' command with one line:
+ *
+ *            Moisture=<1 to 4 digits>\r\n
+ *
+ *          Bytes are fed in one at a time as they arrive and each one costs a
+ *          lookup in a byte class table and a lookup in a state transition
+ *          table. The value is built up digit by digit as it goes, so nothing
+ *          is copied or allocated and no atoi is needed.
+ *
+ *          Anything that does not fit the frame sends the parser to a bad
+ *          line state that ends at the next '\n' with SOIL_PARSE_MALFORMED
+ *          (or SOIL_PARSE_OVERFLOW for too many digits). An 'M' anywhere
+ *          restarts the frame, so line noise in front of an answer is skipped
+ *          without losing the answer. Empty lines are ignored.
+ *
+*/
+
+#ifndef SOIL_PARSER_H
+#define SOIL_PARSER_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Most digits in a value, so it always fits a uint16_t
+#define SOIL_PARSER_MAX_DIGITS  4
+
+// What a byte did
+typedef enum
+{
+    SOIL_PARSE_MORE,            // The line is not finished yet
+    SOIL_PARSE_OK,              // A frame ended, its value is in the parser
+    SOIL_PARSE_MALFORMED,       // A line ended that was not a frame
+    SOIL_PARSE_OVERFLOW         // A frame ended with more than SOIL_PARSER_MAX_DIGITS
+} soil_parse_status_t;
+
+// Parser state
+typedef struct
+{
+    uint8_t state;              // Where the parser is in the line
+    uint16_t value;             // Value of the last frame, or the one being read
+
+    uint32_t frames;            // Frames read
+    uint32_t malformed;         // Lines that were not frames
+    uint32_t overflows;         // Frames with too many digits
+    uint32_t resyncs;           // Frames restarted part way through a line
+} soil_parser_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets the parser to the start of a line and clears its counters
+ *
+ * @param parser The parser
+ */
+void soil_parser_init(soil_parser_t *parser);
+
+/**
+ * @brief Drops any part read line, the counters are kept
+ *
+ * @param parser The parser
+ */
+void soil_parser_reset(soil_parser_t *parser);
+
+/**
+ * @brief Feeds one byte to the parser
+ *
+ * @param parser The parser
+ * @param c The byte
+ * @return soil_parse_status_t SOIL_PARSE_MORE until a line ends, then how it
+ * ended
+ */
+soil_parse_status_t soil_parser_feed(soil_parser_t *parser, uint8_t c);
+
+/**
+ * @brief Feeds bytes to the parser until a line ends or they run out
+ *
+ * @param parser The parser
+ * @param buf The bytes
+ * @param len The number of bytes
+ * @param status Set to how the line ended, or SOIL_PARSE_MORE if it did not
+ * @return size_t The number of bytes used, up to and including the '\n'
+ */
+size_t soil_parser_feed_buf(soil_parser_t *parser, const uint8_t *buf, size_t len, soil_parse_status_t *status);
+
+/**
+ * @brief Gets the value of the last frame, only valid after SOIL_PARSE_OK
+ *
+ * @param parser The parser
+ * @return uint16_t The value
+ */
+static inline uint16_t soil_parser_value(const soil_parser_t *parser)
+{
+    return parser->value;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOIL_PARSER_H
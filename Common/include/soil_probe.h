@@ -0,0 +1,92 @@
+/**
+ * @file    soil_probe.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Interrupt driven driver for the UART soil moisture probe. The
+ *          UART receive interrupt moves each byte into a ring buffer, and a
+ *          read sends the 'w' command and then sleeps until bytes arrive,
+ *          feeding them to the streaming parser in soil_parser.h, which
+ *          finishes as soon as the "Moisture=<value>\r\n" line ends. The core idles through the
+ *          probe's response latency instead of busy waiting for a fixed
+ *          time, and a read that gets no answer times out.
+ *
+ *          Reads must not be made from an interrupt handler, the receive
+ *          interrupt has to be able to run while they wait.
+ *
+*/
+
+#ifndef SOIL_PROBE_H
+#define SOIL_PROBE_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Bytes the ring buffer holds, must be a power of two. An answer is at most
+// 16 bytes, so this holds several even if the core is slow to read them.
+#define SOIL_PROBE_RING_SIZE    64
+
+// How a read ended
+typedef enum
+{
+    SOIL_PROBE_OK,              // A value was read
+    SOIL_PROBE_TIMEOUT,         // No complete line arrived in time
+    SOIL_PROBE_MALFORMED        // A line ended without a valid value
+} soil_probe_status_t;
+
+// Counters since soil_probe_init()
+typedef struct
+{
+    uint32_t requests;          // 'w' commands sent
+    uint32_t ok;                // Values read
+    uint32_t timeouts;          // Requests that timed out
+    uint32_t malformed;         // Requests answered with a bad line
+    uint32_t overruns;          // Bytes dropped because the ring buffer was full
+    uint64_t wait_us;           // Time spent waiting for answers
+} soil_probe_stats_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the UART and its receive interrupt, waits for the probe to
+ * boot and sends it the 'l' set up command
+ *
+ * @param uart The UART bus the probe is on
+ * @param tx_pin The UART TX pin, wired to the RX pin of the probe
+ * @param rx_pin The UART RX pin, wired to the TX pin of the probe
+ * @param baudrate The baud rate of the probe
+ * @param boot_ms The time the probe takes to boot
+ * @return int 1 if successful 0 if failed
+ */
+int soil_probe_init(hal_uart_t uart, uint tx_pin, uint rx_pin, uint baudrate, uint32_t boot_ms);
+
+/**
+ * @brief Asks the probe for a reading and waits for the answer, asking again
+ * if it times out or is malformed
+ *
+ * @param moisture Set to the moisture value if successful
+ * @param timeout_ms The longest time each attempt waits for an answer
+ * @param attempts The number of times to ask, at least 1
+ * @return soil_probe_status_t SOIL_PROBE_OK or how the last attempt failed
+ */
+soil_probe_status_t soil_probe_read(int *moisture, uint32_t timeout_ms, uint8_t attempts);
+
+/**
+ * @brief Gets the driver's counters
+ *
+ * @return const soil_probe_stats_t* The counters
+ */
+const soil_probe_stats_t *soil_probe_stats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOIL_PROBE_H
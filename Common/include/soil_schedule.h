@@ -0,0 +1,93 @@
+/**
+ * @file    soil_schedule.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Adaptive wake interval for the soil node. After each wake the
+ *          interval is set from how fast the moisture is changing:
+ *
+ *            - aim for about `step` units of change between wakes, so the
+ *              interval shrinks as the rate rises
+ *            - never more than half the time the current rate needs to reach
+ *              the threshold, so a wetting slope is checked more and more
+ *              often as it gets close
+ *            - at most double the last interval, so one still reading after
+ *              a storm doesn't jump straight to the longest sleep
+ *            - the shortest interval while the moisture is over the
+ *              threshold
+ *
+ *          all kept between min_s and max_s. Setting max_s to min_s gives
+ *          the old fixed schedule. Only integers are used, the soil node's
+ *          set up is SOIL_SCHEDULE_CONFIG in soil_config.h.
+ *
+*/
+
+#ifndef SOIL_SCHEDULE_H
+#define SOIL_SCHEDULE_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Interval limits and targets
+typedef struct
+{
+    uint32_t min_s;             // Shortest interval
+    uint32_t max_s;             // Longest interval, at least min_s
+    uint16_t step;              // Moisture change aimed for between wakes
+    int16_t threshold;          // Moisture above which there is a landslide risk
+} soil_schedule_config_t;
+
+// Scheduler state
+typedef struct
+{
+    soil_schedule_config_t config;
+
+    uint32_t interval_s;        // Interval returned last
+    int last;                   // Moisture at the last wake
+    bool primed;                // Set once there is a last moisture
+} soil_schedule_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up a scheduler, starting at the shortest interval
+ *
+ * @param sched The scheduler
+ * @param config Interval limits and targets
+ * @return int 1 if successful 0 if the limits are out of order or step is 0
+ */
+int soil_schedule_init(soil_schedule_t *sched, const soil_schedule_config_t *config);
+
+/**
+ * @brief Works out the next interval from the moisture read on this wake,
+ * which is taken to be one interval after the last one
+ *
+ * @param sched The scheduler
+ * @param moisture The moisture read on this wake
+ * @return uint32_t The time to sleep until the next wake (s)
+ */
+uint32_t soil_schedule_next(soil_schedule_t *sched, int moisture);
+
+/**
+ * @brief Gets the current interval
+ *
+ * @param sched The scheduler
+ * @return uint32_t The interval returned last, min_s before the first wake (s)
+ */
+static inline uint32_t soil_schedule_interval(const soil_schedule_t *sched)
+{
+    return sched->interval_s;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOIL_SCHEDULE_H
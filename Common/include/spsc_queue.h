@@ -0,0 +1,144 @@
+/**
+ * @file    spsc_queue.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Lock free queue of fixed size elements from one producer to one
+ *          consumer, for handing samples from core 1 to core 0. Only the
+ *          producer writes head and only the consumer writes tail, so a
+ *          store with release and a load with acquire are all either side
+ *          needs, no lock and no read-modify-write, which the M0+ lacks.
+ *
+ *          The indexes run freely and wrap round 2^32, the capacity is a
+ *          power of two so an index masks down to its slot. Each side keeps
+ *          its own copy of the other's index and only loads the shared one
+ *          when the copy says the queue is full or empty, and head and tail
+ *          sit in their own cache lines, so on a host the two threads do not
+ *          fight over one line for every element.
+ *
+ *          A push to a full queue drops the element and counts it: the
+ *          producer is reading a sensor and can not wait.
+ *
+*/
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+// ################################# [ Includes ] #################################
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+#define SPSC_LINE   64
+
+typedef struct
+{
+    // Producer's side
+    _Alignas(SPSC_LINE) _Atomic uint32_t head;
+    uint32_t tail_seen;         // The tail when last loaded
+    uint32_t dropped;           // Pushes to a full queue
+
+    // Consumer's side
+    _Alignas(SPSC_LINE) _Atomic uint32_t tail;
+    uint32_t head_seen;         // The head when last loaded
+
+    // Fixed when made
+    _Alignas(SPSC_LINE) uint8_t *slots;
+    uint32_t mask;
+    uint32_t size;
+} spsc_queue_t;
+
+
+// ############################## [ Functions ] ####################################
+
+/**
+ * @brief Makes an empty queue over a buffer of capacity * size bytes
+ *
+ * @param q The queue
+ * @param slots The buffer
+ * @param capacity Elements it holds, a power of two
+ * @param size Bytes in an element
+ * @return bool false if capacity is not a power of two
+ */
+static inline bool spsc_init(spsc_queue_t *q, void *slots, uint32_t capacity, uint32_t size)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+    {
+        return false;
+    }
+
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->tail_seen = 0;
+    q->head_seen = 0;
+    q->dropped = 0;
+    q->slots = slots;
+    q->mask = capacity - 1;
+    q->size = size;
+
+    return true;
+}
+
+// Producer only
+static inline bool spsc_push(spsc_queue_t *q, const void *element)
+{
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    if (head - q->tail_seen > q->mask)
+    {
+        q->tail_seen = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+        if (head - q->tail_seen > q->mask)
+        {
+            q->dropped++;
+            return false;
+        }
+    }
+
+    memcpy(&q->slots[(head & q->mask) * q->size], element, q->size);
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+// Consumer only
+static inline bool spsc_pop(spsc_queue_t *q, void *element)
+{
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    if (tail == q->head_seen)
+    {
+        q->head_seen = atomic_load_explicit(&q->head, memory_order_acquire);
+
+        if (tail == q->head_seen)
+        {
+            return false;
+        }
+    }
+
+    memcpy(element, &q->slots[(tail & q->mask) * q->size], q->size);
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+// Elements waiting, either side, may be stale by the time it returns
+static inline uint32_t spsc_count(spsc_queue_t *q)
+{
+    return atomic_load_explicit(&q->head, memory_order_acquire) -
+           atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPSC_QUEUE_H
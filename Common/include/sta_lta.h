@@ -0,0 +1,128 @@
+/**
+ * @file    sta_lta.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Streaming short term average / long term average event detector.
+ *          Each sample of a characteristic function (for the seismic node the
+ *          energy of the acceleration with gravity removed) goes into two
+ *          circular buffers whose running sums give the averages, so an
+ *          update costs the same however long the windows are. An event
+ *          starts when STA/LTA rises above the trigger ratio and ends when it
+ *          falls below the detrigger ratio.
+ *
+ *          A knock lifts the short average for a few samples only, while a
+ *          sustained shake lifts it for the whole short window, so the ratio
+ *          separates the two where a single threshold on one sample can't.
+ *
+ *          Everything is in static buffers sized by STA_LTA_MAX_STA and
+ *          STA_LTA_MAX_LTA (4.3 KB per detector with the defaults), no
+ *          floats are used. The seismic node's set up is SEISMIC_STA_LTA_CONFIG
+ *          in seismic_config.h.
+ *
+*/
+
+#ifndef STA_LTA_H
+#define STA_LTA_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Longest windows, in samples
+#ifndef STA_LTA_MAX_STA
+#define STA_LTA_MAX_STA     64
+#endif
+
+#ifndef STA_LTA_MAX_LTA
+#define STA_LTA_MAX_LTA     1024
+#endif
+
+// Ratios are 8.8 fixed point
+#define STA_LTA_RATIO(r)    ((uint16_t)((r) * 256))
+
+// Window lengths and ratios
+typedef struct
+{
+    uint16_t sta_len;           // Samples in the short window, at most STA_LTA_MAX_STA
+    uint16_t lta_len;           // Samples in the long window, at most STA_LTA_MAX_LTA
+    uint16_t trigger;           // STA/LTA that starts an event, from STA_LTA_RATIO()
+    uint16_t detrigger;         // STA/LTA that ends it, from STA_LTA_RATIO()
+    uint32_t lta_floor;         // Smallest long term average used, so sensor noise on a
+                                // still slope can't trigger
+} sta_lta_config_t;
+
+// What an update did
+typedef enum
+{
+    STA_LTA_NONE,               // No change
+    STA_LTA_TRIGGER,            // An event started
+    STA_LTA_DETRIGGER           // An event ended
+} sta_lta_event_t;
+
+// Detector state
+typedef struct
+{
+    sta_lta_config_t config;
+
+    uint32_t sta_buf[STA_LTA_MAX_STA];
+    uint32_t lta_buf[STA_LTA_MAX_LTA];
+    uint64_t sta_sum;
+    uint64_t lta_sum;
+    uint16_t sta_pos;
+    uint16_t lta_pos;
+    uint32_t count;             // Samples seen, up to lta_len
+    bool active;                // In an event
+} sta_lta_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up a detector with empty windows
+ *
+ * @param det The detector
+ * @param config Window lengths and ratios
+ * @return int 1 if successful 0 if a window is empty or too long
+ */
+int sta_lta_init(sta_lta_t *det, const sta_lta_config_t *config);
+
+/**
+ * @brief Empties the windows, no event can start until the long window has
+ * filled again
+ *
+ * @param det The detector
+ */
+void sta_lta_reset(sta_lta_t *det);
+
+/**
+ * @brief Adds one sample of the characteristic function
+ *
+ * @param det The detector
+ * @param value The sample, for example the energy from seismic_hp_energy()
+ * @return sta_lta_event_t STA_LTA_TRIGGER or STA_LTA_DETRIGGER when an event
+ * starts or ends, STA_LTA_NONE otherwise
+ */
+sta_lta_event_t sta_lta_update(sta_lta_t *det, uint32_t value);
+
+/**
+ * @brief Checks if the detector is in an event
+ *
+ * @param det The detector
+ * @return true between STA_LTA_TRIGGER and STA_LTA_DETRIGGER
+ */
+static inline bool sta_lta_active(const sta_lta_t *det)
+{
+    return det->active;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STA_LTA_H
@@ -0,0 +1,199 @@
+/**
+ * @file    telemetry_frame.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Binary frames of the telemetry link between a sensor node and the
+ *          Zero. A frame carries a batch of timestamped events with a
+ *          sequence number and a CRC, so the Zero learns what was measured,
+ *          when and how much, not just that a warning pin went high. All
+ *          fields are little endian:
+ *
+ *            offset  size
+ *              0      2    sync, 0xA5 0x5A
+ *              2      1    version, TELEMETRY_VERSION
+ *              3      1    node, id << 4 | kind (TELEMETRY_NODE())
+ *              4      2    sequence number, one more for each new frame
+ *              6      4    node time the frame was first sent at (ms)
+ *             10      1    number of events, 1 to TELEMETRY_MAX_EVENTS
+ *             11   10 * n  events: type (1), arg (1), time (4 ms), value (4)
+ *           11+10n    2    CRC-16/CCITT-FALSE of bytes 2 to 10+10n
+ *
+ *          The sync bytes and length in the header make it a byte stream
+ *          protocol as well, so the same frames work over I2C writes, a
+ *          UART or a pseudo terminal. The decoder takes bytes as they come
+ *          and resynchronises on the next sync after noise or a bad CRC.
+ *
+ *          Nothing here uses the HAL, the Linux receiver in Common/gateway
+ *          builds it as it is.
+ *
+*/
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+// ################################# [ Includes ] #################################
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+#define TELEMETRY_SYNC0         0xA5
+#define TELEMETRY_SYNC1         0x5A
+#define TELEMETRY_VERSION       1
+
+// Events in one frame, keeps a frame under 100 bytes
+#define TELEMETRY_MAX_EVENTS    8
+
+#define TELEMETRY_HEADER_LEN    11
+#define TELEMETRY_EVENT_LEN     10
+#define TELEMETRY_CRC_LEN       2
+
+// Length of a frame of n events
+#define TELEMETRY_FRAME_LEN(n)  (TELEMETRY_HEADER_LEN + (n) * TELEMETRY_EVENT_LEN + TELEMETRY_CRC_LEN)
+#define TELEMETRY_FRAME_MAX     TELEMETRY_FRAME_LEN(TELEMETRY_MAX_EVENTS)
+
+// Node byte of a frame, from the site's node id (0 to 15) and the node kind
+#define TELEMETRY_NODE(id, kind)    ((uint8_t)(((id) << 4) | ((kind) & 0x0F)))
+#define TELEMETRY_NODE_ID(node)     ((node) >> 4)
+#define TELEMETRY_NODE_KIND(node)   ((node) & 0x0F)
+
+// What a node measures
+typedef enum
+{
+    TELEMETRY_KIND_RAIN = 1,
+    TELEMETRY_KIND_SOIL = 2,
+    TELEMETRY_KIND_SEISMIC = 3
+} telemetry_kind_t;
+
+// Event types, and what their arg and value hold
+typedef enum
+{
+    TELEMETRY_BOOT = 1,         // Node started, arg: node kind
+    TELEMETRY_ALERT = 2,        // arg: fusion grade, value: confidence | evidence rain, soil, seismic << 8, 16, 24
+    TELEMETRY_RAIN = 3,         // arg: windows over their threshold, value: tips counted
+    TELEMETRY_SOIL = 4,         // value: moisture reading
+    TELEMETRY_SEISMIC = 5,      // arg: wake reason, value: peak with gravity taken off (mg)
+    TELEMETRY_LOST = 6,         // value: events dropped because the queue was full
+    TELEMETRY_CAPTURE = 7,      // A piece of a waveform capture (waveform.h), arg: its bytes (1 to 8),
+                                // time then value: the bytes, little endian
+    TELEMETRY_PHASE = 8,        // A part of a phase's timing statistics (phase_stats.h), arg: phase << 3
+                                // | part, time then value: its bytes, little endian
+    TELEMETRY_EVIDENCE = 9      // A node's evidence for the site fusion (fusion.h), arg: fusion channel
+                                // | 0x80 when its sensor has just reached its threshold, value: evidence (%)
+} telemetry_type_t;
+
+// Bytes of a blob, a waveform capture, each TELEMETRY_CAPTURE event carries
+#define TELEMETRY_BLOB_BYTES    8
+
+typedef struct
+{
+    uint8_t type;               // telemetry_type_t
+    uint8_t arg;
+    uint32_t time_ms;           // Node time of the event
+    int32_t value;
+} telemetry_event_t;
+
+typedef struct
+{
+    uint8_t node;
+    uint16_t seq;
+    uint32_t time_ms;           // Node time the frame was first sent at
+    uint8_t count;
+    telemetry_event_t events[TELEMETRY_MAX_EVENTS];
+} telemetry_frame_t;
+
+// Called by the decoder with each frame that passes its CRC
+typedef void (*telemetry_frame_fn_t)(void *ctx, const telemetry_frame_t *frame);
+
+// Stream decoder, the bytes of a frame not yet complete
+typedef struct
+{
+    uint8_t buf[TELEMETRY_FRAME_MAX];
+    size_t len;
+
+    uint32_t frames;            // Frames decoded
+    uint32_t crc_errors;        // Frames dropped on a bad CRC
+    uint32_t bad_headers;       // Sync bytes followed by an impossible header
+    uint64_t skipped;           // Bytes dropped looking for a sync
+} telemetry_decoder_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Computes the CRC-16/CCITT-FALSE of some bytes (poly 0x1021, start
+ * 0xFFFF, no reflection), a nibble table keeps it to 32 bytes of flash
+ *
+ * @param crc The CRC so far, 0xFFFF to start
+ * @param src The bytes
+ * @param len The number of bytes
+ * @return uint16_t The CRC
+ */
+uint16_t telemetry_crc16(uint16_t crc, const uint8_t *src, size_t len);
+
+/**
+ * @brief Encodes a frame
+ *
+ * @param dst Where to write it, at least TELEMETRY_FRAME_LEN(frame->count) bytes
+ * @param frame The frame, with 1 to TELEMETRY_MAX_EVENTS events
+ * @return size_t The length written, 0 if the event count is out of range
+ */
+size_t telemetry_frame_encode(uint8_t *dst, const telemetry_frame_t *frame);
+
+/**
+ * @brief Sets up a stream decoder
+ *
+ * @param dec The decoder
+ */
+void telemetry_decoder_init(telemetry_decoder_t *dec);
+
+/**
+ * @brief Decodes bytes from the link, they can split frames anywhere
+ *
+ * @param dec The decoder
+ * @param src The bytes
+ * @param len The number of bytes
+ * @param fn Called with each complete frame
+ * @param ctx Passed to fn
+ * @return uint32_t The number of frames decoded
+ */
+uint32_t telemetry_decoder_feed(telemetry_decoder_t *dec, const uint8_t *src, size_t len,
+                                telemetry_frame_fn_t fn, void *ctx);
+
+/**
+ * @brief Packs up to TELEMETRY_BLOB_BYTES bytes of a blob into an event
+ *
+ * @param ev The event, its type and time are left as they are
+ * @param src The bytes
+ * @param len The number of bytes, 1 to TELEMETRY_BLOB_BYTES
+ */
+void telemetry_blob_pack(telemetry_event_t *ev, const uint8_t *src, size_t len);
+
+/**
+ * @brief Unpacks the bytes of a blob from an event
+ *
+ * @param ev The event
+ * @param dst Where to put them, TELEMETRY_BLOB_BYTES bytes
+ * @return size_t The number of bytes, 0 if the event holds none
+ */
+size_t telemetry_blob_unpack(const telemetry_event_t *ev, uint8_t *dst);
+
+/**
+ * @brief Gets a name for an event type
+ *
+ * @param type The type
+ * @return const char* The name
+ */
+const char *telemetry_type_name(uint8_t type);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_FRAME_H
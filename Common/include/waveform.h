@@ -0,0 +1,169 @@
+/**
+ * @file    waveform.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Compact encoding of accelerometer waveforms, for the capture
+ *          around a seismic trigger (seismic_capture.h) and the Zero's tools
+ *          that read it back.
+ *
+ *          Samples are encoded in blocks of up to WAVEFORM_BLOCK_SAMPLES. A
+ *          block keeps its first sample as it is and the change from each
+ *          sample to the next after it, zigzagged so small changes either
+ *          way are small numbers, and packed at the fewest bits that hold
+ *          the largest change of the block on each axis. Sensor noise of a
+ *          few LSB packs to 2 or 3 bits an axis, against 16 raw. All fields
+ *          are little endian:
+ *
+ *            block
+ *              0      1    samples in the block, n
+ *              1      2    bits of each axis, x | y << 5 | z << 10
+ *              3      6    first sample, x y z
+ *              9      -    changes, the n - 1 of x then of y then of z,
+ *                          packed from the low bit of each byte up
+ *
+ *          A capture is a header, the blocks oldest first and a CRC:
+ *
+ *            capture
+ *              0      2    magic, 0x57 0x46 ("WF")
+ *              2      1    version, WAVEFORM_VERSION
+ *              3      1    flags, WAVEFORM_TRUNCATED
+ *              4      2    sample rate (Hz)
+ *              6      2    sensitivity (LSB/g)
+ *              8      4    node time of the trigger sample (ms)
+ *             12      4    samples
+ *             16      4    samples before the trigger sample
+ *             20      4    bytes of blocks
+ *             24      -    the blocks
+ *              -      2    CRC-16/CCITT-FALSE of everything before it
+ *
+ *          Nothing here uses the HAL, the Zero's tools build it as it is.
+ *
+*/
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+// ################################# [ Includes ] #################################
+
+#include "telemetry_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+#define WAVEFORM_MAGIC0         0x57
+#define WAVEFORM_MAGIC1         0x46
+#define WAVEFORM_VERSION        1
+
+// The post trigger part stopped early because the buffer was full or
+// samples were lost
+#define WAVEFORM_TRUNCATED      (1 << 0)
+
+#define WAVEFORM_BLOCK_SAMPLES  32
+#define WAVEFORM_BLOCK_HEADER   9
+
+// Longest block, a change between two int16 values needs 17 bits
+#define WAVEFORM_BLOCK_MAX      (WAVEFORM_BLOCK_HEADER + ((WAVEFORM_BLOCK_SAMPLES - 1) * 3 * 17 + 7) / 8)
+
+#define WAVEFORM_HEADER_LEN     24
+#define WAVEFORM_CRC_LEN        2
+
+// One x, y, z sample in LSB
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} waveform_sample_t;
+
+// What a capture holds
+typedef struct
+{
+    uint8_t flags;
+    uint16_t rate_hz;
+    uint16_t lsb_per_g;
+    uint32_t trigger_ms;
+    uint32_t samples;
+    uint32_t pre;               // Samples before the trigger sample
+    uint32_t payload;           // Bytes of blocks
+} waveform_header_t;
+
+// Called with each sample of a capture, index 0 is the oldest
+typedef void (*waveform_sample_fn_t)(void *ctx, uint32_t index, const waveform_sample_t *sample);
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Encodes a block of samples
+ *
+ * @param dst Where to write it, at least WAVEFORM_BLOCK_MAX bytes
+ * @param samples The samples
+ * @param n The number of samples, 1 to WAVEFORM_BLOCK_SAMPLES
+ * @return size_t The length written
+ */
+size_t waveform_block_encode(uint8_t *dst, const waveform_sample_t *samples, uint32_t n);
+
+/**
+ * @brief Gets the length of a block from its first 3 bytes
+ *
+ * @param src The block
+ * @return size_t The length, 0 if it is not a block
+ */
+size_t waveform_block_len(const uint8_t *src);
+
+/**
+ * @brief Decodes a block
+ *
+ * @param src The block, waveform_block_len() bytes
+ * @param samples Where to put the samples, WAVEFORM_BLOCK_SAMPLES of them
+ * @return uint32_t The number of samples, 0 if it is not a block
+ */
+uint32_t waveform_block_decode(const uint8_t *src, waveform_sample_t *samples);
+
+/**
+ * @brief Encodes a capture header
+ *
+ * @param dst Where to write it, WAVEFORM_HEADER_LEN bytes
+ * @param header The header
+ */
+void waveform_header_encode(uint8_t *dst, const waveform_header_t *header);
+
+/**
+ * @brief Checks a whole capture and decodes its header
+ *
+ * @param src The capture
+ * @param len Its length
+ * @param header Where to put the header
+ * @return true If it is a capture with a good CRC and length
+ */
+bool waveform_header_decode(const uint8_t *src, size_t len, waveform_header_t *header);
+
+/**
+ * @brief Gets the length of a whole capture from its header
+ *
+ * @param src The first WAVEFORM_HEADER_LEN bytes of the capture
+ * @return size_t The length, 0 if it is not a capture header
+ */
+size_t waveform_capture_len(const uint8_t *src);
+
+/**
+ * @brief Decodes every sample of a capture
+ *
+ * @param src The capture
+ * @param len Its length
+ * @param fn Called with each sample, oldest first
+ * @param ctx Passed to fn
+ * @param header Where to put the header, can be NULL
+ * @return int32_t The number of samples, -1 if the capture is broken
+ */
+int32_t waveform_decode(const uint8_t *src, size_t len, waveform_sample_fn_t fn, void *ctx,
+                        waveform_header_t *header);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WAVEFORM_H
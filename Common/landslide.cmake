@@ -0,0 +1,100 @@
+# Shared build helpers for every sensor node firmware.
+#
+# Each subsystem variant includes this file before its project() call. It
+# selects which backend the landslide_hal library is built for:
+#
+#   PICO - the real firmware, built with the Pico SDK (and PICO EXTRAS for the
+#          sleep functions) into a .uf2 for the Pi Pico.
+#   HOST - a Linux executable that runs the same firmware against a simulated
+#          board driven by a scripted sensor trace (see Common/README.md).
+#
+# The default is PICO when PICO_SDK_PATH is set in the environment and HOST
+# otherwise, so a plain "cmake -S . -B build" works on a Linux build box.
+#
+# LANDSLIDE_SITE picks the deployment site profile from Common/profiles, which
+# sets the pins, thresholds and timings of every node at compile time.
+
+# Only run the setup once, even when several subsystems are added from the
+# top level CMakeLists.txt
+if (DEFINED LANDSLIDE_COMMON_DIR)
+    return()
+endif()
+
+set(LANDSLIDE_COMMON_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+# Pick the default backend
+if (DEFINED ENV{PICO_SDK_PATH})
+    set(LANDSLIDE_DEFAULT_BACKEND PICO)
+else()
+    set(LANDSLIDE_DEFAULT_BACKEND HOST)
+endif()
+
+set(LANDSLIDE_HAL_BACKEND ${LANDSLIDE_DEFAULT_BACKEND} CACHE STRING "Backend for landslide_hal (PICO or HOST)")
+set_property(CACHE LANDSLIDE_HAL_BACKEND PROPERTY STRINGS PICO HOST)
+
+if (NOT LANDSLIDE_HAL_BACKEND STREQUAL "PICO" AND NOT LANDSLIDE_HAL_BACKEND STREQUAL "HOST")
+    message(FATAL_ERROR "LANDSLIDE_HAL_BACKEND must be PICO or HOST, not '${LANDSLIDE_HAL_BACKEND}'")
+endif()
+
+# Pick the site profile, any header in Common/profiles
+file(GLOB LANDSLIDE_SITE_FILES RELATIVE ${LANDSLIDE_COMMON_DIR}/profiles ${LANDSLIDE_COMMON_DIR}/profiles/*.h)
+string(REPLACE ".h" "" LANDSLIDE_SITES "${LANDSLIDE_SITE_FILES}")
+
+set(LANDSLIDE_SITE default CACHE STRING "Deployment site profile from Common/profiles")
+set_property(CACHE LANDSLIDE_SITE PROPERTY STRINGS ${LANDSLIDE_SITES})
+
+if (NOT LANDSLIDE_SITE IN_LIST LANDSLIDE_SITES)
+    message(FATAL_ERROR "LANDSLIDE_SITE must be one of ${LANDSLIDE_SITES}, not '${LANDSLIDE_SITE}'")
+endif()
+
+
+# Include build functions from Pico SDK, and PICO EXTRAS if EXTRAS is passed.
+# Must be called before project(). Does nothing for the HOST backend.
+macro(landslide_import_sdk)
+    if (LANDSLIDE_HAL_BACKEND STREQUAL "PICO")
+        if (NOT COMMAND pico_sdk_init)
+            include($ENV{PICO_SDK_PATH}/external/pico_sdk_import.cmake)
+        endif()
+
+        set(LANDSLIDE_IMPORT_ARGS ${ARGV})
+        if ("EXTRAS" IN_LIST LANDSLIDE_IMPORT_ARGS AND NOT DEFINED PICO_EXTRAS_PATH)
+            if (DEFINED ENV{PICO_EXTRAS_PATH})
+                include($ENV{PICO_EXTRAS_PATH}/external/pico_extras_import.cmake)
+            else()
+                include(C:\\VSARM\\sdk\\pico\\pico-extras\\external\\pico_extras_import.cmake)
+            endif()
+        endif()
+    endif()
+endmacro()
+
+
+# Initialises the Pico SDK and adds the landslide_hal library. Must be called
+# after project().
+macro(landslide_sdk_init)
+    if (LANDSLIDE_HAL_BACKEND STREQUAL "PICO")
+        get_property(LANDSLIDE_SDK_DONE GLOBAL PROPERTY LANDSLIDE_SDK_DONE)
+        if (NOT LANDSLIDE_SDK_DONE)
+            pico_sdk_init()
+            set_property(GLOBAL PROPERTY LANDSLIDE_SDK_DONE TRUE)
+        endif()
+    endif()
+
+    if (NOT TARGET landslide_hal)
+        add_subdirectory(${LANDSLIDE_COMMON_DIR} ${CMAKE_BINARY_DIR}/landslide_hal)
+    endif()
+endmacro()
+
+
+# Adds a firmware executable linked to landslide_hal. On the PICO backend this
+# also creates the map/bin/hex/uf2 files and enables usb and uart output.
+function(landslide_add_firmware TARGET)
+    add_executable(${TARGET} ${ARGN})
+
+    target_link_libraries(${TARGET} landslide_hal)
+
+    if (LANDSLIDE_HAL_BACKEND STREQUAL "PICO")
+        pico_add_extra_outputs(${TARGET})
+        pico_enable_stdio_usb(${TARGET} 1)
+        pico_enable_stdio_uart(${TARGET} 1)
+    endif()
+endfunction()
@@ -0,0 +1,16 @@
+/**
+ * @file    default.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Site profile for the original test slope. Changes nothing, every
+ *          value is the default from node_config.h and the node type's
+ *          *_config.h.
+ *
+ *          A profile for a new site is a copy of this file defining only the
+ *          macros that differ, picked with -DLANDSLIDE_SITE=<file name>.
+ *
+*/
+
+#ifndef SITE_PROFILE_H
+#define SITE_PROFILE_H
+
+#endif // SITE_PROFILE_H
@@ -0,0 +1,29 @@
+/**
+ * @file    steep_slope.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Site profile for a steep, already unstable slope, where less
+ *          shaking, rain or moisture is needed to start a slide. Warns earlier
+ *          and checks the soil more often than the defaults.
+ *
+*/
+
+#ifndef SITE_PROFILE_H
+#define SITE_PROFILE_H
+
+// Seismic node: 1.5 g instead of 2 g, longer window after each wake and a
+// more sensitive STA/LTA detector
+#define SEISMIC_THRESHOLD_MG        1500
+#define SEISMIC_RISK_WINDOW         400
+#define SEISMIC_STA_LTA_TRIGGER     2.5
+
+// Rain node: warn on about three quarters of the default rainfall
+#define RAIN_SHORT_WARNING_UM       4000
+#define RAIN_HOUR_WARNING_UM        11000
+#define RAIN_DAY_WARNING_UM         70000
+
+// Soil node: lower moisture threshold, woken every 5 s while the moisture
+// changes fast
+#define SOIL_MOISTURE_THRESHOLD     40
+#define SOIL_SLEEP_S                5
+
+#endif // SITE_PROFILE_H
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Compares the battery life of every variant of a subsystem on one trace.
+# Each variant's host simulation plays the trace with the supply currents
+# of node_config.h, or of LANDSLIDE_CURRENTS if it is set. Variants that
+# poll too often to get to the end of the trace within the host cpu budget
+# stop early, marked *, and their battery life is worked out from the time
+# they got through.
+#
+#   Common/sim/energy_compare.sh <build dir> <trace> [cpu budget s]
+#
+# The subsystem is the first word of the trace's name, so
+# seismic_season.trace runs every seismic_monitoring_subsystem_* in the
+# build.
+
+set -eu
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 <build dir> <trace> [cpu budget s]" >&2
+    exit 1
+fi
+
+build=$1
+trace=$2
+budget=${3:-10}
+subsystem=$(basename "$trace" | cut -d_ -f1)
+
+printf '%-12s %12s %10s %12s %9s %8s\n' variant "days played" "mean mA" "battery" warnings "cpu s"
+
+# By variant name, the paths have spaces in them
+find "$build" -type f -perm -u+x -name "${subsystem}_monitoring_subsystem_*" -printf '%f %p\n' | sort |
+while read -r name exe; do
+    LANDSLIDE_SIM_QUIET=1 LANDSLIDE_SIM_CPU_S=$budget LANDSLIDE_TRACE=$trace "$exe" 2>&1 >/dev/null |
+        awk -v variant="${name##*_subsystem_}" '
+            /^\[sim\] virtual time/         { days = $5 / 86400 }
+            /^\[sim\] cpu budget/           { cut = "*" }
+            /^\[sim\] mean current      :/  { ma = $5 }
+            /^\[sim\] battery life/         { life = $5 }
+            /^\[sim\] warnings issued/      { warnings = $5 }
+            /^\[sim\] host cpu time/        { cpu = $6 / 1000 }
+            END {
+                printf "%-12s %11.2f%1s %10.3f %10.1f d %9s %8.2f\n",
+                       variant, days, cut, ma, life, warnings, cpu
+            }'
+done
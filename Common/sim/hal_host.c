@@ -0,0 +1,1996 @@
+/**
+ * @file    hal_host.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Host (Linux) backend of the landslide HAL. Implements every
+ *          function in landslide_hal.h against a simulated Pi Pico with a
+ *          virtual clock, see hal_host.h.
+ *
+*/
+
+#define _GNU_SOURCE
+
+// ################################# [ Includes ] #################################
+
+#include "hal_host.h"
+#include "sim_board.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Number of buses of each type
+#define HOST_NUM_BUSES      2
+
+// Most devices that can be attached to one I2C bus
+#define HOST_MAX_I2C_DEVS   8
+
+// Size of each UART receive FIFO
+#define HOST_RX_FIFO_SIZE   4096
+
+// Bytes the UART can queue for sending before putc has to wait
+#define HOST_TX_FIFO_DEPTH  32
+
+// Number of pin or UART polls in a row with no time passing before the
+// simulation skips ahead to the next event, so polling loops don't spin forever
+#define HOST_POLL_LIMIT     1000
+
+// Stack of core 1's coroutine, generous as the firmware keeps buffers on it
+#define HOST_CORE1_STACK    (256 * 1024)
+
+// Virtual time the simulation stops at when neither the trace nor the
+// environment set an end
+#define HOST_DEFAULT_END_NS (60 * 1000000000ull)
+
+// Events run between looks at the host cpu time, when there is a budget
+#define HOST_CPU_CHECK      4096
+
+// uA ns in a mAh
+#define HOST_UANS_PER_MAH   3.6e15
+
+// Devices on the board that draw a current of their own
+#define HOST_MAX_LOADS      4
+
+// A scheduled event
+typedef struct
+{
+    uint64_t at_ns;
+    uint64_t seq;
+    hal_host_event_fn_t fn;
+    void *ctx;
+    uint32_t a;
+    uint32_t b;
+} host_event_t;
+
+// Events kept as a binary min heap on (at_ns, seq)
+typedef struct
+{
+    host_event_t *events;
+    size_t num;
+    size_t max;
+} host_heap_t;
+
+// States of the pulse counter, the instructions of pulse_counter.pio it can
+// wait in
+enum
+{
+    HOST_COUNTER_WAIT_HIGH,     // wait 1 pin 0
+    HOST_COUNTER_HOLD_HIGH,     // its [31] delay
+    HOST_COUNTER_WAIT_LOW,      // wait 0 pin 0
+    HOST_COUNTER_HOLD_LOW       // its [31] delay
+};
+
+// Blocks whose clocks sleep and dormant mode stop, as bits of host.stopped
+enum
+{
+    HOST_CLOCK_TIMER = 1 << 0,  // The timer and its alarms
+    HOST_CLOCK_DMA = 1 << 1,    // DMA and the I2C block it feeds
+    HOST_CLOCK_UART = 1 << 2,
+    HOST_CLOCK_PIO = 1 << 3,    // The pulse counter
+    HOST_CLOCK_IO = 1 << 4,     // GPIO interrupts
+    HOST_CLOCK_CORE1 = 1 << 5,
+    HOST_CLOCKS_ALL = (1 << 6) - 1
+};
+
+// Parts the charge of a run is split into, the power states then these
+enum
+{
+    HOST_CHARGE_CORE1 = HAL_HOST_NUM_STATES,
+    HOST_CHARGE_I2C,
+    HOST_CHARGE_UART,
+    HOST_CHARGE_LOADS,
+    HOST_NUM_CHARGES
+};
+
+static const char *const host_charge_names[HOST_NUM_CHARGES] = {
+    "run", "idle", "sleep", "dormant", "core 1", "i2c", "uart", "pin loads"
+};
+
+// The charge parts, then one for each device load
+#define HOST_NUM_PARTS      (HOST_NUM_CHARGES + HOST_MAX_LOADS)
+
+// A device's current, the charge it has used up to since_ns and its name
+typedef struct
+{
+    const char *name;
+    double ua;
+    double uans;
+    uint64_t since_ns;
+} host_load_t;
+
+// A device attached to an I2C bus
+typedef struct
+{
+    uint8_t addr;
+    hal_host_i2c_device_t dev;
+} host_i2c_slot_t;
+
+// State of the simulated Pico
+static struct
+{
+    bool initialised;
+    bool quiet;
+    bool in_irq;
+
+    // Virtual clock
+    uint64_t now_ns;
+    uint64_t end_ns;
+    uint32_t polls;
+    hal_host_end_fn_t end_fn;
+
+    // Host cpu time the simulation may take, 0 for no limit, and whether it
+    // ran out
+    clock_t cpu_budget;
+    uint32_t cpu_checks;
+    bool cpu_out;
+
+    // Pending events, those of the trace and the sensor models apart from
+    // the Pico's own, which sleep and dormant mode have to go through
+    host_heap_t world;
+    host_heap_t clocked;
+    uint64_t next_seq;
+
+    // Blocks with their clocks stopped, since when, and their events that
+    // came due meanwhile
+    uint32_t stopped;
+    uint64_t stopped_ns;
+    host_event_t *held;
+    size_t num_held;
+    size_t max_held;
+
+    // GPIO
+    bool gpio_is_out[HAL_HOST_NUM_GPIO];
+    bool gpio_out[HAL_HOST_NUM_GPIO];
+    bool gpio_in[HAL_HOST_NUM_GPIO];
+    uint32_t gpio_rises[HAL_HOST_NUM_GPIO];
+    hal_host_gpio_watch_fn_t gpio_watch[HAL_HOST_NUM_GPIO];
+    void *gpio_watch_ctx[HAL_HOST_NUM_GPIO];
+    uint gpio_irq_edges[HAL_HOST_NUM_GPIO];
+    hal_irq_callback_t gpio_irq_callback[HAL_HOST_NUM_GPIO];
+    void *gpio_irq_ctx[HAL_HOST_NUM_GPIO];
+
+    // Current drawn while the firmware drives each pin high, and the time
+    // it has been high so far and since when
+    uint32_t gpio_load_ua[HAL_HOST_NUM_GPIO];
+    uint64_t gpio_high_ns[HAL_HOST_NUM_GPIO];
+    uint64_t gpio_high_since_ns[HAL_HOST_NUM_GPIO];
+
+    // Devices drawing their own current
+    host_load_t loads[HOST_MAX_LOADS];
+    int num_loads;
+
+    // I2C
+    uint i2c_baud[HOST_NUM_BUSES];
+    host_i2c_slot_t i2c_devs[HOST_NUM_BUSES][HOST_MAX_I2C_DEVS];
+    size_t num_i2c_devs[HOST_NUM_BUSES];
+
+    // Background I2C read
+    bool dma_busy;
+    hal_i2c_t dma_i2c;
+    uint8_t dma_addr;
+    uint8_t dma_reg;
+    uint8_t *dma_dst;
+    size_t dma_len;
+    size_t dma_count;
+    hal_irq_callback_t dma_callback;
+    void *dma_ctx;
+
+    // Periodic timers, the generation stops ticks of a stopped timer firing
+    bool timer_running[HAL_NUM_TIMERS];
+    uint32_t timer_gen[HAL_NUM_TIMERS];
+    uint64_t timer_period_ns[HAL_NUM_TIMERS];
+    hal_irq_callback_t timer_callback[HAL_NUM_TIMERS];
+    void *timer_ctx[HAL_NUM_TIMERS];
+
+    // UART
+    uint uart_baud[HOST_NUM_BUSES];
+    hal_host_uart_device_t uart_dev[HOST_NUM_BUSES];
+    uint64_t uart_tx_free_ns[HOST_NUM_BUSES];
+    uint64_t uart_rx_next_ns[HOST_NUM_BUSES];
+    uint8_t uart_rx[HOST_NUM_BUSES][HOST_RX_FIFO_SIZE];
+    size_t uart_rx_head[HOST_NUM_BUSES];
+    size_t uart_rx_count[HOST_NUM_BUSES];
+    hal_irq_callback_t uart_irq_callback[HOST_NUM_BUSES];
+    void *uart_irq_ctx[HOST_NUM_BUSES];
+
+    // Pulse counter, a model of the PIO program: the state it waits in, the
+    // count, the pulses left before the interrupt and the threshold
+    bool counter_running;
+    uint counter_pin;
+    uint64_t counter_debounce_ns;
+    int counter_state;
+    uint32_t counter_gen;
+    uint32_t counter_count;
+    uint32_t counter_left;
+    uint32_t counter_threshold;
+    hal_irq_callback_t counter_callback;
+    void *counter_ctx;
+
+    // RTC, the time it was set to and the virtual time it was set at
+    bool rtc_running;
+    int64_t rtc_base_s;
+    uint64_t rtc_set_ns;
+
+    // Time the timer counted across the last dormant or sleep wait
+    uint32_t wake_us;
+
+    // Core 1, the context it runs in and the one that resumed it, and the
+    // time it started waiting in hal_core_wait()
+    bool core1_running;
+    bool core1_waiting;
+    uint64_t core1_wait_ns;
+    void (*core1_entry)(void);
+    void *core1_stack;
+    ucontext_t core1_ctx;
+    ucontext_t core1_caller;
+
+    // stdio
+    FILE *real_stdout;
+    size_t stdio_pending;
+    clock_t cpu_start;
+
+    hal_host_energy_t energy;
+    hal_host_stats_t stats;
+} host;
+
+// The flash, apart from the rest as it keeps its contents through a reset
+static struct
+{
+    bool initialised;
+    const char *image;          // File it is saved to at the end
+    uint8_t data[HAL_FLASH_SIZE];
+    uint32_t erases[HAL_HOST_FLASH_SECTORS];
+} host_flash;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// ---------------------------------- [ Events ] ---------------------------------
+
+static bool host_event_before(const host_event_t *x, const host_event_t *y)
+{
+    return x->at_ns < y->at_ns || (x->at_ns == y->at_ns && x->seq < y->seq);
+}
+
+static void host_heap_push(host_heap_t *heap, const host_event_t *ev)
+{
+    // Grow the heap when it is full
+    if (heap->num == heap->max)
+    {
+        heap->max = heap->max ? heap->max * 2 : 64;
+        heap->events = realloc(heap->events, heap->max * sizeof(host_event_t));
+        if (heap->events == NULL)
+        {
+            fprintf(stderr, "[sim] out of memory for events\n");
+            exit(1);
+        }
+    }
+
+    // Sift the new event up to its place
+    size_t i = heap->num++;
+    while (i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        if (!host_event_before(ev, &heap->events[parent]))
+        {
+            break;
+        }
+        heap->events[i] = heap->events[parent];
+        i = parent;
+    }
+    heap->events[i] = *ev;
+}
+
+static host_event_t host_heap_pop(host_heap_t *heap)
+{
+    host_event_t top = heap->events[0];
+    host_event_t last = heap->events[--heap->num];
+
+    // Sift the last event down from the root
+    size_t i = 0;
+    while (true)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= heap->num)
+        {
+            break;
+        }
+        if (child + 1 < heap->num && host_event_before(&heap->events[child + 1], &heap->events[child]))
+        {
+            child++;
+        }
+        if (!host_event_before(&heap->events[child], &last))
+        {
+            break;
+        }
+        heap->events[i] = heap->events[child];
+        i = child;
+    }
+    if (heap->num > 0)
+    {
+        heap->events[i] = last;
+    }
+
+    return top;
+}
+
+static uint32_t host_event_clock(const host_event_t *ev);
+
+static void host_event_push(const host_event_t *ev)
+{
+    host_heap_push(host_event_clock(ev) ? &host.clocked : &host.world, ev);
+}
+
+// The heap the next event is in, NULL if there are none
+static host_heap_t *host_event_heap(void)
+{
+    if (host.clocked.num == 0)
+    {
+        return host.world.num ? &host.world : NULL;
+    }
+
+    if (host.world.num == 0 || host_event_before(&host.clocked.events[0], &host.world.events[0]))
+    {
+        return &host.clocked;
+    }
+
+    return &host.world;
+}
+
+// The next event, NULL if there are none
+static const host_event_t *host_event_next(void)
+{
+    host_heap_t *heap = host_event_heap();
+
+    return heap != NULL ? &heap->events[0] : NULL;
+}
+
+static host_event_t host_event_pop(void)
+{
+    return host_heap_pop(host_event_heap());
+}
+
+// ------------------------------- [ Virtual Clock ] -----------------------------
+
+static void host_flash_save(void);
+
+static void host_finish(void)
+{
+    fflush(stdout);
+
+    if (host.end_fn != NULL)
+    {
+        host.end_fn();
+    }
+
+    host_flash_save();
+
+    hal_host_report(stderr);
+    exit(0);
+}
+
+static void host_core1_event(void *ctx, uint32_t a, uint32_t b);
+
+// Hands core 1 back to core 0, resuming it at resume_ns or, for
+// UINT64_MAX, when core 0 signals it
+static void host_core1_yield(uint64_t resume_ns)
+{
+    if (resume_ns != UINT64_MAX)
+    {
+        hal_host_schedule(resume_ns, &host_core1_event, NULL, 0, 0);
+    }
+
+    swapcontext(&host.core1_ctx, &host.core1_caller);
+}
+
+static void host_charge(uint64_t until_ns, hal_host_state_t state)
+{
+    if (until_ns > host.now_ns)
+    {
+        host.stats.state_ns[state] += until_ns - host.now_ns;
+        host.now_ns = until_ns;
+        host.polls = 0;
+    }
+}
+
+static void host_event_hold(const host_event_t *ev);
+static void host_uart_rx_event(void *ctx, uint32_t uart, uint32_t c);
+
+// Runs every event due up to target_ns then moves the clock to target_ns
+static void host_run_until(uint64_t target_ns, hal_host_state_t state)
+{
+    // Core 1 leaves the clock to core 0 and comes back at target_ns
+    if (host.core1_running)
+    {
+        if (target_ns > host.now_ns)
+        {
+            host.stats.core1_ns[state] += target_ns - host.now_ns;
+        }
+
+        host_core1_yield(target_ns);
+        return;
+    }
+
+    bool past_end = host.end_ns != 0 && target_ns >= host.end_ns;
+
+    if (past_end)
+    {
+        target_ns = host.end_ns;
+    }
+
+    const host_event_t *next;
+
+    while ((next = host_event_next()) != NULL && next->at_ns <= target_ns)
+    {
+        host_event_t ev = host_event_pop();
+        host_charge(ev.at_ns, state);
+
+        // A block with its clock stopped waits for it, a byte coming in to a
+        // stopped UART is lost
+        if (host_event_clock(&ev) & host.stopped)
+        {
+            if (ev.fn != &host_uart_rx_event)
+            {
+                host_event_hold(&ev);
+            }
+            continue;
+        }
+
+        ev.fn(ev.ctx, ev.a, ev.b);
+
+        // Stop where it got to once the host cpu time runs out
+        if (host.cpu_budget != 0 && ++host.cpu_checks % HOST_CPU_CHECK == 0 &&
+            clock() - host.cpu_start > host.cpu_budget)
+        {
+            host.cpu_out = true;
+            host_finish();
+        }
+    }
+
+    host_charge(target_ns, state);
+
+    if (past_end)
+    {
+        host_finish();
+    }
+}
+
+// Moves the clock to the next event and runs it, ending the simulation if
+// there is nothing left that could happen
+static void host_run_next(hal_host_state_t state)
+{
+    const host_event_t *next = host_event_next();
+
+    if (next == NULL)
+    {
+        if (host.end_ns != 0)
+        {
+            host_run_until(host.end_ns, state);
+        }
+        host_finish();
+    }
+
+    host_run_until(next->at_ns, state);
+}
+
+// Counts a poll that didn't move the clock and skips ahead if the firmware is
+// stuck polling
+static void host_poll(void)
+{
+    if (++host.polls > HOST_POLL_LIMIT)
+    {
+        host.polls = 0;
+        host_run_next(HAL_HOST_RUN);
+    }
+}
+
+// Time to clock a number of bits over a bus
+static uint64_t host_bits_ns(uint64_t bits, uint baud)
+{
+    return bits * 1000000000ull / (baud ? baud : 1);
+}
+
+// -------------------------------- [ Multicore ] --------------------------------
+
+static void host_core1_start(void)
+{
+    host.core1_entry();
+
+    // Core 1 returning stops it, the context goes back to the caller
+    host.core1_entry = NULL;
+}
+
+// Runs core 1 until it next yields, not as an interrupt even if core 0 was in
+// one when the event came due
+static void host_core1_event(void *ctx, uint32_t a, uint32_t b)
+{
+    (void)ctx;
+    (void)a;
+    (void)b;
+
+    if (host.core1_entry == NULL)
+    {
+        return;
+    }
+
+    bool in_irq = host.in_irq;
+
+    host.in_irq = false;
+    host.core1_running = true;
+    swapcontext(&host.core1_caller, &host.core1_ctx);
+    host.core1_running = false;
+    host.in_irq = in_irq;
+}
+
+// ----------------------------------- [ GPIO ] ----------------------------------
+
+static bool host_gpio_driven(uint pin)
+{
+    return host.gpio_is_out[pin] && host.gpio_out[pin];
+}
+
+// Calls the pin watcher if the level the firmware drives has changed
+static void host_gpio_notify(uint pin, bool was_driven)
+{
+    bool driven = host_gpio_driven(pin);
+
+    if (driven == was_driven)
+    {
+        return;
+    }
+
+    // Count the time a pin with a load is high
+    if (driven)
+    {
+        host.gpio_high_since_ns[pin] = host.now_ns;
+    }
+    else
+    {
+        host.gpio_high_ns[pin] += host.now_ns - host.gpio_high_since_ns[pin];
+    }
+
+    if (host.gpio_watch[pin] != NULL)
+    {
+        host.gpio_watch[pin](host.gpio_watch_ctx[pin], pin, driven);
+    }
+}
+
+static void host_gpio_event(void *ctx, uint32_t pin, uint32_t level)
+{
+    (void)ctx;
+    hal_host_set_gpio_input(pin, level);
+}
+
+// Runs a callback as if from an interrupt handler
+static void host_irq(hal_irq_callback_t callback, void *ctx)
+{
+    bool was_in_irq = host.in_irq;
+
+    host.stats.irqs++;
+    host.in_irq = true;
+    callback(ctx);
+    host.in_irq = was_in_irq;
+}
+
+// ------------------------------- [ Pulse counter ] -----------------------------
+
+static void host_counter_event(void *ctx, uint32_t gen, uint32_t unused);
+
+// Starts holding a level for the debounce time
+static void host_counter_hold(int state)
+{
+    host.counter_state = state;
+    hal_host_schedule(host.now_ns + host.counter_debounce_ns, &host_counter_event, NULL, ++host.counter_gen, 0);
+}
+
+// Called on every level change of the counter's pin
+static void host_counter_edge(bool level)
+{
+    if (host.counter_state == HOST_COUNTER_WAIT_HIGH && level)
+    {
+        host_counter_hold(HOST_COUNTER_HOLD_HIGH);
+    }
+    else if (host.counter_state == HOST_COUNTER_WAIT_LOW && !level)
+    {
+        host_counter_hold(HOST_COUNTER_HOLD_LOW);
+    }
+}
+
+// End of a debounce time
+static void host_counter_event(void *ctx, uint32_t gen, uint32_t unused)
+{
+    (void)ctx;
+    (void)unused;
+
+    if (!host.counter_running || gen != host.counter_gen)
+    {
+        return;
+    }
+
+    bool level = host.gpio_in[host.counter_pin];
+
+    if (host.counter_state == HOST_COUNTER_HOLD_LOW)
+    {
+        host.counter_state = HOST_COUNTER_WAIT_HIGH;
+        host_counter_edge(level);
+        return;
+    }
+
+    // Still high after the hold, a pulse, otherwise a bounce
+    if (level)
+    {
+        host.counter_count++;
+        host.stats.pulses++;
+
+        if (host.counter_left != 0)
+        {
+            host.counter_left--;
+        }
+        else
+        {
+            host.counter_left = host.counter_threshold;
+            if (host.counter_callback != NULL)
+            {
+                host_irq(host.counter_callback, host.counter_ctx);
+            }
+        }
+    }
+
+    host.counter_state = HOST_COUNTER_WAIT_LOW;
+    host_counter_edge(host.gpio_in[host.counter_pin]);
+}
+
+static const hal_host_i2c_device_t *host_i2c_find(hal_i2c_t i2c, uint8_t addr)
+{
+    for (size_t i = 0; i < host.num_i2c_devs[i2c]; i++)
+    {
+        if (host.i2c_devs[i2c][i].addr == addr)
+        {
+            return &host.i2c_devs[i2c][i].dev;
+        }
+    }
+
+    return NULL;
+}
+
+// Finishes a background I2C read once the bus time has passed
+static void host_dma_event(void *ctx, uint32_t a, uint32_t b)
+{
+    (void)ctx;
+    (void)a;
+    (void)b;
+
+    const hal_host_i2c_device_t *dev = host_i2c_find(host.dma_i2c, host.dma_addr);
+
+    // Each read is a register write and a read of its own
+    for (size_t n = 0; n < host.dma_count; n++)
+    {
+        host.stats.i2c_transfers += 2;
+        host.stats.i2c_bytes += 1 + host.dma_len;
+
+        if (dev != NULL && dev->write != NULL && dev->read != NULL)
+        {
+            dev->write(dev->ctx, &host.dma_reg, 1, true);
+            dev->read(dev->ctx, host.dma_dst + n * host.dma_len, host.dma_len, false);
+        }
+    }
+
+    host.dma_busy = false;
+
+    if (host.dma_callback != NULL)
+    {
+        host_irq(host.dma_callback, host.dma_ctx);
+    }
+}
+
+static void host_timer_event(void *ctx, uint32_t timer, uint32_t gen)
+{
+    (void)ctx;
+
+    if (!host.timer_running[timer] || host.timer_gen[timer] != gen)
+    {
+        return;
+    }
+
+    hal_host_schedule(host.now_ns + host.timer_period_ns[timer], &host_timer_event, NULL, timer, gen);
+    host_irq(host.timer_callback[timer], host.timer_ctx[timer]);
+}
+
+// ----------------------------------- [ UART ] ----------------------------------
+
+static void host_uart_rx_event(void *ctx, uint32_t uart, uint32_t c)
+{
+    (void)ctx;
+
+    // Drop the byte if the FIFO has overflowed, as the hardware would
+    if (host.uart_rx_count[uart] == HOST_RX_FIFO_SIZE)
+    {
+        return;
+    }
+
+    host.stats.uart_ns += host_bits_ns(10, host.uart_baud[uart]);
+
+    size_t tail = (host.uart_rx_head[uart] + host.uart_rx_count[uart]) % HOST_RX_FIFO_SIZE;
+    host.uart_rx[uart][tail] = (uint8_t)c;
+    host.uart_rx_count[uart]++;
+
+    if (host.uart_irq_callback[uart] != NULL)
+    {
+        host_irq(host.uart_irq_callback[uart], host.uart_irq_ctx[uart]);
+    }
+}
+
+static void host_uart_tx_event(void *ctx, uint32_t uart, uint32_t c)
+{
+    (void)ctx;
+
+    if (host.uart_dev[uart].rx != NULL)
+    {
+        host.uart_dev[uart].rx(host.uart_dev[uart].ctx, (uint8_t)c);
+    }
+}
+
+// ------------------------------- [ Clock gating ] ------------------------------
+
+// The block an event belongs to, 0 for the world outside the Pico
+static uint32_t host_event_clock(const host_event_t *ev)
+{
+    if (ev->fn == &host_timer_event)
+    {
+        return HOST_CLOCK_TIMER;
+    }
+    if (ev->fn == &host_dma_event)
+    {
+        return HOST_CLOCK_DMA;
+    }
+    if (ev->fn == &host_uart_rx_event || ev->fn == &host_uart_tx_event)
+    {
+        return HOST_CLOCK_UART;
+    }
+    if (ev->fn == &host_counter_event)
+    {
+        return HOST_CLOCK_PIO;
+    }
+    if (ev->fn == &host_core1_event)
+    {
+        return HOST_CLOCK_CORE1;
+    }
+
+    return 0;
+}
+
+static void host_event_hold(const host_event_t *ev)
+{
+    if (host.num_held == host.max_held)
+    {
+        host.max_held = host.max_held ? host.max_held * 2 : 16;
+        host.held = realloc(host.held, host.max_held * sizeof(host_event_t));
+        if (host.held == NULL)
+        {
+            fprintf(stderr, "[sim] out of memory for events\n");
+            exit(1);
+        }
+    }
+
+    host.held[host.num_held++] = *ev;
+}
+
+// Stops the clocks of some blocks, their pending events are held
+static void host_clocks_stop(uint32_t clocks)
+{
+    host_heap_t *heap = &host.clocked;
+    size_t num = heap->num;
+
+    host.stopped = clocks;
+    host.stopped_ns = host.now_ns;
+
+    // The heap is rebuilt in place from what is left, the events only move
+    // towards the front
+    heap->num = 0;
+    for (size_t i = 0; i < num; i++)
+    {
+        host_event_t ev = heap->events[i];
+
+        if (host_event_clock(&ev) & clocks)
+        {
+            host_event_hold(&ev);
+        }
+        else
+        {
+            host_heap_push(heap, &ev);
+        }
+    }
+}
+
+// Starts the stopped clocks again. Each block goes on where it stopped, so its
+// held events come as much later as the clock was stopped.
+static void host_clocks_start(void)
+{
+    uint32_t stopped = host.stopped;
+    uint64_t frozen_ns = host.now_ns - host.stopped_ns;
+
+    host.stopped = 0;
+
+    for (size_t i = 0; i < host.num_held; i++)
+    {
+        host_event_t ev = host.held[i];
+
+        ev.at_ns += frozen_ns;
+        host_event_push(&ev);
+    }
+    host.num_held = 0;
+
+    // The counter's program looks at the pin again, a pulse that is still
+    // high counts
+    if ((stopped & HOST_CLOCK_PIO) && host.counter_running)
+    {
+        host_counter_edge(host.gpio_in[host.counter_pin]);
+    }
+}
+
+// ----------------------------------- [ stdio ] ---------------------------------
+
+// Counts what the firmware prints so hal_stdio_flush() can charge the time it
+// takes to send it, and passes it on to the real stdout
+static ssize_t host_stdout_write(void *cookie, const char *buf, size_t size)
+{
+    (void)cookie;
+
+    host.stdio_pending += size;
+    host.stats.stdio_bytes += size;
+
+    if (!host.quiet)
+    {
+        fwrite(buf, 1, size, host.real_stdout);
+        fflush(host.real_stdout);
+    }
+
+    return size;
+}
+
+// ---------------------------------- [ Energy ] ---------------------------------
+
+// Works out the charge of each part of the run so far (uA ns)
+static void host_charges(double *uans)
+{
+    const hal_host_energy_t *e = &host.energy;
+    const hal_host_stats_t *s = &host.stats;
+
+    for (int i = 0; i < HAL_HOST_NUM_STATES; i++)
+    {
+        uans[i] = (double)s->state_ns[i] * e->state_ua[i];
+    }
+
+    uans[HOST_CHARGE_CORE1] = (double)s->core1_ns[HAL_HOST_RUN] * e->core1_ua;
+    uans[HOST_CHARGE_I2C] = (double)s->i2c_ns * e->i2c_ua;
+    uans[HOST_CHARGE_UART] = (double)s->uart_ns * e->uart_ua;
+    uans[HOST_CHARGE_LOADS] = 0.0;
+
+    // A pin still high counts up to now
+    for (uint pin = 0; pin < HAL_HOST_NUM_GPIO; pin++)
+    {
+        uint64_t high_ns = host.gpio_high_ns[pin];
+        if (host_gpio_driven(pin))
+        {
+            high_ns += host.now_ns - host.gpio_high_since_ns[pin];
+        }
+
+        uans[HOST_CHARGE_LOADS] += (double)high_ns * host.gpio_load_ua[pin];
+    }
+
+    // A device's current so far counts up to now
+    for (int i = 0; i < HOST_MAX_LOADS; i++)
+    {
+        const host_load_t *load = &host.loads[i];
+
+        uans[HOST_NUM_CHARGES + i] = load->uans + (double)(host.now_ns - load->since_ns) * load->ua;
+    }
+}
+
+static const char *host_charge_name(int part)
+{
+    return part < HOST_NUM_CHARGES ? host_charge_names[part] : host.loads[part - HOST_NUM_CHARGES].name;
+}
+
+// ---------------------------------- [ Flash ] ----------------------------------
+
+static void host_flash_init(void)
+{
+    if (!host_flash.initialised)
+    {
+        host_flash.initialised = true;
+        memset(host_flash.data, 0xFF, sizeof(host_flash.data));
+    }
+}
+
+// The Pico would hang or write somewhere else, better to stop
+static void host_flash_check(uint32_t offset, size_t len, size_t align, const char *what)
+{
+    if (offset % align != 0 || len % align != 0 || offset > HAL_FLASH_SIZE || len > HAL_FLASH_SIZE - offset)
+    {
+        fprintf(stderr, "[sim] bad flash %s of %zu bytes at 0x%06x\n", what, len, (unsigned)offset);
+        exit(1);
+    }
+}
+
+static void host_flash_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+
+    host_flash.image = path;
+
+    // No image yet, the flash starts erased
+    if (f == NULL)
+    {
+        return;
+    }
+
+    size_t len = fread(host_flash.data, 1, sizeof(host_flash.data), f);
+    fclose(f);
+
+    if (len != sizeof(host_flash.data))
+    {
+        fprintf(stderr, "[sim] flash image %s is %zu bytes, not %u\n", path, len, HAL_FLASH_SIZE);
+        exit(1);
+    }
+}
+
+static void host_flash_save(void)
+{
+    if (host_flash.image == NULL)
+    {
+        return;
+    }
+
+    FILE *f = fopen(host_flash.image, "wb");
+    if (f == NULL || fwrite(host_flash.data, 1, sizeof(host_flash.data), f) != sizeof(host_flash.data))
+    {
+        fprintf(stderr, "[sim] could not save the flash to %s\n", host_flash.image);
+    }
+
+    if (f != NULL)
+    {
+        fclose(f);
+    }
+}
+
+static void host_init(void)
+{
+    if (host.initialised)
+    {
+        return;
+    }
+
+    host.initialised = true;
+    host.cpu_start = clock();
+    host_flash_init();
+
+    for (int i = 0; i < HOST_NUM_BUSES; i++)
+    {
+        host.i2c_baud[i] = 100 * 1000;
+        host.uart_baud[i] = HAL_HOST_STDIO_BAUD;
+    }
+}
+
+// ----------------------------------- [ RTC ] -----------------------------------
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+static int64_t host_days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static int64_t host_datetime_to_s(const hal_datetime_t *t)
+{
+    return host_days_from_civil(t->year, t->month, t->day) * 86400 + t->hour * 3600 + t->min * 60 + t->sec;
+}
+
+static void host_s_to_datetime(int64_t s, hal_datetime_t *t)
+{
+    int64_t z = (s >= 0 ? s : s - 86399) / 86400;
+    int64_t secs = s - z * 86400;
+
+    t->hour = secs / 3600;
+    t->min = (secs / 60) % 60;
+    t->sec = secs % 60;
+    t->dotw = (int8_t)(((z % 7) + 11) % 7);  // 1970-01-01 was a Thursday
+
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    unsigned m = mp < 10 ? mp + 3 : mp - 9;
+
+    t->year = (int16_t)(yoe + era * 400 + (m <= 2));
+    t->month = m;
+    t->day = doy - (153 * mp + 2) / 5 + 1;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+// ---------------------------- [ Simulation Control ] ---------------------------
+
+void hal_host_reset(void)
+{
+    free(host.world.events);
+    free(host.clocked.events);
+    free(host.held);
+    free(host.core1_stack);
+
+    FILE *real_stdout = host.real_stdout;
+    bool quiet = host.quiet;
+
+    memset(&host, 0, sizeof(host));
+
+    host.real_stdout = real_stdout;
+    host.quiet = quiet;
+    host_init();
+}
+
+uint64_t hal_host_now_ns(void)
+{
+    return host.now_ns;
+}
+
+void hal_host_advance_ns(uint64_t ns, hal_host_state_t state)
+{
+    host_run_until(host.now_ns + ns, state);
+}
+
+void hal_host_schedule(uint64_t at_ns, hal_host_event_fn_t fn, void *ctx, uint32_t a, uint32_t b)
+{
+    host_event_t ev = {
+        .at_ns = at_ns < host.now_ns ? host.now_ns : at_ns,
+        .seq = host.next_seq++,
+        .fn = fn,
+        .ctx = ctx,
+        .a = a,
+        .b = b
+    };
+
+    host_event_push(&ev);
+}
+
+void hal_host_set_end_ns(uint64_t end_ns)
+{
+    host.end_ns = end_ns;
+}
+
+void hal_host_set_end_handler(hal_host_end_fn_t fn)
+{
+    host.end_fn = fn;
+}
+
+void hal_host_set_gpio_input(uint pin, bool level)
+{
+    if (pin >= HAL_HOST_NUM_GPIO || host.gpio_in[pin] == level)
+    {
+        return;
+    }
+
+    host.gpio_in[pin] = level;
+    host.gpio_rises[pin] += level;
+
+    if (host.counter_running && pin == host.counter_pin && !(host.stopped & HOST_CLOCK_PIO))
+    {
+        host_counter_edge(level);
+    }
+
+    // Raise the GPIO interrupt if the firmware asked for this edge, with the
+    // IO clock stopped the edge is not seen
+    uint edge = level ? HAL_GPIO_EDGE_RISE : HAL_GPIO_EDGE_FALL;
+    if (!host.gpio_is_out[pin] && (host.gpio_irq_edges[pin] & edge) && host.gpio_irq_callback[pin] != NULL &&
+        !(host.stopped & HOST_CLOCK_IO))
+    {
+        host_irq(host.gpio_irq_callback[pin], host.gpio_irq_ctx[pin]);
+    }
+}
+
+void hal_host_schedule_gpio(uint64_t at_ns, uint pin, bool level)
+{
+    hal_host_schedule(at_ns, &host_gpio_event, NULL, pin, level);
+}
+
+void hal_host_watch_gpio(uint pin, hal_host_gpio_watch_fn_t fn, void *ctx)
+{
+    if (pin < HAL_HOST_NUM_GPIO)
+    {
+        host.gpio_watch[pin] = fn;
+        host.gpio_watch_ctx[pin] = ctx;
+    }
+}
+
+void hal_host_attach_i2c(hal_i2c_t i2c, uint8_t addr, const hal_host_i2c_device_t *dev)
+{
+    // Replace a device already at this address
+    for (size_t i = 0; i < host.num_i2c_devs[i2c]; i++)
+    {
+        if (host.i2c_devs[i2c][i].addr == addr)
+        {
+            host.i2c_devs[i2c][i].dev = *dev;
+            return;
+        }
+    }
+
+    if (host.num_i2c_devs[i2c] < HOST_MAX_I2C_DEVS)
+    {
+        host_i2c_slot_t *slot = &host.i2c_devs[i2c][host.num_i2c_devs[i2c]++];
+        slot->addr = addr;
+        slot->dev = *dev;
+    }
+}
+
+void hal_host_attach_uart(hal_uart_t uart, const hal_host_uart_device_t *dev)
+{
+    host.uart_dev[uart] = *dev;
+}
+
+void hal_host_uart_inject(hal_uart_t uart, uint64_t delay_ns, const uint8_t *src, size_t len)
+{
+    uint64_t byte_ns = host_bits_ns(10, host.uart_baud[uart]);
+    uint64_t at_ns = host.now_ns + delay_ns;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        // Bytes can't arrive faster than the baud rate allows
+        if (at_ns < host.uart_rx_next_ns[uart])
+        {
+            at_ns = host.uart_rx_next_ns[uart];
+        }
+
+        hal_host_schedule(at_ns, &host_uart_rx_event, NULL, uart, src[i]);
+
+        at_ns += byte_ns;
+        host.uart_rx_next_ns[uart] = at_ns;
+    }
+}
+
+void hal_host_set_energy(const hal_host_energy_t *energy)
+{
+    host.energy = *energy;
+}
+
+const hal_host_energy_t *hal_host_energy(void)
+{
+    return &host.energy;
+}
+
+void hal_host_set_gpio_load(uint pin, uint32_t ua)
+{
+    if (pin < HAL_HOST_NUM_GPIO)
+    {
+        host.gpio_load_ua[pin] = ua;
+    }
+}
+
+int hal_host_add_load(const char *name)
+{
+    if (host.num_loads == HOST_MAX_LOADS)
+    {
+        return -1;
+    }
+
+    host_load_t *load = &host.loads[host.num_loads];
+    load->name = name;
+    load->since_ns = host.now_ns;
+
+    return host.num_loads++;
+}
+
+void hal_host_set_load(int load, double ua)
+{
+    if (load < 0 || load >= host.num_loads)
+    {
+        return;
+    }
+
+    host_load_t *l = &host.loads[load];
+    l->uans += (double)(host.now_ns - l->since_ns) * l->ua;
+    l->since_ns = host.now_ns;
+    l->ua = ua;
+}
+
+double hal_host_charge_mah(void)
+{
+    double uans[HOST_NUM_PARTS];
+
+    host_charges(uans);
+
+    double total = 0.0;
+    for (int i = 0; i < HOST_NUM_PARTS; i++)
+    {
+        total += uans[i];
+    }
+
+    return total / HOST_UANS_PER_MAH;
+}
+
+const hal_host_stats_t *hal_host_stats(void)
+{
+    return &host.stats;
+}
+
+void hal_host_flash_wipe(void)
+{
+    host_flash.initialised = true;
+    memset(host_flash.data, 0xFF, sizeof(host_flash.data));
+    memset(host_flash.erases, 0, sizeof(host_flash.erases));
+}
+
+const uint32_t *hal_host_flash_erases(void)
+{
+    return host_flash.erases;
+}
+
+void hal_host_report(FILE *out)
+{
+    static const char *state_names[HAL_HOST_NUM_STATES] = {"run", "idle", "sleep", "dormant"};
+
+    const hal_host_stats_t *s = &host.stats;
+    double total_s = host.now_ns / 1e9;
+    double awake_ms = (s->state_ns[HAL_HOST_RUN] + s->state_ns[HAL_HOST_IDLE]) / 1e6;
+    double cpu_ms = (clock() - host.cpu_start) * 1000.0 / CLOCKS_PER_SEC;
+
+    fprintf(out, "[sim] ---------------- host simulation report ----------------\n");
+    fprintf(out, "[sim] virtual time      : %.3f s\n", total_s);
+    if (host.cpu_out)
+    {
+        fprintf(out, "[sim] cpu budget        : ran out, the trace was not played to its end\n");
+    }
+
+    for (int i = 0; i < HAL_HOST_NUM_STATES; i++)
+    {
+        double state_s = s->state_ns[i] / 1e9;
+        fprintf(out, "[sim] %-18s: %.3f s (%.2f%%)\n", state_names[i], state_s,
+                total_s > 0 ? 100.0 * state_s / total_s : 0.0);
+    }
+
+    if (host.core1_stack != NULL)
+    {
+        fprintf(out, "[sim] core 1 run / idle : %.3f s / %.3f s\n", s->core1_ns[HAL_HOST_RUN] / 1e9,
+                s->core1_ns[HAL_HOST_IDLE] / 1e9);
+    }
+
+    fprintf(out, "[sim] wakes             : %u\n", s->wakes);
+    fprintf(out, "[sim] interrupt wakes   : %u\n", s->irq_wakes);
+    fprintf(out, "[sim] awake per wake    : %.3f ms\n", s->wakes ? awake_ms / s->wakes : awake_ms);
+    fprintf(out, "[sim] i2c transfers     : %u (%llu bytes)\n", s->i2c_transfers, (unsigned long long)s->i2c_bytes);
+    fprintf(out, "[sim] uart tx / rx      : %llu / %llu bytes\n",
+            (unsigned long long)s->uart_tx_bytes, (unsigned long long)s->uart_rx_bytes);
+    fprintf(out, "[sim] stdio             : %llu bytes\n", (unsigned long long)s->stdio_bytes);
+    if (host.counter_running)
+    {
+        fprintf(out, "[sim] pulses counted    : %u\n", s->pulses);
+    }
+    if (s->flash_erases != 0 || s->flash_pages != 0)
+    {
+        fprintf(out, "[sim] flash erases/pages: %u / %u\n", s->flash_erases, s->flash_pages);
+    }
+    fprintf(out, "[sim] host cpu time     : %.3f ms\n", cpu_ms);
+
+    // The charge of each part and the battery life it comes to
+    const hal_host_energy_t *e = &host.energy;
+    double uans[HOST_NUM_PARTS];
+    double total_uans = 0.0;
+
+    host_charges(uans);
+    for (int i = 0; i < HOST_NUM_PARTS; i++)
+    {
+        total_uans += uans[i];
+    }
+
+    fprintf(out, "[sim] ---------------- energy ----------------\n");
+
+    for (int i = 0; i < HOST_NUM_PARTS; i++)
+    {
+        if (uans[i] != 0.0)
+        {
+            fprintf(out, "[sim] %-18s: %.4f mAh (%.1f%%)\n", host_charge_name(i), uans[i] / HOST_UANS_PER_MAH,
+                    100.0 * uans[i] / total_uans);
+        }
+    }
+
+    double mean_ua = host.now_ns != 0 ? total_uans / host.now_ns : 0.0;
+
+    fprintf(out, "[sim] mean current      : %.3f mA, %.1f mAh a day\n", mean_ua / 1000.0, mean_ua * 24.0 / 1000.0);
+    if (mean_ua > 0.0)
+    {
+        fprintf(out, "[sim] battery life      : %.1f days on %u mAh\n", e->battery_mah * 1000.0 / mean_ua / 24.0,
+                e->battery_mah);
+    }
+
+    sim_board_report(out);
+}
+
+// ---------------------------------- [ stdio ] ----------------------------------
+
+void hal_stdio_init(void)
+{
+    host_init();
+
+    // Count everything the firmware prints on its way to the real stdout
+    if (host.real_stdout == NULL)
+    {
+        cookie_io_functions_t io = { .write = &host_stdout_write };
+        const char *quiet = getenv("LANDSLIDE_SIM_QUIET");
+
+        host.quiet = quiet != NULL && strcmp(quiet, "0") != 0;
+        host.real_stdout = fdopen(dup(STDOUT_FILENO), "w");
+
+        FILE *counted = fopencookie(NULL, "w", io);
+        if (host.real_stdout != NULL && counted != NULL)
+        {
+            setvbuf(counted, NULL, _IOLBF, 0);
+            stdout = counted;
+        }
+    }
+
+    // Put the sensors on the board and load the scripted trace
+    sim_board_init();
+
+    const char *trace = getenv("LANDSLIDE_TRACE");
+    if (trace != NULL && sim_board_load_trace(trace) != 0)
+    {
+        fprintf(stderr, "[sim] could not load trace %s\n", trace);
+        exit(1);
+    }
+
+    const char *flash = getenv("LANDSLIDE_FLASH");
+    if (flash != NULL && host_flash.image == NULL)
+    {
+        host_flash_load(flash);
+    }
+
+    const char *end_ms = getenv("LANDSLIDE_SIM_END_MS");
+    if (end_ms != NULL)
+    {
+        host.end_ns = (uint64_t)(strtod(end_ms, NULL) * 1e6);
+    }
+
+    const char *cpu_s = getenv("LANDSLIDE_SIM_CPU_S");
+    if (cpu_s != NULL)
+    {
+        host.cpu_budget = (clock_t)(strtod(cpu_s, NULL) * CLOCKS_PER_SEC);
+    }
+
+    // Firmware that polls would otherwise run forever
+    if (host.end_ns == 0)
+    {
+        host.end_ns = HOST_DEFAULT_END_NS;
+    }
+}
+
+void hal_stdio_flush(void)
+{
+    fflush(stdout);
+
+    // Charge the time to send what was printed over the default uart
+    uint64_t bits_ns = host_bits_ns(10 * host.stdio_pending, HAL_HOST_STDIO_BAUD);
+
+    host.stats.uart_ns += bits_ns;
+    host_run_until(host.now_ns + bits_ns, HAL_HOST_RUN);
+    host.stdio_pending = 0;
+}
+
+void hal_stdio_write_raw(const uint8_t *src, size_t len)
+{
+    fwrite(src, 1, len, stdout);
+}
+
+// ---------------------------------- [ GPIO ] -----------------------------------
+
+void hal_gpio_init(uint pin)
+{
+    bool was_driven = host_gpio_driven(pin);
+
+    host.gpio_is_out[pin] = false;
+    host.gpio_out[pin] = false;
+
+    host_gpio_notify(pin, was_driven);
+}
+
+void hal_gpio_set_dir(uint pin, bool out)
+{
+    bool was_driven = host_gpio_driven(pin);
+
+    host.gpio_is_out[pin] = out;
+
+    host_gpio_notify(pin, was_driven);
+}
+
+void hal_gpio_set_function(uint pin, hal_gpio_function_t fn)
+{
+    (void)pin;
+    (void)fn;
+}
+
+void hal_gpio_put(uint pin, bool value)
+{
+    bool was_driven = host_gpio_driven(pin);
+
+    host.gpio_out[pin] = value;
+
+    host_gpio_notify(pin, was_driven);
+}
+
+bool hal_gpio_get(uint pin)
+{
+    host_poll();
+
+    return host.gpio_is_out[pin] ? host.gpio_out[pin] : host.gpio_in[pin];
+}
+
+void hal_gpio_set_irq(uint pin, uint edges, hal_irq_callback_t callback, void *ctx)
+{
+    host.gpio_irq_edges[pin] = callback != NULL ? edges : 0;
+    host.gpio_irq_callback[pin] = callback;
+    host.gpio_irq_ctx[pin] = ctx;
+}
+
+// ----------------------------------- [ I2C ] -----------------------------------
+
+void hal_i2c_init(hal_i2c_t i2c, uint baudrate)
+{
+    host_init();
+    host.i2c_baud[i2c] = baudrate;
+}
+
+// Finds the device at an address, charging the time for the address byte and
+// the data bytes
+static const hal_host_i2c_device_t *host_i2c_transfer(hal_i2c_t i2c, uint8_t addr, size_t len)
+{
+    uint64_t bits_ns = host_bits_ns(9 * (len + 1) + 2, host.i2c_baud[i2c]);
+
+    host_run_until(host.now_ns + bits_ns, HAL_HOST_RUN);
+
+    host.stats.i2c_transfers++;
+    host.stats.i2c_ns += bits_ns;
+    host.stats.i2c_bytes += len;
+
+    return host_i2c_find(i2c, addr);
+}
+
+int hal_i2c_write_blocking(hal_i2c_t i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    const hal_host_i2c_device_t *dev = host_i2c_transfer(i2c, addr, len);
+
+    if (dev == NULL || dev->write == NULL)
+    {
+        return HAL_ERROR_GENERIC;
+    }
+
+    // Waits as long as the device holds the bus, for ever if it never lets go
+    int written;
+    while ((written = dev->write(dev->ctx, src, len, nostop)) == HAL_ERROR_TIMEOUT)
+    {
+        host_run_next(HAL_HOST_RUN);
+    }
+
+    return written;
+}
+
+int hal_i2c_write_timeout_us(hal_i2c_t i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop,
+                             uint timeout_us)
+{
+    uint64_t give_up_ns = host.now_ns + timeout_us * 1000ull;
+    const hal_host_i2c_device_t *dev = host_i2c_transfer(i2c, addr, len);
+
+    if (dev == NULL || dev->write == NULL)
+    {
+        return HAL_ERROR_GENERIC;
+    }
+
+    int written;
+    while ((written = dev->write(dev->ctx, src, len, nostop)) == HAL_ERROR_TIMEOUT)
+    {
+        const host_event_t *next = host_event_next();
+
+        if (next == NULL || next->at_ns >= give_up_ns)
+        {
+            host_run_until(give_up_ns, HAL_HOST_RUN);
+            return HAL_ERROR_TIMEOUT;
+        }
+
+        host_run_next(HAL_HOST_RUN);
+    }
+
+    return written;
+}
+
+int hal_i2c_read_blocking(hal_i2c_t i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    const hal_host_i2c_device_t *dev = host_i2c_transfer(i2c, addr, len);
+
+    if (dev == NULL || dev->read == NULL)
+    {
+        return HAL_ERROR_GENERIC;
+    }
+
+    return dev->read(dev->ctx, dst, len, nostop);
+}
+
+bool hal_i2c_read_dma(hal_i2c_t i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                      hal_irq_callback_t callback, void *ctx)
+{
+    return hal_i2c_read_dma_repeat(i2c, addr, reg, dst, len, 1, callback, ctx);
+}
+
+bool hal_i2c_read_dma_repeat(hal_i2c_t i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                             size_t count, hal_irq_callback_t callback, void *ctx)
+{
+    if (host.dma_busy || len == 0 || count == 0 || len * count > HAL_I2C_DMA_MAX_LEN)
+    {
+        return false;
+    }
+
+    host.dma_busy = true;
+    host.dma_i2c = i2c;
+    host.dma_addr = addr;
+    host.dma_reg = reg;
+    host.dma_dst = dst;
+    host.dma_len = len;
+    host.dma_count = count;
+    host.dma_callback = callback;
+    host.dma_ctx = ctx;
+
+    // The core is free while the register writes, restarts and reads go out
+    uint64_t bits_ns = host_bits_ns(count * (9 * 2 + 9 * (len + 1) + 3), host.i2c_baud[i2c]);
+    hal_host_schedule(host.now_ns + bits_ns, &host_dma_event, NULL, 0, 0);
+    host.stats.i2c_ns += bits_ns;
+
+    return true;
+}
+
+// ----------------------------------- [ UART ] ----------------------------------
+
+void hal_uart_init(hal_uart_t uart, uint baudrate)
+{
+    host_init();
+    host.uart_baud[uart] = baudrate;
+}
+
+void hal_uart_putc_raw(hal_uart_t uart, char c)
+{
+    uint64_t byte_ns = host_bits_ns(10, host.uart_baud[uart]);
+
+    // Wait for room in the transmit FIFO
+    if (host.uart_tx_free_ns[uart] > host.now_ns + HOST_TX_FIFO_DEPTH * byte_ns)
+    {
+        host_run_until(host.uart_tx_free_ns[uart] - HOST_TX_FIFO_DEPTH * byte_ns, HAL_HOST_RUN);
+    }
+
+    // The byte reaches the device once it has been clocked out
+    uint64_t start_ns = host.uart_tx_free_ns[uart] > host.now_ns ? host.uart_tx_free_ns[uart] : host.now_ns;
+    host.uart_tx_free_ns[uart] = start_ns + byte_ns;
+    host.stats.uart_tx_bytes++;
+    host.stats.uart_ns += byte_ns;
+
+    hal_host_schedule(host.uart_tx_free_ns[uart], &host_uart_tx_event, NULL, uart, (uint8_t)c);
+}
+
+char hal_uart_getc(hal_uart_t uart)
+{
+    // Spin until a byte arrives
+    while (host.uart_rx_count[uart] == 0)
+    {
+        host_run_next(HAL_HOST_RUN);
+    }
+
+    char c = host.uart_rx[uart][host.uart_rx_head[uart]];
+    host.uart_rx_head[uart] = (host.uart_rx_head[uart] + 1) % HOST_RX_FIFO_SIZE;
+    host.uart_rx_count[uart]--;
+    host.stats.uart_rx_bytes++;
+
+    return c;
+}
+
+bool hal_uart_is_readable(hal_uart_t uart)
+{
+    // Only polling loops outside an interrupt can get stuck
+    if (!host.in_irq)
+    {
+        host_poll();
+    }
+
+    return host.uart_rx_count[uart] > 0;
+}
+
+void hal_uart_set_irq(hal_uart_t uart, hal_irq_callback_t callback, void *ctx)
+{
+    host.uart_irq_callback[uart] = callback;
+    host.uart_irq_ctx[uart] = ctx;
+}
+
+// ------------------------------- [ Sleep / Time ] ------------------------------
+
+void hal_sleep_ms(uint32_t ms)
+{
+    host_run_until(host.now_ns + ms * 1000000ull, HAL_HOST_IDLE);
+}
+
+void hal_busy_wait_ms(uint32_t ms)
+{
+    host_run_until(host.now_ns + ms * 1000000ull, HAL_HOST_RUN);
+}
+
+void hal_wait_ms(uint32_t ms)
+{
+    if (hal_in_irq())
+    {
+        hal_busy_wait_ms(ms);
+    }
+    else
+    {
+        hal_sleep_ms(ms);
+    }
+}
+
+bool hal_in_irq(void)
+{
+    return host.in_irq;
+}
+
+uint64_t hal_time_us_64(void)
+{
+    return host.now_ns / 1000;
+}
+
+void hal_wfi(void)
+{
+    uint32_t irqs = host.stats.irqs;
+
+    host_run_next(HAL_HOST_IDLE);
+
+    if (host.stats.irqs != irqs)
+    {
+        host.stats.irq_wakes++;
+    }
+}
+
+void hal_sleep_until_us(uint64_t us)
+{
+    host_run_until(us * 1000, HAL_HOST_IDLE);
+}
+
+int hal_timer_start(uint32_t period_us, hal_irq_callback_t callback, void *ctx)
+{
+    for (int i = 0; i < HAL_NUM_TIMERS; i++)
+    {
+        if (!host.timer_running[i])
+        {
+            host.timer_running[i] = true;
+            host.timer_gen[i]++;
+            host.timer_period_ns[i] = period_us * 1000ull;
+            host.timer_callback[i] = callback;
+            host.timer_ctx[i] = ctx;
+
+            hal_host_schedule(host.now_ns + host.timer_period_ns[i], &host_timer_event, NULL, i, host.timer_gen[i]);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void hal_timer_stop(int timer)
+{
+    if (timer >= 0 && timer < HAL_NUM_TIMERS)
+    {
+        host.timer_running[timer] = false;
+    }
+}
+
+void hal_sleep_run_from_xosc(void)
+{
+}
+
+uint32_t hal_sleep_wake_us(void)
+{
+    return host.wake_us;
+}
+
+// The core waits for the crystal oscillator to start again after dormant mode
+static void host_dormant_wake(void)
+{
+    host.stats.wakes++;
+    host.wake_us = (uint32_t)(HAL_HOST_XOSC_START_NS / 1000);
+    host_run_until(host.now_ns + HAL_HOST_XOSC_START_NS, HAL_HOST_RUN);
+    host_clocks_start();
+}
+
+void hal_sleep_goto_dormant_until_level_high(uint pin)
+{
+    // Dormant mode stops the clocks, only a pin change can wake the Pico
+    host_clocks_stop(HOST_CLOCKS_ALL);
+    while (!(host.gpio_is_out[pin] ? host.gpio_out[pin] : host.gpio_in[pin]))
+    {
+        host_run_next(HAL_HOST_DORMANT);
+    }
+
+    host_dormant_wake();
+}
+
+void hal_sleep_goto_dormant_until_edge_high(uint pin)
+{
+    uint32_t rises = host.gpio_rises[pin];
+
+    // Only an edge wakes it, not a pin that is already high
+    host_clocks_stop(HOST_CLOCKS_ALL);
+    while (host.gpio_rises[pin] == rises)
+    {
+        host_run_next(HAL_HOST_DORMANT);
+    }
+
+    host_dormant_wake();
+}
+
+// When the RTC reaches an alarm time, UINT64_MAX if it is not running
+static uint64_t host_alarm_ns(const hal_datetime_t *alarm)
+{
+    if (!host.rtc_running)
+    {
+        return UINT64_MAX;
+    }
+
+    int64_t alarm_s = host_datetime_to_s(alarm) - host.rtc_base_s;
+
+    return host.rtc_set_ns + (alarm_s > 0 ? (uint64_t)alarm_s * 1000000000ull : 0);
+}
+
+void hal_sleep_goto_sleep_until(const hal_datetime_t *alarm, hal_rtc_callback_t callback)
+{
+    // Only the RTC is clocked, work out when it reaches the alarm time
+    host_clocks_stop(HOST_CLOCKS_ALL);
+    if (host.rtc_running)
+    {
+        host_run_until(host_alarm_ns(alarm), HAL_HOST_SLEEP);
+    }
+    host_clocks_start();
+
+    // The crystal oscillator keeps running in sleep mode
+    host.stats.wakes++;
+    host.wake_us = 0;
+
+    // The callback runs from the RTC interrupt
+    if (callback != NULL)
+    {
+        host.in_irq = true;
+        callback();
+        host.in_irq = false;
+    }
+}
+
+bool hal_sleep_goto_sleep_until_irq(const hal_datetime_t *alarm, const volatile bool *woken)
+{
+    uint64_t at_ns = host_alarm_ns(alarm);
+    uint32_t irqs = host.stats.irqs;
+
+    // Checked with interrupts off on the Pico, the interrupt already came
+    if (woken != NULL && *woken)
+    {
+        return false;
+    }
+
+    // The RTC, GPIO and PIO clocks run. Their events and the world's run as
+    // they come due until one of them interrupts or the alarm time is reached
+    host_clocks_stop(HOST_CLOCKS_ALL & ~(HOST_CLOCK_IO | HOST_CLOCK_PIO));
+    while (host.stats.irqs == irqs && host.now_ns < at_ns)
+    {
+        const host_event_t *next = host_event_next();
+
+        if (next != NULL && next->at_ns < at_ns)
+        {
+            host_run_next(HAL_HOST_SLEEP);
+        }
+        else
+        {
+            host_run_until(at_ns, HAL_HOST_SLEEP);
+        }
+    }
+    host_clocks_start();
+
+    // The crystal oscillator keeps running in sleep mode
+    host.stats.wakes++;
+    host.wake_us = 0;
+
+    return host.now_ns >= at_ns;
+}
+
+// ------------------------------- [ Pulse counter ] -----------------------------
+
+int hal_pulse_counter_init(uint pin, uint32_t debounce_us)
+{
+    if (host.counter_running || pin >= HAL_HOST_NUM_GPIO || debounce_us == 0)
+    {
+        return 0;
+    }
+
+    host.counter_running = true;
+    host.counter_pin = pin;
+    host.counter_debounce_ns = debounce_us * 1000ull;
+    host.counter_state = HOST_COUNTER_WAIT_HIGH;
+    host.counter_count = 0;
+    host.counter_left = UINT32_MAX;
+    host.counter_threshold = UINT32_MAX;
+
+    host_counter_edge(host.gpio_in[pin]);
+    return 1;
+}
+
+uint32_t hal_pulse_counter_read(void)
+{
+    return host.counter_count;
+}
+
+void hal_pulse_counter_set_irq(uint32_t pulses, hal_irq_callback_t callback, void *ctx)
+{
+    // The Pico puts the threshold into the tx FIFO, joined to rx it is lost
+    // and the state machine keeps its old count
+    if (pulses != 0 && HAL_PULSE_COUNTER_FIFO_JOIN == HAL_PIO_FIFO_JOIN_RX)
+    {
+        fprintf(stderr, "[sim] pulse counter threshold of %u put to a tx FIFO joined to rx\n", (unsigned)pulses);
+        exit(1);
+    }
+
+    host.counter_callback = pulses != 0 ? callback : NULL;
+    host.counter_ctx = ctx;
+
+    if (pulses != 0)
+    {
+        host.counter_threshold = pulses - 1;
+        host.counter_left = pulses - 1;
+    }
+}
+
+// ---------------------------------- [ Flash ] ----------------------------------
+
+void hal_flash_erase(uint32_t offset, size_t len)
+{
+    host_flash_init();
+    host_flash_check(offset, len, HAL_FLASH_SECTOR_SIZE, "erase");
+
+    memset(&host_flash.data[offset], 0xFF, len);
+
+    for (size_t s = 0; s < len / HAL_FLASH_SECTOR_SIZE; s++)
+    {
+        host_flash.erases[offset / HAL_FLASH_SECTOR_SIZE + s]++;
+        host.stats.flash_erases++;
+    }
+
+    // Interrupts are off, anything due waits until the erase is done
+    host_charge(host.now_ns + len / HAL_FLASH_SECTOR_SIZE * HAL_HOST_FLASH_ERASE_NS, HAL_HOST_RUN);
+}
+
+void hal_flash_program(uint32_t offset, const uint8_t *src, size_t len)
+{
+    host_flash_init();
+    host_flash_check(offset, len, HAL_FLASH_PAGE_SIZE, "program");
+
+    // Programming can only clear bits
+    for (size_t i = 0; i < len; i++)
+    {
+        host_flash.data[offset + i] &= src[i];
+    }
+
+    host.stats.flash_pages += (uint32_t)(len / HAL_FLASH_PAGE_SIZE);
+    host_charge(host.now_ns + len / HAL_FLASH_PAGE_SIZE * HAL_HOST_FLASH_PAGE_NS, HAL_HOST_RUN);
+}
+
+const uint8_t *hal_flash_read(uint32_t offset)
+{
+    host_flash_init();
+    return &host_flash.data[offset];
+}
+
+// -------------------------------- [ Multicore ] --------------------------------
+
+void hal_core1_launch(void (*entry)(void))
+{
+    host.core1_stack = malloc(HOST_CORE1_STACK);
+    if (host.core1_stack == NULL)
+    {
+        fprintf(stderr, "[sim] out of memory for core 1\n");
+        exit(1);
+    }
+
+    getcontext(&host.core1_ctx);
+    host.core1_ctx.uc_stack.ss_sp = host.core1_stack;
+    host.core1_ctx.uc_stack.ss_size = HOST_CORE1_STACK;
+    host.core1_ctx.uc_link = &host.core1_caller;
+    makecontext(&host.core1_ctx, &host_core1_start, 0);
+
+    host.core1_entry = entry;
+    hal_host_schedule(host.now_ns, &host_core1_event, NULL, 0, 0);
+}
+
+void hal_core_wait(void)
+{
+    if (host.core1_running)
+    {
+        // Until core 0 signals
+        host.core1_waiting = true;
+        host.core1_wait_ns = host.now_ns;
+        host_core1_yield(UINT64_MAX);
+        return;
+    }
+
+    host_run_next(HAL_HOST_IDLE);
+}
+
+void hal_core_signal(void)
+{
+    // Core 0 wakes from any event, core 1's included
+    if (host.core1_running || !host.core1_waiting)
+    {
+        return;
+    }
+
+    host.core1_waiting = false;
+    host.stats.core1_ns[HAL_HOST_IDLE] += host.now_ns - host.core1_wait_ns;
+    hal_host_schedule(host.now_ns, &host_core1_event, NULL, 0, 0);
+}
+
+// ----------------------------------- [ RTC ] -----------------------------------
+
+void hal_rtc_init(void)
+{
+    host.rtc_running = false;
+}
+
+bool hal_rtc_set_datetime(const hal_datetime_t *t)
+{
+    if (t->month < 1 || t->month > 12 || t->day < 1 || t->day > 31 ||
+        t->hour < 0 || t->hour > 23 || t->min < 0 || t->min > 59 || t->sec < 0 || t->sec > 59)
+    {
+        return false;
+    }
+
+    host.rtc_running = true;
+    host.rtc_base_s = host_datetime_to_s(t);
+    host.rtc_set_ns = host.now_ns;
+
+    return true;
+}
+
+bool hal_rtc_get_datetime(hal_datetime_t *t)
+{
+    if (!host.rtc_running)
+    {
+        return false;
+    }
+
+    host_s_to_datetime(host.rtc_base_s + (int64_t)((host.now_ns - host.rtc_set_ns) / 1000000000ull), t);
+
+    return true;
+}
@@ -0,0 +1,342 @@
+/**
+ * @file    hal_host.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Control interface of the host (Linux) backend of the landslide HAL.
+ *
+ *          The host backend runs the firmware against a simulated Pi Pico
+ *          with a virtual clock. Nothing happens in real time: waiting,
+ *          sleeping and bus transfers move the virtual clock forward and are
+ *          charged to one of the power states below, so a run reports how long
+ *          the Pico would have spent awake, asleep and dormant.
+ *
+ *          External stimulus (GPIO levels, accelerometer samples, soil
+ *          readings) comes from scheduled events, normally loaded from the
+ *          trace file named by the LANDSLIDE_TRACE environment variable when
+ *          the firmware calls hal_stdio_init(). When there is nothing left that
+ *          could wake the firmware the simulation ends, a report is printed
+ *          and the program exits.
+ *
+ *          Environment variables read by hal_stdio_init():
+ *            LANDSLIDE_TRACE       trace file to load (see sim_board.h)
+ *            LANDSLIDE_SIM_END_MS  stop after this much virtual time, the
+ *                                  default is 60 s if the trace sets no end
+ *            LANDSLIDE_SIM_QUIET   set to 1 to drop the firmware's printf output
+ *            LANDSLIDE_ZERO_LINK   file or pseudo terminal the Zero copies the
+ *                                  telemetry link's bytes to
+ *            LANDSLIDE_FLASH       image of the flash, loaded if it exists
+ *                                  and saved when the simulation ends, so
+ *                                  the next run boots with what this one
+ *                                  left in the flash
+ *
+ *          The flash starts erased and keeps its contents and erase counts
+ *          through hal_host_reset(), like a real Pico through a reset.
+ *
+ *          Core 1 runs as a coroutine on the same virtual clock. It runs from
+ *          an event until it waits, sleeps or clocks a bus transfer, then
+ *          hands back to core 0 until the clock reaches where it would go on.
+ *          The power states are core 0's, core 1's time is counted apart.
+ *
+ *          Sleep and dormant mode stop the clocks of the Pico's blocks as
+ *          the RP2040 does. The events of a stopped block (timer alarms,
+ *          DMA, UART, the PIO pulse counter and core 1) are held and run
+ *          when its clock starts again, as late as the clock was stopped.
+ *          A byte or GPIO interrupt that comes in meanwhile is lost. Dormant
+ *          mode stops everything, so only its wake pin ends it. The sleep
+ *          of hal_sleep_goto_sleep_until_irq() keeps the GPIO and PIO
+ *          clocks, hal_sleep_goto_sleep_until() only the RTC's.
+ *
+ *          The report ends with the charge the run used: the time in each
+ *          power state at its supply current, core 1's run time, the time
+ *          the buses were clocking bits and the time the firmware drove a
+ *          pin with a load (the LED) high, each at the current of
+ *          hal_host_energy_t, what each sensor model drew (hal_host_set_load())
+ *          and the battery life that mean current gives.
+ *
+*/
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Number of GPIO pins on the simulated Pico
+#define HAL_HOST_NUM_GPIO   30
+
+// Baud rate of the default uart used by printf
+#define HAL_HOST_STDIO_BAUD 115200
+
+// Time the core stalls for a flash sector erase and a page program, the
+// typical times of the Pico's W25Q16 (the worst are 400 ms and 3 ms)
+#define HAL_HOST_FLASH_ERASE_NS (45 * 1000000ull)
+#define HAL_HOST_FLASH_PAGE_NS  (800 * 1000ull)
+
+// Time the crystal oscillator takes to start after dormant mode, the SDK's
+// startup delay of 47 * 256 cycles at 12 MHz
+#define HAL_HOST_XOSC_START_NS  (1003 * 1000ull)
+
+#define HAL_HOST_FLASH_SECTORS  (HAL_FLASH_SIZE / HAL_FLASH_SECTOR_SIZE)
+
+// Power states the virtual time is charged to
+typedef enum
+{
+    HAL_HOST_RUN,       // Core running, including busy waits and bus transfers
+    HAL_HOST_IDLE,      // Core waiting in sleep_ms() with the clocks running
+    HAL_HOST_SLEEP,     // Sleep mode waiting on the RTC alarm
+    HAL_HOST_DORMANT,   // Dormant mode waiting on a GPIO level
+    HAL_HOST_NUM_STATES
+} hal_host_state_t;
+
+// Counters collected while the simulation runs
+typedef struct
+{
+    uint64_t state_ns[HAL_HOST_NUM_STATES]; // Virtual time spent in each state
+    uint64_t core1_ns[HAL_HOST_NUM_STATES]; // The same for core 1, run or idle
+    uint32_t wakes;                         // Returns from dormant or sleep mode
+    uint32_t irq_wakes;                     // Returns from hal_wfi() after an interrupt
+    uint32_t irqs;                          // Interrupt handlers run
+    uint32_t pulses;                        // Pulses the pulse counter counted
+    uint32_t i2c_transfers;                 // I2C reads and writes
+    uint64_t i2c_bytes;                     // Bytes moved over I2C
+    uint64_t i2c_ns;                        // Time the I2C buses were clocking bits
+    uint64_t uart_tx_bytes;                 // Bytes sent to UART devices
+    uint64_t uart_rx_bytes;                 // Bytes read from UART devices
+    uint64_t stdio_bytes;                   // Bytes printed to the default uart
+    uint64_t uart_ns;                       // Time the UARTs were clocking bytes
+    uint32_t flash_erases;                  // Flash sectors erased
+    uint32_t flash_pages;                   // Flash pages programmed
+} hal_host_stats_t;
+
+// Supply currents the virtual time is charged at (uA), all but the power
+// states' are on top of the state the core is in
+typedef struct
+{
+    uint32_t state_ua[HAL_HOST_NUM_STATES]; // Each power state of core 0
+    uint32_t core1_ua;                      // Core 1 running
+    uint32_t i2c_ua;                        // An I2C bus clocking bits
+    uint32_t uart_ua;                       // A UART clocking bytes
+    uint32_t battery_mah;                   // Capacity the battery life is worked out from
+} hal_host_energy_t;
+
+// Function run by a scheduled event
+typedef void (*hal_host_event_fn_t)(void *ctx, uint32_t a, uint32_t b);
+
+// Function called when the firmware changes the level it drives on a pin
+typedef void (*hal_host_gpio_watch_fn_t)(void *ctx, uint pin, bool level);
+
+// Function called when the simulation has nothing left to do
+typedef void (*hal_host_end_fn_t)(void);
+
+// A simulated device on an I2C bus, both functions return the number of bytes
+// transferred or HAL_ERROR_GENERIC, or HAL_ERROR_TIMEOUT while the device
+// holds the bus
+typedef struct
+{
+    int (*write)(void *ctx, const uint8_t *src, size_t len, bool nostop);
+    int (*read)(void *ctx, uint8_t *dst, size_t len, bool nostop);
+    void *ctx;
+} hal_host_i2c_device_t;
+
+// A simulated device on a UART bus, rx is called with each byte the firmware
+// sends once it has been clocked out
+typedef struct
+{
+    void (*rx)(void *ctx, uint8_t c);
+    void *ctx;
+} hal_host_uart_device_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Puts the simulated board back to power on: clears every event,
+ * device, pin and counter and sets the virtual clock to zero
+ */
+void hal_host_reset(void);
+
+/**
+ * @brief Gets the virtual time
+ *
+ * @return uint64_t Nanoseconds since the simulation started
+ */
+uint64_t hal_host_now_ns(void);
+
+/**
+ * @brief Moves the virtual clock forward, running any events that fall due
+ * and charging the time to a power state
+ *
+ * @param ns How far to move the clock
+ * @param state The power state to charge the time to
+ */
+void hal_host_advance_ns(uint64_t ns, hal_host_state_t state);
+
+/**
+ * @brief Schedules a function to run at a point in virtual time. Events at
+ * the same time run in the order they were scheduled.
+ *
+ * @param at_ns The virtual time to run at
+ * @param fn The function to run
+ * @param ctx Passed to the function
+ * @param a Passed to the function
+ * @param b Passed to the function
+ */
+void hal_host_schedule(uint64_t at_ns, hal_host_event_fn_t fn, void *ctx, uint32_t a, uint32_t b);
+
+/**
+ * @brief Sets the virtual time the simulation stops at, 0 for no limit
+ *
+ * @param end_ns The end time
+ */
+void hal_host_set_end_ns(uint64_t end_ns);
+
+/**
+ * @brief Replaces what happens when the simulation ends. The default prints
+ * the report to stderr and exits.
+ *
+ * @param fn The function to call, it must not return
+ */
+void hal_host_set_end_handler(hal_host_end_fn_t fn);
+
+/**
+ * @brief Drives a pin from outside the Pico, as a sensor would
+ *
+ * @param pin The GPIO pin number
+ * @param level The level to drive
+ */
+void hal_host_set_gpio_input(uint pin, bool level);
+
+/**
+ * @brief Schedules an external level change on a pin
+ *
+ * @param at_ns The virtual time of the change
+ * @param pin The GPIO pin number
+ * @param level The level to drive
+ */
+void hal_host_schedule_gpio(uint64_t at_ns, uint pin, bool level);
+
+/**
+ * @brief Registers a function to call when the firmware changes the level
+ * it drives on a pin. One watcher per pin.
+ *
+ * @param pin The GPIO pin number
+ * @param fn The function to call, NULL to remove the watcher
+ * @param ctx Passed to the function
+ */
+void hal_host_watch_gpio(uint pin, hal_host_gpio_watch_fn_t fn, void *ctx);
+
+/**
+ * @brief Attaches a simulated device to an I2C bus
+ *
+ * @param i2c The bus the device is on
+ * @param addr The 7 bit address of the device
+ * @param dev The device, copied
+ */
+void hal_host_attach_i2c(hal_i2c_t i2c, uint8_t addr, const hal_host_i2c_device_t *dev);
+
+/**
+ * @brief Attaches a simulated device to a UART bus
+ *
+ * @param uart The bus the device is on
+ * @param dev The device, copied
+ */
+void hal_host_attach_uart(hal_uart_t uart, const hal_host_uart_device_t *dev);
+
+/**
+ * @brief Sends bytes from a device to the firmware. The first byte arrives
+ * after delay_ns and the rest follow at the bus baud rate.
+ *
+ * @param uart The bus to send on
+ * @param delay_ns Time until the first byte arrives
+ * @param src The bytes to send
+ * @param len The number of bytes to send
+ */
+void hal_host_uart_inject(hal_uart_t uart, uint64_t delay_ns, const uint8_t *src, size_t len);
+
+/**
+ * @brief Sets the supply currents the report charges the run at
+ *
+ * @param energy The currents, copied
+ */
+void hal_host_set_energy(const hal_host_energy_t *energy);
+
+/**
+ * @brief Gets the supply currents the report charges the run at
+ *
+ * @return const hal_host_energy_t* The currents
+ */
+const hal_host_energy_t *hal_host_energy(void);
+
+/**
+ * @brief Sets the current drawn while the firmware drives a pin high, as an
+ * LED would
+ *
+ * @param pin The GPIO pin number
+ * @param ua The current (uA), 0 for none
+ */
+void hal_host_set_gpio_load(uint pin, uint32_t ua);
+
+/**
+ * @brief Adds a device that draws a current of its own, charged on its own
+ * line of the report. Loads are cleared by hal_host_reset().
+ *
+ * @param name Name in the report, not copied
+ * @return int The load, -1 if there is no room for another
+ */
+int hal_host_add_load(const char *name);
+
+/**
+ * @brief Sets the current a device draws from now on
+ *
+ * @param load The load from hal_host_add_load(), ignored if it is -1
+ * @param ua The current (uA)
+ */
+void hal_host_set_load(int load, double ua);
+
+/**
+ * @brief Gets the charge the run has used so far, at the supply currents of
+ * hal_host_set_energy() and the device loads
+ *
+ * @return double The charge (mAh)
+ */
+double hal_host_charge_mah(void);
+
+/**
+ * @brief Gets the counters collected so far
+ *
+ * @return const hal_host_stats_t* The counters
+ */
+const hal_host_stats_t *hal_host_stats(void);
+
+/**
+ * @brief Erases the whole simulated flash and zeroes its erase counts
+ */
+void hal_host_flash_wipe(void);
+
+/**
+ * @brief Gets how many times each sector of the simulated flash has been
+ * erased, since the program started or the last hal_host_flash_wipe()
+ *
+ * @return const uint32_t* HAL_HOST_FLASH_SECTORS counts
+ */
+const uint32_t *hal_host_flash_erases(void);
+
+/**
+ * @brief Prints the simulation report
+ *
+ * @param out Where to print it
+ */
+void hal_host_report(FILE *out);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAL_HOST_H
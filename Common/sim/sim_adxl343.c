@@ -0,0 +1,727 @@
+/**
+ * @file    sim_adxl343.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Register level model of the ADXL343 accelerometer, see
+ *          sim_adxl343.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "sim_adxl343.h"
+#include "adxl343.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Supply current measuring at each rate code from 0.10 to 3200 Hz at normal
+// power, and at 12.5 to 400 Hz at low power (uA), from the datasheet
+static const double adxl343_normal_ua[16] = {
+    23, 23, 23, 23, 34, 40, 45, 50, 60, 90, 140, 140, 140, 140, 90, 140
+};
+
+static const double adxl343_low_power_ua[16] = {
+    [ADXL343_RATE_12HZ5] = 34, 40, 45, 50, 60, 90
+};
+
+// Standby (uA)
+#define ADXL343_STANDBY_UA      0.1
+
+static const char *const adxl343_mode_names[SIM_ADXL343_NUM_MODES] = {
+    "standby", "measure", "low power", "sleep"
+};
+
+
+// ############################## [ Local Functions ] ##############################
+
+static bool adxl343_measuring(const sim_adxl343_t *dev)
+{
+    return dev->regs[ADXL343_REG_POWER_CTL] & ADXL343_POWER_CTL_MEASURE;
+}
+
+// Whether sampling is at the wake up rate
+static bool adxl343_sleeping(const sim_adxl343_t *dev)
+{
+    return (dev->regs[ADXL343_REG_POWER_CTL] & ADXL343_POWER_CTL_SLEEP) || dev->asleep;
+}
+
+// Whether auto sleep drops to the wake up rate once inactivity is raised
+static bool adxl343_auto_sleep(const sim_adxl343_t *dev)
+{
+    uint8_t ctl = dev->regs[ADXL343_REG_POWER_CTL];
+
+    return (ctl & ADXL343_POWER_CTL_AUTO_SLEEP) && (ctl & ADXL343_POWER_CTL_LINK);
+}
+
+// Rate code of the wake up rate, 8 Hz is nearest 6.25 Hz
+static uint8_t adxl343_wakeup_code(const sim_adxl343_t *dev)
+{
+    return (uint8_t)(6 - (dev->regs[ADXL343_REG_POWER_CTL] & ADXL343_POWER_CTL_WAKEUP_MASK));
+}
+
+static sim_adxl343_mode_t adxl343_mode(const sim_adxl343_t *dev)
+{
+    uint8_t bw_rate = dev->regs[ADXL343_REG_BW_RATE];
+
+    if (!adxl343_measuring(dev))
+    {
+        return SIM_ADXL343_STANDBY;
+    }
+
+    if (adxl343_sleeping(dev))
+    {
+        return SIM_ADXL343_SLEEP;
+    }
+
+    // Low power only applies from 12.5 to 400 Hz
+    if ((bw_rate & ADXL343_BW_LOW_POWER) && adxl343_low_power_ua[bw_rate & 0x0F] != 0)
+    {
+        return SIM_ADXL343_LOW_POWER;
+    }
+
+    return SIM_ADXL343_MEASURE;
+}
+
+// Counts the time in the mode so far and charges the current of the mode
+// the registers now give
+static void adxl343_update_power(sim_adxl343_t *dev)
+{
+    uint64_t now_ns = hal_host_now_ns();
+    sim_adxl343_mode_t mode = adxl343_mode(dev);
+    uint8_t code = dev->regs[ADXL343_REG_BW_RATE] & 0x0F;
+    double ua = ADXL343_STANDBY_UA;
+
+    dev->mode_ns[dev->mode] += now_ns - dev->mode_since_ns;
+    dev->mode_since_ns = now_ns;
+    dev->mode = mode;
+
+    if (mode == SIM_ADXL343_SLEEP)
+    {
+        ua = adxl343_normal_ua[adxl343_wakeup_code(dev)];
+    }
+    else if (mode == SIM_ADXL343_LOW_POWER)
+    {
+        ua = adxl343_low_power_ua[code];
+    }
+    else if (mode == SIM_ADXL343_MEASURE)
+    {
+        ua = adxl343_normal_ua[code];
+    }
+
+    hal_host_set_load(dev->load, ua);
+}
+
+static uint8_t adxl343_fifo_mode(const sim_adxl343_t *dev)
+{
+    return dev->regs[ADXL343_REG_FIFO_CTL] & ADXL343_FIFO_MODE_MASK;
+}
+
+// Time between samples, the rate code n gives 3200 / 2^(15 - n) Hz, and in
+// sleep the wake up rate
+static uint64_t adxl343_period_ns(const sim_adxl343_t *dev)
+{
+    uint8_t code = dev->regs[ADXL343_REG_BW_RATE] & 0x0F;
+
+    if (adxl343_sleeping(dev))
+    {
+        return 1000000000ull / ADXL343_WAKEUP_HZ(dev->regs[ADXL343_REG_POWER_CTL] & ADXL343_POWER_CTL_WAKEUP_MASK);
+    }
+
+    return (1000000000ull << (15 - code)) / 3200;
+}
+
+static bool adxl343_read_only(uint8_t reg)
+{
+    return reg == ADXL343_REG_DEVID || reg == ADXL343_REG_INT_SOURCE || reg == ADXL343_REG_FIFO_STATUS ||
+           (reg >= ADXL343_REG_DATAX0 && reg <= ADXL343_REG_DATAZ1);
+}
+
+// Interrupts that stay set until INT_SOURCE is read
+#define ADXL343_INT_LATCHED     (ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY)
+
+// Registers whose writes start activity and inactivity detection again
+static bool adxl343_motion_reg(uint8_t reg)
+{
+    return (reg >= ADXL343_REG_THRESH_ACT && reg <= ADXL343_REG_ACT_INACT_CTL) || reg == ADXL343_REG_POWER_CTL ||
+           reg == ADXL343_REG_INT_ENABLE;
+}
+
+static void adxl343_fifo_clear(sim_adxl343_t *dev)
+{
+    dev->fifo_head = 0;
+    dev->fifo_count = 0;
+    dev->triggered = false;
+    dev->overrun = false;
+}
+
+// Puts n copies of the current sample into the FIFO as the mode says
+static void adxl343_fifo_push(sim_adxl343_t *dev, uint64_t n)
+{
+    uint8_t mode = adxl343_fifo_mode(dev);
+
+    // FIFO mode, and trigger mode once triggered, stop when full while stream
+    // mode throws away the oldest entry
+    bool keep_oldest = mode == ADXL343_FIFO_FIFO || (mode == ADXL343_FIFO_TRIGGER && dev->triggered);
+
+    if (mode == ADXL343_FIFO_BYPASS)
+    {
+        return;
+    }
+
+    // Only the newest entries can survive, they are all the same sample
+    if (n > SIM_ADXL343_FIFO_DEPTH)
+    {
+        if (!keep_oldest)
+        {
+            dev->overrun = true;
+        }
+        n = keep_oldest ? n : SIM_ADXL343_FIFO_DEPTH + 1;
+    }
+
+    for (uint64_t i = 0; i < n; i++)
+    {
+        if (dev->fifo_count == SIM_ADXL343_FIFO_DEPTH)
+        {
+            if (keep_oldest)
+            {
+                return;
+            }
+
+            dev->fifo_head = (dev->fifo_head + 1) % SIM_ADXL343_FIFO_DEPTH;
+            dev->fifo_count--;
+            dev->overrun = true;
+        }
+
+        int16_t *entry = dev->fifo[(dev->fifo_head + dev->fifo_count) % SIM_ADXL343_FIFO_DEPTH];
+        memcpy(entry, dev->sample, sizeof(dev->sample));
+        dev->fifo_count++;
+    }
+}
+
+// Drops the oldest FIFO entries so no more than n are left
+static void adxl343_fifo_keep(sim_adxl343_t *dev, uint8_t n)
+{
+    while (dev->fifo_count > n)
+    {
+        dev->fifo_head = (dev->fifo_head + 1) % SIM_ADXL343_FIFO_DEPTH;
+        dev->fifo_count--;
+    }
+}
+
+// Whether any enabled axis of the sample is further than thresh from ref,
+// or from 0 when DC coupled. axes has x in bit 2, y in bit 1 and z in bit 0.
+static bool adxl343_moved(const int16_t *sample, const int16_t *ref, bool ac, uint8_t axes, uint8_t thresh)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        int32_t diff = sample[i] - (ac ? ref[i] : 0);
+
+        if ((axes & (4 >> i)) && abs(diff) > thresh * ADXL343_THRESH_LSB)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Starts activity and inactivity detection from the current sample
+static void adxl343_motion_start(sim_adxl343_t *dev)
+{
+    memcpy(dev->act_ref, dev->sample, sizeof(dev->sample));
+    memcpy(dev->inact_ref, dev->sample, sizeof(dev->sample));
+    dev->still_ns = hal_host_now_ns();
+    dev->inact_raised = false;
+}
+
+// Whether activity and inactivity are being looked for now
+static bool adxl343_act_on(const sim_adxl343_t *dev)
+{
+    bool link = dev->regs[ADXL343_REG_POWER_CTL] & ADXL343_POWER_CTL_LINK;
+
+    return (dev->regs[ADXL343_REG_INT_ENABLE] & ADXL343_INT_ACTIVITY) &&
+           (dev->regs[ADXL343_REG_ACT_INACT_CTL] & ADXL343_ACT_XYZ) && !(link && dev->active);
+}
+
+static bool adxl343_inact_on(const sim_adxl343_t *dev)
+{
+    bool link = dev->regs[ADXL343_REG_POWER_CTL] & ADXL343_POWER_CTL_LINK;
+
+    return (dev->regs[ADXL343_REG_INT_ENABLE] & ADXL343_INT_INACTIVITY) &&
+           (dev->regs[ADXL343_REG_ACT_INACT_CTL] & ADXL343_INACT_XYZ) && !(link && !dev->active);
+}
+
+// Whether the next sample raises activity
+static bool adxl343_act_next(const sim_adxl343_t *dev)
+{
+    uint8_t ctl = dev->regs[ADXL343_REG_ACT_INACT_CTL];
+
+    return adxl343_act_on(dev) && adxl343_moved(dev->sample, dev->act_ref, ctl & ADXL343_ACT_AC,
+                                                (ctl & ADXL343_ACT_XYZ) >> 4, dev->regs[ADXL343_REG_THRESH_ACT]);
+}
+
+// Raises an activity or inactivity interrupt, which in trigger mode is the
+// trigger if it goes to the pin FIFO_CTL names
+static void adxl343_raise(sim_adxl343_t *dev, uint8_t bit)
+{
+    uint8_t fifo_ctl = dev->regs[ADXL343_REG_FIFO_CTL];
+    bool on_int2 = dev->regs[ADXL343_REG_INT_MAP] & bit;
+
+    dev->regs[ADXL343_REG_INT_SOURCE] |= bit;
+
+    if (adxl343_fifo_mode(dev) == ADXL343_FIFO_TRIGGER && !dev->triggered &&
+        on_int2 == ((fifo_ctl & ADXL343_FIFO_TRIGGER_INT2) != 0))
+    {
+        dev->triggered = true;
+        adxl343_fifo_keep(dev, fifo_ctl & ADXL343_FIFO_SAMPLES_MASK);
+    }
+}
+
+// Time of inactivity's TIME_INACT seconds of still samples
+static uint64_t adxl343_inact_due_ns(const sim_adxl343_t *dev)
+{
+    return dev->still_ns + dev->regs[ADXL343_REG_TIME_INACT] * 1000000000ull;
+}
+
+// Runs activity and inactivity detection over the samples from first_ns to
+// last_ns, which all measured the current acceleration
+static void adxl343_motion(sim_adxl343_t *dev, uint64_t first_ns, uint64_t last_ns)
+{
+    uint8_t ctl = dev->regs[ADXL343_REG_ACT_INACT_CTL];
+    bool link = dev->regs[ADXL343_REG_POWER_CTL] & ADXL343_POWER_CTL_LINK;
+
+    if (adxl343_act_next(dev))
+    {
+        if (!(dev->regs[ADXL343_REG_INT_SOURCE] & ADXL343_INT_ACTIVITY))
+        {
+            dev->activities++;
+        }
+        adxl343_raise(dev, ADXL343_INT_ACTIVITY);
+
+        // Linked, inactivity is looked for from here on, at the full rate
+        if (link)
+        {
+            if (dev->asleep)
+            {
+                dev->asleep = false;
+                adxl343_update_power(dev);
+            }
+            dev->active = true;
+            memcpy(dev->inact_ref, dev->sample, sizeof(dev->sample));
+            dev->still_ns = first_ns;
+            dev->inact_raised = false;
+        }
+    }
+
+    if (!adxl343_inact_on(dev))
+    {
+        return;
+    }
+
+    // Moving starts the still spell again, AC coupled from where it moved to
+    bool ac = ctl & ADXL343_INACT_AC;
+    if (adxl343_moved(dev->sample, dev->inact_ref, ac, ctl & ADXL343_INACT_XYZ, dev->regs[ADXL343_REG_THRESH_INACT]))
+    {
+        memcpy(dev->inact_ref, dev->sample, sizeof(dev->sample));
+        dev->still_ns = ac ? first_ns + adxl343_period_ns(dev) : UINT64_MAX;
+        dev->inact_raised = false;
+    }
+    else if (dev->still_ns == UINT64_MAX)
+    {
+        dev->still_ns = first_ns;
+    }
+
+    if (dev->still_ns != UINT64_MAX && !dev->inact_raised && last_ns >= adxl343_inact_due_ns(dev))
+    {
+        dev->inactivities++;
+        dev->inact_raised = true;
+        adxl343_raise(dev, ADXL343_INT_INACTIVITY);
+
+        // Linked, activity is looked for from where it came to rest, at the
+        // wake up rate with auto sleep
+        if (link)
+        {
+            dev->active = false;
+            memcpy(dev->act_ref, dev->sample, sizeof(dev->sample));
+        }
+
+        if (adxl343_auto_sleep(dev))
+        {
+            dev->asleep = true;
+            adxl343_update_power(dev);
+        }
+    }
+}
+
+// Takes every sample due at the output data rate up to now
+static void adxl343_take_samples(sim_adxl343_t *dev)
+{
+    uint64_t now_ns = hal_host_now_ns();
+
+    if (!adxl343_measuring(dev))
+    {
+        dev->last_sample_ns = now_ns;
+        return;
+    }
+
+    // In runs of samples at one rate, which auto sleep changes on the
+    // sample that raises inactivity or activity
+    while (true)
+    {
+        uint64_t period_ns = adxl343_period_ns(dev);
+        uint64_t n = (now_ns - dev->last_sample_ns) / period_ns;
+
+        if (n == 0)
+        {
+            return;
+        }
+
+        if (adxl343_auto_sleep(dev) && !dev->asleep && dev->still_ns != UINT64_MAX && !dev->inact_raised &&
+            adxl343_inact_on(dev))
+        {
+            uint64_t due_ns = adxl343_inact_due_ns(dev);
+            uint64_t k = due_ns > dev->last_sample_ns ? (due_ns - dev->last_sample_ns + period_ns - 1) / period_ns : 1;
+            n = k < n ? k : n;
+        }
+        else if (dev->asleep && adxl343_act_next(dev))
+        {
+            n = 1;
+        }
+
+        uint64_t first_ns = dev->last_sample_ns + period_ns;
+
+        dev->last_sample_ns += n * period_ns;
+        dev->data_ready = true;
+        adxl343_motion(dev, first_ns, dev->last_sample_ns);
+        adxl343_fifo_push(dev, n);
+    }
+}
+
+// Live value of INT_SOURCE
+static uint8_t adxl343_int_source(const sim_adxl343_t *dev)
+{
+    uint8_t source = dev->regs[ADXL343_REG_INT_SOURCE] & ADXL343_INT_LATCHED;
+
+    if (adxl343_fifo_mode(dev) == ADXL343_FIFO_BYPASS)
+    {
+        source |= dev->data_ready ? ADXL343_INT_DATA_READY : 0;
+    }
+    else
+    {
+        source |= dev->fifo_count > 0 ? ADXL343_INT_DATA_READY : 0;
+        source |= dev->fifo_count >= (dev->regs[ADXL343_REG_FIFO_CTL] & ADXL343_FIFO_SAMPLES_MASK) ? ADXL343_INT_WATERMARK : 0;
+    }
+
+    source |= dev->overrun ? ADXL343_INT_OVERRUN : 0;
+
+    return source;
+}
+
+// Drives the interrupt pins from the enabled interrupts
+static void adxl343_update_pins(sim_adxl343_t *dev)
+{
+    uint8_t active = adxl343_int_source(dev) & dev->regs[ADXL343_REG_INT_ENABLE];
+    uint8_t map = dev->regs[ADXL343_REG_INT_MAP];
+    bool levels[2] = {(active & ~map) != 0, (active & map) != 0};
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (dev->int_pins[i] >= 0)
+        {
+            hal_host_set_gpio_input(dev->int_pins[i], levels[i]);
+        }
+    }
+}
+
+static void adxl343_sync(sim_adxl343_t *dev);
+
+static void adxl343_int_event(void *ctx, uint32_t gen, uint32_t b)
+{
+    sim_adxl343_t *dev = ctx;
+    (void)b;
+
+    if (gen == dev->int_gen)
+    {
+        adxl343_sync(dev);
+    }
+}
+
+// Schedules an update for the next time an enabled interrupt could go high
+static void adxl343_schedule(sim_adxl343_t *dev)
+{
+    dev->int_gen++;
+
+    uint8_t enabled = dev->regs[ADXL343_REG_INT_ENABLE] & ~adxl343_int_source(dev);
+    uint8_t mode = adxl343_fifo_mode(dev);
+    uint64_t period_ns = adxl343_period_ns(dev);
+    uint64_t samples = 0;
+
+    if (!adxl343_measuring(dev) || (dev->int_pins[0] < 0 && dev->int_pins[1] < 0))
+    {
+        return;
+    }
+
+    // Samples until each interrupt would go high
+    if (enabled & ADXL343_INT_DATA_READY)
+    {
+        samples = 1;
+    }
+    else if ((enabled & ADXL343_INT_WATERMARK) && mode != ADXL343_FIFO_BYPASS)
+    {
+        samples = (dev->regs[ADXL343_REG_FIFO_CTL] & ADXL343_FIFO_SAMPLES_MASK) - dev->fifo_count;
+    }
+    else if ((enabled & ADXL343_INT_OVERRUN) && (mode == ADXL343_FIFO_STREAM || (mode == ADXL343_FIFO_TRIGGER && !dev->triggered)))
+    {
+        samples = SIM_ADXL343_FIFO_DEPTH + 1 - dev->fifo_count;
+    }
+
+    uint64_t at_ns = samples > 0 ? dev->last_sample_ns + samples * period_ns : UINT64_MAX;
+    uint64_t next_ns = dev->last_sample_ns + period_ns;
+
+    // The next sample raises activity if the acceleration has moved far
+    // enough, inactivity is due once the still spell is long enough
+    if ((enabled & ADXL343_INT_ACTIVITY) && adxl343_act_next(dev))
+    {
+        at_ns = next_ns < at_ns ? next_ns : at_ns;
+    }
+
+    if ((enabled & ADXL343_INT_INACTIVITY) && adxl343_inact_on(dev) && dev->still_ns != UINT64_MAX &&
+        !dev->inact_raised)
+    {
+        // On the first sample at or after it
+        uint64_t due_ns = adxl343_inact_due_ns(dev);
+        if (due_ns > next_ns)
+        {
+            next_ns += (due_ns - next_ns + period_ns - 1) / period_ns * period_ns;
+        }
+        at_ns = next_ns < at_ns ? next_ns : at_ns;
+    }
+
+    if (at_ns != UINT64_MAX)
+    {
+        hal_host_schedule(at_ns, &adxl343_int_event, dev, dev->int_gen, 0);
+    }
+}
+
+// Brings the model up to the current virtual time
+static void adxl343_sync(sim_adxl343_t *dev)
+{
+    adxl343_take_samples(dev);
+    adxl343_update_pins(dev);
+    adxl343_schedule(dev);
+}
+
+// Fills the data registers from the FIFO, or with the current sample in
+// bypass mode, or zeros in standby
+static void adxl343_latch_sample(sim_adxl343_t *dev)
+{
+    const int16_t *sample = dev->sample;
+    static const int16_t zero[3] = {0, 0, 0};
+
+    if (!adxl343_measuring(dev))
+    {
+        sample = zero;
+    }
+    else if (adxl343_fifo_mode(dev) != ADXL343_FIFO_BYPASS)
+    {
+        sample = dev->fifo_count > 0 ? dev->fifo[dev->fifo_head] : zero;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        uint16_t raw = (uint16_t)sample[i];
+        dev->regs[ADXL343_REG_DATAX0 + 2 * i] = raw & 0xFF;
+        dev->regs[ADXL343_REG_DATAX0 + 2 * i + 1] = raw >> 8;
+    }
+}
+
+static int adxl343_write(void *ctx, const uint8_t *src, size_t len, bool nostop)
+{
+    sim_adxl343_t *dev = ctx;
+    (void)nostop;
+
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    adxl343_take_samples(dev);
+
+    bool was_measuring = adxl343_measuring(dev);
+    uint8_t old_mode = adxl343_fifo_mode(dev);
+    bool motion = false;
+
+    // First byte is the register pointer, the rest are data
+    dev->pointer = src[0] % SIM_ADXL343_NUM_REGS;
+
+    for (size_t i = 1; i < len; i++)
+    {
+        if (!adxl343_read_only(dev->pointer))
+        {
+            dev->regs[dev->pointer] = src[i];
+            motion |= adxl343_motion_reg(dev->pointer);
+        }
+
+        dev->reg_writes++;
+        dev->pointer = (dev->pointer + 1) % SIM_ADXL343_NUM_REGS;
+    }
+
+    // Sampling starts from the moment the Measure bit is set, awake. Linked,
+    // activity is only looked for once inactivity has been seen.
+    if (!was_measuring && adxl343_measuring(dev))
+    {
+        dev->last_sample_ns = hal_host_now_ns();
+        dev->active = true;
+        dev->asleep = false;
+    }
+
+    if (!adxl343_auto_sleep(dev))
+    {
+        dev->asleep = false;
+    }
+
+    adxl343_update_power(dev);
+
+    if (motion)
+    {
+        adxl343_motion_start(dev);
+    }
+
+    // Bypass mode empties the FIFO, and a new mode rearms the trigger
+    if (adxl343_fifo_mode(dev) == ADXL343_FIFO_BYPASS)
+    {
+        adxl343_fifo_clear(dev);
+    }
+    else if (adxl343_fifo_mode(dev) != old_mode)
+    {
+        dev->triggered = false;
+    }
+
+    adxl343_sync(dev);
+
+    return (int)len;
+}
+
+static int adxl343_read(void *ctx, uint8_t *dst, size_t len, bool nostop)
+{
+    sim_adxl343_t *dev = ctx;
+    (void)nostop;
+
+    adxl343_take_samples(dev);
+
+    // A multi-byte read that covers the data registers sees one consistent
+    // sample
+    bool data_read = dev->pointer <= ADXL343_REG_DATAZ1 && dev->pointer + len > ADXL343_REG_DATAX0;
+    if (data_read)
+    {
+        adxl343_latch_sample(dev);
+    }
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (dev->pointer == ADXL343_REG_INT_SOURCE)
+        {
+            // Reading it clears the interrupts that stay set
+            dst[i] = adxl343_int_source(dev);
+            dev->regs[ADXL343_REG_INT_SOURCE] &= ~ADXL343_INT_LATCHED;
+        }
+        else if (dev->pointer == ADXL343_REG_FIFO_STATUS)
+        {
+            dst[i] = (dev->triggered ? ADXL343_FIFO_STATUS_TRIG : 0) | dev->fifo_count;
+        }
+        else
+        {
+            dst[i] = dev->regs[dev->pointer];
+        }
+
+        dev->reg_reads++;
+        dev->pointer = (dev->pointer + 1) % SIM_ADXL343_NUM_REGS;
+    }
+
+    // Reading the data clears DATA_READY and the overrun and pops the FIFO
+    if (data_read)
+    {
+        dev->data_ready = false;
+        dev->overrun = false;
+
+        if (adxl343_fifo_mode(dev) != ADXL343_FIFO_BYPASS && dev->fifo_count > 0)
+        {
+            dev->fifo_head = (dev->fifo_head + 1) % SIM_ADXL343_FIFO_DEPTH;
+            dev->fifo_count--;
+        }
+    }
+
+    adxl343_sync(dev);
+
+    return (int)len;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void sim_adxl343_init(sim_adxl343_t *dev)
+{
+    memset(dev, 0, sizeof(*dev));
+
+    // Reset values from the datasheet
+    dev->regs[ADXL343_REG_DEVID] = ADXL343_DEVID;
+    dev->regs[ADXL343_REG_BW_RATE] = 0x0A;
+    dev->int_pins[0] = -1;
+    dev->int_pins[1] = -1;
+
+    // Powered up in standby
+    dev->load = hal_host_add_load("adxl343");
+    dev->mode_since_ns = hal_host_now_ns();
+    adxl343_update_power(dev);
+}
+
+void sim_adxl343_attach(sim_adxl343_t *dev, hal_i2c_t i2c, uint8_t addr)
+{
+    hal_host_i2c_device_t i2c_dev = {
+        .write = &adxl343_write,
+        .read = &adxl343_read,
+        .ctx = dev
+    };
+
+    hal_host_attach_i2c(i2c, addr, &i2c_dev);
+}
+
+void sim_adxl343_connect_int(sim_adxl343_t *dev, int int1_pin, int int2_pin)
+{
+    dev->int_pins[0] = int1_pin;
+    dev->int_pins[1] = int2_pin;
+    adxl343_sync(dev);
+}
+
+void sim_adxl343_set_sample(sim_adxl343_t *dev, int16_t x, int16_t y, int16_t z)
+{
+    // Samples taken up to now saw the old acceleration
+    adxl343_take_samples(dev);
+
+    dev->sample[0] = x;
+    dev->sample[1] = y;
+    dev->sample[2] = z;
+
+    // The new acceleration can be activity, or end a still spell
+    adxl343_update_pins(dev);
+    adxl343_schedule(dev);
+}
+
+uint64_t sim_adxl343_mode_ns(const sim_adxl343_t *dev, sim_adxl343_mode_t mode)
+{
+    uint64_t ns = dev->mode_ns[mode];
+
+    if (dev->mode == mode)
+    {
+        ns += hal_host_now_ns() - dev->mode_since_ns;
+    }
+
+    return ns;
+}
+
+const char *sim_adxl343_mode_name(sim_adxl343_mode_t mode)
+{
+    return mode < SIM_ADXL343_NUM_MODES ? adxl343_mode_names[mode] : "unknown";
+}
@@ -0,0 +1,165 @@
+/**
+ * @file    sim_adxl343.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Register level model of the ADXL343 accelerometer for the host
+ *          backend. The firmware talks to it over the simulated I2C bus
+ *          exactly as it would to the real part: the first byte of a write
+ *          sets the register pointer, following bytes are written to
+ *          consecutive registers and reads auto-increment the pointer.
+ *
+ *          The acceleration it reports is set by the test or trace with
+ *          sim_adxl343_set_sample() and is held until the next sample. While
+ *          measuring, samples are taken at the BW_RATE output data rate into
+ *          the 32 entry FIFO (bypass, FIFO, stream and trigger modes), and the
+ *          DATA_READY, watermark and overrun interrupts drive the INT1/INT2
+ *          pins as mapped by INT_MAP. Each read that starts in the data
+ *          registers pops one FIFO entry.
+ *
+ *          Activity and inactivity detection follow THRESH_ACT, THRESH_INACT,
+ *          TIME_INACT and ACT_INACT_CTL, AC or DC coupled, and the LINK bit
+ *          of POWER_CTL. Their INT_SOURCE bits stay set until INT_SOURCE is
+ *          read. In trigger mode an interrupt going high on the pin FIFO_CTL
+ *          names is the trigger: the FIFO keeps its newest samples entries
+ *          and fills up after them.
+ *
+ *          SLEEP in POWER_CTL, or AUTO_SLEEP with LINK once inactivity is
+ *          raised, drops sampling to the wake up rate until activity. The
+ *          model charges the supply current of the datasheet for the mode
+ *          and rate it is in (hal_host_set_load()): 0.1 uA in standby, 23 to
+ *          140 uA measuring, and the current at the wake up rate in sleep.
+ *
+*/
+
+#ifndef SIM_ADXL343_H
+#define SIM_ADXL343_H
+
+// ################################# [ Includes ] #################################
+
+#include "hal_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Number of registers on the ADXL343
+#define SIM_ADXL343_NUM_REGS    0x40
+
+// Entries in the FIFO
+#define SIM_ADXL343_FIFO_DEPTH  32
+
+// Modes the part's time is counted in
+typedef enum
+{
+    SIM_ADXL343_STANDBY,
+    SIM_ADXL343_MEASURE,                // Normal power
+    SIM_ADXL343_LOW_POWER,              // LOW_POWER set at a rate it applies to
+    SIM_ADXL343_SLEEP,                  // Sampling at the wake up rate
+    SIM_ADXL343_NUM_MODES
+} sim_adxl343_mode_t;
+
+// Simulated accelerometer
+typedef struct
+{
+    uint8_t regs[SIM_ADXL343_NUM_REGS]; // Register file
+    uint8_t pointer;                    // Register the next access starts at
+    int16_t sample[3];                  // Current x, y, z acceleration in LSB
+
+    // FIFO, entries are taken from the head
+    int16_t fifo[SIM_ADXL343_FIFO_DEPTH][3];
+    uint8_t fifo_head;
+    uint8_t fifo_count;
+    bool triggered;                     // Trigger mode has seen its trigger
+    bool data_ready;                    // A new sample since the data registers were last read
+    bool overrun;                       // A sample was lost since the FIFO was last read
+    uint64_t last_sample_ns;            // Virtual time of the last sample taken
+
+    // Activity and inactivity detection: where each compares from when AC
+    // coupled, whether LINK has it looking for inactivity, the first sample
+    // inactivity has been still since (UINT64_MAX while moving) and whether
+    // this still spell has raised it yet
+    int16_t act_ref[3];
+    int16_t inact_ref[3];
+    bool active;
+    uint64_t still_ns;
+    bool inact_raised;
+    uint32_t activities;                // Activity interrupts raised
+    uint32_t inactivities;              // Inactivity interrupts raised
+    bool asleep;                        // Auto sleep has dropped to the wake up rate
+
+    // Supply current, the mode it is in since when and the time in each
+    int load;                           // hal_host_add_load() of the model
+    sim_adxl343_mode_t mode;
+    uint64_t mode_since_ns;
+    uint64_t mode_ns[SIM_ADXL343_NUM_MODES];
+
+    // Pico pins wired to INT1 and INT2, -1 if not connected
+    int int_pins[2];
+    uint32_t int_gen;                   // Bumped to cancel the scheduled interrupt update
+
+    uint32_t reg_writes;                // Registers written by the firmware
+    uint32_t reg_reads;                 // Registers read by the firmware
+} sim_adxl343_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Puts the model into its power on state
+ *
+ * @param dev The model
+ */
+void sim_adxl343_init(sim_adxl343_t *dev);
+
+/**
+ * @brief Attaches the model to a simulated I2C bus
+ *
+ * @param dev The model
+ * @param i2c The bus to attach to
+ * @param addr The address to answer on, 0x53 with ALT ADDRESS low
+ */
+void sim_adxl343_attach(sim_adxl343_t *dev, hal_i2c_t i2c, uint8_t addr);
+
+/**
+ * @brief Wires the INT1 and INT2 outputs to Pico pins
+ *
+ * @param dev The model
+ * @param int1_pin The pin INT1 drives, -1 if not connected
+ * @param int2_pin The pin INT2 drives, -1 if not connected
+ */
+void sim_adxl343_connect_int(sim_adxl343_t *dev, int int1_pin, int int2_pin);
+
+/**
+ * @brief Sets the acceleration the model measures
+ *
+ * @param dev The model
+ * @param x The x axis in LSB
+ * @param y The y axis in LSB
+ * @param z The z axis in LSB
+ */
+void sim_adxl343_set_sample(sim_adxl343_t *dev, int16_t x, int16_t y, int16_t z);
+
+/**
+ * @brief Gets the time spent in a mode up to now
+ *
+ * @param dev The model
+ * @param mode The mode
+ * @return uint64_t The time (ns)
+ */
+uint64_t sim_adxl343_mode_ns(const sim_adxl343_t *dev, sim_adxl343_mode_t mode);
+
+/**
+ * @brief Gets the name of a mode
+ *
+ * @param mode The mode
+ * @return const char* The name
+ */
+const char *sim_adxl343_mode_name(sim_adxl343_mode_t mode);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_ADXL343_H
@@ -0,0 +1,670 @@
+/**
+ * @file    sim_board.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   The simulated sensor node and trace loader, see sim_board.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "sim_board.h"
+#include "seismic_config.h"
+#include "soil_config.h"
+#include "node_phase.h"
+#include "node_warning.h"
+#include "node_telemetry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Pins and buses of the sensor node, wired as the site profile says
+#define BOARD_I2C_ACC       SEISMIC_I2C
+#define BOARD_ADXL343_ADDR  SEISMIC_ADXL343_ADDR
+#define BOARD_ACC_INT1_PIN  SEISMIC_INT_PIN
+#define BOARD_UART_SOIL     SOIL_UART
+#define BOARD_WARNING_PIN   NODE_WARNING_PIN
+#define BOARD_ACK_PIN       NODE_ACK_PIN
+#define BOARD_I2C_ZERO      NODE_ZERO_I2C
+#define BOARD_ZERO_ADDR     NODE_ZERO_I2C_ADDR
+
+// How long the Zero holds the ack (clear) pin high, from normal.py
+#define BOARD_ACK_HOLD_MS   1000
+
+// Time between the bounces of a pulse's switch contact
+#define BOARD_BOUNCE_NS     1000000ull
+
+// Longest line in a trace file
+#define BOARD_MAX_LINE      256
+
+// Units a trace's times can be given in, milliseconds when there is none
+static const struct
+{
+    const char *name;
+    double ms;
+} board_units[] = {
+    {"ms", 1.0}, {"s", 1e3}, {"m", 60e3}, {"h", 3600e3}, {"d", 86400e3}
+};
+
+#define BOARD_NUM_UNITS     (sizeof(board_units) / sizeof(board_units[0]))
+
+// A trace file read into memory, so the lines of a repeat block can be
+// parsed once for each time round
+typedef struct
+{
+    const char *path;
+    char (*lines)[BOARD_MAX_LINE];
+    int count;
+} board_trace_t;
+
+static struct
+{
+    sim_adxl343_t adxl343;
+    sim_soil_probe_t soil_probe;
+
+    // Zero model
+    uint warning_pin;
+    uint ack_pin;
+    uint32_t ack_delay_ms;
+    uint32_t warnings;
+
+    // Zero's end of the telemetry link, and where its bytes are copied to
+    bool link_up;
+    bool link_stuck;
+    FILE *link_out;
+    telemetry_decoder_t link;
+    uint32_t link_events;
+    uint32_t link_repeats;
+    uint32_t link_gaps;
+    uint16_t link_seq;
+    bool link_seen;
+
+    // Added to the times of the trace lines being parsed, for repeat blocks
+    uint64_t trace_offset_ns;
+} board;
+
+
+// ############################## [ Local Functions ] ##############################
+
+static void board_acc_event(void *ctx, uint32_t a, uint32_t b)
+{
+    (void)ctx;
+    sim_adxl343_set_sample(&board.adxl343, (int16_t)(a & 0xFFFF), (int16_t)(a >> 16), (int16_t)b);
+}
+
+static void board_soil_event(void *ctx, uint32_t a, uint32_t b)
+{
+    (void)ctx;
+    (void)b;
+    sim_soil_probe_set_moisture(&board.soil_probe, (int32_t)a);
+}
+
+// Called when the Pico changes the level on the warning pin
+static void board_warning_watch(void *ctx, uint pin, bool level)
+{
+    (void)ctx;
+    (void)pin;
+
+    if (!level)
+    {
+        return;
+    }
+
+    board.warnings++;
+
+    // The Zero pulses its clear pin high to acknowledge the warning
+    if (board.ack_delay_ms != 0)
+    {
+        uint64_t ack_ns = hal_host_now_ns() + board.ack_delay_ms * 1000000ull;
+        hal_host_schedule_gpio(ack_ns, board.ack_pin, 1);
+        hal_host_schedule_gpio(ack_ns + BOARD_ACK_HOLD_MS * 1000000ull, board.ack_pin, 0);
+    }
+}
+
+// Checks the sequence of each frame the Zero decodes
+static void board_link_frame(void *ctx, const telemetry_frame_t *frame)
+{
+    (void)ctx;
+
+    uint16_t expected = (uint16_t)(board.link_seq + 1);
+
+    if (board.link_seen && frame->seq == board.link_seq)
+    {
+        board.link_repeats++;
+        return;
+    }
+
+    if (board.link_seen && frame->seq != expected)
+    {
+        board.link_gaps++;
+    }
+
+    board.link_seq = frame->seq;
+    board.link_seen = true;
+    board.link_events += frame->count;
+}
+
+// I2C write from the Pico to the Zero, NAKed while the link is down and held
+// while it is stuck
+static int board_link_write(void *ctx, const uint8_t *src, size_t len, bool nostop)
+{
+    (void)ctx;
+    (void)nostop;
+
+    if (board.link_stuck)
+    {
+        return HAL_ERROR_TIMEOUT;
+    }
+
+    if (!board.link_up)
+    {
+        return HAL_ERROR_GENERIC;
+    }
+
+    if (board.link_out != NULL)
+    {
+        fwrite(src, 1, len, board.link_out);
+        fflush(board.link_out);
+    }
+
+    telemetry_decoder_feed(&board.link, src, len, &board_link_frame, NULL);
+    return (int)len;
+}
+
+static void board_link_event(void *ctx, uint32_t a, uint32_t b)
+{
+    (void)ctx;
+    (void)b;
+    board.link_up = a != 0;
+    board.link_stuck = b != 0;
+}
+
+// Parses a time into nanoseconds, in milliseconds or as numbers each with a
+// unit ("1d6h", "2.5s")
+static bool board_parse_ms(const char *text, uint64_t *ns)
+{
+    const char *p = text;
+    double ms = 0.0;
+
+    if (*p == '\0')
+    {
+        return false;
+    }
+
+    while (*p != '\0')
+    {
+        char *end;
+        double value = strtod(p, &end);
+        size_t i = 0;
+
+        if (end == p || value < 0)
+        {
+            return false;
+        }
+
+        while (i < BOARD_NUM_UNITS && strncmp(end, board_units[i].name, strlen(board_units[i].name)) != 0)
+        {
+            i++;
+        }
+
+        // No unit, only allowed for the last number
+        if (i == BOARD_NUM_UNITS)
+        {
+            if (*end != '\0')
+            {
+                return false;
+            }
+
+            ms += value;
+            break;
+        }
+
+        ms += value * board_units[i].ms;
+        p = end + strlen(board_units[i].name);
+    }
+
+    *ns = (uint64_t)(ms * 1e6);
+    return true;
+}
+
+// Parses LANDSLIDE_CURRENTS, name=uA pairs split by commas
+static bool board_parse_currents(const char *text, hal_host_energy_t *energy, uint32_t *led_ua)
+{
+    const struct
+    {
+        const char *name;
+        uint32_t *value;
+    } fields[] = {
+        {"run", &energy->state_ua[HAL_HOST_RUN]},
+        {"idle", &energy->state_ua[HAL_HOST_IDLE]},
+        {"sleep", &energy->state_ua[HAL_HOST_SLEEP]},
+        {"dormant", &energy->state_ua[HAL_HOST_DORMANT]},
+        {"core1", &energy->core1_ua},
+        {"i2c", &energy->i2c_ua},
+        {"uart", &energy->uart_ua},
+        {"led", led_ua},
+        {"battery", &energy->battery_mah},
+    };
+    char copy[BOARD_MAX_LINE];
+
+    if (strlen(text) >= sizeof(copy))
+    {
+        return false;
+    }
+    strcpy(copy, text);
+
+    for (char *item = strtok(copy, ","); item != NULL; item = strtok(NULL, ","))
+    {
+        char *eq = strchr(item, '=');
+        char *end;
+        size_t i = 0;
+
+        if (eq == NULL)
+        {
+            return false;
+        }
+
+        *eq = '\0';
+        unsigned long value = strtoul(eq + 1, &end, 10);
+
+        while (i < sizeof(fields) / sizeof(fields[0]) && strcmp(item, fields[i].name) != 0)
+        {
+            i++;
+        }
+
+        if (i == sizeof(fields) / sizeof(fields[0]) || end == eq + 1 || *end != '\0' || value > UINT32_MAX)
+        {
+            return false;
+        }
+
+        *fields[i].value = (uint32_t)value;
+    }
+
+    return true;
+}
+
+// Parses one line of a trace, returns false if it is malformed
+static bool board_parse_line(char *line)
+{
+    char *tok[6];
+    int n = 0;
+
+    // Drop the comment and split into words
+    char *hash = strchr(line, '#');
+    if (hash != NULL)
+    {
+        *hash = '\0';
+    }
+
+    for (char *word = strtok(line, " \t\r\n"); word != NULL && n < 6; word = strtok(NULL, " \t\r\n"))
+    {
+        tok[n++] = word;
+    }
+
+    if (n == 0)
+    {
+        return true;
+    }
+
+    // Settings
+    if (strcmp(tok[0], "end") == 0 && n == 2)
+    {
+        uint64_t end_ns;
+        if (!board_parse_ms(tok[1], &end_ns))
+        {
+            return false;
+        }
+        hal_host_set_end_ns(end_ns);
+        return true;
+    }
+
+    if (strcmp(tok[0], "gateway") == 0 && n == 2 && strcmp(tok[1], "off") == 0)
+    {
+        sim_board_set_gateway(board.warning_pin, board.ack_pin, 0);
+        return true;
+    }
+
+    if (strcmp(tok[0], "gateway") == 0 && n == 4)
+    {
+        sim_board_set_gateway(atoi(tok[1]), atoi(tok[2]), atoi(tok[3]));
+        return true;
+    }
+
+    if (strcmp(tok[0], "probe_latency") == 0 && n == 2)
+    {
+        board.soil_probe.latency_ms = atoi(tok[1]);
+        return true;
+    }
+
+    if (strcmp(tok[0], "probe_faults") == 0 && n == 2)
+    {
+        sim_soil_probe_set_faults(&board.soil_probe, atoi(tok[1]));
+        return true;
+    }
+
+    // Timed events
+    uint64_t at_ns;
+    if (n < 3 || !board_parse_ms(tok[0], &at_ns))
+    {
+        return false;
+    }
+
+    at_ns += board.trace_offset_ns;
+
+    if (strcmp(tok[1], "gpio") == 0 && n == 4)
+    {
+        hal_host_schedule_gpio(at_ns, atoi(tok[2]), atoi(tok[3]) != 0);
+        return true;
+    }
+
+    if (strcmp(tok[1], "pulse") == 0 && (n == 4 || n == 5))
+    {
+        uint64_t width_ns;
+        int bounces = n == 5 ? atoi(tok[4]) : 0;
+        if (!board_parse_ms(tok[3], &width_ns) || bounces < 0)
+        {
+            return false;
+        }
+
+        // A switch contact bounces for a ms after closing and after opening,
+        // each bounce a 0.5 ms glitch
+        uint pin = atoi(tok[2]);
+        uint64_t close_ns = at_ns;
+        uint64_t open_ns = at_ns + width_ns;
+
+        for (int i = 0; i < bounces; i++)
+        {
+            hal_host_schedule_gpio(close_ns, pin, 1);
+            hal_host_schedule_gpio(close_ns + BOARD_BOUNCE_NS / 2, pin, 0);
+            close_ns += BOARD_BOUNCE_NS;
+        }
+
+        hal_host_schedule_gpio(close_ns, pin, 1);
+        hal_host_schedule_gpio(open_ns, pin, 0);
+
+        for (int i = 0; i < bounces; i++)
+        {
+            hal_host_schedule_gpio(open_ns + BOARD_BOUNCE_NS / 2, pin, 1);
+            hal_host_schedule_gpio(open_ns + BOARD_BOUNCE_NS, pin, 0);
+            open_ns += BOARD_BOUNCE_NS;
+        }
+
+        return true;
+    }
+
+    if (strcmp(tok[1], "acc") == 0 && n == 5)
+    {
+        uint32_t xy = (uint16_t)atoi(tok[2]) | ((uint32_t)(uint16_t)atoi(tok[3]) << 16);
+        hal_host_schedule(at_ns, &board_acc_event, NULL, xy, (uint16_t)atoi(tok[4]));
+        return true;
+    }
+
+    if (strcmp(tok[1], "soil") == 0 && n == 3)
+    {
+        hal_host_schedule(at_ns, &board_soil_event, NULL, (uint32_t)atoi(tok[2]), 0);
+        return true;
+    }
+
+    if (strcmp(tok[1], "link") == 0 && n == 3)
+    {
+        bool stuck = strcmp(tok[2], "stuck") == 0;
+        hal_host_schedule(at_ns, &board_link_event, NULL, !stuck && atoi(tok[2]) != 0, stuck);
+        return true;
+    }
+
+    return false;
+}
+
+// Finds the done that closes the repeat on line first, -1 if there is none
+static int board_block_end(const board_trace_t *trace, int first)
+{
+    int depth = 0;
+
+    for (int i = first; i < trace->count; i++)
+    {
+        char word[16];
+
+        if (sscanf(trace->lines[i], "%15s", word) != 1)
+        {
+            continue;
+        }
+
+        if (strcmp(word, "repeat") == 0)
+        {
+            depth++;
+        }
+        else if (strcmp(word, "done") == 0 && --depth == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// Parses the lines from first up to last of a trace with their times moved
+// offset_ns later, returns false if one is malformed
+static bool board_parse_lines(const board_trace_t *trace, int first, int last, uint64_t offset_ns)
+{
+    for (int i = first; i < last; i++)
+    {
+        char line[BOARD_MAX_LINE];
+        char word[16];
+        char period[32];
+        int times;
+
+        // A repeat block, its lines once for each time round
+        if (sscanf(trace->lines[i], "%15s %31s %d", word, period, &times) == 3 && strcmp(word, "repeat") == 0)
+        {
+            uint64_t period_ns;
+            int end = board_block_end(trace, i);
+
+            if (end < 0 || times < 1 || !board_parse_ms(period, &period_ns))
+            {
+                fprintf(stderr, "[sim] %s:%d: bad repeat\n", trace->path, i + 1);
+                return false;
+            }
+
+            for (int k = 0; k < times; k++)
+            {
+                if (!board_parse_lines(trace, i + 1, end, offset_ns + (uint64_t)k * period_ns))
+                {
+                    return false;
+                }
+            }
+
+            i = end;
+            continue;
+        }
+
+        // The line is cut up as it is parsed
+        memcpy(line, trace->lines[i], sizeof(line));
+        board.trace_offset_ns = offset_ns;
+
+        if (!board_parse_line(line))
+        {
+            fprintf(stderr, "[sim] %s:%d: bad trace line\n", trace->path, i + 1);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void sim_board_init(void)
+{
+    sim_adxl343_init(&board.adxl343);
+    sim_adxl343_attach(&board.adxl343, BOARD_I2C_ACC, BOARD_ADXL343_ADDR);
+    sim_adxl343_connect_int(&board.adxl343, BOARD_ACC_INT1_PIN, -1);
+
+    // The accelerometer sits flat, measuring 1 g on z
+    sim_adxl343_set_sample(&board.adxl343, 0, 0, 256);
+
+    sim_soil_probe_init(&board.soil_probe);
+    sim_soil_probe_attach(&board.soil_probe, BOARD_UART_SOIL);
+
+    board.warnings = 0;
+    sim_board_set_gateway(BOARD_WARNING_PIN, BOARD_ACK_PIN, 1000);
+
+    // What the board draws, the figures of node_config.h unless
+    // LANDSLIDE_CURRENTS changes them. Core 1 running adds what the core
+    // draws running over waiting.
+    hal_host_energy_t energy = {
+        .state_ua = {
+            [HAL_HOST_RUN] = NODE_CURRENT_RUN_UA,
+            [HAL_HOST_IDLE] = NODE_CURRENT_IDLE_UA,
+            [HAL_HOST_SLEEP] = NODE_CURRENT_SLEEP_UA,
+            [HAL_HOST_DORMANT] = NODE_CURRENT_DORMANT_UA,
+        },
+        .core1_ua = NODE_CURRENT_RUN_UA - NODE_CURRENT_IDLE_UA,
+        .i2c_ua = NODE_CURRENT_I2C_UA,
+        .uart_ua = NODE_CURRENT_UART_UA,
+        .battery_mah = NODE_BATTERY_MAH
+    };
+    uint32_t led_ua = NODE_CURRENT_LED_UA;
+
+    const char *currents = getenv("LANDSLIDE_CURRENTS");
+    if (currents != NULL && !board_parse_currents(currents, &energy, &led_ua))
+    {
+        fprintf(stderr, "[sim] bad LANDSLIDE_CURRENTS %s\n", currents);
+        exit(1);
+    }
+
+    hal_host_set_energy(&energy);
+    hal_host_set_gpio_load(NODE_LED_PIN, led_ua);
+
+    // The Zero listens on the telemetry link, and copies what it gets to a
+    // file or pseudo terminal for a receiver on the host
+    static const hal_host_i2c_device_t link_dev = { .write = &board_link_write };
+    hal_host_attach_i2c(BOARD_I2C_ZERO, BOARD_ZERO_ADDR, &link_dev);
+
+    board.link_up = true;
+    board.link_stuck = false;
+    telemetry_decoder_init(&board.link);
+    board.link_events = 0;
+    board.link_repeats = 0;
+    board.link_gaps = 0;
+    board.link_seen = false;
+
+    const char *link_path = getenv("LANDSLIDE_ZERO_LINK");
+    if (board.link_out == NULL && link_path != NULL)
+    {
+        board.link_out = fopen(link_path, "wb");
+        if (board.link_out == NULL)
+        {
+            fprintf(stderr, "[sim] could not open the zero link %s\n", link_path);
+        }
+    }
+}
+
+int sim_board_load_trace(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    board_trace_t trace = { .path = path };
+    int max_lines = 0;
+
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    // Read every line first, a repeat block is parsed more than once
+    while (true)
+    {
+        if (trace.count == max_lines)
+        {
+            max_lines = max_lines ? max_lines * 2 : 256;
+            trace.lines = realloc(trace.lines, max_lines * sizeof(trace.lines[0]));
+            if (trace.lines == NULL)
+            {
+                fprintf(stderr, "[sim] out of memory for the trace\n");
+                exit(1);
+            }
+        }
+
+        if (fgets(trace.lines[trace.count], BOARD_MAX_LINE, file) == NULL)
+        {
+            break;
+        }
+
+        trace.count++;
+    }
+
+    fclose(file);
+
+    bool ok = board_parse_lines(&trace, 0, trace.count, 0);
+
+    board.trace_offset_ns = 0;
+    free(trace.lines);
+
+    return ok ? 0 : -1;
+}
+
+void sim_board_set_gateway(uint warning_pin, uint ack_pin, uint32_t delay_ms)
+{
+    hal_host_watch_gpio(board.warning_pin, NULL, NULL);
+
+    board.warning_pin = warning_pin;
+    board.ack_pin = ack_pin;
+    board.ack_delay_ms = delay_ms;
+
+    hal_host_watch_gpio(warning_pin, &board_warning_watch, NULL);
+}
+
+sim_adxl343_t *sim_board_adxl343(void)
+{
+    return &board.adxl343;
+}
+
+sim_soil_probe_t *sim_board_soil_probe(void)
+{
+    return &board.soil_probe;
+}
+
+uint32_t sim_board_warnings(void)
+{
+    return board.warnings;
+}
+
+void sim_board_report(FILE *out)
+{
+    fprintf(out, "[sim] site profile      : %s\n", LANDSLIDE_SITE_NAME);
+    const node_warning_stats_t *handshake = node_warning_stats();
+
+    fprintf(out, "[sim] warnings issued   : %u\n", board.warnings);
+    fprintf(out, "[sim] warning handshakes: %u raised, %u acked, %u timeouts, %u given up\n",
+            handshake->raised, handshake->acked, handshake->timeouts, handshake->failed);
+    fprintf(out, "[sim] adxl343 registers : %u read, %u written\n", board.adxl343.reg_reads, board.adxl343.reg_writes);
+    fprintf(out, "[sim] adxl343 motion    : %u activity, %u inactivity interrupts\n", board.adxl343.activities,
+            board.adxl343.inactivities);
+
+    // Time in each power mode the accelerometer was in
+    const char *sep = " ";
+    fprintf(out, "[sim] adxl343 modes     :");
+    for (int mode = 0; mode < SIM_ADXL343_NUM_MODES; mode++)
+    {
+        uint64_t ns = sim_adxl343_mode_ns(&board.adxl343, (sim_adxl343_mode_t)mode);
+        if (ns != 0)
+        {
+            fprintf(out, "%s%s %.3f s", sep, sim_adxl343_mode_name((sim_adxl343_mode_t)mode), ns / 1e9);
+            sep = ", ";
+        }
+    }
+    fprintf(out, "\n");
+    fprintf(out, "[sim] soil readings     : %u (%u faulty answers)\n", board.soil_probe.requests, board.soil_probe.faults);
+
+    const node_telemetry_stats_t *telemetry = node_telemetry_stats();
+
+    fprintf(out, "[sim] telemetry sent    : %u events in %u frames (%llu bytes), %u retries (%u timed out), %u lost\n",
+            telemetry->sent, telemetry->frames, (unsigned long long)telemetry->bytes, telemetry->retries,
+            telemetry->timeouts, telemetry->lost);
+    fprintf(out, "[sim] telemetry at zero : %u events in %u frames, %u repeats, %u gaps, %u bad\n",
+            board.link_events, board.link.frames - board.link_repeats, board.link_repeats, board.link_gaps,
+            board.link.crc_errors + board.link.bad_headers);
+
+    node_phase_report(out, "[sim] ");
+}
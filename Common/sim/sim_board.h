@@ -0,0 +1,112 @@
+/**
+ * @file    sim_board.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   The simulated sensor node used by the host backend: a Pi Pico with
+ *          the ADXL343 on i2c0 (INT1 on GPIO 6), the soil probe on uart1, the
+ *          Zero's warning/ack handshake and its end of the telemetry link on
+ *          i2c1, plus the loader for scripted sensor traces.
+ *
+ *          A trace is a text file with one directive per line, '#' starts a
+ *          comment. Times are in milliseconds of virtual time, or numbers
+ *          each with a unit of ms, s, m, h or d ("1d6h", "2.5s").
+ *
+ *            end <ms>                            stop the simulation at <ms>
+ *            gateway <warning> <ack> <delay_ms>  Zero acks warnings after <delay_ms>
+ *            gateway off                         Zero never acks
+ *            probe_latency <ms>                  soil probe response latency
+ *            probe_faults <n>                    every nth soil probe answer is faulty
+ *            <ms> gpio <pin> <level>             drive a pin high or low
+ *            <ms> pulse <pin> <width_ms> [bounces]
+ *                                                drive a pin high for <width_ms>,
+ *                                                bouncing at each end
+ *            <ms> acc <x> <y> <z>                ADXL343 measures x, y, z (LSB)
+ *            <ms> soil <value>                   soil probe reports <value>
+ *            <ms> link <0|1|stuck>               Zero stops or starts acking the
+ *                                                telemetry link, or holds its bus
+ *            repeat <period> <times>             the lines up to the matching
+ *            ...                                 done, <times> times, each time
+ *            done                                round <period> later. Blocks
+ *                                                can be inside each other.
+ *
+ *          The board draws the NODE_CURRENT_* figures of node_config.h, and
+ *          NODE_CURRENT_LED_UA while the LED pin is high, on a battery of
+ *          NODE_BATTERY_MAH. LANDSLIDE_CURRENTS changes any of them without
+ *          a rebuild, as name=value pairs split by commas: run, idle, sleep,
+ *          dormant, core1, i2c, uart and led in uA, battery in mAh.
+ *
+ *            LANDSLIDE_CURRENTS=dormant=180,battery=5200
+ *
+*/
+
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+// ################################# [ Includes ] #################################
+
+#include "hal_host.h"
+#include "sim_adxl343.h"
+#include "sim_soil_probe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Attaches the sensors to the simulated Pico and starts the Zero
+ * model acking warnings on pins 3 and 2 after one second
+ */
+void sim_board_init(void);
+
+/**
+ * @brief Loads a trace file and schedules its events
+ *
+ * @param path The trace file
+ * @return int 0 if successful -1 if the file could not be read or parsed
+ */
+int sim_board_load_trace(const char *path);
+
+/**
+ * @brief Sets how the Zero model answers warnings
+ *
+ * @param warning_pin The pin the Pico raises a warning on
+ * @param ack_pin The pin the Zero acks on
+ * @param delay_ms Time from the warning to the ack, 0 to never ack
+ */
+void sim_board_set_gateway(uint warning_pin, uint ack_pin, uint32_t delay_ms);
+
+/**
+ * @brief Gets the simulated accelerometer
+ *
+ * @return sim_adxl343_t* The model on i2c0
+ */
+sim_adxl343_t *sim_board_adxl343(void);
+
+/**
+ * @brief Gets the simulated soil probe
+ *
+ * @return sim_soil_probe_t* The model on uart1
+ */
+sim_soil_probe_t *sim_board_soil_probe(void);
+
+/**
+ * @brief Gets the number of warnings the Zero model has seen
+ *
+ * @return uint32_t The number of warnings
+ */
+uint32_t sim_board_warnings(void);
+
+/**
+ * @brief Prints the board counters as part of the simulation report
+ *
+ * @param out Where to print them
+ */
+void sim_board_report(FILE *out);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_BOARD_H
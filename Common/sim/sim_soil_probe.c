@@ -0,0 +1,84 @@
+/**
+ * @file    sim_soil_probe.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Model of the UART soil moisture probe, see sim_soil_probe.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "sim_soil_probe.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ############################## [ Local Functions ] ##############################
+
+static void soil_probe_rx(void *ctx, uint8_t c)
+{
+    sim_soil_probe_t *probe = ctx;
+
+    // Only a 'w' asks for a reading, the 'l' sent at start up needs no answer
+    if (c != 'w')
+    {
+        return;
+    }
+
+    char answer[48];
+    int len = snprintf(answer, sizeof(answer), "Moisture=%d\r\n", probe->moisture);
+
+    probe->requests++;
+
+    if (probe->fault_every != 0 && probe->requests % probe->fault_every == 0)
+    {
+        switch ((sim_soil_fault_t)(probe->faults++ % SIM_SOIL_NUM_FAULTS))
+        {
+            case SIM_SOIL_FAULT_DROP:
+                return;
+
+            case SIM_SOIL_FAULT_TRUNCATE:
+                len -= 3;
+                break;
+
+            case SIM_SOIL_FAULT_GARBLE:
+                answer[len - 3] = 'O';
+                break;
+
+            default:
+                len = snprintf(answer, sizeof(answer), "\x7f=\xfe#\r\nMoisture=%d\r\n", probe->moisture);
+                break;
+        }
+    }
+
+    hal_host_uart_inject(probe->uart, probe->latency_ms * 1000000ull, (const uint8_t *)answer, len);
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void sim_soil_probe_init(sim_soil_probe_t *probe)
+{
+    memset(probe, 0, sizeof(*probe));
+    probe->latency_ms = 50;
+}
+
+void sim_soil_probe_attach(sim_soil_probe_t *probe, hal_uart_t uart)
+{
+    hal_host_uart_device_t uart_dev = {
+        .rx = &soil_probe_rx,
+        .ctx = probe
+    };
+
+    probe->uart = uart;
+    hal_host_attach_uart(uart, &uart_dev);
+}
+
+void sim_soil_probe_set_moisture(sim_soil_probe_t *probe, int moisture)
+{
+    probe->moisture = moisture;
+}
+
+void sim_soil_probe_set_faults(sim_soil_probe_t *probe, uint32_t every)
+{
+    probe->fault_every = every;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file    sim_soil_probe.h
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Model of the UART soil moisture probe for the host backend. When
+ *          the firmware sends a 'w' the probe answers, after its response
+ *          latency, with "Moisture=<value>\r\n" at the bus baud rate.
+ *
+ *          To test the driver against a misbehaving probe, every Nth answer
+ *          can be made faulty. The faults take turns:
+ *            drop      no answer at all
+ *            truncate  the answer stops before its line ends
+ *            garble    a letter in place of a digit
+ *            noise     a line of line noise before the real answer
+ *
+*/
+
+#ifndef SIM_SOIL_PROBE_H
+#define SIM_SOIL_PROBE_H
+
+// ################################# [ Includes ] #################################
+
+#include "hal_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ################################## [ Types ] ###################################
+
+// Faults, in the order they are used
+typedef enum
+{
+    SIM_SOIL_FAULT_DROP,
+    SIM_SOIL_FAULT_TRUNCATE,
+    SIM_SOIL_FAULT_GARBLE,
+    SIM_SOIL_FAULT_NOISE,
+    SIM_SOIL_NUM_FAULTS
+} sim_soil_fault_t;
+
+// Simulated soil moisture probe
+typedef struct
+{
+    hal_uart_t uart;        // Bus the probe is on
+    int moisture;           // Value reported to the next request
+    uint32_t latency_ms;    // Time from the request to the first byte of the answer
+    uint32_t fault_every;   // Every fault_every-th answer is faulty, 0 for none
+    uint32_t requests;      // Number of readings asked for
+    uint32_t faults;        // Number of faulty answers sent
+} sim_soil_probe_t;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Puts the probe into its power on state
+ *
+ * @param probe The model
+ */
+void sim_soil_probe_init(sim_soil_probe_t *probe);
+
+/**
+ * @brief Attaches the probe to a simulated UART bus
+ *
+ * @param probe The model
+ * @param uart The bus to attach to
+ */
+void sim_soil_probe_attach(sim_soil_probe_t *probe, hal_uart_t uart);
+
+/**
+ * @brief Sets the moisture the probe reports
+ *
+ * @param probe The model
+ * @param moisture The moisture value
+ */
+void sim_soil_probe_set_moisture(sim_soil_probe_t *probe, int moisture);
+
+/**
+ * @brief Makes every Nth answer faulty
+ *
+ * @param probe The model
+ * @param every The spacing of faulty answers, 0 to answer properly every time
+ */
+void sim_soil_probe_set_faults(sim_soil_probe_t *probe, uint32_t every);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_SOIL_PROBE_H
@@ -0,0 +1,239 @@
+/**
+ * @file    adxl343_fifo.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Watermark driven FIFO acquisition engine for the ADXL343, see
+ *          adxl343_fifo.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "adxl343_fifo.h"
+#include "adxl343_power.h"
+#include "landslide_node.h"
+#include "node_phase.h"
+
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Bus, address and set up of the accelerometer
+static hal_i2c_t fifo_i2c;
+static uint8_t fifo_addr;
+static adxl343_fifo_config_t fifo_config;
+
+// Raw bytes filled in by the DMA job, one 6 byte read per FIFO entry
+static uint8_t fifo_data[ADXL343_FIFO_DEPTH * ADXL343_SAMPLE_BYTES];
+
+// Ring buffer written by the DMA interrupt and read by the core
+static adxl343_sample_t fifo_ring[ADXL343_FIFO_RING_SIZE];
+static volatile uint32_t fifo_head;
+static volatile uint32_t fifo_tail;
+
+// Set on the entry after samples were dropped, so the reader knows where
+// the timeline has a hole
+static bool fifo_ring_lost[ADXL343_FIFO_RING_SIZE];
+static volatile bool fifo_losing;
+static bool fifo_lost;
+
+// Progress of the acquisition
+static volatile uint32_t fifo_wanted;
+static volatile bool fifo_reading;
+static volatile bool fifo_done;
+static bool fifo_measuring;
+
+static adxl343_fifo_stats_t fifo_stats;
+
+
+// ############################## [ Local Functions ] ##############################
+
+static void fifo_drain(void);
+
+// DMA interrupt, moves the entries into the ring buffer
+static void fifo_read_done(void *ctx)
+{
+    (void)ctx;
+
+    fifo_reading = false;
+    fifo_stats.reads++;
+    NODE_PHASE_STOP(PHASE_I2C_READ);
+
+    for (uint8_t i = 0; i < fifo_config.watermark && fifo_stats.samples < fifo_wanted; i++)
+    {
+        if (fifo_head - fifo_tail == ADXL343_FIFO_RING_SIZE)
+        {
+            fifo_stats.overruns++;
+            fifo_losing = true;
+        }
+        else
+        {
+            adxl343_unpack(&fifo_data[i * ADXL343_SAMPLE_BYTES], &fifo_ring[fifo_head % ADXL343_FIFO_RING_SIZE]);
+            fifo_ring_lost[fifo_head % ADXL343_FIFO_RING_SIZE] = fifo_losing;
+            fifo_losing = false;
+            fifo_head++;
+        }
+
+        fifo_stats.samples++;
+    }
+
+    if (fifo_stats.samples >= fifo_wanted)
+    {
+        fifo_done = true;
+        return;
+    }
+
+    // More samples arrived while reading, the watermark is still up so there
+    // won't be another edge
+    if (hal_gpio_get(fifo_config.int_pin))
+    {
+        fifo_drain();
+    }
+}
+
+// Starts reading a watermark's worth of entries
+static void fifo_drain(void)
+{
+    if (fifo_done || fifo_reading)
+    {
+        return;
+    }
+
+    NODE_PHASE_START(PHASE_I2C_READ);
+    fifo_reading = hal_i2c_read_dma_repeat(fifo_i2c, fifo_addr, ADXL343_REG_DATAX0, fifo_data, ADXL343_SAMPLE_BYTES,
+                                           fifo_config.watermark, &fifo_read_done, NULL);
+}
+
+// GPIO interrupt on INT1
+static void fifo_watermark(void *ctx)
+{
+    (void)ctx;
+
+    fifo_drain();
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int adxl343_fifo_init(hal_i2c_t i2c, uint8_t addr, const adxl343_fifo_config_t *config)
+{
+    fifo_i2c = i2c;
+    fifo_addr = addr;
+    fifo_config = *config;
+    fifo_done = true;
+
+    if (fifo_config.watermark == 0 || fifo_config.watermark > ADXL343_FIFO_DEPTH)
+    {
+        fifo_config.watermark = ADXL343_FIFO_WATERMARK;
+    }
+
+    // INT1 is an input that interrupts on the watermark going high
+    hal_gpio_init(fifo_config.int_pin);
+    hal_gpio_set_dir(fifo_config.int_pin, HAL_GPIO_IN);
+    hal_gpio_set_irq(fifo_config.int_pin, HAL_GPIO_EDGE_RISE, &fifo_watermark, NULL);
+
+    fifo_measuring = true;
+    adxl343_fifo_stop();
+
+    return 1;
+}
+
+int adxl343_fifo_start(uint32_t count)
+{
+    uint8_t fifo_ctl;
+
+    memset(&fifo_stats, 0, sizeof(fifo_stats));
+    fifo_head = 0;
+    fifo_tail = 0;
+    fifo_losing = false;
+    fifo_lost = false;
+    fifo_wanted = count;
+    fifo_reading = false;
+    fifo_done = count == 0;
+    fifo_stats.start_us = hal_time_us_64();
+    fifo_stats.end_us = fifo_stats.start_us;
+
+    if (fifo_done)
+    {
+        return 1;
+    }
+
+    // Bypass mode empties the FIFO, then switch to the mode wanted
+    fifo_ctl = ADXL343_FIFO_BYPASS;
+    if (reg_write(fifo_i2c, fifo_addr, ADXL343_REG_FIFO_CTL, &fifo_ctl, 1) == 0)
+    {
+        fifo_done = true;
+        return 0;
+    }
+
+    // The power manager only writes the rate, power and interrupt registers
+    // that change, with the watermark on INT1
+    fifo_ctl = fifo_config.mode | (fifo_config.watermark & ADXL343_FIFO_SAMPLES_MASK);
+    if (reg_write(fifo_i2c, fifo_addr, ADXL343_REG_FIFO_CTL, &fifo_ctl, 1) == 0 ||
+        adxl343_power_measure(fifo_config.rate, ADXL343_INT_WATERMARK) == 0)
+    {
+        fifo_done = true;
+        return 0;
+    }
+
+    fifo_measuring = true;
+
+    return 1;
+}
+
+bool adxl343_fifo_next(adxl343_sample_t *sample)
+{
+    // Sleep until a sample arrives or the acquisition is over
+    while (fifo_tail == fifo_head)
+    {
+        if (fifo_done)
+        {
+            // Samples dropped after the last one taken out
+            fifo_lost = fifo_losing;
+            adxl343_fifo_stop();
+            return false;
+        }
+
+        NODE_PHASE_BEGIN(PHASE_IDLE);
+        hal_wfi();
+        NODE_PHASE_END(PHASE_IDLE);
+    }
+
+    *sample = fifo_ring[fifo_tail % ADXL343_FIFO_RING_SIZE];
+    fifo_lost = fifo_ring_lost[fifo_tail % ADXL343_FIFO_RING_SIZE];
+    fifo_tail++;
+
+    return true;
+}
+
+void adxl343_fifo_stop(void)
+{
+    fifo_done = true;
+
+    // The DMA is still writing into fifo_data
+    while (fifo_reading)
+    {
+        hal_wfi();
+    }
+
+    // Back to the mode the node rests in and the FIFO emptied
+    if (fifo_measuring)
+    {
+        uint8_t fifo_ctl = ADXL343_FIFO_BYPASS;
+
+        adxl343_power_rest();
+        reg_write(fifo_i2c, fifo_addr, ADXL343_REG_FIFO_CTL, &fifo_ctl, 1);
+        fifo_measuring = false;
+    }
+
+    fifo_stats.end_us = hal_time_us_64();
+}
+
+bool adxl343_fifo_lost(void)
+{
+    return fifo_lost;
+}
+
+const adxl343_fifo_stats_t *adxl343_fifo_stats(void)
+{
+    return &fifo_stats;
+}
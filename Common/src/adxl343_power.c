@@ -0,0 +1,218 @@
+/**
+ * @file    adxl343_power.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   ADXL343 power modes with batched register writes, see
+ *          adxl343_power.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "adxl343_power.h"
+#include "landslide_node.h"
+
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// The registers managed, THRESH_ACT to INT_MAP, by their offset from the first
+#define POWER_FIRST             ADXL343_REG_THRESH_ACT
+#define POWER_NUM_REGS          (ADXL343_REG_INT_MAP - POWER_FIRST + 1)
+#define POWER_REG(reg)          ((reg) - POWER_FIRST)
+
+// Bus, address and set up of the accelerometer
+static hal_i2c_t power_i2c;
+static uint8_t power_addr;
+static adxl343_power_config_t power_config;
+
+// What the part's registers hold, and whether every one has to be written
+// because the part's are not known
+static uint8_t power_regs[POWER_NUM_REGS];
+static bool power_unknown;
+
+static adxl343_power_mode_t power_mode;
+static adxl343_power_stats_t power_stats;
+
+static const char *const power_mode_names[ADXL343_POWER_MODES] = {
+    "standby", "watch", "measure"
+};
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Writes the registers from first to last that differ from the part's in
+// one write, from the first that differs to the last
+static int power_write_run(uint8_t first, uint8_t last, const uint8_t *target)
+{
+    int from = -1;
+    int to = -1;
+
+    for (int reg = first; reg <= last; reg++)
+    {
+        if (power_unknown || target[POWER_REG(reg)] != power_regs[POWER_REG(reg)])
+        {
+            from = from < 0 ? reg : from;
+            to = reg;
+        }
+    }
+
+    if (from < 0)
+    {
+        return 1;
+    }
+
+    uint8_t len = (uint8_t)(to - from + 1);
+    uint8_t data[POWER_NUM_REGS];
+    memcpy(data, &target[POWER_REG(from)], len);
+
+    power_stats.writes++;
+    if (reg_write(power_i2c, power_addr, (uint8_t)from, data, len) == 0)
+    {
+        power_stats.failed++;
+        return 0;
+    }
+
+    power_stats.bytes += len;
+    memcpy(&power_regs[POWER_REG(from)], data, len);
+
+    return 1;
+}
+
+// Brings the part's registers to target for a mode
+static int power_apply(adxl343_power_mode_t mode, const uint8_t *target)
+{
+    uint8_t ctl = power_regs[POWER_REG(ADXL343_REG_POWER_CTL)];
+    uint8_t new_ctl = target[POWER_REG(ADXL343_REG_POWER_CTL)];
+    int ok = 1;
+
+    // The datasheet asks for standby between clearing AUTO_SLEEP and
+    // measuring again
+    if (!power_unknown && (ctl & ADXL343_POWER_CTL_AUTO_SLEEP) && !(new_ctl & ADXL343_POWER_CTL_AUTO_SLEEP) &&
+        (new_ctl & ADXL343_POWER_CTL_MEASURE))
+    {
+        uint8_t standby[POWER_NUM_REGS];
+
+        memcpy(standby, power_regs, sizeof(standby));
+        standby[POWER_REG(ADXL343_REG_POWER_CTL)] = 0;
+        ok &= power_write_run(ADXL343_REG_POWER_CTL, ADXL343_REG_POWER_CTL, standby);
+    }
+
+    // The thresholds first, so they are in place when measuring starts
+    ok &= power_write_run(ADXL343_REG_THRESH_ACT, ADXL343_REG_ACT_INACT_CTL, target);
+    ok &= power_write_run(ADXL343_REG_BW_RATE, ADXL343_REG_INT_MAP, target);
+
+    if (ok)
+    {
+        power_unknown = false;
+    }
+
+    if (mode != power_mode)
+    {
+        power_mode = mode;
+        power_stats.changes[mode]++;
+    }
+
+    return ok;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int adxl343_power_init(hal_i2c_t i2c, uint8_t addr, const adxl343_power_config_t *config)
+{
+    uint8_t target[POWER_NUM_REGS] = {0};
+
+    power_i2c = i2c;
+    power_addr = addr;
+    power_config = *config;
+    power_unknown = true;
+    power_mode = ADXL343_POWER_STANDBY;
+    memset(&power_stats, 0, sizeof(power_stats));
+
+    // Out of measuring before anything else changes
+    uint8_t standby = 0;
+    power_stats.writes++;
+    if (reg_write(i2c, addr, ADXL343_REG_POWER_CTL, &standby, 1) == 0)
+    {
+        power_stats.failed++;
+        return 0;
+    }
+
+    // The thresholds and the watch rate, so watching only has to start
+    target[POWER_REG(ADXL343_REG_THRESH_ACT)] = config->act_thresh;
+    target[POWER_REG(ADXL343_REG_THRESH_INACT)] = config->inact_thresh;
+    target[POWER_REG(ADXL343_REG_TIME_INACT)] = config->inact_s;
+    target[POWER_REG(ADXL343_REG_ACT_INACT_CTL)] = config->act_inact_ctl;
+    target[POWER_REG(ADXL343_REG_BW_RATE)] = ADXL343_BW_LOW_POWER | config->watch_rate;
+
+    return power_apply(ADXL343_POWER_STANDBY, target);
+}
+
+int adxl343_power_standby(void)
+{
+    uint8_t target[POWER_NUM_REGS];
+
+    // Rate and thresholds stay as they are
+    memcpy(target, power_regs, sizeof(target));
+    target[POWER_REG(ADXL343_REG_POWER_CTL)] = 0;
+    target[POWER_REG(ADXL343_REG_INT_ENABLE)] = 0;
+    target[POWER_REG(ADXL343_REG_INT_MAP)] = 0;
+
+    return power_apply(ADXL343_POWER_STANDBY, target);
+}
+
+int adxl343_power_watch(void)
+{
+    uint8_t target[POWER_NUM_REGS];
+    uint8_t ctl = ADXL343_POWER_CTL_LINK | ADXL343_POWER_CTL_MEASURE;
+
+    if (power_config.auto_sleep)
+    {
+        ctl |= ADXL343_POWER_CTL_AUTO_SLEEP | (power_config.wakeup & ADXL343_POWER_CTL_WAKEUP_MASK);
+    }
+
+    memcpy(target, power_regs, sizeof(target));
+    target[POWER_REG(ADXL343_REG_THRESH_ACT)] = power_config.act_thresh;
+    target[POWER_REG(ADXL343_REG_THRESH_INACT)] = power_config.inact_thresh;
+    target[POWER_REG(ADXL343_REG_TIME_INACT)] = power_config.inact_s;
+    target[POWER_REG(ADXL343_REG_ACT_INACT_CTL)] = power_config.act_inact_ctl;
+    target[POWER_REG(ADXL343_REG_BW_RATE)] = ADXL343_BW_LOW_POWER | power_config.watch_rate;
+    target[POWER_REG(ADXL343_REG_POWER_CTL)] = ctl;
+    target[POWER_REG(ADXL343_REG_INT_ENABLE)] = power_config.watch_ints;
+    target[POWER_REG(ADXL343_REG_INT_MAP)] = 0;
+
+    return power_apply(ADXL343_POWER_WATCH, target);
+}
+
+int adxl343_power_measure(uint8_t rate, uint8_t ints)
+{
+    uint8_t target[POWER_NUM_REGS];
+
+    memcpy(target, power_regs, sizeof(target));
+    target[POWER_REG(ADXL343_REG_BW_RATE)] = rate;
+    target[POWER_REG(ADXL343_REG_POWER_CTL)] = ADXL343_POWER_CTL_MEASURE;
+    target[POWER_REG(ADXL343_REG_INT_ENABLE)] = ints;
+    target[POWER_REG(ADXL343_REG_INT_MAP)] = 0;
+
+    return power_apply(ADXL343_POWER_MEASURE, target);
+}
+
+int adxl343_power_rest(void)
+{
+    return power_config.rest == ADXL343_POWER_WATCH ? adxl343_power_watch() : adxl343_power_standby();
+}
+
+adxl343_power_mode_t adxl343_power_mode(void)
+{
+    return power_mode;
+}
+
+const char *adxl343_power_mode_name(adxl343_power_mode_t mode)
+{
+    return mode < ADXL343_POWER_MODES ? power_mode_names[mode] : "unknown";
+}
+
+const adxl343_power_stats_t *adxl343_power_stats(void)
+{
+    return &power_stats;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file    dlog_format.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Deferred log records and frames, see dlog_format.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "dlog_format.h"
+
+#include <stdio.h>
+
+// ############################# [ Global Variables ] #############################
+
+#define DLOG_TEXT(name, format)   format,
+
+static const char *const dlog_formats[DLOG_NUM_FORMATS] = {
+    DLOG_FORMATS(DLOG_TEXT)
+};
+
+// Longest conversion, "%-020.10llu" and the like
+#define DLOG_SPEC_MAX   16
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Reads the conversion at format, just after its '%', into spec. Returns the
+// conversion character, with longs set to the number of l's, or 0 if it is
+// not one the log takes.
+static char dlog_spec(const char **format, char *spec, int *longs)
+{
+    const char *at = *format;
+    size_t len = 0;
+
+    spec[len++] = '%';
+    *longs = 0;
+
+    while (*at != '\0' && len < DLOG_SPEC_MAX - 1)
+    {
+        char c = *at++;
+        spec[len++] = c;
+
+        if (c == 'l')
+        {
+            (*longs)++;
+        }
+        else if (strchr("-+ #0123456789.h", c) == NULL)
+        {
+            spec[len] = '\0';
+            *format = at;
+            return strchr("diuxXocfeEgG", c) != NULL ? c : 0;
+        }
+    }
+
+    return 0;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+const char *dlog_format_of(uint32_t id)
+{
+    return id < DLOG_NUM_FORMATS ? dlog_formats[id] : NULL;
+}
+
+uint32_t dlog_words(const char *format)
+{
+    char spec[DLOG_SPEC_MAX];
+    uint32_t words = 0;
+
+    while (*format != '\0')
+    {
+        if (*format++ != '%')
+        {
+            continue;
+        }
+
+        if (*format == '%')
+        {
+            format++;
+            continue;
+        }
+
+        int longs;
+        if (dlog_spec(&format, spec, &longs) != 0)
+        {
+            words += longs >= 2 ? 2 : 1;
+        }
+    }
+
+    return words;
+}
+
+int dlog_format(char *dst, size_t cap, const dlog_record_t *record)
+{
+    const char *format = dlog_format_of(record->id);
+    char spec[DLOG_SPEC_MAX];
+    const uint32_t *arg = record->args;
+    size_t len = 0;
+
+    if (cap == 0 || format == NULL || record->nargs > DLOG_MAX_ARGS || dlog_words(format) != record->nargs)
+    {
+        return -1;
+    }
+
+    while (*format != '\0')
+    {
+        int n;
+
+        if (*format != '%' || format[1] == '%')
+        {
+            n = 1;
+            if (len + 1 < cap)
+            {
+                dst[len] = *format;
+            }
+            format += *format == '%' ? 2 : 1;
+        }
+        else
+        {
+            int longs;
+
+            format++;
+            char c = dlog_spec(&format, spec, &longs);
+            bool is_signed = c == 'd' || c == 'i';
+
+            // Past the end snprintf is only counting
+            char *at = len < cap ? &dst[len] : dst;
+            size_t left = len < cap ? cap - len : 0;
+
+            if (c == 'f' || c == 'e' || c == 'E' || c == 'g' || c == 'G')
+            {
+                float value;
+                memcpy(&value, arg++, sizeof(value));
+                n = snprintf(at, left, spec, (double)value);
+            }
+            else if (longs >= 2)
+            {
+                uint64_t value = arg[0] | (uint64_t)arg[1] << 32;
+                arg += 2;
+                n = is_signed ? snprintf(at, left, spec, (long long)value) :
+                                snprintf(at, left, spec, (unsigned long long)value);
+            }
+            else if (longs == 1)
+            {
+                uint32_t value = *arg++;
+                n = is_signed ? snprintf(at, left, spec, (long)(int32_t)value) :
+                                snprintf(at, left, spec, (unsigned long)value);
+            }
+            else if (c != 0)
+            {
+                uint32_t value = *arg++;
+                n = is_signed ? snprintf(at, left, spec, (int)value) : snprintf(at, left, spec, (unsigned)value);
+            }
+            else
+            {
+                n = 0;
+            }
+        }
+
+        len += n > 0 ? (size_t)n : 0;
+    }
+
+    dst[len < cap ? len : cap - 1] = '\0';
+    return (int)len;
+}
+
+size_t dlog_frame_encode(uint8_t *dst, const dlog_record_t *record)
+{
+    dst[0] = DLOG_FRAME_START;
+    dst[1] = (uint8_t)record->id;
+    dst[2] = record->nargs;
+    dst[3] = record->lost;
+
+    for (int i = 0; i < 4; i++)
+    {
+        dst[4 + i] = (uint8_t)(record->time_us >> (8 * i));
+    }
+
+    for (uint32_t a = 0; a < record->nargs; a++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            dst[DLOG_FRAME_HEADER + 4 * a + i] = (uint8_t)(record->args[a] >> (8 * i));
+        }
+    }
+
+    return DLOG_FRAME_HEADER + 4 * record->nargs;
+}
+
+int32_t dlog_frame_decode(const uint8_t *src, size_t len, dlog_record_t *record)
+{
+    if (len > 0 && src[0] != DLOG_FRAME_START)
+    {
+        return -1;
+    }
+
+    if (len < 3)
+    {
+        return 0;
+    }
+
+    // Only the table says how long a frame is, a frame that disagrees with
+    // it is not one
+    const char *format = dlog_format_of(src[1]);
+    if (format == NULL || src[2] > DLOG_MAX_ARGS || dlog_words(format) != src[2])
+    {
+        return -1;
+    }
+
+    size_t frame = DLOG_FRAME_HEADER + 4 * (size_t)src[2];
+    if (len < frame)
+    {
+        return 0;
+    }
+
+    record->id = src[1];
+    record->nargs = src[2];
+    record->lost = src[3];
+    record->time_us = (uint32_t)(src[4] | src[5] << 8 | src[6] << 16 | (uint32_t)src[7] << 24);
+
+    for (uint32_t a = 0; a < record->nargs; a++)
+    {
+        const uint8_t *at = &src[DLOG_FRAME_HEADER + 4 * a];
+        record->args[a] = (uint32_t)(at[0] | at[1] << 8 | at[2] << 16 | (uint32_t)at[3] << 24);
+    }
+
+    return (int32_t)frame;
+}
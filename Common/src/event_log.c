@@ -0,0 +1,196 @@
+/**
+ * @file    event_log.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Flash event log layout and reader, see event_log.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "event_log.h"
+
+// ############################## [ Local Functions ] ##############################
+
+static void log_put16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static void log_put32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+static uint16_t log_get16(const uint8_t *src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static uint32_t log_get32(const uint8_t *src)
+{
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+// The CRC of a record covers its type and arg as well as what follows it
+static uint16_t log_record_crc(const uint8_t *src)
+{
+    uint16_t crc = telemetry_crc16(0xFFFF, &src[4], EVENT_LOG_RECORD_LEN - 4);
+    return telemetry_crc16(crc, src, 2);
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void event_log_encode_header(uint8_t *dst, const event_log_header_t *header)
+{
+    log_put32(&dst[0], EVENT_LOG_MAGIC);
+    log_put32(&dst[4], header->seq);
+    log_put32(&dst[8], header->erases);
+    log_put16(&dst[12], header->boot);
+    log_put16(&dst[14], telemetry_crc16(0xFFFF, dst, 14));
+}
+
+bool event_log_decode_header(const uint8_t *src, event_log_header_t *header)
+{
+    if (log_get32(&src[0]) != EVENT_LOG_MAGIC || log_get16(&src[14]) != telemetry_crc16(0xFFFF, src, 14))
+    {
+        return false;
+    }
+
+    header->seq = log_get32(&src[4]);
+    header->erases = log_get32(&src[8]);
+    header->boot = log_get16(&src[12]);
+
+    return true;
+}
+
+void event_log_encode_record(uint8_t *dst, const event_log_record_t *record)
+{
+    dst[0] = record->type;
+    dst[1] = record->arg;
+    log_put32(&dst[4], record->time_ms);
+    log_put32(&dst[8], (uint32_t)record->value);
+    log_put32(&dst[12], (uint32_t)record->stat);
+    log_put16(&dst[2], log_record_crc(dst));
+}
+
+bool event_log_decode_record(const uint8_t *src, event_log_record_t *record)
+{
+    if (log_get16(&src[2]) != log_record_crc(src))
+    {
+        return false;
+    }
+
+    record->type = src[0];
+    record->arg = src[1];
+    record->time_ms = log_get32(&src[4]);
+    record->value = (int32_t)log_get32(&src[8]);
+    record->stat = (int32_t)log_get32(&src[12]);
+
+    return true;
+}
+
+bool event_log_slot_free(const uint8_t *src)
+{
+    for (int i = 0; i < EVENT_LOG_RECORD_LEN; i++)
+    {
+        if (src[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t event_log_scan(const uint8_t *region, size_t len, event_log_fn_t fn, void *ctx, event_log_info_t *info)
+{
+    uint32_t sectors = (uint32_t)(len / EVENT_LOG_SECTOR_LEN);
+    event_log_header_t header;
+
+    *info = (event_log_info_t){ .newest = UINT32_MAX, .min_erases = UINT32_MAX };
+
+    // The newest sector is the one with the highest sequence number
+    for (uint32_t s = 0; s < sectors; s++)
+    {
+        if (!event_log_decode_header(region + s * EVENT_LOG_SECTOR_LEN, &header))
+        {
+            continue;
+        }
+
+        if (info->newest == UINT32_MAX || header.seq > info->newest_seq)
+        {
+            info->newest = s;
+            info->newest_seq = header.seq;
+        }
+
+        info->sectors++;
+        info->min_erases = header.erases < info->min_erases ? header.erases : info->min_erases;
+        info->max_erases = header.erases > info->max_erases ? header.erases : info->max_erases;
+    }
+
+    if (info->newest == UINT32_MAX)
+    {
+        info->min_erases = 0;
+        return 0;
+    }
+
+    // The sectors are written round the ring, so the oldest is the next good
+    // one after the newest
+    for (uint32_t i = 1; i <= sectors; i++)
+    {
+        uint32_t s = (info->newest + i) % sectors;
+        const uint8_t *sector = region + s * EVENT_LOG_SECTOR_LEN;
+
+        if (!event_log_decode_header(sector, &header))
+        {
+            continue;
+        }
+
+        info->boot = header.boot;
+
+        uint32_t next_slot = 1;
+        for (uint32_t slot = 1; slot < EVENT_LOG_SLOTS; slot++)
+        {
+            const uint8_t *src = sector + slot * EVENT_LOG_RECORD_LEN;
+            event_log_record_t record;
+
+            if (event_log_slot_free(src))
+            {
+                continue;
+            }
+
+            next_slot = slot + 1;
+
+            if (!event_log_decode_record(src, &record))
+            {
+                info->torn++;
+                continue;
+            }
+
+            if (record.type == TELEMETRY_BOOT)
+            {
+                info->boot = (uint16_t)record.value;
+            }
+
+            record.boot = info->boot;
+            info->records++;
+
+            if (fn != NULL)
+            {
+                fn(ctx, &record);
+            }
+        }
+
+        if (s == info->newest)
+        {
+            info->next_slot = next_slot;
+        }
+    }
+
+    return info->records;
+}
@@ -0,0 +1,269 @@
+/**
+ * @file    fusion.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Rain, soil and seismic evidence fusion, see fusion.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "fusion.h"
+
+// ############################## [ Local Functions ] ##############################
+
+// Energy of a dynamic peak, mg^2 / 1000
+static uint32_t fusion_energy(uint32_t peak_mg)
+{
+    return (uint32_t)((uint64_t)peak_mg * peak_mg / 1000);
+}
+
+// Halves a value every half_s, straight line between the halvings
+static uint32_t fusion_decay(uint32_t value, uint32_t elapsed_s, uint32_t half_s)
+{
+    uint32_t halvings = elapsed_s / half_s;
+
+    if (halvings >= 32)
+    {
+        return 0;
+    }
+
+    value >>= halvings;
+    return value - (uint32_t)((uint64_t)value * (elapsed_s % half_s) / (2 * half_s));
+}
+
+static uint8_t fusion_pct(int64_t pct)
+{
+    return pct < 0 ? 0 : pct > 100 ? 100 : (uint8_t)pct;
+}
+
+static uint8_t fusion_soil_pct(const fusion_t *fusion)
+{
+    const fusion_config_t *c = &fusion->config;
+
+    if (!fusion->soil_seen)
+    {
+        return 0;
+    }
+
+    int64_t level = (int64_t)(fusion->moisture - c->soil_dry) * 100 / (c->soil_full - c->soil_dry);
+    int64_t rise = fusion->trend > 0 ? (int64_t)fusion->trend * 50 / c->soil_trend_full : 0;
+
+    return fusion_pct(level < 0 ? rise : level + rise);
+}
+
+static uint8_t fusion_seismic_pct(const fusion_t *fusion, uint32_t now_s)
+{
+    uint32_t energy = fusion_decay(fusion->energy, now_s - fusion->energy_s, fusion->config.seismic_half_s);
+    return fusion_pct((int64_t)energy * 100 / fusion->seismic_full);
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int fusion_init(fusion_t *fusion, const fusion_config_t *config)
+{
+    if (config->soil_full <= config->soil_dry || config->soil_trend_full == 0 ||
+        config->seismic_full_mg == 0 || config->seismic_half_s == 0 || config->raise >= FUSION_GRADES)
+    {
+        return 0;
+    }
+
+    // The grades have to go up in confidence
+    for (int g = FUSION_ADVISORY + 1; g < FUSION_GRADES; g++)
+    {
+        if (config->grade[g] <= config->grade[g - 1] || config->grade[g] > 100)
+        {
+            return 0;
+        }
+    }
+
+    fusion->config = *config;
+    fusion->seismic_full = fusion_energy(config->seismic_full_mg);
+
+    fusion->rain_pct = 0;
+    fusion->rain_over = 0;
+    fusion->moisture = 0;
+    fusion->trend_moisture = 0;
+    fusion->trend_s = 0;
+    fusion->trend = 0;
+    fusion->soil_seen = false;
+    fusion->soil_armed = true;
+    fusion->energy = 0;
+    fusion->energy_s = 0;
+    fusion->fresh = 0;
+    fusion->raised = FUSION_NONE;
+    fusion->reported = 0;
+
+    for (int ch = 0; ch < FUSION_CHANNELS; ch++)
+    {
+        fusion->report_pct[ch] = 0;
+        fusion->report_s[ch] = 0;
+    }
+
+    return 1;
+}
+
+void fusion_rain(fusion_t *fusion, uint32_t pct, uint32_t over)
+{
+    // Only a window going over its threshold is new, not it staying there
+    if (over & ~fusion->rain_over)
+    {
+        fusion->fresh |= 1u << FUSION_RAIN;
+    }
+
+    fusion->rain_pct = fusion_pct(pct);
+    fusion->rain_over = over;
+}
+
+void fusion_soil(fusion_t *fusion, uint32_t now_s, int moisture)
+{
+    const fusion_config_t *c = &fusion->config;
+
+    if (!fusion->soil_seen)
+    {
+        fusion->trend_moisture = moisture;
+        fusion->trend_s = now_s;
+        fusion->soil_seen = true;
+    }
+    else if (now_s - fusion->trend_s >= c->soil_trend_min_s)
+    {
+        // Readings close together are mostly the probe's noise, so the rise
+        // is only measured over at least soil_trend_min_s, and smoothed
+        int32_t rise = (int32_t)((int64_t)(moisture - fusion->trend_moisture) * 3600 / (now_s - fusion->trend_s));
+
+        fusion->trend = (fusion->trend + rise) / 2;
+        fusion->trend_moisture = moisture;
+        fusion->trend_s = now_s;
+    }
+
+    fusion->moisture = moisture;
+
+    // Only going over is new, not staying there or the probe's noise taking
+    // it back and forth, so it has to drop under 80 % first
+    uint8_t pct = fusion_soil_pct(fusion);
+
+    if (pct >= 100 && fusion->soil_armed)
+    {
+        fusion->fresh |= 1u << FUSION_SOIL;
+        fusion->soil_armed = false;
+    }
+    else if (pct < 80)
+    {
+        fusion->soil_armed = true;
+    }
+}
+
+void fusion_seismic(fusion_t *fusion, uint32_t now_s, uint32_t peak_mg)
+{
+    uint32_t energy = fusion_energy(peak_mg);
+
+    fusion->energy = fusion_decay(fusion->energy, now_s - fusion->energy_s, fusion->config.seismic_half_s);
+    fusion->energy_s = now_s;
+
+    // Saturates well before it could wrap
+    fusion->energy = fusion->energy + energy < fusion->energy ? UINT32_MAX : fusion->energy + energy;
+
+    if (energy >= fusion->seismic_full)
+    {
+        fusion->fresh |= 1u << FUSION_SEISMIC;
+    }
+}
+
+void fusion_report(fusion_t *fusion, uint32_t now_s, fusion_channel_t channel, uint32_t pct, bool fresh)
+{
+    if (channel >= FUSION_CHANNELS)
+    {
+        return;
+    }
+
+    fusion->reported |= 1u << channel;
+    fusion->report_pct[channel] = fusion_pct(pct);
+    fusion->report_s[channel] = now_s;
+
+    if (fresh)
+    {
+        fusion->fresh |= 1u << channel;
+    }
+}
+
+fusion_grade_t fusion_assess(fusion_t *fusion, uint32_t now_s, fusion_alert_t *alert)
+{
+    const fusion_config_t *c = &fusion->config;
+
+    alert->evidence[FUSION_RAIN] = fusion->rain_pct;
+    alert->evidence[FUSION_SOIL] = fusion_soil_pct(fusion);
+    alert->evidence[FUSION_SEISMIC] = fusion_seismic_pct(fusion, now_s);
+
+    // Reported evidence in place of the readings, the vibration fading on
+    // from when it was reported
+    for (int ch = 0; ch < FUSION_CHANNELS; ch++)
+    {
+        if (fusion->reported & (1u << ch))
+        {
+            uint32_t pct = fusion->report_pct[ch];
+
+            if (ch == FUSION_SEISMIC)
+            {
+                pct = fusion_decay(pct * 100, now_s - fusion->report_s[ch], c->seismic_half_s) / 100;
+            }
+
+            alert->evidence[ch] = (uint8_t)pct;
+        }
+    }
+
+    // Noisy OR, in units of 1/10000
+    uint32_t doubt = 10000;
+    alert->channels = 0;
+
+    for (int ch = 0; ch < FUSION_CHANNELS; ch++)
+    {
+        doubt = doubt * (10000 - (uint32_t)c->weight[ch] * alert->evidence[ch]) / 10000;
+        alert->channels += alert->evidence[ch] > 0;
+    }
+
+    alert->confidence = (uint8_t)((10000 - doubt) / 100);
+
+    alert->grade = FUSION_NONE;
+    for (int g = FUSION_ADVISORY; g < FUSION_GRADES; g++)
+    {
+        if (alert->confidence >= c->grade[g])
+        {
+            alert->grade = (fusion_grade_t)g;
+        }
+    }
+
+    // Raise on reaching the raise grade, going up from it, or a sensor
+    // reaching its own threshold again while there
+    alert->raise = alert->grade >= c->raise && (alert->grade > fusion->raised || fusion->fresh != 0);
+
+    // The grade has to fall two under the raise grade before reaching it is
+    // new again, one under is often only noise
+    if ((int)alert->grade + 2 <= (int)c->raise || alert->grade == FUSION_NONE)
+    {
+        fusion->raised = FUSION_NONE;
+    }
+    else if (alert->grade > fusion->raised)
+    {
+        fusion->raised = alert->grade;
+    }
+
+    alert->fresh = fusion->fresh;
+    fusion->fresh = 0;
+
+    return alert->grade;
+}
+
+const char *fusion_grade_name(fusion_grade_t grade)
+{
+    switch (grade)
+    {
+        case FUSION_ADVISORY:
+            return "advisory";
+        case FUSION_WATCH:
+            return "watch";
+        case FUSION_WARNING:
+            return "warning";
+        default:
+            return "none";
+    }
+}
@@ -0,0 +1,782 @@
+/**
+ * @file    hal_pico.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Pi Pico backend of the landslide HAL. Every function is a thin
+ *          wrapper around the matching Pico SDK / PICO EXTRAS call.
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_hal.h"
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/uart.h"
+#include "hardware/rtc.h"
+#include "hardware/sync.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "hardware/flash.h"
+#include "hardware/structs/scb.h"
+#include "pico/multicore.h"
+
+#include "pulse_counter.pio.h"
+
+#ifdef LANDSLIDE_HAL_HAS_SLEEP
+#include "pico/sleep.h"
+#endif
+
+_Static_assert(HAL_PIO_FIFO_JOIN_TX == PIO_FIFO_JOIN_TX && HAL_PIO_FIFO_JOIN_RX == PIO_FIFO_JOIN_RX,
+               "HAL_PIO_FIFO_JOIN_* must match the SDK's pio_fifo_join");
+
+// ############################# [ Global Variables ] #############################
+
+// Background I2C read, the command words fed to the I2C block by the tx DMA
+// channel and the callback run when the rx DMA channel finishes
+static struct
+{
+    bool claimed;
+    int tx_chan;
+    int rx_chan;
+    volatile bool busy;
+    uint16_t cmds[2 * HAL_I2C_DMA_MAX_LEN];
+    hal_irq_callback_t callback;
+    void *ctx;
+} pico_dma;
+
+// Functions called from the GPIO interrupt, one per pin
+static struct
+{
+    hal_irq_callback_t callback;
+    void *ctx;
+} pico_gpio_irqs[NUM_BANK0_GPIOS];
+
+// Functions called from the UART receive interrupts
+static struct
+{
+    hal_irq_callback_t callback;
+    void *ctx;
+    bool handler_set;
+} pico_uart_irqs[2];
+
+// Periodic timers
+static struct
+{
+    bool running;
+    repeating_timer_t timer;
+    hal_irq_callback_t callback;
+    void *ctx;
+} pico_timers[HAL_NUM_TIMERS];
+
+// Pulse counter state machine and the function called at its threshold
+static struct
+{
+    bool running;
+    PIO pio;
+    uint sm;
+    hal_irq_callback_t callback;
+    void *ctx;
+} pico_counter;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Maps a HAL bus number onto the SDK instance
+static inline i2c_inst_t *pico_i2c(hal_i2c_t i2c)
+{
+    return i2c == HAL_I2C0 ? i2c0 : i2c1;
+}
+
+static inline uart_inst_t *pico_uart(hal_uart_t uart)
+{
+    return uart == HAL_UART0 ? uart0 : uart1;
+}
+
+// Runs when the rx DMA channel has read the last byte
+static void pico_dma_irq(void)
+{
+    if (!dma_channel_get_irq0_status(pico_dma.rx_chan))
+    {
+        return;
+    }
+
+    dma_channel_acknowledge_irq0(pico_dma.rx_chan);
+    pico_dma.busy = false;
+
+    if (pico_dma.callback != NULL)
+    {
+        pico_dma.callback(pico_dma.ctx);
+    }
+}
+
+// Shared GPIO interrupt, passes the edge on to the function for the pin
+static void pico_gpio_irq(uint gpio, uint32_t events)
+{
+    (void)events;
+
+    if (gpio < NUM_BANK0_GPIOS && pico_gpio_irqs[gpio].callback != NULL)
+    {
+        pico_gpio_irqs[gpio].callback(pico_gpio_irqs[gpio].ctx);
+    }
+}
+
+// UART receive interrupts, fire when the rx FIFO is half full or has gone
+// quiet for 32 bit periods
+static void pico_uart0_irq(void)
+{
+    pico_uart_irqs[HAL_UART0].callback(pico_uart_irqs[HAL_UART0].ctx);
+}
+
+static void pico_uart1_irq(void)
+{
+    pico_uart_irqs[HAL_UART1].callback(pico_uart_irqs[HAL_UART1].ctx);
+}
+
+// Runs from the timer alarm interrupt
+static bool pico_timer_irq(repeating_timer_t *rt)
+{
+    int timer = (int)(intptr_t)rt->user_data;
+
+    pico_timers[timer].callback(pico_timers[timer].ctx);
+
+    return pico_timers[timer].running;
+}
+
+// Runs when the pulse counter reaches its threshold
+static void pico_counter_irq(void)
+{
+    pio_interrupt_clear(pico_counter.pio, 0);
+
+    if (pico_counter.callback != NULL)
+    {
+        pico_counter.callback(pico_counter.ctx);
+    }
+}
+
+// Copies between the HAL and SDK date and time structures
+static void pico_datetime(const hal_datetime_t *in, datetime_t *out)
+{
+    out->year  = in->year;
+    out->month = in->month;
+    out->day   = in->day;
+    out->dotw  = in->dotw;
+    out->hour  = in->hour;
+    out->min   = in->min;
+    out->sec   = in->sec;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void hal_stdio_init(void)
+{
+    stdio_init_all();
+}
+
+void hal_stdio_flush(void)
+{
+    uart_default_tx_wait_blocking();
+}
+
+void hal_stdio_write_raw(const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        putchar_raw(src[i]);
+    }
+}
+
+void hal_gpio_init(uint pin)
+{
+    gpio_init(pin);
+}
+
+void hal_gpio_set_dir(uint pin, bool out)
+{
+    gpio_set_dir(pin, out);
+}
+
+void hal_gpio_set_function(uint pin, hal_gpio_function_t fn)
+{
+    switch (fn)
+    {
+        case HAL_GPIO_FUNC_I2C:
+            gpio_set_function(pin, GPIO_FUNC_I2C);
+            break;
+        case HAL_GPIO_FUNC_UART:
+            gpio_set_function(pin, GPIO_FUNC_UART);
+            break;
+        default:
+            gpio_set_function(pin, GPIO_FUNC_SIO);
+            break;
+    }
+}
+
+void hal_gpio_put(uint pin, bool value)
+{
+    gpio_put(pin, value);
+}
+
+bool hal_gpio_get(uint pin)
+{
+    return gpio_get(pin);
+}
+
+void hal_gpio_set_irq(uint pin, uint edges, hal_irq_callback_t callback, void *ctx)
+{
+    uint32_t events = 0;
+
+    if (edges & HAL_GPIO_EDGE_RISE)
+    {
+        events |= GPIO_IRQ_EDGE_RISE;
+    }
+    if (edges & HAL_GPIO_EDGE_FALL)
+    {
+        events |= GPIO_IRQ_EDGE_FALL;
+    }
+
+    pico_gpio_irqs[pin].callback = callback;
+    pico_gpio_irqs[pin].ctx = ctx;
+
+    // Turn off both edges first so an edge that is no longer wanted stops
+    gpio_set_irq_enabled(pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+    if (events != 0 && callback != NULL)
+    {
+        gpio_set_irq_enabled_with_callback(pin, events, true, &pico_gpio_irq);
+    }
+}
+
+void hal_i2c_init(hal_i2c_t i2c, uint baudrate)
+{
+    i2c_init(pico_i2c(i2c), baudrate);
+}
+
+int hal_i2c_write_blocking(hal_i2c_t i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    return i2c_write_blocking(pico_i2c(i2c), addr, src, len, nostop);
+}
+
+int hal_i2c_write_timeout_us(hal_i2c_t i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop,
+                             uint timeout_us)
+{
+    return i2c_write_timeout_us(pico_i2c(i2c), addr, src, len, nostop, timeout_us);
+}
+
+int hal_i2c_read_blocking(hal_i2c_t i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    return i2c_read_blocking(pico_i2c(i2c), addr, dst, len, nostop);
+}
+
+bool hal_i2c_read_dma(hal_i2c_t i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                      hal_irq_callback_t callback, void *ctx)
+{
+    return hal_i2c_read_dma_repeat(i2c, addr, reg, dst, len, 1, callback, ctx);
+}
+
+bool hal_i2c_read_dma_repeat(hal_i2c_t i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                             size_t count, hal_irq_callback_t callback, void *ctx)
+{
+    i2c_inst_t *inst = pico_i2c(i2c);
+
+    if (pico_dma.busy || len == 0 || count == 0 || len * count > HAL_I2C_DMA_MAX_LEN)
+    {
+        return false;
+    }
+
+    // Claim the two DMA channels the first time round
+    if (!pico_dma.claimed)
+    {
+        pico_dma.tx_chan = dma_claim_unused_channel(true);
+        pico_dma.rx_chan = dma_claim_unused_channel(true);
+        dma_channel_set_irq0_enabled(pico_dma.rx_chan, true);
+        irq_add_shared_handler(DMA_IRQ_0, &pico_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        pico_dma.claimed = true;
+    }
+
+    pico_dma.busy = true;
+    pico_dma.callback = callback;
+    pico_dma.ctx = ctx;
+
+    // Command words for each read: write the register address, then a restart
+    // and len reads with a stop after the last one. The next register write
+    // after a stop goes out with a new start.
+    size_t num_cmds = 0;
+    for (size_t n = 0; n < count; n++)
+    {
+        pico_dma.cmds[num_cmds++] = reg;
+        for (size_t i = 0; i < len; i++)
+        {
+            pico_dma.cmds[num_cmds++] = I2C_IC_DATA_CMD_CMD_BITS;
+        }
+        pico_dma.cmds[num_cmds - len] |= I2C_IC_DATA_CMD_RESTART_BITS;
+        pico_dma.cmds[num_cmds - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    }
+
+    // Point the I2C block at the device and let it request DMA
+    inst->hw->enable = 0;
+    inst->hw->tar = addr;
+    inst->hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+    inst->hw->enable = 1;
+
+    // Received bytes go from the data register into dst
+    dma_channel_config rx = dma_channel_get_default_config(pico_dma.rx_chan);
+    channel_config_set_transfer_data_size(&rx, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx, false);
+    channel_config_set_write_increment(&rx, true);
+    channel_config_set_dreq(&rx, i2c_get_dreq(inst, false));
+    dma_channel_configure(pico_dma.rx_chan, &rx, dst, &inst->hw->data_cmd, len * count, true);
+
+    // Command words go from the buffer into the data register
+    dma_channel_config tx = dma_channel_get_default_config(pico_dma.tx_chan);
+    channel_config_set_transfer_data_size(&tx, DMA_SIZE_16);
+    channel_config_set_read_increment(&tx, true);
+    channel_config_set_write_increment(&tx, false);
+    channel_config_set_dreq(&tx, i2c_get_dreq(inst, true));
+    dma_channel_configure(pico_dma.tx_chan, &tx, &inst->hw->data_cmd, pico_dma.cmds, num_cmds, true);
+
+    return true;
+}
+
+void hal_uart_init(hal_uart_t uart, uint baudrate)
+{
+    uart_init(pico_uart(uart), baudrate);
+}
+
+void hal_uart_putc_raw(hal_uart_t uart, char c)
+{
+    uart_putc_raw(pico_uart(uart), c);
+}
+
+char hal_uart_getc(hal_uart_t uart)
+{
+    return uart_getc(pico_uart(uart));
+}
+
+bool hal_uart_is_readable(hal_uart_t uart)
+{
+    return uart_is_readable(pico_uart(uart));
+}
+
+void hal_uart_set_irq(hal_uart_t uart, hal_irq_callback_t callback, void *ctx)
+{
+    uint irq = uart == HAL_UART0 ? UART0_IRQ : UART1_IRQ;
+
+    if (callback == NULL)
+    {
+        uart_set_irq_enables(pico_uart(uart), false, false);
+        irq_set_enabled(irq, false);
+        pico_uart_irqs[uart].callback = NULL;
+        return;
+    }
+
+    pico_uart_irqs[uart].callback = callback;
+    pico_uart_irqs[uart].ctx = ctx;
+
+    // The SDK only allows the exclusive handler to be set once
+    if (!pico_uart_irqs[uart].handler_set)
+    {
+        irq_set_exclusive_handler(irq, uart == HAL_UART0 ? &pico_uart0_irq : &pico_uart1_irq);
+        pico_uart_irqs[uart].handler_set = true;
+    }
+
+    irq_set_enabled(irq, true);
+    uart_set_irq_enables(pico_uart(uart), true, false);
+}
+
+void hal_sleep_ms(uint32_t ms)
+{
+    sleep_ms(ms);
+}
+
+void hal_busy_wait_ms(uint32_t ms)
+{
+    busy_wait_ms(ms);
+}
+
+void hal_wait_ms(uint32_t ms)
+{
+    if (hal_in_irq())
+    {
+        busy_wait_ms(ms);
+    }
+    else
+    {
+        sleep_ms(ms);
+    }
+}
+
+bool hal_in_irq(void)
+{
+    return __get_current_exception() != 0;
+}
+
+uint64_t hal_time_us_64(void)
+{
+    return time_us_64();
+}
+
+void hal_sleep_until_us(uint64_t us)
+{
+    sleep_until(from_us_since_boot(us));
+}
+
+void hal_wfi(void)
+{
+    __wfi();
+}
+
+int hal_timer_start(uint32_t period_us, hal_irq_callback_t callback, void *ctx)
+{
+    for (int i = 0; i < HAL_NUM_TIMERS; i++)
+    {
+        if (!pico_timers[i].running)
+        {
+            pico_timers[i].running = true;
+            pico_timers[i].callback = callback;
+            pico_timers[i].ctx = ctx;
+
+            // A negative period is measured from the start of each callback
+            add_repeating_timer_us(-(int64_t)period_us, &pico_timer_irq, (void *)(intptr_t)i, &pico_timers[i].timer);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void hal_timer_stop(int timer)
+{
+    if (timer >= 0 && timer < HAL_NUM_TIMERS && pico_timers[timer].running)
+    {
+        pico_timers[timer].running = false;
+        cancel_repeating_timer(&pico_timers[timer].timer);
+    }
+}
+
+int hal_pulse_counter_init(uint pin, uint32_t debounce_us)
+{
+    // 32 clocks of the state machine make up the debounce time
+    float clkdiv = (float)clock_get_hz(clk_sys) * debounce_us / 32e6f;
+
+    if (pico_counter.running || clkdiv < 1.0f || clkdiv > 65535.0f)
+    {
+        return 0;
+    }
+
+    PIO pio = pio0;
+    int sm = pio_claim_unused_sm(pio, false);
+
+    if (sm < 0 || !pio_can_add_program(pio, &pulse_counter_program))
+    {
+        if (sm >= 0)
+        {
+            pio_sm_unclaim(pio, sm);
+        }
+        return 0;
+    }
+
+    uint offset = pio_add_program(pio, &pulse_counter_program);
+    pulse_counter_program_init(pio, sm, offset, pin, clkdiv);
+
+    // No pulses yet and no threshold
+    pio_sm_exec(pio, sm, pio_encode_mov_not(pio_y, pio_null));
+    pio_sm_exec(pio, sm, pio_encode_mov_not(pio_x, pio_null));
+    pio_sm_exec(pio, sm, pio_encode_mov_not(pio_osr, pio_null));
+
+    pico_counter.pio = pio;
+    pico_counter.sm = (uint)sm;
+    pico_counter.running = true;
+
+    pio_interrupt_clear(pio, 0);
+    irq_set_exclusive_handler(PIO0_IRQ_0, &pico_counter_irq);
+    irq_set_enabled(PIO0_IRQ_0, true);
+
+    pio_sm_set_enabled(pio, sm, true);
+
+    return 1;
+}
+
+uint32_t hal_pulse_counter_read(void)
+{
+    if (!pico_counter.running)
+    {
+        return 0;
+    }
+
+    PIO pio = pico_counter.pio;
+    uint sm = pico_counter.sm;
+
+    // The program only waits or counts, so these can run between any two of
+    // its instructions
+    pio_sm_exec(pio, sm, pio_encode_mov_not(pio_isr, pio_y));
+    pio_sm_exec(pio, sm, pio_encode_push(false, false));
+
+    return pio_sm_get_blocking(pio, sm);
+}
+
+void hal_pulse_counter_set_irq(uint32_t pulses, hal_irq_callback_t callback, void *ctx)
+{
+    if (!pico_counter.running)
+    {
+        return;
+    }
+
+    PIO pio = pico_counter.pio;
+    uint sm = pico_counter.sm;
+
+    pio_set_irq0_source_enabled(pio, pis_interrupt0, false);
+
+    pico_counter.callback = callback;
+    pico_counter.ctx = ctx;
+
+    if (pulses == 0 || callback == NULL)
+    {
+        return;
+    }
+
+    // Load pulses - 1 into the OSR through the tx FIFO, then into x
+    pio_sm_put(pio, sm, pulses - 1);
+    pio_sm_exec(pio, sm, pio_encode_pull(false, false));
+    pio_sm_exec(pio, sm, pio_encode_mov(pio_x, pio_osr));
+
+    pio_interrupt_clear(pio, 0);
+    pio_set_irq0_source_enabled(pio, pis_interrupt0, true);
+}
+
+void hal_flash_erase(uint32_t offset, size_t len)
+{
+    // Nothing may run from the flash while it is busy
+    uint32_t irqs = save_and_disable_interrupts();
+    flash_range_erase(offset, len);
+    restore_interrupts(irqs);
+}
+
+void hal_flash_program(uint32_t offset, const uint8_t *src, size_t len)
+{
+    uint32_t irqs = save_and_disable_interrupts();
+    flash_range_program(offset, src, len);
+    restore_interrupts(irqs);
+}
+
+const uint8_t *hal_flash_read(uint32_t offset)
+{
+    return (const uint8_t *)(XIP_BASE + offset);
+}
+
+// ---------------------------------- [ Multicore ] ------------------------------
+
+void hal_core1_launch(void (*entry)(void))
+{
+    multicore_launch_core1(entry);
+}
+
+void hal_core_wait(void)
+{
+    __wfe();
+}
+
+void hal_core_signal(void)
+{
+    __sev();
+}
+
+// Time the timer counted across the last dormant or sleep wait
+static uint32_t pico_wake_us;
+
+uint32_t hal_sleep_wake_us(void)
+{
+    return pico_wake_us;
+}
+
+// Alarm callback and flag used to wait for the RTC alarm outside the sleep
+// library
+static hal_rtc_callback_t pico_alarm_callback;
+static volatile bool pico_alarm_fired;
+
+static void pico_alarm_handler(void)
+{
+    pico_alarm_fired = true;
+
+    if (pico_alarm_callback != NULL)
+    {
+        pico_alarm_callback();
+    }
+}
+
+#ifdef LANDSLIDE_HAL_HAS_SLEEP
+
+void hal_sleep_run_from_xosc(void)
+{
+    sleep_run_from_xosc();
+}
+
+void hal_sleep_goto_dormant_until_level_high(uint pin)
+{
+    uint64_t start_us = time_us_64();
+    sleep_goto_dormant_until_level_high(pin);
+    pico_wake_us = (uint32_t)(time_us_64() - start_us);
+}
+
+void hal_sleep_goto_dormant_until_edge_high(uint pin)
+{
+    uint64_t start_us = time_us_64();
+    sleep_goto_dormant_until_edge_high(pin);
+    pico_wake_us = (uint32_t)(time_us_64() - start_us);
+}
+
+void hal_sleep_goto_sleep_until(const hal_datetime_t *alarm, hal_rtc_callback_t callback)
+{
+    datetime_t t;
+    pico_datetime(alarm, &t);
+
+    uint64_t start_us = time_us_64();
+    sleep_goto_sleep_until(&t, callback);
+    pico_wake_us = (uint32_t)(time_us_64() - start_us);
+}
+
+bool hal_sleep_goto_sleep_until_irq(const hal_datetime_t *alarm, const volatile bool *woken)
+{
+    datetime_t t;
+    pico_datetime(alarm, &t);
+
+    // An interrupt from here on stays pending, and a pending interrupt ends
+    // the WFI even with interrupts off
+    uint32_t irqs = save_and_disable_interrupts();
+    if (woken != NULL && *woken)
+    {
+        restore_interrupts(irqs);
+        return false;
+    }
+
+    pico_alarm_callback = NULL;
+    pico_alarm_fired = false;
+    rtc_set_alarm(&t, &pico_alarm_handler);
+
+    // As sleep_goto_sleep_until() but with the GPIO and PIO clocks left on in
+    // sleep, so their interrupts wake the core too
+    uint64_t start_us = time_us_64();
+    clocks_hw->sleep_en0 = CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PIO0_BITS |
+                           CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS;
+    clocks_hw->sleep_en1 = 0;
+    scb_hw->scr |= M0PLUS_SCR_SLEEPDEEP_BITS;
+
+    __wfi();
+
+    scb_hw->scr &= ~M0PLUS_SCR_SLEEPDEEP_BITS;
+    clocks_hw->sleep_en0 = 0xFFFFFFFF;
+    clocks_hw->sleep_en1 = 0xFFFFFFFF;
+    pico_wake_us = (uint32_t)(time_us_64() - start_us);
+
+    // The interrupt that woke it runs now, on the full clocks
+    restore_interrupts(irqs);
+    rtc_disable_alarm();
+
+    return pico_alarm_fired;
+}
+
+#else
+
+// Without PICO EXTRAS there is no sleep library, so fall back to running from
+// the normal clocks and polling
+void hal_sleep_run_from_xosc(void)
+{
+}
+
+void hal_sleep_goto_dormant_until_level_high(uint pin)
+{
+    while (gpio_get(pin) == 0)
+    {
+        tight_loop_contents();
+    }
+}
+
+void hal_sleep_goto_dormant_until_edge_high(uint pin)
+{
+    while (gpio_get(pin) == 1)
+    {
+        tight_loop_contents();
+    }
+
+    while (gpio_get(pin) == 0)
+    {
+        tight_loop_contents();
+    }
+}
+
+void hal_sleep_goto_sleep_until(const hal_datetime_t *alarm, hal_rtc_callback_t callback)
+{
+    datetime_t t;
+    pico_datetime(alarm, &t);
+
+    pico_alarm_callback = callback;
+    pico_alarm_fired = false;
+    rtc_set_alarm(&t, &pico_alarm_handler);
+
+    // Wait for the alarm with the core idling
+    while (!pico_alarm_fired)
+    {
+        __wfi();
+    }
+}
+
+bool hal_sleep_goto_sleep_until_irq(const hal_datetime_t *alarm, const volatile bool *woken)
+{
+    datetime_t t;
+    pico_datetime(alarm, &t);
+
+    uint32_t irqs = save_and_disable_interrupts();
+    if (woken != NULL && *woken)
+    {
+        restore_interrupts(irqs);
+        return false;
+    }
+
+    pico_alarm_callback = NULL;
+    pico_alarm_fired = false;
+    rtc_set_alarm(&t, &pico_alarm_handler);
+
+    // Idle until the alarm or any other interrupt
+    __wfi();
+    restore_interrupts(irqs);
+    rtc_disable_alarm();
+
+    return pico_alarm_fired;
+}
+
+#endif
+
+void hal_rtc_init(void)
+{
+    rtc_init();
+}
+
+bool hal_rtc_set_datetime(const hal_datetime_t *t)
+{
+    datetime_t dt;
+    pico_datetime(t, &dt);
+    return rtc_set_datetime(&dt);
+}
+
+bool hal_rtc_get_datetime(hal_datetime_t *t)
+{
+    datetime_t dt;
+
+    if (!rtc_get_datetime(&dt))
+    {
+        return false;
+    }
+
+    t->year  = dt.year;
+    t->month = dt.month;
+    t->day   = dt.day;
+    t->dotw  = dt.dotw;
+    t->hour  = dt.hour;
+    t->min   = dt.min;
+    t->sec   = dt.sec;
+
+    return true;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file    landslide_node.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Helpers shared by every sensor node firmware, see landslide_node.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "landslide_node.h"
+#include "node_warning.h"
+
+// ############################## [ Functions ] ####################################
+
+void node_setup_pins(uint LED_PIN, uint WARNING_PIN, uint ACK_PIN)
+{
+    // Setting up the LED
+    hal_gpio_init(LED_PIN);
+    hal_gpio_set_dir(LED_PIN, HAL_GPIO_OUT);
+
+    // Setup the warning pin as an output
+    hal_gpio_init(WARNING_PIN);
+    hal_gpio_set_dir(WARNING_PIN, HAL_GPIO_OUT);
+
+    // Setup the ack pin as an input
+    hal_gpio_init(ACK_PIN);
+    hal_gpio_set_dir(ACK_PIN, HAL_GPIO_IN);
+
+    // Warnings are raised with node_warning_raise() from now on
+    node_warning_init(WARNING_PIN, ACK_PIN, LED_PIN, NULL);
+}
+
+
+
+int reg_write(hal_i2c_t i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes)
+{
+
+    int return_val = 0;
+
+    // Create a buffer to hold the data to be written
+    uint8_t msg[nbytes + 1];
+
+    // Check to make sure caller is sending 1 or more bytes
+    if (nbytes < 1)
+    {
+        // Send back a fail
+        return 0;
+    }
+
+    // Append register address to front of data packet
+    msg[0] = reg;
+
+    // Add the data to the data packet
+    for (int i = 0; i < nbytes; i++)
+    {
+        msg[i + 1] = buf[i];
+    }
+
+    // Write data to register over I2C bus given
+    return_val = hal_i2c_write_blocking(i2c, addr, msg, (nbytes + 1), false);
+
+    // Check for error from write
+    if (return_val == HAL_ERROR_GENERIC)
+    {
+        // Output a print error
+        printf("Error writing to register %d, of device %d\r\n", reg, addr);
+        hal_stdio_flush();
+
+        // Return a fail
+        return 0;
+    }
+
+    return 1;
+}
+
+
+
+int reg_read(hal_i2c_t i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes)
+{
+
+    // Variable to return the number of bytes read
+    int num_bytes_read = 0;
+
+    // Check to make sure caller is asking for 1 or more bytes
+    if (nbytes < 1)
+    {
+        return 0;
+    }
+
+    // Issue a write command to tell the device to send the data
+    hal_i2c_write_blocking(i2c, addr, &reg, 1, true);
+
+    // Read the data from the device
+    num_bytes_read = hal_i2c_read_blocking(i2c, addr, buf, nbytes, false);
+
+    // Check for a read error
+    if (num_bytes_read == HAL_ERROR_GENERIC)
+    {
+        // Output a print error
+        printf("Error reading from register %d, of device %d\r\n", reg, addr);
+        hal_stdio_flush();
+
+        // Return a fail
+        return 0;
+    }
+
+    // Return the number of bytes read
+    return num_bytes_read;
+}
+
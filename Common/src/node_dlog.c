@@ -0,0 +1,91 @@
+/**
+ * @file    node_dlog.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Deferred log for the hot paths, see node_dlog.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "node_dlog.h"
+#include "node_phase.h"
+#include "spsc_queue.h"
+
+#include <stdio.h>
+
+// ############################# [ Global Variables ] #############################
+
+static dlog_record_t dlog_slots[NODE_DLOG_RECORDS];
+static spsc_queue_t dlog_ring;
+
+// Records dropped since the last one that fitted
+static uint32_t dlog_lost_since;
+
+
+// ############################## [ Functions ] ####################################
+
+void node_dlog_init(void)
+{
+    spsc_init(&dlog_ring, dlog_slots, NODE_DLOG_RECORDS, sizeof(dlog_record_t));
+    dlog_lost_since = 0;
+}
+
+bool node_dlog_write(uint16_t id, const uint32_t *args, uint32_t nargs)
+{
+    dlog_record_t record;
+
+    record.time_us = (uint32_t)hal_time_us_64();
+    record.id = id;
+    record.nargs = (uint8_t)(nargs < DLOG_MAX_ARGS ? nargs : DLOG_MAX_ARGS);
+    record.lost = (uint8_t)(dlog_lost_since < 255 ? dlog_lost_since : 255);
+    memcpy(record.args, args, record.nargs * sizeof(uint32_t));
+
+    if (!spsc_push(&dlog_ring, &record))
+    {
+        dlog_lost_since++;
+        return false;
+    }
+
+    dlog_lost_since = 0;
+    return true;
+}
+
+uint32_t node_dlog_drain(void)
+{
+    dlog_record_t record;
+    uint32_t count = 0;
+
+    NODE_PHASE_BEGIN(PHASE_UART_DRAIN);
+
+    while (spsc_pop(&dlog_ring, &record))
+    {
+#if NODE_DLOG_MODE == NODE_DLOG_BINARY
+        uint8_t frame[DLOG_FRAME_MAX];
+        hal_stdio_write_raw(frame, dlog_frame_encode(frame, &record));
+#else
+        char text[160];
+
+        if (record.lost != 0)
+        {
+            printf("[%u log records lost]\r\n", (unsigned)record.lost);
+        }
+
+        if (dlog_format(text, sizeof(text), &record) >= 0)
+        {
+            fputs(text, stdout);
+        }
+#endif
+
+        count++;
+    }
+
+    hal_stdio_flush();
+
+    NODE_PHASE_END(PHASE_UART_DRAIN);
+    return count;
+}
+
+uint32_t node_dlog_lost(void)
+{
+    return dlog_ring.dropped;
+}
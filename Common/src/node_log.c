@@ -0,0 +1,171 @@
+/**
+ * @file    node_log.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Event log in the node's flash, see node_log.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "node_log.h"
+#include "node_config.h"
+
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+#define LOG_SECTORS         (NODE_LOG_SIZE / HAL_FLASH_SECTOR_SIZE)
+#define LOG_PAGE_SLOTS      (HAL_FLASH_PAGE_SIZE / EVENT_LOG_RECORD_LEN)
+
+#if HAL_FLASH_SECTOR_SIZE != EVENT_LOG_SECTOR_LEN || HAL_FLASH_PAGE_SIZE % EVENT_LOG_RECORD_LEN != 0
+#error "The event log layout does not fit the flash"
+#endif
+
+static bool log_ready;
+
+// Where the next record goes, and the sequence number of its sector
+static uint32_t log_sector;
+static uint32_t log_slot;
+static uint32_t log_seq;
+static uint32_t log_max_erases;
+
+// The page the next record goes in, 0xFF except for the records waiting
+static uint8_t log_page[HAL_FLASH_PAGE_SIZE];
+static uint32_t log_pending;
+
+static node_log_stats_t log_stats;
+
+
+// ############################## [ Local Functions ] ##############################
+
+static uint32_t log_offset(uint32_t sector, uint32_t slot)
+{
+    return NODE_LOG_OFFSET + sector * HAL_FLASH_SECTOR_SIZE + slot * EVENT_LOG_RECORD_LEN;
+}
+
+// Erases the next sector round the ring and programs its header, the oldest
+// records go with it
+static void log_open_sector(void)
+{
+    event_log_header_t header;
+    uint32_t sector = (log_sector + 1) % LOG_SECTORS;
+
+    // A sector without a good header has been erased at least as often as
+    // the most worn one, as far as anyone knows
+    uint32_t erases = log_max_erases;
+    if (event_log_decode_header(hal_flash_read(log_offset(sector, 0)), &header))
+    {
+        erases = header.erases;
+    }
+
+    hal_flash_erase(log_offset(sector, 0), HAL_FLASH_SECTOR_SIZE);
+    log_stats.erases++;
+
+    header = (event_log_header_t){ .seq = log_seq + 1, .erases = erases + 1, .boot = log_stats.boot };
+
+    uint8_t page[HAL_FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    event_log_encode_header(page, &header);
+    hal_flash_program(log_offset(sector, 0), page, sizeof(page));
+    log_stats.pages++;
+
+    log_sector = sector;
+    log_slot = 1;
+    log_seq = header.seq;
+    log_max_erases = header.erases > log_max_erases ? header.erases : log_max_erases;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int node_log_init(uint8_t kind)
+{
+    event_log_info_t info;
+
+    event_log_scan(hal_flash_read(NODE_LOG_OFFSET), NODE_LOG_SIZE, NULL, NULL, &info);
+
+    log_stats = (node_log_stats_t){ .boot = (uint16_t)(info.boot + 1), .found = info.records };
+    log_max_erases = info.max_erases;
+    log_pending = 0;
+    memset(log_page, 0xFF, sizeof(log_page));
+
+    // Carry on after the last record, or open the first sector of a new log
+    if (info.newest != UINT32_MAX)
+    {
+        log_sector = info.newest;
+        log_slot = info.next_slot;
+        log_seq = info.newest_seq;
+    }
+    else
+    {
+        log_sector = LOG_SECTORS - 1;
+        log_slot = EVENT_LOG_SLOTS;
+        log_seq = UINT32_MAX;
+    }
+
+    log_ready = true;
+
+    node_log_append(TELEMETRY_BOOT, kind, log_stats.boot, (int32_t)info.records);
+    node_log_flush();
+
+    return 1;
+}
+
+void node_log_append(telemetry_type_t type, uint8_t arg, int32_t value, int32_t stat)
+{
+    if (!log_ready)
+    {
+        return;
+    }
+
+    if (log_slot == EVENT_LOG_SLOTS)
+    {
+        log_open_sector();
+    }
+
+    event_log_record_t record = {
+        .type = (uint8_t)type, .arg = arg, .time_ms = (uint32_t)(hal_time_us_64() / 1000), .value = value, .stat = stat
+    };
+
+    event_log_encode_record(&log_page[(log_slot % LOG_PAGE_SLOTS) * EVENT_LOG_RECORD_LEN], &record);
+    log_slot++;
+    log_pending++;
+    log_stats.appended++;
+
+    // The page is full
+    if (log_slot % LOG_PAGE_SLOTS == 0)
+    {
+        node_log_flush();
+    }
+}
+
+void node_log_alert(const fusion_alert_t *alert)
+{
+    uint32_t value = alert->confidence | (uint32_t)alert->evidence[FUSION_RAIN] << 8 |
+                     (uint32_t)alert->evidence[FUSION_SOIL] << 16 | (uint32_t)alert->evidence[FUSION_SEISMIC] << 24;
+
+    node_log_append(TELEMETRY_ALERT, (uint8_t)alert->grade, (int32_t)value, alert->channels);
+    node_log_flush();
+}
+
+void node_log_flush(void)
+{
+    if (log_pending == 0)
+    {
+        return;
+    }
+
+    // The page of the last record, the slots already programmed are 0xFF in
+    // the buffer and stay as they are
+    uint32_t page_slot = (log_slot - 1) / LOG_PAGE_SLOTS * LOG_PAGE_SLOTS;
+    hal_flash_program(log_offset(log_sector, page_slot), log_page, sizeof(log_page));
+    log_stats.pages++;
+
+    memset(log_page, 0xFF, sizeof(log_page));
+    log_pending = 0;
+}
+
+const node_log_stats_t *node_log_stats(void)
+{
+    return &log_stats;
+}
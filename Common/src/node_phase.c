@@ -0,0 +1,255 @@
+/**
+ * @file    node_phase.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Phase timing of the wake cycle, see node_phase.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "node_phase.h"
+#include "node_telemetry.h"
+
+// ############################# [ Global Variables ] #############################
+
+static phase_stats_t phase_stats[PHASE_COUNT];
+
+// Phases of the main loop open now, the time each has had so far and when
+// the innermost last began counting
+static uint8_t phase_open[NODE_PHASE_DEPTH];
+static uint64_t phase_open_us[NODE_PHASE_DEPTH];
+static uint32_t phase_depth;
+static uint32_t phase_too_deep;
+static uint64_t phase_mark_us;
+
+// Time the main loop spent in a phase, the rest is charged as running
+static uint64_t phase_covered_us;
+
+// Phases beside the main loop started now, and when
+static volatile bool phase_started[PHASE_COUNT];
+static uint64_t phase_start_us[PHASE_COUNT];
+
+// When the statistics were last sent
+static uint64_t phase_export_us;
+
+// Supply current of each phase (uA), those beside the main loop are on top of
+// what the core draws. The LED is lit half the time a warning waits.
+static const uint32_t phase_current_ua[PHASE_COUNT] = {
+    [PHASE_DORMANT] = NODE_CURRENT_DORMANT_UA,
+    [PHASE_SLEEP] = NODE_CURRENT_SLEEP_UA,
+    [PHASE_IDLE] = NODE_CURRENT_IDLE_UA,
+    [PHASE_CLOCK_RESTORE] = NODE_CURRENT_RUN_UA,
+    [PHASE_I2C_READ] = NODE_CURRENT_I2C_UA,
+    [PHASE_PROBE] = NODE_CURRENT_RUN_UA + NODE_CURRENT_UART_UA,
+    [PHASE_DETECT] = NODE_CURRENT_RUN_UA,
+    [PHASE_UART_DRAIN] = NODE_CURRENT_RUN_UA + NODE_CURRENT_UART_UA,
+    [PHASE_LINK] = NODE_CURRENT_RUN_UA + NODE_CURRENT_I2C_UA,
+    [PHASE_HANDSHAKE] = NODE_CURRENT_LED_UA / 2,
+};
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Closes the phase begun last and gets the time it had, false if it is not
+// the one begun last
+static bool phase_close(phase_id_t phase, uint64_t *us)
+{
+    if (phase_too_deep != 0)
+    {
+        phase_too_deep--;
+        return false;
+    }
+
+    if (phase_depth == 0 || phase_open[phase_depth - 1] != phase)
+    {
+        return false;
+    }
+
+    uint64_t now_us = hal_time_us_64();
+
+    phase_depth--;
+    *us = phase_open_us[phase_depth] + (now_us - phase_mark_us);
+    phase_mark_us = now_us;
+    phase_covered_us += *us;
+
+    return true;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void node_phase_begin(phase_id_t phase)
+{
+    if (phase_depth == NODE_PHASE_DEPTH || phase_too_deep != 0)
+    {
+        phase_too_deep++;
+        return;
+    }
+
+    uint64_t now_us = hal_time_us_64();
+
+    // The phase it is inside stops counting until this one ends
+    if (phase_depth != 0)
+    {
+        phase_open_us[phase_depth - 1] += now_us - phase_mark_us;
+    }
+
+    phase_open[phase_depth] = (uint8_t)phase;
+    phase_open_us[phase_depth] = 0;
+    phase_depth++;
+    phase_mark_us = now_us;
+}
+
+void node_phase_end(phase_id_t phase)
+{
+    uint64_t us;
+
+    if (phase_close(phase, &us))
+    {
+        phase_stats_add(&phase_stats[phase], us);
+    }
+}
+
+void node_phase_wake(phase_id_t phase)
+{
+    uint64_t us;
+
+    if (!phase_close(phase, &us))
+    {
+        return;
+    }
+
+    uint64_t restore_us = hal_sleep_wake_us();
+    if (restore_us > us)
+    {
+        restore_us = us;
+    }
+
+    phase_stats_add(&phase_stats[phase], us - restore_us);
+    phase_stats_add(&phase_stats[PHASE_CLOCK_RESTORE], restore_us);
+}
+
+void node_phase_start(phase_id_t phase)
+{
+    phase_start_us[phase] = hal_time_us_64();
+    phase_started[phase] = true;
+}
+
+void node_phase_stop(phase_id_t phase)
+{
+    if (!phase_started[phase])
+    {
+        return;
+    }
+
+    phase_started[phase] = false;
+    phase_stats_add(&phase_stats[phase], hal_time_us_64() - phase_start_us[phase]);
+}
+
+void node_phase_poll(void)
+{
+    uint64_t now_us = hal_time_us_64();
+
+    if (NODE_PHASE_EXPORT_S != 0 && now_us - phase_export_us >= NODE_PHASE_EXPORT_S * 1000000ull &&
+        node_phase_export())
+    {
+        phase_export_us = now_us;
+    }
+}
+
+int node_phase_export(void)
+{
+    telemetry_event_t events[PHASE_STATS_PARTS];
+
+    for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        if (phase_stats[phase].count == 0)
+        {
+            continue;
+        }
+
+        // Copied first, the phases beside the main loop add from interrupts
+        phase_stats_t stats = phase_stats[phase];
+
+        phase_stats_pack(events, (uint8_t)phase, &stats);
+        if (!node_telemetry_send(events, PHASE_STATS_PARTS))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+const phase_stats_t *node_phase_stats(phase_id_t phase)
+{
+    return &phase_stats[phase];
+}
+
+void node_phase_report(FILE *out, const char *prefix)
+{
+    uint64_t span_us = hal_time_us_64();
+    uint64_t covered_us = phase_covered_us;
+    double charge[PHASE_COUNT];
+    bool any = false;
+
+    for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        charge[phase] = (double)phase_stats[phase].total_us * phase_current_ua[phase];
+        any |= phase_stats[phase].count != 0;
+    }
+
+    // The phases still open, often the wait the simulation ended in, are
+    // charged for their time so far
+    for (uint32_t i = 0; i < phase_depth; i++)
+    {
+        uint64_t open_us = phase_open_us[i] + (i == phase_depth - 1 ? span_us - phase_mark_us : 0);
+
+        charge[phase_open[i]] += (double)open_us * phase_current_ua[phase_open[i]];
+        covered_us += open_us;
+    }
+
+    uint64_t other_us = span_us > covered_us ? span_us - covered_us : 0;
+    double total = (double)other_us * NODE_CURRENT_RUN_UA;
+
+    for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        total += charge[phase];
+    }
+
+    if (!any || span_us == 0)
+    {
+        return;
+    }
+
+    fprintf(out, "%s---------------- phase timing ----------------\n", prefix);
+
+    for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        if (phase_stats[phase].count != 0)
+        {
+            phase_stats_print(out, prefix, phase, &phase_stats[phase]);
+        }
+    }
+
+    for (uint32_t i = 0; i < phase_depth; i++)
+    {
+        fprintf(out, "%s%-13s still open\n", prefix, phase_name(phase_open[i]));
+    }
+
+    fprintf(out, "%s%-13s %12.3f s, charged at the run current\n", prefix, "no phase", other_us / 1e6);
+
+    // Share of the charge, the phases that used none left out
+    fprintf(out, "%scharge       :", prefix);
+    for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        if (charge[phase] != 0.0)
+        {
+            fprintf(out, " %s %.1f%%,", phase_name(phase), 100.0 * charge[phase] / total);
+        }
+    }
+    fprintf(out, " no phase %.1f%%\n", 100.0 * other_us * NODE_CURRENT_RUN_UA / total);
+
+    double mean_ua = total / span_us;
+    fprintf(out, "%smean current : %.3f mA, %.1f mAh a day\n", prefix, mean_ua / 1000.0, mean_ua * 24.0 / 1000.0);
+}
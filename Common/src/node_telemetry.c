@@ -0,0 +1,280 @@
+/**
+ * @file    node_telemetry.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Batched telemetry frames to the Zero, see node_telemetry.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "node_telemetry.h"
+#include "node_config.h"
+#include "node_phase.h"
+
+#if NODE_ZERO_I2C_TIMEOUT_US < TELEMETRY_FRAME_MAX * 9 * 1000000ll / NODE_ZERO_I2C_BAUD
+#error "NODE_ZERO_I2C_TIMEOUT_US must be longer than a full frame takes on the bus"
+#endif
+
+// ############################# [ Global Variables ] #############################
+
+// Bus and node
+static hal_i2c_t telemetry_i2c;
+static uint8_t telemetry_addr;
+static uint8_t telemetry_node;
+static uint16_t telemetry_seq;
+
+// Events waiting for a frame, a ring
+static telemetry_event_t telemetry_queue[NODE_TELEMETRY_QUEUE];
+static uint telemetry_head;
+static uint telemetry_count;
+static uint32_t telemetry_lost;
+
+// The frame being sent, kept until the Zero acks it
+static uint8_t telemetry_frame[TELEMETRY_FRAME_MAX];
+static size_t telemetry_frame_len;
+static uint8_t telemetry_frame_events;
+
+static node_telemetry_stats_t telemetry_stats;
+
+// Evidence last sent to the site fusion, each channel
+static uint8_t telemetry_evidence[FUSION_CHANNELS];
+
+
+// ############################## [ Local Functions ] ##############################
+
+static uint32_t telemetry_now_ms(void)
+{
+    return (uint32_t)(hal_time_us_64() / 1000);
+}
+
+// Queues an event, dropping the oldest that is not an alert if the queue is
+// full, or the event itself if they all are
+static void telemetry_push(const telemetry_event_t *ev)
+{
+    if (telemetry_count == NODE_TELEMETRY_QUEUE)
+    {
+        uint drop = 0;
+        while (drop < telemetry_count &&
+               telemetry_queue[(telemetry_head + drop) % NODE_TELEMETRY_QUEUE].type == TELEMETRY_ALERT)
+        {
+            drop++;
+        }
+
+        telemetry_lost++;
+        telemetry_stats.lost++;
+
+        if (drop == telemetry_count)
+        {
+            return;
+        }
+
+        // The events before it move up one
+        for (uint i = drop; i > 0; i--)
+        {
+            telemetry_queue[(telemetry_head + i) % NODE_TELEMETRY_QUEUE] =
+                telemetry_queue[(telemetry_head + i - 1) % NODE_TELEMETRY_QUEUE];
+        }
+
+        telemetry_head = (telemetry_head + 1) % NODE_TELEMETRY_QUEUE;
+        telemetry_count--;
+    }
+
+    telemetry_queue[(telemetry_head + telemetry_count) % NODE_TELEMETRY_QUEUE] = *ev;
+    telemetry_count++;
+    telemetry_stats.posted++;
+}
+
+// Takes the next frame's events off the queue and encodes them
+static void telemetry_build(void)
+{
+    telemetry_frame_t frame;
+    uint32_t now_ms = telemetry_now_ms();
+
+    frame.node = telemetry_node;
+    frame.seq = telemetry_seq;
+    frame.time_ms = now_ms;
+    frame.count = 0;
+
+    if (telemetry_lost != 0)
+    {
+        frame.events[frame.count++] = (telemetry_event_t){
+            .type = TELEMETRY_LOST, .arg = 0, .time_ms = now_ms, .value = (int32_t)telemetry_lost
+        };
+        telemetry_lost = 0;
+    }
+
+    while (frame.count < TELEMETRY_MAX_EVENTS && telemetry_count > 0)
+    {
+        frame.events[frame.count++] = telemetry_queue[telemetry_head];
+        telemetry_head = (telemetry_head + 1) % NODE_TELEMETRY_QUEUE;
+        telemetry_count--;
+    }
+
+    telemetry_frame_len = telemetry_frame_encode(telemetry_frame, &frame);
+    telemetry_frame_events = frame.count;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int node_telemetry_init(hal_i2c_t i2c, uint sda_pin, uint scl_pin, uint8_t addr, uint8_t node)
+{
+    telemetry_i2c = i2c;
+    telemetry_addr = addr;
+    telemetry_node = node;
+    telemetry_seq = 0;
+
+    telemetry_head = 0;
+    telemetry_count = 0;
+    telemetry_lost = 0;
+    telemetry_frame_len = 0;
+    telemetry_stats = (node_telemetry_stats_t){0};
+
+    for (int ch = 0; ch < FUSION_CHANNELS; ch++)
+    {
+        telemetry_evidence[ch] = 0;
+    }
+
+    hal_i2c_init(i2c, NODE_ZERO_I2C_BAUD);
+    hal_gpio_set_function(sda_pin, HAL_GPIO_FUNC_I2C);
+    hal_gpio_set_function(scl_pin, HAL_GPIO_FUNC_I2C);
+
+    node_telemetry_post(TELEMETRY_BOOT, TELEMETRY_NODE_KIND(node), 0);
+
+    return 1;
+}
+
+void node_telemetry_post(telemetry_type_t type, uint8_t arg, int32_t value)
+{
+    telemetry_event_t ev = { .type = (uint8_t)type, .arg = arg, .time_ms = telemetry_now_ms(), .value = value };
+    telemetry_push(&ev);
+
+    if (telemetry_count >= TELEMETRY_MAX_EVENTS)
+    {
+        node_telemetry_flush();
+    }
+}
+
+int node_telemetry_alert(const fusion_alert_t *alert)
+{
+    uint32_t value = alert->confidence | (uint32_t)alert->evidence[FUSION_RAIN] << 8 |
+                     (uint32_t)alert->evidence[FUSION_SOIL] << 16 | (uint32_t)alert->evidence[FUSION_SEISMIC] << 24;
+
+    node_telemetry_post(TELEMETRY_ALERT, (uint8_t)alert->grade, (int32_t)value);
+    return node_telemetry_flush();
+}
+
+int node_telemetry_evidence(fusion_channel_t channel, const fusion_alert_t *alert)
+{
+    if (channel >= FUSION_CHANNELS)
+    {
+        return 1;
+    }
+
+    int pct = alert->evidence[channel];
+    int last = telemetry_evidence[channel];
+    bool fresh = (alert->fresh & (1u << channel)) != 0;
+    bool moved = channel == FUSION_SEISMIC ? pct > last
+                                           : pct >= last + NODE_TELEMETRY_EVIDENCE_STEP ||
+                                             pct <= last - NODE_TELEMETRY_EVIDENCE_STEP;
+
+    // The vibration fades the same on both ends, so it is followed as it
+    // fades and only a rise, a new check, is sent
+    if (channel == FUSION_SEISMIC)
+    {
+        telemetry_evidence[channel] = (uint8_t)pct;
+    }
+
+    if (!fresh && !moved && (pct == 0) == (last == 0))
+    {
+        return 1;
+    }
+
+    telemetry_evidence[channel] = (uint8_t)pct;
+    node_telemetry_post(TELEMETRY_EVIDENCE, (uint8_t)(channel | (fresh ? 0x80 : 0)), pct);
+
+    // A raised alert is sent straight after, in the same flush
+    return alert->raise ? 1 : node_telemetry_flush();
+}
+
+int node_telemetry_blob(const uint8_t *src, size_t len)
+{
+    // The blob's frames follow each other with nothing in between
+    if (!node_telemetry_flush())
+    {
+        return 0;
+    }
+
+    for (size_t at = 0; at < len; at += TELEMETRY_BLOB_BYTES)
+    {
+        telemetry_event_t ev = { .type = TELEMETRY_CAPTURE };
+        telemetry_blob_pack(&ev, src + at, len - at < TELEMETRY_BLOB_BYTES ? len - at : TELEMETRY_BLOB_BYTES);
+        telemetry_push(&ev);
+
+        if (telemetry_count == TELEMETRY_MAX_EVENTS && !node_telemetry_flush())
+        {
+            return 0;
+        }
+    }
+
+    if (node_telemetry_flush())
+    {
+        telemetry_stats.blobs++;
+        return 1;
+    }
+
+    return 0;
+}
+
+int node_telemetry_send(const telemetry_event_t *events, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        telemetry_push(&events[i]);
+
+        if (telemetry_count >= TELEMETRY_MAX_EVENTS && !node_telemetry_flush())
+        {
+            return 0;
+        }
+    }
+
+    return node_telemetry_flush();
+}
+
+int node_telemetry_flush(void)
+{
+    while (telemetry_frame_len != 0 || telemetry_count != 0 || telemetry_lost != 0)
+    {
+        if (telemetry_frame_len == 0)
+        {
+            telemetry_build();
+        }
+
+        // Not acked, the same frame goes again next time
+        NODE_PHASE_BEGIN(PHASE_LINK);
+        int written = hal_i2c_write_timeout_us(telemetry_i2c, telemetry_addr, telemetry_frame, telemetry_frame_len,
+                                               false, NODE_ZERO_I2C_TIMEOUT_US);
+        NODE_PHASE_END(PHASE_LINK);
+
+        if (written != (int)telemetry_frame_len)
+        {
+            telemetry_stats.retries++;
+            telemetry_stats.timeouts += written == HAL_ERROR_TIMEOUT;
+            return 0;
+        }
+
+        telemetry_stats.frames++;
+        telemetry_stats.sent += telemetry_frame_events;
+        telemetry_stats.bytes += telemetry_frame_len;
+
+        telemetry_seq++;
+        telemetry_frame_len = 0;
+    }
+
+    return 1;
+}
+
+const node_telemetry_stats_t *node_telemetry_stats(void)
+{
+    return &telemetry_stats;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file    node_time.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   RTC time base of the sensor node, see node_time.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "node_time.h"
+#include "node_phase.h"
+
+// ############################# [ Global Variables ] #############################
+
+// RTC second seen last by node_time_ms() and the timer when it was first seen
+static int64_t time_second;
+static uint64_t time_second_us;
+
+// Last timestamp given out
+static uint64_t time_last_ms;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+static int64_t time_days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static int time_set_rtc(int64_t unix_s)
+{
+    hal_datetime_t t;
+    node_time_from_unix(unix_s, &t);
+
+    if (!hal_rtc_set_datetime(&t))
+    {
+        return 0;
+    }
+
+    // The RTC takes a few of its clock cycles to load a new time
+    hal_busy_wait_ms(1);
+
+    return 1;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int node_time_init(int64_t unix_s)
+{
+    hal_rtc_init();
+
+    time_second = 0;
+    time_second_us = 0;
+    time_last_ms = 0;
+
+    return time_set_rtc(unix_s);
+}
+
+int node_time_set(int64_t unix_s)
+{
+    return time_set_rtc(unix_s);
+}
+
+int64_t node_time_unix(void)
+{
+    hal_datetime_t t;
+
+    if (!hal_rtc_get_datetime(&t))
+    {
+        return 0;
+    }
+
+    return node_time_to_unix(&t);
+}
+
+uint64_t node_time_ms(void)
+{
+    int64_t now_s = node_time_unix();
+    uint64_t now_us = hal_time_us_64();
+    uint64_t ms;
+
+    // The RTC only counts seconds, the timer fills in the milliseconds from
+    // the first time this second was seen. It doesn't run in sleep mode, so
+    // it is only trusted within one second.
+    if (now_s != time_second)
+    {
+        time_second = now_s;
+        time_second_us = now_us;
+    }
+
+    uint64_t sub_ms = (now_us - time_second_us) / 1000;
+    ms = (uint64_t)now_s * 1000 + (sub_ms < 999 ? sub_ms : 999);
+
+    // Never go back
+    if (ms < time_last_ms)
+    {
+        ms = time_last_ms;
+    }
+
+    time_last_ms = ms;
+    return ms;
+}
+
+void node_time_sleep(uint32_t seconds, hal_rtc_callback_t callback)
+{
+    hal_datetime_t alarm;
+
+    node_time_from_unix(node_time_unix() + seconds, &alarm);
+
+    NODE_PHASE_BEGIN(PHASE_SLEEP);
+    hal_sleep_goto_sleep_until(&alarm, callback);
+    NODE_PHASE_WAKE(PHASE_SLEEP);
+}
+
+int node_time_sleep_until_irq(int64_t unix_s, const volatile bool *woken)
+{
+    hal_datetime_t alarm;
+
+    if (node_time_unix() >= unix_s)
+    {
+        return 1;
+    }
+
+    node_time_from_unix(unix_s, &alarm);
+
+    NODE_PHASE_BEGIN(PHASE_SLEEP);
+    hal_sleep_goto_sleep_until_irq(&alarm, woken);
+    NODE_PHASE_WAKE(PHASE_SLEEP);
+
+    return node_time_unix() >= unix_s;
+}
+
+int64_t node_time_to_unix(const hal_datetime_t *t)
+{
+    return time_days_from_civil(t->year, t->month, t->day) * 86400 + t->hour * 3600 + t->min * 60 + t->sec;
+}
+
+void node_time_from_unix(int64_t unix_s, hal_datetime_t *t)
+{
+    int64_t z = (unix_s >= 0 ? unix_s : unix_s - 86399) / 86400;
+    int64_t secs = unix_s - z * 86400;
+
+    t->hour = (int8_t)(secs / 3600);
+    t->min = (int8_t)((secs / 60) % 60);
+    t->sec = (int8_t)(secs % 60);
+    t->dotw = (int8_t)(((z % 7) + 11) % 7);  // 1970-01-01 was a Thursday
+
+    // Civil date from the day number
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    unsigned m = mp < 10 ? mp + 3 : mp - 9;
+
+    t->year = (int16_t)(yoe + era * 400 + (m <= 2));
+    t->month = (int8_t)m;
+    t->day = (int8_t)(doy - (153 * mp + 2) / 5 + 1);
+}
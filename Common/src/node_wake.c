@@ -0,0 +1,279 @@
+/**
+ * @file    node_wake.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Debounced edge triggered wake on a trigger pin, see node_wake.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "node_wake.h"
+#include "node_phase.h"
+#include "node_time.h"
+#include "node_warning.h"
+
+// ############################## [ Local Functions ] ##############################
+
+// Pin interrupt, the waits check the flag after each wake
+static void wake_edge(void *ctx)
+{
+    ((node_wake_t *)ctx)->edge = true;
+}
+
+// Timer interrupt, only wakes the core so the waits check the time
+static void wake_tick(void *ctx)
+{
+    (void)ctx;
+}
+
+// Starts a timer that wakes the core at a time, -1 if there is no time or it
+// has passed
+static int wake_timer(uint64_t until_us)
+{
+    uint64_t now_us = hal_time_us_64();
+
+    if (until_us == 0 || now_us >= until_us)
+    {
+        return -1;
+    }
+
+    return hal_timer_start((uint32_t)(until_us - now_us), wake_tick, NULL);
+}
+
+static bool wake_passed(uint64_t until_us)
+{
+    return until_us != 0 && hal_time_us_64() >= until_us;
+}
+
+// The RTC time a wait until a timer time ends at, rounded up to the second,
+// 0 if there is no time or the RTC is not running
+static int64_t wake_rtc_until(uint64_t until_us)
+{
+    uint64_t now_us = hal_time_us_64();
+    int64_t now_s = node_time_unix();
+
+    if (until_us == 0 || now_s == 0)
+    {
+        return 0;
+    }
+
+    return now_s + (int64_t)((until_us > now_us ? until_us - now_us : 0) + 999999) / 1000000;
+}
+
+// Earliest of two times, 0 being no time
+static uint64_t wake_earliest(uint64_t a_us, uint64_t b_us)
+{
+    if (a_us == 0 || (b_us != 0 && b_us < a_us))
+    {
+        return b_us;
+    }
+
+    return a_us;
+}
+
+// Waits until the line has been low for the hold-off time, returns false if
+// that did not happen by until_us
+static bool wake_holdoff(node_wake_t *wake, uint64_t until_us)
+{
+    uint pin = wake->config.pin;
+
+    while (1)
+    {
+        // Wait for the line to go low
+        if (hal_gpio_get(pin) == 1)
+        {
+            wake->edge = false;
+            hal_gpio_set_irq(pin, HAL_GPIO_EDGE_FALL, wake_edge, wake);
+            int timer = wake_timer(until_us);
+
+            while (hal_gpio_get(pin) == 1 && !wake_passed(until_us))
+            {
+                NODE_PHASE_BEGIN(PHASE_IDLE);
+                hal_wfi();
+                NODE_PHASE_END(PHASE_IDLE);
+            }
+
+            hal_timer_stop(timer);
+            hal_gpio_set_irq(pin, 0, NULL, NULL);
+
+            if (hal_gpio_get(pin) == 1)
+            {
+                return false;
+            }
+        }
+
+        // Then stay low for the hold-off time, a rising edge starts it again
+        wake->edge = false;
+        hal_gpio_set_irq(pin, HAL_GPIO_EDGE_RISE, wake_edge, wake);
+        NODE_PHASE_BEGIN(PHASE_IDLE);
+        hal_sleep_ms(wake->config.holdoff_ms);
+        NODE_PHASE_END(PHASE_IDLE);
+        hal_gpio_set_irq(pin, 0, NULL, NULL);
+
+        if (!wake->edge && hal_gpio_get(pin) == 0)
+        {
+            return true;
+        }
+
+        wake->last_holdoffs++;
+        wake->holdoffs++;
+
+        if (wake_passed(until_us))
+        {
+            return false;
+        }
+    }
+}
+
+// Sleeps until a rising edge, returns false if until_us came first
+static bool wake_sleep(node_wake_t *wake, uint64_t until_us)
+{
+    uint pin = wake->config.pin;
+
+    // No time limit and nothing needing the clocks, sleep as deep as possible
+    if (until_us == 0 && !node_warning_pending())
+    {
+        NODE_PHASE_BEGIN(PHASE_DORMANT);
+        hal_sleep_goto_dormant_until_edge_high(pin);
+        NODE_PHASE_WAKE(PHASE_DORMANT);
+        return true;
+    }
+
+    // Dormant mode would stop the timer, so wait for an interrupt instead.
+    // With the RTC running the Pico sleeps on its alarm, otherwise and while
+    // a warning's LED needs the timer it idles. The pin is read as well as
+    // the flag, an edge between the hold-off and arming the interrupt leaves
+    // the line high without one.
+    wake->edge = false;
+    hal_gpio_set_irq(pin, HAL_GPIO_EDGE_RISE, wake_edge, wake);
+    int timer = wake_timer(until_us);
+    int64_t until_s = wake_rtc_until(until_us);
+
+    while (!wake->edge && hal_gpio_get(pin) == 0 && !wake_passed(until_us))
+    {
+        // The warning has been acked, so the rest of the wait can be dormant
+        if (until_us == 0 && !node_warning_pending())
+        {
+            hal_gpio_set_irq(pin, 0, NULL, NULL);
+            NODE_PHASE_BEGIN(PHASE_DORMANT);
+            hal_sleep_goto_dormant_until_edge_high(pin);
+            NODE_PHASE_WAKE(PHASE_DORMANT);
+            return true;
+        }
+
+        if (until_s != 0 && !node_warning_pending())
+        {
+            // The timer stops in sleep mode, so the RTC says when it is over
+            if (node_time_sleep_until_irq(until_s, &wake->edge))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        NODE_PHASE_BEGIN(PHASE_IDLE);
+        hal_wfi();
+        NODE_PHASE_END(PHASE_IDLE);
+    }
+
+    hal_timer_stop(timer);
+    hal_gpio_set_irq(pin, 0, NULL, NULL);
+
+    return wake->edge || hal_gpio_get(pin) == 1;
+}
+
+// Fills in the end of a wait
+static node_wake_reason_t wake_return(node_wake_t *wake, node_wake_reason_t reason)
+{
+    wake->reason = reason;
+    wake->at_us = hal_time_us_64();
+
+    if (reason == NODE_WAKE_EDGE)
+    {
+        wake->events++;
+    }
+
+    return reason;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void node_wake_init(node_wake_t *wake, const node_wake_config_t *config)
+{
+    wake->config = *config;
+    wake->edge = false;
+
+    wake->reason = NODE_WAKE_NONE;
+    wake->at_us = 0;
+    wake->last_wakes = 0;
+    wake->last_glitches = 0;
+    wake->last_holdoffs = 0;
+
+    wake->events = 0;
+    wake->wakes = 0;
+    wake->glitches = 0;
+    wake->holdoffs = 0;
+}
+
+node_wake_reason_t node_wake_wait(node_wake_t *wake, uint32_t timeout_ms)
+{
+    uint64_t start_us = hal_time_us_64();
+    uint64_t timeout_us = timeout_ms ? start_us + timeout_ms * 1000ull : 0;
+    uint64_t settle_us = wake->config.settle_ms ? start_us + wake->config.settle_ms * 1000ull : 0;
+
+    wake->last_wakes = 0;
+    wake->last_glitches = 0;
+    wake->last_holdoffs = 0;
+
+    // Let the last event die down first
+    if (!wake_holdoff(wake, wake_earliest(timeout_us, settle_us)))
+    {
+        return wake_return(wake, wake_passed(timeout_us) ? NODE_WAKE_TIMEOUT : NODE_WAKE_UNSETTLED);
+    }
+
+    while (1)
+    {
+        if (!wake_sleep(wake, timeout_us))
+        {
+            return wake_return(wake, NODE_WAKE_TIMEOUT);
+        }
+
+        wake->last_wakes++;
+        wake->wakes++;
+
+        // Rounded up, the line has to be high for at least the debounce time
+        NODE_PHASE_BEGIN(PHASE_IDLE);
+        hal_sleep_ms(wake->config.debounce_us / 1000 + 1);
+        NODE_PHASE_END(PHASE_IDLE);
+
+        if (hal_gpio_get(wake->config.pin) == 1)
+        {
+            return wake_return(wake, NODE_WAKE_EDGE);
+        }
+
+        // Gone low again, a glitch
+        wake->last_glitches++;
+        wake->glitches++;
+    }
+}
+
+const char *node_wake_reason_name(node_wake_reason_t reason)
+{
+    switch (reason)
+    {
+        case NODE_WAKE_EDGE:
+            return "edge";
+        case NODE_WAKE_TIMEOUT:
+            return "timeout";
+        case NODE_WAKE_UNSETTLED:
+            return "unsettled";
+        case NODE_WAKE_ACTIVITY:
+            return "activity";
+        case NODE_WAKE_INACTIVITY:
+            return "inactivity";
+        default:
+            return "none";
+    }
+}
@@ -0,0 +1,194 @@
+/**
+ * @file    node_warning.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Event driven warning handshake with the Zero, see node_warning.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "node_warning.h"
+#include "node_config.h"
+#include "node_phase.h"
+
+// ############################# [ Global Variables ] #############################
+
+// Pins and policy
+static uint warning_pin;
+static uint ack_pin;
+static uint led_pin;
+static node_warning_config_t warning_config;
+
+// Handshake, changed by the timer and GPIO interrupts
+static volatile node_warning_state_t warning_state = NODE_WARNING_IDLE;
+static volatile uint32_t warning_ticks;
+static volatile uint8_t warning_retries;
+static volatile bool warning_led;
+static int warning_timer = -1;
+
+static node_warning_stats_t warning_stats;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Drives the warning pin high for a new attempt
+static void warning_attempt(void)
+{
+    warning_ticks = 0;
+    warning_led = true;
+    warning_stats.attempts++;
+
+    hal_gpio_set_dir(warning_pin, HAL_GPIO_OUT);
+    hal_gpio_put(warning_pin, 1);
+    hal_gpio_put(led_pin, 1);
+}
+
+// Drops the warning pin back to high impedance and turns the LED off
+static void warning_release(void)
+{
+    hal_gpio_set_dir(warning_pin, HAL_GPIO_IN);
+    hal_gpio_put(led_pin, 0);
+    warning_led = false;
+}
+
+// Ends the handshake in the given state
+static void warning_finish(node_warning_state_t state)
+{
+    hal_timer_stop(warning_timer);
+    warning_timer = -1;
+
+    warning_release();
+    warning_state = state;
+    NODE_PHASE_STOP(PHASE_HANDSHAKE);
+}
+
+// Timer interrupt every blink_ms, flashes the LED and runs the timeouts
+static void warning_tick(void *ctx)
+{
+    (void)ctx;
+
+    uint32_t elapsed_ms = ++warning_ticks * warning_config.blink_ms;
+
+    if (warning_state == NODE_WARNING_RAISED)
+    {
+        if (elapsed_ms < warning_config.timeout_ms)
+        {
+            warning_led = !warning_led;
+            hal_gpio_put(led_pin, warning_led);
+            return;
+        }
+
+        // No ack in time
+        warning_stats.timeouts++;
+
+        if (warning_retries == 0)
+        {
+            warning_stats.failed++;
+            warning_finish(NODE_WARNING_FAILED);
+            return;
+        }
+
+        warning_retries--;
+        warning_release();
+        warning_ticks = 0;
+        warning_state = NODE_WARNING_BACKOFF;
+    }
+    else if (warning_state == NODE_WARNING_BACKOFF && elapsed_ms >= warning_config.retry_ms)
+    {
+        warning_state = NODE_WARNING_RAISED;
+        warning_attempt();
+    }
+}
+
+// GPIO interrupt on the rising edge of the ack pin
+static void warning_ack(void *ctx)
+{
+    (void)ctx;
+
+    // A late ack during the backoff still means the Zero saw the warning
+    if (warning_state == NODE_WARNING_RAISED || warning_state == NODE_WARNING_BACKOFF)
+    {
+        warning_stats.acked++;
+        warning_finish(NODE_WARNING_ACKED);
+    }
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int node_warning_init(uint WARNING_PIN, uint ACK_PIN, uint LED_PIN, const node_warning_config_t *config)
+{
+    static const node_warning_config_t default_config = {
+        .blink_ms = NODE_WARNING_BLINK_MS,
+        .timeout_ms = NODE_WARNING_TIMEOUT_MS,
+        .retry_ms = NODE_WARNING_RETRY_MS,
+        .retries = NODE_WARNING_RETRIES
+    };
+
+    if (config == NULL)
+    {
+        config = &default_config;
+    }
+
+    if (config->blink_ms == 0)
+    {
+        return 0;
+    }
+
+    warning_pin = WARNING_PIN;
+    ack_pin = ACK_PIN;
+    led_pin = LED_PIN;
+    warning_config = *config;
+    warning_state = NODE_WARNING_IDLE;
+    warning_stats = (node_warning_stats_t){0};
+
+    // The Zero pulses the ack pin high, only the rising edge matters
+    hal_gpio_set_irq(ack_pin, HAL_GPIO_EDGE_RISE, &warning_ack, NULL);
+
+    return 1;
+}
+
+int node_warning_raise(void)
+{
+    // Already waiting for an ack, the Zero knows
+    if (node_warning_pending())
+    {
+        return 1;
+    }
+
+    warning_stats.raised++;
+    warning_retries = warning_config.retries;
+
+    // Set up before the timer can fire
+    NODE_PHASE_START(PHASE_HANDSHAKE);
+    warning_state = NODE_WARNING_RAISED;
+    warning_attempt();
+
+    warning_timer = hal_timer_start(warning_config.blink_ms * 1000, &warning_tick, NULL);
+    if (warning_timer < 0)
+    {
+        warning_release();
+        warning_state = NODE_WARNING_FAILED;
+        NODE_PHASE_STOP(PHASE_HANDSHAKE);
+        return 0;
+    }
+
+    return 1;
+}
+
+node_warning_state_t node_warning_state(void)
+{
+    return warning_state;
+}
+
+bool node_warning_pending(void)
+{
+    node_warning_state_t state = warning_state;
+
+    return state == NODE_WARNING_RAISED || state == NODE_WARNING_BACKOFF;
+}
+
+const node_warning_stats_t *node_warning_stats(void)
+{
+    return &warning_stats;
+}
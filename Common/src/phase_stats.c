@@ -0,0 +1,212 @@
+/**
+ * @file    phase_stats.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Phase timing statistics and their telemetry events, see
+ *          phase_stats.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "phase_stats.h"
+
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+#define PHASE_TEXT(name, text)  text,
+
+static const char *const phase_names[PHASE_COUNT] = {
+    PHASE_LIST(PHASE_TEXT)
+};
+
+// Every part of a phase
+#define PHASE_ALL_PARTS         ((1u << PHASE_STATS_PARTS) - 1)
+
+
+// ############################## [ Local Functions ] ##############################
+
+static void phase_put16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static void phase_put32(uint8_t *dst, uint32_t value)
+{
+    phase_put16(&dst[0], (uint16_t)value);
+    phase_put16(&dst[2], (uint16_t)(value >> 16));
+}
+
+static uint16_t phase_get16(const uint8_t *src)
+{
+    return (uint16_t)(src[0] | src[1] << 8);
+}
+
+static uint32_t phase_get32(const uint8_t *src)
+{
+    return phase_get16(&src[0]) | (uint32_t)phase_get16(&src[2]) << 16;
+}
+
+// Prints a time in the unit that suits it
+static void phase_print_time(FILE *out, double us)
+{
+    if (us < 1000.0)
+    {
+        fprintf(out, "%.0f us", us);
+    }
+    else if (us < 1000000.0)
+    {
+        fprintf(out, "%.3g ms", us / 1000.0);
+    }
+    else if (us < 1e9)
+    {
+        fprintf(out, "%.3g s", us / 1000000.0);
+    }
+    else
+    {
+        fprintf(out, "%.0f s", us / 1000000.0);
+    }
+}
+
+
+// ############################## [ Functions ] ####################################
+
+const char *phase_name(uint32_t phase)
+{
+    return phase < PHASE_COUNT ? phase_names[phase] : "unknown";
+}
+
+uint32_t phase_stats_bucket(uint32_t us)
+{
+    uint32_t bucket = 0;
+
+    while (us != 0 && bucket < PHASE_STATS_BUCKETS - 1)
+    {
+        us >>= 2;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void phase_stats_add(phase_stats_t *stats, uint64_t us)
+{
+    uint32_t us32 = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    uint32_t bucket = phase_stats_bucket(us32);
+
+    if (stats->count == 0 || us32 < stats->min_us)
+    {
+        stats->min_us = us32;
+    }
+
+    if (us32 > stats->max_us)
+    {
+        stats->max_us = us32;
+    }
+
+    stats->count++;
+    stats->total_us += us;
+
+    if (stats->hist[bucket] != UINT16_MAX)
+    {
+        stats->hist[bucket]++;
+    }
+}
+
+void phase_stats_pack(telemetry_event_t *events, uint8_t phase, const phase_stats_t *stats)
+{
+    uint8_t bytes[PHASE_STATS_PARTS * TELEMETRY_BLOB_BYTES] = {0};
+
+    phase_put32(&bytes[0], (uint32_t)stats->total_us);
+    phase_put32(&bytes[4], (uint32_t)(stats->total_us >> 32));
+    phase_put32(&bytes[8], stats->count);
+    phase_put32(&bytes[12], stats->min_us);
+    phase_put32(&bytes[16], stats->max_us);
+
+    for (uint32_t b = 0; b < PHASE_STATS_BUCKETS; b++)
+    {
+        phase_put16(&bytes[20 + 2 * b], stats->hist[b]);
+    }
+
+    for (uint8_t part = 0; part < PHASE_STATS_PARTS; part++)
+    {
+        events[part].type = TELEMETRY_PHASE;
+        telemetry_blob_pack(&events[part], &bytes[part * TELEMETRY_BLOB_BYTES], TELEMETRY_BLOB_BYTES);
+        events[part].arg = PHASE_EVENT_ARG(phase, part);
+    }
+}
+
+int phase_stats_take(phase_stats_rx_t *rx, const telemetry_event_t *ev, phase_stats_t *stats)
+{
+    uint32_t phase = PHASE_EVENT_PHASE(ev->arg);
+    uint32_t part = PHASE_EVENT_PART(ev->arg);
+
+    if (ev->type != TELEMETRY_PHASE || phase >= PHASE_COUNT || part >= PHASE_STATS_PARTS)
+    {
+        return -1;
+    }
+
+    uint8_t *bytes = rx->bytes[phase];
+
+    phase_put32(&bytes[part * TELEMETRY_BLOB_BYTES], ev->time_ms);
+    phase_put32(&bytes[part * TELEMETRY_BLOB_BYTES + 4], (uint32_t)ev->value);
+    rx->have[phase] |= (uint8_t)(1u << part);
+
+    if (rx->have[phase] != PHASE_ALL_PARTS)
+    {
+        return -1;
+    }
+
+    rx->have[phase] = 0;
+
+    stats->total_us = phase_get32(&bytes[0]) | (uint64_t)phase_get32(&bytes[4]) << 32;
+    stats->count = phase_get32(&bytes[8]);
+    stats->min_us = phase_get32(&bytes[12]);
+    stats->max_us = phase_get32(&bytes[16]);
+
+    for (uint32_t b = 0; b < PHASE_STATS_BUCKETS; b++)
+    {
+        stats->hist[b] = phase_get16(&bytes[20 + 2 * b]);
+    }
+
+    return (int)phase;
+}
+
+void phase_stats_print(FILE *out, const char *prefix, uint32_t phase, const phase_stats_t *stats)
+{
+    double mean_us = stats->count ? (double)stats->total_us / stats->count : 0.0;
+
+    fprintf(out, "%s%-13s %8lu times, %12.3f s, min ", prefix, phase_name(phase), (unsigned long)stats->count,
+            stats->total_us / 1e6);
+    phase_print_time(out, stats->min_us);
+    fprintf(out, ", mean ");
+    phase_print_time(out, mean_us);
+    fprintf(out, ", max ");
+    phase_print_time(out, stats->max_us);
+    fprintf(out, "\n%s%-13s ", prefix, "");
+
+    for (uint32_t b = 0; b < PHASE_STATS_BUCKETS; b++)
+    {
+        if (stats->hist[b] == 0)
+        {
+            continue;
+        }
+
+        // Each bucket by the time it ends at
+        if (b == PHASE_STATS_BUCKETS - 1)
+        {
+            fprintf(out, " >=");
+            phase_print_time(out, (double)(1ull << (2 * (b - 1))));
+        }
+        else
+        {
+            fprintf(out, " <");
+            phase_print_time(out, b == 0 ? 1.0 : (double)(1ull << (2 * b)));
+        }
+
+        fprintf(out, ":%u%s", stats->hist[b], stats->hist[b] == UINT16_MAX ? "+" : "");
+    }
+
+    fprintf(out, "\n");
+}
@@ -0,0 +1,107 @@
+/**
+ * @file    rain_rate.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Sliding window rainfall intensity, see rain_rate.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "rain_rate.h"
+
+#include <string.h>
+
+// ############################## [ Functions ] ####################################
+
+int rain_rate_init(rain_rate_t *rate, const rain_rate_config_t *config)
+{
+    if (config->windows == 0 || config->windows > RAIN_RATE_MAX_WINDOWS)
+    {
+        return 0;
+    }
+
+    for (uint8_t w = 0; w < config->windows; w++)
+    {
+        if (config->window[w].len_s == 0 || config->window[w].len_s >= 24 * 24 * 60 * 60)
+        {
+            return 0;
+        }
+    }
+
+    rate->config = *config;
+    rate->head = 0;
+    rate->overflows = 0;
+    memset(rate->tail, 0, sizeof(rate->tail));
+
+    return 1;
+}
+
+void rain_rate_expire(rain_rate_t *rate, uint32_t now_ms)
+{
+    for (uint8_t w = 0; w < rate->config.windows; w++)
+    {
+        uint32_t len_ms = rate->config.window[w].len_s * 1000;
+
+        // Tips are in time order, so stop at the first one still inside
+        while (rate->tail[w] != rate->head &&
+               now_ms - rate->tips[rate->tail[w] % RAIN_RATE_MAX_TIPS] >= len_ms)
+        {
+            rate->tail[w]++;
+        }
+    }
+}
+
+uint32_t rain_rate_over(const rain_rate_t *rate)
+{
+    uint32_t over = 0;
+
+    for (uint8_t w = 0; w < rate->config.windows; w++)
+    {
+        uint32_t warning = rate->config.window[w].warning_tips;
+
+        if (warning != 0 && rain_rate_tips(rate, w) >= warning)
+        {
+            over |= 1u << w;
+        }
+    }
+
+    return over;
+}
+
+uint32_t rain_rate_tip(rain_rate_t *rate, uint32_t now_ms)
+{
+    rain_rate_expire(rate, now_ms);
+
+    // A full buffer drops its oldest tip from every window still holding it
+    for (uint8_t w = 0; w < rate->config.windows; w++)
+    {
+        if (rate->head - rate->tail[w] == RAIN_RATE_MAX_TIPS)
+        {
+            rate->tail[w]++;
+            rate->overflows++;
+        }
+    }
+
+    rate->tips[rate->head % RAIN_RATE_MAX_TIPS] = now_ms;
+    rate->head++;
+
+    return rain_rate_over(rate);
+}
+
+uint32_t rain_rate_intensity_um_h(const rain_rate_t *rate, uint8_t window)
+{
+    return (uint32_t)((uint64_t)rain_rate_depth_um(rate, window) * 3600 / rate->config.window[window].len_s);
+}
+
+bool rain_rate_empty(const rain_rate_t *rate)
+{
+    for (uint8_t w = 0; w < rate->config.windows; w++)
+    {
+        if (rate->tail[w] != rate->head)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,285 @@
+/**
+ * @file    seismic_capture.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Waveform capture around a seismic trigger, see seismic_capture.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "seismic_capture.h"
+#include "seismic_config.h"
+
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// The ring of blocks sits between room for the header and the CRC, so once
+// it is closed the capture is all in one piece
+static uint8_t capture_buf[WAVEFORM_HEADER_LEN + SEISMIC_CAPTURE_BYTES + WAVEFORM_CRC_LEN];
+#define capture_ring    (&capture_buf[WAVEFORM_HEADER_LEN])
+
+static uint16_t capture_rate_hz;
+static uint16_t capture_lsb_per_g;
+static uint32_t capture_pre_samples;
+static uint32_t capture_post_samples;
+
+static seismic_capture_state_t capture_state;
+
+// Blocks in the ring, from the oldest at head
+static uint32_t capture_head;
+static uint32_t capture_used;
+static uint32_t capture_kept;
+
+// Samples waiting to fill a block
+static waveform_sample_t capture_stage[WAVEFORM_BLOCK_SAMPLES];
+static uint32_t capture_staged;
+
+// Set at the trigger
+static uint32_t capture_trigger_ms;
+static uint32_t capture_pre;
+static uint32_t capture_post_left;
+static uint8_t capture_flags;
+
+static seismic_capture_stats_t capture_stats;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Samples and length of the oldest block
+static uint32_t capture_oldest(size_t *len)
+{
+    uint8_t head[3];
+
+    for (uint32_t i = 0; i < sizeof(head); i++)
+    {
+        head[i] = capture_ring[(capture_head + i) % SEISMIC_CAPTURE_BYTES];
+    }
+
+    *len = waveform_block_len(head);
+    return head[0];
+}
+
+static void capture_drop_oldest(void)
+{
+    size_t len;
+    uint32_t n = capture_oldest(&len);
+
+    capture_head = (capture_head + len) % SEISMIC_CAPTURE_BYTES;
+    capture_used -= len;
+    capture_kept -= n;
+}
+
+// Encodes the waiting samples onto the ring, making room if it can
+static bool capture_push(void)
+{
+    uint8_t block[WAVEFORM_BLOCK_MAX];
+    size_t len = waveform_block_encode(block, capture_stage, capture_staged);
+    size_t oldest_len;
+
+    while (capture_used + len > SEISMIC_CAPTURE_BYTES)
+    {
+        uint32_t n = capture_oldest(&oldest_len);
+
+        // Only blocks wholly before the trigger can go once it has come
+        if (capture_state == SEISMIC_CAPTURE_TRIGGERED)
+        {
+            if (capture_pre < n)
+            {
+                return false;
+            }
+
+            capture_pre -= n;
+        }
+
+        capture_drop_oldest();
+        capture_stats.shortened++;
+    }
+
+    uint32_t tail = (capture_head + capture_used) % SEISMIC_CAPTURE_BYTES;
+    size_t first = len < SEISMIC_CAPTURE_BYTES - tail ? len : SEISMIC_CAPTURE_BYTES - tail;
+
+    memcpy(&capture_ring[tail], block, first);
+    memcpy(&capture_ring[0], block + first, len - first);
+
+    capture_used += len;
+    capture_kept += capture_staged;
+    capture_staged = 0;
+
+    // Keep no more before a trigger than asked for
+    while (capture_state == SEISMIC_CAPTURE_ARMED && capture_used > 0)
+    {
+        uint32_t n = capture_oldest(&oldest_len);
+
+        if (capture_kept - n < capture_pre_samples)
+        {
+            break;
+        }
+
+        capture_drop_oldest();
+    }
+
+    return true;
+}
+
+static void capture_reverse(uint8_t *a, size_t len)
+{
+    for (size_t i = 0, j = len - 1; i < j; i++, j--)
+    {
+        uint8_t t = a[i];
+        a[i] = a[j];
+        a[j] = t;
+    }
+}
+
+// Ends the capture: the last samples are encoded, the ring is turned so the
+// oldest block is first and the header and CRC are put round it
+static void capture_finish(void)
+{
+    if (capture_staged > 0 && !capture_push())
+    {
+        capture_flags |= WAVEFORM_TRUNCATED;
+        capture_staged = 0;
+    }
+
+    if (capture_head != 0)
+    {
+        capture_reverse(capture_ring, capture_head);
+        capture_reverse(capture_ring + capture_head, SEISMIC_CAPTURE_BYTES - capture_head);
+        capture_reverse(capture_ring, SEISMIC_CAPTURE_BYTES);
+        capture_head = 0;
+    }
+
+    waveform_header_t header = {
+        .flags = capture_flags,
+        .rate_hz = capture_rate_hz,
+        .lsb_per_g = capture_lsb_per_g,
+        .trigger_ms = capture_trigger_ms,
+        .samples = capture_kept,
+        .pre = capture_pre,
+        .payload = capture_used
+    };
+
+    waveform_header_encode(capture_buf, &header);
+
+    uint16_t crc = telemetry_crc16(0xFFFF, capture_buf, WAVEFORM_HEADER_LEN + capture_used);
+    capture_ring[capture_used] = (uint8_t)crc;
+    capture_ring[capture_used + 1] = (uint8_t)(crc >> 8);
+
+    capture_state = SEISMIC_CAPTURE_DONE;
+    capture_stats.captures++;
+
+    if (capture_flags & WAVEFORM_TRUNCATED)
+    {
+        capture_stats.truncated++;
+    }
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void seismic_capture_init(uint16_t rate_hz, uint16_t lsb_per_g, uint32_t pre_samples, uint32_t post_samples)
+{
+    capture_rate_hz = rate_hz;
+    capture_lsb_per_g = lsb_per_g;
+    capture_pre_samples = pre_samples;
+    capture_post_samples = post_samples;
+    capture_stats = (seismic_capture_stats_t){0};
+
+    seismic_capture_arm();
+}
+
+void seismic_capture_arm(void)
+{
+    capture_state = SEISMIC_CAPTURE_ARMED;
+    capture_head = 0;
+    capture_used = 0;
+    capture_kept = 0;
+    capture_staged = 0;
+    capture_pre = 0;
+    capture_flags = 0;
+}
+
+seismic_capture_state_t seismic_capture_add(const adxl343_sample_t *sample)
+{
+    if (capture_state == SEISMIC_CAPTURE_DONE)
+    {
+        return capture_state;
+    }
+
+    capture_stage[capture_staged++] = (waveform_sample_t){ .x = sample->x, .y = sample->y, .z = sample->z };
+
+    bool post = capture_state == SEISMIC_CAPTURE_TRIGGERED;
+
+    // A block that does not fit after the trigger ends the capture there
+    if (capture_staged == WAVEFORM_BLOCK_SAMPLES && !capture_push())
+    {
+        capture_flags |= WAVEFORM_TRUNCATED;
+        capture_staged = 0;
+        capture_finish();
+        return capture_state;
+    }
+
+    if (post && --capture_post_left == 0)
+    {
+        capture_finish();
+    }
+
+    return capture_state;
+}
+
+void seismic_capture_trigger(uint32_t now_ms)
+{
+    if (capture_state != SEISMIC_CAPTURE_ARMED || capture_kept + capture_staged == 0)
+    {
+        return;
+    }
+
+    capture_state = SEISMIC_CAPTURE_TRIGGERED;
+    capture_trigger_ms = now_ms;
+    capture_pre = capture_kept + capture_staged - 1;
+    capture_post_left = capture_post_samples;
+
+    if (capture_post_left == 0)
+    {
+        capture_finish();
+    }
+}
+
+void seismic_capture_close(void)
+{
+    if (capture_state == SEISMIC_CAPTURE_TRIGGERED)
+    {
+        capture_finish();
+    }
+}
+
+void seismic_capture_cut(void)
+{
+    if (capture_state == SEISMIC_CAPTURE_TRIGGERED)
+    {
+        capture_flags |= WAVEFORM_TRUNCATED;
+        capture_finish();
+    }
+}
+
+seismic_capture_state_t seismic_capture_state(void)
+{
+    return capture_state;
+}
+
+const uint8_t *seismic_capture_get(size_t *len)
+{
+    if (capture_state != SEISMIC_CAPTURE_DONE)
+    {
+        return NULL;
+    }
+
+    *len = WAVEFORM_HEADER_LEN + capture_used + WAVEFORM_CRC_LEN;
+    return capture_buf;
+}
+
+const seismic_capture_stats_t *seismic_capture_stats(void)
+{
+    return &capture_stats;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file    seismic_risk.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Landslide risk check over a window of ADXL343 samples, see
+ *          seismic_risk.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "seismic_risk.h"
+#include "node_phase.h"
+#include "seismic_capture.h"
+#include "seismic_detect.h"
+
+#include <math.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Gravity estimate of the high pass, kept between windows
+static seismic_hp_t risk_hp;
+
+#if SEISMIC_CAPTURE
+// The last check left the acquisition going for the capture
+static bool risk_capturing;
+#endif
+
+
+// ############################## [ Local Functions ] ##############################
+
+// Runs the kernel picked by SEISMIC_DETECTOR on one sample, hp_sq is the
+// sample's squared magnitude with gravity taken off
+static inline int risk_detect(const adxl343_sample_t *sample, uint32_t hp_sq)
+{
+#if SEISMIC_DETECTOR == SEISMIC_DETECT_AXIS
+    (void)hp_sq;
+    return seismic_detect_axis(sample);
+#elif SEISMIC_DETECTOR == SEISMIC_DETECT_HP
+    (void)sample;
+    return hp_sq > SEISMIC_HP_THRESHOLD_SQ;
+#else
+    (void)hp_sq;
+    return seismic_detect_magnitude(sample);
+#endif
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int seismic_risk_init(hal_i2c_t i2c, uint8_t addr, uint int_pin)
+{
+    // Stream mode, by default at the fastest rate the bus can keep up with
+    adxl343_fifo_config_t config = {
+        .rate = SEISMIC_FIFO_RATE,
+        .mode = ADXL343_FIFO_STREAM,
+        .watermark = SEISMIC_FIFO_WATERMARK,
+        .int_pin = int_pin
+    };
+
+#if SEISMIC_CAPTURE
+    seismic_capture_init(ADXL343_RATE_HZ(SEISMIC_FIFO_RATE), SEISMIC_LSB_PER_G, SEISMIC_CAPTURE_PRE,
+                         SEISMIC_CAPTURE_POST);
+#endif
+
+    return adxl343_fifo_init(i2c, addr, &config);
+}
+
+int seismic_risk_check(uint32_t window, seismic_risk_report_t *report)
+{
+    adxl343_sample_t sample;
+    uint32_t peak_sq = 0;
+    uint32_t hp_peak_sq = 0;
+    uint32_t checked = 0;
+    uint64_t decided_us = 0;
+    uint32_t decided_reads = 0;
+    int risk = 0;
+    uint32_t count = window;
+
+    NODE_PHASE_BEGIN(PHASE_DETECT);
+
+#if SEISMIC_CAPTURE
+    // The capture is of this check alone, the samples of the last one were
+    // taken before the node slept. A risk keeps the acquisition going for
+    // the samples after the trigger.
+    seismic_risk_finish();
+    seismic_capture_arm();
+    count += SEISMIC_CAPTURE_POST;
+#endif
+
+    if (adxl343_fifo_start(count) == 0)
+    {
+        NODE_PHASE_END(PHASE_DETECT);
+        return 0;
+    }
+
+    while (adxl343_fifo_next(&sample))
+    {
+        uint32_t mag_sq = seismic_magnitude_sq(&sample);
+
+        if (mag_sq > peak_sq)
+        {
+            peak_sq = mag_sq;
+        }
+
+        uint32_t hp_sq = seismic_hp_energy(&risk_hp, &sample);
+
+        if (hp_sq > hp_peak_sq)
+        {
+            hp_peak_sq = hp_sq;
+        }
+
+#if SEISMIC_CAPTURE
+        // Samples were dropped before this one, the ones kept before them
+        // would not line up with the trigger
+        if (adxl343_fifo_lost())
+        {
+            seismic_capture_arm();
+        }
+
+        seismic_capture_add(&sample);
+#endif
+
+        checked++;
+
+        if (risk_detect(&sample, hp_sq))
+        {
+            risk = 1;
+            decided_us = hal_time_us_64();
+            decided_reads = adxl343_fifo_stats()->reads;
+
+#if SEISMIC_CAPTURE
+            // The samples after the trigger are left to seismic_risk_finish()
+            seismic_capture_trigger((uint32_t)(decided_us / 1000));
+            if (seismic_capture_state() != SEISMIC_CAPTURE_DONE)
+            {
+                risk_capturing = true;
+                break;
+            }
+#endif
+
+            adxl343_fifo_stop();
+            break;
+        }
+
+        // The extra samples are only for the capture
+        if (checked == window)
+        {
+            adxl343_fifo_stop();
+            break;
+        }
+    }
+
+#if SEISMIC_CAPTURE
+    // The acquisition ended before every sample after the trigger came
+    if (!risk_capturing)
+    {
+        seismic_capture_close();
+    }
+#endif
+
+    if (report != NULL)
+    {
+        const adxl343_fifo_stats_t *stats = adxl343_fifo_stats();
+
+        report->samples = stats->samples;
+        report->checked = checked;
+        report->reads = risk ? decided_reads : stats->reads;
+
+        // The only square roots are for the report, once per window
+        report->peak_g = sqrtf((float)peak_sq) / SEISMIC_LSB_PER_G;
+        report->dynamic_mg = (uint32_t)(sqrtf((float)hp_peak_sq) * 1000.0f / SEISMIC_LSB_PER_G);
+        report->awake_us = (risk ? decided_us : stats->end_us) - stats->start_us;
+    }
+
+    NODE_PHASE_END(PHASE_DETECT);
+    return risk;
+}
+
+uint32_t seismic_risk_finish(void)
+{
+    uint32_t taken = 0;
+
+#if SEISMIC_CAPTURE
+    adxl343_sample_t sample;
+
+    if (!risk_capturing)
+    {
+        return 0;
+    }
+
+    risk_capturing = false;
+
+    while (adxl343_fifo_next(&sample))
+    {
+        // The capture stops at the first hole, after it the samples would
+        // not line up with the trigger
+        if (adxl343_fifo_lost())
+        {
+            break;
+        }
+
+        taken++;
+
+        if (seismic_capture_add(&sample) == SEISMIC_CAPTURE_DONE)
+        {
+            adxl343_fifo_stop();
+            break;
+        }
+    }
+
+    if (adxl343_fifo_lost())
+    {
+        adxl343_fifo_stop();
+        seismic_capture_cut();
+    }
+    else
+    {
+        seismic_capture_close();
+    }
+#endif
+
+    return taken;
+}
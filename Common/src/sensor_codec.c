@@ -0,0 +1,368 @@
+/**
+ * @file    sensor_codec.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Compression of sensor reading batches, see sensor_codec.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "sensor_codec.h"
+
+// ############################# [ Global Variables ] #############################
+
+// Longest rain block, every interval escaped
+#define SENSOR_RAIN_BLOCK_MAX   ((5 + SENSOR_CODEC_BLOCK * BITS_RICE_MAX + 7) / 8)
+
+
+// ############################## [ Local Functions ] ##############################
+
+// The Rice parameter that takes the fewest bits for the values. Below the
+// width of the smallest value less one every quotient is 2 or more, so a
+// bigger k saves at least the bit it adds to each value, and once every
+// value fits in k bits a bigger k only adds bits.
+static uint32_t codec_rice_k(const uint32_t *values, uint32_t n)
+{
+    uint32_t low = UINT32_MAX;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        low = values[i] < low ? values[i] : low;
+    }
+
+    uint32_t k = bits_width(low);
+    k = k > 0 ? k - 1 : 0;
+
+    uint32_t best_k = k;
+    uint32_t best = UINT32_MAX;
+
+    for (; k < 32; k++)
+    {
+        uint32_t bits = 0;
+        uint32_t high = 0;
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint32_t q = values[i] >> k;
+            bits += q < BITS_RICE_ESCAPE ? q + 1 + k : BITS_RICE_ESCAPE + 5 + bits_width(values[i]);
+            high |= q;
+        }
+
+        if (bits < best)
+        {
+            best = bits;
+            best_k = k;
+        }
+
+        if (high == 0)
+        {
+            break;
+        }
+    }
+
+    return best_k;
+}
+
+// Bytes the blocks already take, counting a part byte
+static size_t codec_used(const sensor_codec_t *codec)
+{
+    return (size_t)(codec->w.dst - codec->dst) + (codec->w.bits > 0);
+}
+
+// Whether a reading of the kind can be taken
+static bool codec_room(sensor_codec_t *codec, sensor_codec_kind_t kind)
+{
+    if (codec->kind != kind || codec->count == SENSOR_CODEC_MAX)
+    {
+        return false;
+    }
+
+    // A block is only started if it fits however badly it packs
+    if (codec->staged == 0)
+    {
+        size_t worst = kind == SENSOR_CODEC_ACCEL ? WAVEFORM_BLOCK_MAX :
+                       kind == SENSOR_CODEC_SOIL ? SENSOR_CODEC_BLOCK_MAX : SENSOR_RAIN_BLOCK_MAX;
+
+        if (codec->cap - codec_used(codec) < worst)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void codec_soil_block(sensor_codec_t *codec)
+{
+    uint32_t times[SENSOR_CODEC_BLOCK];
+    uint32_t moistures[SENSOR_CODEC_BLOCK];
+    uint32_t n = codec->staged;
+
+    // The change in the interval and in the moisture, wrapping as the node's
+    // time does
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const sensor_soil_t *reading = &codec->stage.soil[i];
+        uint32_t interval = reading->time_ms - codec->last_ms;
+
+        times[i] = bits_zigzag((int32_t)(interval - codec->last_interval));
+        moistures[i] = bits_zigzag((int32_t)((uint32_t)reading->moisture - (uint32_t)codec->last_moisture));
+
+        codec->last_ms = reading->time_ms;
+        codec->last_interval = interval;
+        codec->last_moisture = reading->moisture;
+    }
+
+    uint32_t kt = codec_rice_k(times, n);
+    uint32_t km = codec_rice_k(moistures, n);
+
+    bits_write(&codec->w, kt, 5);
+    bits_write(&codec->w, km, 5);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        bits_write_rice(&codec->w, times[i], kt);
+        bits_write_rice(&codec->w, moistures[i], km);
+    }
+}
+
+static void codec_rain_block(sensor_codec_t *codec)
+{
+    uint32_t intervals[SENSOR_CODEC_BLOCK];
+    uint32_t n = codec->staged;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        intervals[i] = codec->stage.tip_ms[i] - codec->last_ms;
+        codec->last_ms = codec->stage.tip_ms[i];
+    }
+
+    uint32_t k = codec_rice_k(intervals, n);
+
+    bits_write(&codec->w, k, 5);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        bits_write_rice(&codec->w, intervals[i], k);
+    }
+}
+
+// Encodes the waiting readings
+static void codec_block(sensor_codec_t *codec)
+{
+    if (codec->staged == 0)
+    {
+        return;
+    }
+
+    switch (codec->kind)
+    {
+        case SENSOR_CODEC_ACCEL:
+            codec->w.dst += waveform_block_encode(codec->w.dst, codec->stage.accel, codec->staged);
+            break;
+        case SENSOR_CODEC_SOIL:
+            codec_soil_block(codec);
+            break;
+        case SENSOR_CODEC_RAIN:
+            codec_rain_block(codec);
+            break;
+    }
+
+    codec->staged = 0;
+}
+
+static int32_t codec_decode_accel(const uint8_t *at, const uint8_t *end, uint32_t n, sensor_value_fn_t fn,
+                                  void *ctx)
+{
+    waveform_sample_t samples[WAVEFORM_BLOCK_SAMPLES];
+    sensor_value_t value = { 0 };
+    uint32_t count = 0;
+
+    while (count < n)
+    {
+        // A block can not run past the end or hold more than is left
+        size_t len = end - at >= WAVEFORM_BLOCK_HEADER ? waveform_block_len(at) : 0;
+        if (len == 0 || len > (size_t)(end - at) || at[0] > n - count)
+        {
+            return -1;
+        }
+
+        uint32_t got = waveform_block_decode(at, samples);
+        for (uint32_t i = 0; i < got && fn != NULL; i++)
+        {
+            value.accel = samples[i];
+            fn(ctx, count + i, &value);
+        }
+
+        count += got;
+        at += len;
+    }
+
+    return at == end ? (int32_t)count : -1;
+}
+
+static int32_t codec_decode_bits(sensor_codec_kind_t kind, const uint8_t *at, const uint8_t *end, uint32_t n,
+                                 sensor_value_fn_t fn, void *ctx)
+{
+    bits_reader_t r;
+    sensor_value_t value = { 0 };
+    uint32_t last_ms = 0;
+    uint32_t last_interval = 0;
+    int32_t last_moisture = 0;
+
+    bits_reader_init(&r, at, end);
+
+    for (uint32_t count = 0; count < n; count += SENSOR_CODEC_BLOCK)
+    {
+        uint32_t block = n - count < SENSOR_CODEC_BLOCK ? n - count : SENSOR_CODEC_BLOCK;
+        uint32_t kt = bits_read(&r, 5);
+        uint32_t km = kind == SENSOR_CODEC_SOIL ? bits_read(&r, 5) : 0;
+
+        for (uint32_t i = 0; i < block; i++)
+        {
+            if (kind == SENSOR_CODEC_SOIL)
+            {
+                last_interval += (uint32_t)bits_unzigzag(bits_read_rice(&r, kt));
+                last_ms += last_interval;
+                last_moisture = (int32_t)((uint32_t)last_moisture + (uint32_t)bits_unzigzag(bits_read_rice(&r, km)));
+
+                value.soil.time_ms = last_ms;
+                value.soil.moisture = last_moisture;
+            }
+            else
+            {
+                last_ms += bits_read_rice(&r, kt);
+                value.tip_ms = last_ms;
+            }
+
+            if (r.over)
+            {
+                return -1;
+            }
+
+            if (fn != NULL)
+            {
+                fn(ctx, count + i, &value);
+            }
+        }
+    }
+
+    // Nothing may follow the last block but its padding
+    return r.src == end ? (int32_t)n : -1;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+void sensor_codec_init(sensor_codec_t *codec, sensor_codec_kind_t kind, uint8_t *dst, size_t cap)
+{
+    codec->kind = kind;
+    codec->dst = dst;
+    codec->cap = cap;
+    codec->count = 0;
+    codec->staged = 0;
+    codec->last_ms = 0;
+    codec->last_interval = 0;
+    codec->last_moisture = 0;
+
+    bits_writer_init(&codec->w, dst + SENSOR_CODEC_HEADER);
+}
+
+bool sensor_codec_accel(sensor_codec_t *codec, const waveform_sample_t *sample)
+{
+    if (!codec_room(codec, SENSOR_CODEC_ACCEL))
+    {
+        return false;
+    }
+
+    codec->stage.accel[codec->staged++] = *sample;
+    codec->count++;
+
+    if (codec->staged == SENSOR_CODEC_BLOCK)
+    {
+        codec_block(codec);
+    }
+
+    return true;
+}
+
+bool sensor_codec_soil(sensor_codec_t *codec, uint32_t time_ms, int32_t moisture)
+{
+    if (!codec_room(codec, SENSOR_CODEC_SOIL))
+    {
+        return false;
+    }
+
+    codec->stage.soil[codec->staged++] = (sensor_soil_t){ .time_ms = time_ms, .moisture = moisture };
+    codec->count++;
+
+    if (codec->staged == SENSOR_CODEC_BLOCK)
+    {
+        codec_block(codec);
+    }
+
+    return true;
+}
+
+bool sensor_codec_rain(sensor_codec_t *codec, uint32_t tip_ms)
+{
+    if (!codec_room(codec, SENSOR_CODEC_RAIN))
+    {
+        return false;
+    }
+
+    codec->stage.tip_ms[codec->staged++] = tip_ms;
+    codec->count++;
+
+    if (codec->staged == SENSOR_CODEC_BLOCK)
+    {
+        codec_block(codec);
+    }
+
+    return true;
+}
+
+size_t sensor_codec_finish(sensor_codec_t *codec)
+{
+    codec_block(codec);
+
+    codec->dst[0] = (uint8_t)codec->kind;
+    codec->dst[1] = (uint8_t)codec->count;
+    codec->dst[2] = (uint8_t)(codec->count >> 8);
+
+    return (size_t)(bits_flush(&codec->w) - codec->dst);
+}
+
+int32_t sensor_codec_decode(const uint8_t *src, size_t len, sensor_value_fn_t fn, void *ctx,
+                            sensor_codec_kind_t *kind)
+{
+    if (len < SENSOR_CODEC_HEADER)
+    {
+        return -1;
+    }
+
+    sensor_codec_kind_t k = (sensor_codec_kind_t)src[0];
+    uint32_t n = (uint32_t)(src[1] | (src[2] << 8));
+    const uint8_t *end = src + len;
+    int32_t count;
+
+    switch (k)
+    {
+        case SENSOR_CODEC_ACCEL:
+            count = codec_decode_accel(src + SENSOR_CODEC_HEADER, end, n, fn, ctx);
+            break;
+        case SENSOR_CODEC_SOIL:
+        case SENSOR_CODEC_RAIN:
+            count = codec_decode_bits(k, src + SENSOR_CODEC_HEADER, end, n, fn, ctx);
+            break;
+        default:
+            return -1;
+    }
+
+    if (count >= 0 && kind != NULL)
+    {
+        *kind = k;
+    }
+
+    return count;
+}
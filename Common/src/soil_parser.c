@@ -0,0 +1,180 @@
+/**
+ * @file    soil_parser.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Table driven soil probe answer parser, see soil_parser.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "soil_parser.h"
+
+// ############################# [ Global Variables ] #############################
+
+// Classes of byte the parser tells apart, one for each letter of "Moisture"
+enum
+{
+    C_OTHER,
+    C_M, C_O, C_I, C_S, C_T, C_U, C_R, C_E,
+    C_EQ,
+    C_DIGIT,
+    C_CR,
+    C_LF,
+    C_COUNT
+};
+
+// Parser states. The ones from S_EMIT_OK on end a line, the parser goes back
+// to S_KEY0 after them.
+enum
+{
+    S_KEY0,                     // Start of a line
+    S_KEY1, S_KEY2, S_KEY3,     // Part of "Moisture" matched
+    S_KEY4, S_KEY5, S_KEY6, S_KEY7,
+    S_EQ,                       // "Moisture" matched, waiting for the '='
+    S_VAL0,                     // '=' matched, waiting for the first digit
+    S_D1, S_D2, S_D3, S_D4,     // Digits read
+    S_CR,                       // '\r' after the value, waiting for the '\n'
+    S_BAD,                      // Not a frame, waiting for the '\n'
+    S_LONG,                     // Too many digits, waiting for the '\n'
+    S_EMIT_OK,
+    S_EMIT_MALFORMED,
+    S_EMIT_OVERFLOW,
+    S_COUNT
+};
+
+// Class of every byte, anything not listed is C_OTHER
+static const uint8_t parser_class[256] =
+{
+    ['M'] = C_M, ['o'] = C_O, ['i'] = C_I, ['s'] = C_S,
+    ['t'] = C_T, ['u'] = C_U, ['r'] = C_R, ['e'] = C_E,
+    ['='] = C_EQ,
+    ['0'] = C_DIGIT, ['1'] = C_DIGIT, ['2'] = C_DIGIT, ['3'] = C_DIGIT, ['4'] = C_DIGIT,
+    ['5'] = C_DIGIT, ['6'] = C_DIGIT, ['7'] = C_DIGIT, ['8'] = C_DIGIT, ['9'] = C_DIGIT,
+    ['\r'] = C_CR,
+    ['\n'] = C_LF
+};
+
+// Short names so the table below lines up
+#define B   S_BAD
+#define L   S_LONG
+#define OK  S_EMIT_OK
+#define EM  S_EMIT_MALFORMED
+#define EO  S_EMIT_OVERFLOW
+
+// Next state for every state and byte class
+static const uint8_t parser_next[S_COUNT][C_COUNT] =
+{
+    //               other  M       o       i       s       t       u       r       e       =       digit   \r      \n
+    [S_KEY0]   =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      B,      B,      S_KEY0, S_KEY0 },
+    [S_KEY1]   =   { B,     S_KEY1, S_KEY2, B,      B,      B,      B,      B,      B,      B,      B,      B,      EM     },
+    [S_KEY2]   =   { B,     S_KEY1, B,      S_KEY3, B,      B,      B,      B,      B,      B,      B,      B,      EM     },
+    [S_KEY3]   =   { B,     S_KEY1, B,      B,      S_KEY4, B,      B,      B,      B,      B,      B,      B,      EM     },
+    [S_KEY4]   =   { B,     S_KEY1, B,      B,      B,      S_KEY5, B,      B,      B,      B,      B,      B,      EM     },
+    [S_KEY5]   =   { B,     S_KEY1, B,      B,      B,      B,      S_KEY6, B,      B,      B,      B,      B,      EM     },
+    [S_KEY6]   =   { B,     S_KEY1, B,      B,      B,      B,      B,      S_KEY7, B,      B,      B,      B,      EM     },
+    [S_KEY7]   =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      S_EQ,   B,      B,      B,      EM     },
+    [S_EQ]     =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      S_VAL0, B,      B,      EM     },
+    [S_VAL0]   =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      B,      S_D1,   B,      EM     },
+    [S_D1]     =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      B,      S_D2,   S_CR,   OK     },
+    [S_D2]     =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      B,      S_D3,   S_CR,   OK     },
+    [S_D3]     =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      B,      S_D4,   S_CR,   OK     },
+    [S_D4]     =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      B,      L,      S_CR,   OK     },
+    [S_CR]     =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      B,      B,      B,      OK     },
+    [S_BAD]    =   { B,     S_KEY1, B,      B,      B,      B,      B,      B,      B,      B,      B,      B,      EM     },
+    [S_LONG]   =   { L,     S_KEY1, L,      L,      L,      L,      L,      L,      L,      L,      L,      L,      EO     },
+};
+
+#undef B
+#undef L
+#undef OK
+#undef EM
+#undef EO
+
+
+// ############################## [ Functions ] ####################################
+
+void soil_parser_init(soil_parser_t *parser)
+{
+    parser->frames = 0;
+    parser->malformed = 0;
+    parser->overflows = 0;
+    parser->resyncs = 0;
+    parser->value = 0;
+
+    soil_parser_reset(parser);
+}
+
+void soil_parser_reset(soil_parser_t *parser)
+{
+    parser->state = S_KEY0;
+}
+
+// Ends a line, counting how it ended
+static soil_parse_status_t parser_emit(soil_parser_t *parser, uint8_t next)
+{
+    parser->state = S_KEY0;
+
+    switch (next)
+    {
+        case S_EMIT_OK:
+            parser->frames++;
+            return SOIL_PARSE_OK;
+
+        case S_EMIT_OVERFLOW:
+            parser->overflows++;
+            return SOIL_PARSE_OVERFLOW;
+
+        default:
+            parser->malformed++;
+            return SOIL_PARSE_MALFORMED;
+    }
+}
+
+soil_parse_status_t soil_parser_feed(soil_parser_t *parser, uint8_t c)
+{
+    soil_parse_status_t status;
+
+    soil_parser_feed_buf(parser, &c, 1, &status);
+    return status;
+}
+
+size_t soil_parser_feed_buf(soil_parser_t *parser, const uint8_t *buf, size_t len, soil_parse_status_t *status)
+{
+    // Kept in locals so the compiler can hold them in registers, the buffer
+    // could alias the parser as far as it knows
+    uint8_t state = parser->state;
+    uint16_t value = parser->value;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t c = buf[i];
+        uint8_t next = parser_next[state][parser_class[c]];
+
+        // Most bytes only move the parser along the frame
+        if (next >= S_D1 && next <= S_D4)
+        {
+            value = (uint16_t)(value * 10 + (c - '0'));
+        }
+        else if (next == S_VAL0)
+        {
+            value = 0;
+        }
+        else if (next == S_KEY1 && state != S_KEY0)
+        {
+            parser->resyncs++;
+        }
+        else if (next >= S_EMIT_OK)
+        {
+            parser->value = value;
+            *status = parser_emit(parser, next);
+            return i + 1;
+        }
+
+        state = next;
+    }
+
+    parser->state = state;
+    parser->value = value;
+    *status = SOIL_PARSE_MORE;
+    return len;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file    soil_probe.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Interrupt driven soil moisture probe driver, see soil_probe.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "soil_probe.h"
+#include "node_phase.h"
+#include "soil_parser.h"
+
+// ############################# [ Global Variables ] #############################
+
+// Bus the probe is on
+static hal_uart_t probe_uart;
+
+// Ring buffer written by the UART interrupt and read by the core
+static uint8_t probe_ring[SOIL_PROBE_RING_SIZE];
+static volatile uint32_t probe_head;
+static volatile uint32_t probe_tail;
+
+// Set by the timer when a read has waited too long
+static volatile bool probe_timed_out;
+
+// Parses the answer as it comes in
+static soil_parser_t probe_parser;
+
+static soil_probe_stats_t probe_stats;
+
+
+// ############################## [ Local Functions ] ##############################
+
+// UART interrupt, moves every waiting byte into the ring buffer
+static void probe_rx_irq(void *ctx)
+{
+    (void)ctx;
+
+    while (hal_uart_is_readable(probe_uart))
+    {
+        uint8_t c = (uint8_t)hal_uart_getc(probe_uart);
+
+        if (probe_head - probe_tail == SOIL_PROBE_RING_SIZE)
+        {
+            probe_stats.overruns++;
+            continue;
+        }
+
+        probe_ring[probe_head % SOIL_PROBE_RING_SIZE] = c;
+        probe_head++;
+    }
+}
+
+static void probe_timeout_irq(void *ctx)
+{
+    (void)ctx;
+    probe_timed_out = true;
+}
+
+// One request, sends 'w' and waits for the end of the answer line
+static soil_probe_status_t probe_request(int *moisture, uint32_t timeout_ms)
+{
+    soil_parse_status_t status = SOIL_PARSE_MORE;
+    uint64_t start_us = hal_time_us_64();
+
+    // Anything left over belongs to an earlier answer
+    probe_tail = probe_head;
+    soil_parser_reset(&probe_parser);
+    probe_timed_out = false;
+
+    int timer = hal_timer_start(timeout_ms * 1000, &probe_timeout_irq, NULL);
+    if (timer < 0)
+    {
+        probe_stats.timeouts++;
+        return SOIL_PROBE_TIMEOUT;
+    }
+
+    hal_uart_putc_raw(probe_uart, 'w');
+    probe_stats.requests++;
+
+    // Sleep until bytes arrive, parsing them as they come
+    while (status == SOIL_PARSE_MORE)
+    {
+        while (probe_tail != probe_head && status == SOIL_PARSE_MORE)
+        {
+            status = soil_parser_feed(&probe_parser, probe_ring[probe_tail % SOIL_PROBE_RING_SIZE]);
+            probe_tail++;
+        }
+
+        if (status != SOIL_PARSE_MORE || probe_timed_out)
+        {
+            break;
+        }
+
+        NODE_PHASE_BEGIN(PHASE_IDLE);
+        hal_wfi();
+        NODE_PHASE_END(PHASE_IDLE);
+    }
+
+    hal_timer_stop(timer);
+    probe_stats.wait_us += hal_time_us_64() - start_us;
+
+    switch (status)
+    {
+        case SOIL_PARSE_OK:
+            *moisture = soil_parser_value(&probe_parser);
+            probe_stats.ok++;
+            return SOIL_PROBE_OK;
+
+        case SOIL_PARSE_MORE:
+            probe_stats.timeouts++;
+            return SOIL_PROBE_TIMEOUT;
+
+        default:
+            probe_stats.malformed++;
+            return SOIL_PROBE_MALFORMED;
+    }
+}
+
+
+// ############################## [ Functions ] ####################################
+
+int soil_probe_init(hal_uart_t uart, uint tx_pin, uint rx_pin, uint baudrate, uint32_t boot_ms)
+{
+    probe_uart = uart;
+    probe_head = 0;
+    probe_tail = 0;
+    probe_stats = (soil_probe_stats_t){0};
+    soil_parser_init(&probe_parser);
+
+    // Set up the UART bus
+    hal_uart_init(uart, baudrate);
+    hal_gpio_set_function(tx_pin, HAL_GPIO_FUNC_UART);
+    hal_gpio_set_function(rx_pin, HAL_GPIO_FUNC_UART);
+
+    // Every byte received goes into the ring buffer
+    hal_uart_set_irq(uart, &probe_rx_irq, NULL);
+
+    // Wait for the soil sensor to boot up
+    hal_sleep_ms(boot_ms);
+
+    // Send a l to the soil sensor to set it up
+    hal_uart_putc_raw(uart, 'l');
+
+    return 1;
+}
+
+soil_probe_status_t soil_probe_read(int *moisture, uint32_t timeout_ms, uint8_t attempts)
+{
+    soil_probe_status_t status = SOIL_PROBE_TIMEOUT;
+
+    NODE_PHASE_BEGIN(PHASE_PROBE);
+
+    for (uint8_t i = 0; i < attempts && status != SOIL_PROBE_OK; i++)
+    {
+        status = probe_request(moisture, timeout_ms);
+    }
+
+    NODE_PHASE_END(PHASE_PROBE);
+    return status;
+}
+
+const soil_probe_stats_t *soil_probe_stats(void)
+{
+    return &probe_stats;
+}
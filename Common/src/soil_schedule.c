@@ -0,0 +1,84 @@
+/**
+ * @file    soil_schedule.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Adaptive soil wake interval, see soil_schedule.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "soil_schedule.h"
+
+// ############################## [ Functions ] ####################################
+
+int soil_schedule_init(soil_schedule_t *sched, const soil_schedule_config_t *config)
+{
+    if (config->min_s == 0 || config->max_s < config->min_s || config->step == 0)
+    {
+        return 0;
+    }
+
+    sched->config = *config;
+    sched->interval_s = config->min_s;
+    sched->last = 0;
+    sched->primed = false;
+
+    return 1;
+}
+
+uint32_t soil_schedule_next(soil_schedule_t *sched, int moisture)
+{
+    const soil_schedule_config_t *cfg = &sched->config;
+
+    // The first wake has nothing to compare with
+    if (!sched->primed)
+    {
+        sched->primed = true;
+        sched->last = moisture;
+        return sched->interval_s;
+    }
+
+    int delta = moisture - sched->last;
+    uint32_t change = (uint32_t)(delta < 0 ? -delta : delta);
+    uint64_t next;
+
+    sched->last = moisture;
+
+    // Stay alert while there is a risk
+    if (moisture > cfg->threshold)
+    {
+        sched->interval_s = cfg->min_s;
+        return sched->interval_s;
+    }
+
+    // Aim for step units of change between wakes
+    next = change == 0 ? cfg->max_s : (uint64_t)sched->interval_s * cfg->step / change;
+
+    // Wake at least twice before the threshold at the current rate
+    if (delta > 0)
+    {
+        uint64_t to_threshold = (uint64_t)sched->interval_s * (uint32_t)(cfg->threshold - moisture) / (uint32_t)delta;
+        if (next > to_threshold / 2)
+        {
+            next = to_threshold / 2;
+        }
+    }
+
+    // Lengthen gradually
+    if (next > 2 * (uint64_t)sched->interval_s)
+    {
+        next = 2 * (uint64_t)sched->interval_s;
+    }
+
+    if (next < cfg->min_s)
+    {
+        next = cfg->min_s;
+    }
+    else if (next > cfg->max_s)
+    {
+        next = cfg->max_s;
+    }
+
+    sched->interval_s = (uint32_t)next;
+    return sched->interval_s;
+}
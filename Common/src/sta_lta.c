@@ -0,0 +1,91 @@
+/**
+ * @file    sta_lta.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Streaming STA/LTA event detector, see sta_lta.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "sta_lta.h"
+
+#include <string.h>
+
+// ############################## [ Functions ] ####################################
+
+int sta_lta_init(sta_lta_t *det, const sta_lta_config_t *config)
+{
+    if (config->sta_len == 0 || config->sta_len > STA_LTA_MAX_STA ||
+        config->lta_len < config->sta_len || config->lta_len > STA_LTA_MAX_LTA)
+    {
+        return 0;
+    }
+
+    det->config = *config;
+    sta_lta_reset(det);
+
+    return 1;
+}
+
+void sta_lta_reset(sta_lta_t *det)
+{
+    memset(det->sta_buf, 0, sizeof(det->sta_buf));
+    memset(det->lta_buf, 0, sizeof(det->lta_buf));
+    det->sta_sum = 0;
+    det->lta_sum = 0;
+    det->sta_pos = 0;
+    det->lta_pos = 0;
+    det->count = 0;
+    det->active = false;
+}
+
+sta_lta_event_t sta_lta_update(sta_lta_t *det, uint32_t value)
+{
+    const sta_lta_config_t *cfg = &det->config;
+
+    // Swap the oldest sample in the short window for the new one
+    det->sta_sum += value - (uint64_t)det->sta_buf[det->sta_pos];
+    det->sta_buf[det->sta_pos] = value;
+    det->sta_pos = det->sta_pos + 1 == cfg->sta_len ? 0 : det->sta_pos + 1;
+
+    // The long window stands still during an event so the event itself
+    // doesn't become the background it is measured against
+    if (!det->active)
+    {
+        det->lta_sum += value - (uint64_t)det->lta_buf[det->lta_pos];
+        det->lta_buf[det->lta_pos] = value;
+        det->lta_pos = det->lta_pos + 1 == cfg->lta_len ? 0 : det->lta_pos + 1;
+
+        if (det->count < cfg->lta_len)
+        {
+            det->count++;
+            return STA_LTA_NONE;
+        }
+    }
+
+    // Compare sta_sum / sta_len against ratio * lta_sum / lta_len without
+    // dividing, the floor keeps a quiet background from making the ratio huge
+    uint64_t lta_sum = det->lta_sum;
+    uint64_t floor_sum = (uint64_t)cfg->lta_floor * cfg->lta_len;
+    if (lta_sum < floor_sum)
+    {
+        lta_sum = floor_sum;
+    }
+
+    uint64_t sta_scaled = det->sta_sum * cfg->lta_len * 256;
+    uint64_t lta_scaled = lta_sum * cfg->sta_len;
+
+    if (!det->active && sta_scaled > lta_scaled * cfg->trigger)
+    {
+        det->active = true;
+        return STA_LTA_TRIGGER;
+    }
+
+    if (det->active && sta_scaled < lta_scaled * cfg->detrigger)
+    {
+        det->active = false;
+        return STA_LTA_DETRIGGER;
+    }
+
+    return STA_LTA_NONE;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file    telemetry_frame.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Telemetry link frames, see telemetry_frame.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "telemetry_frame.h"
+
+#include <string.h>
+
+// ############################# [ Global Variables ] #############################
+
+// CRC-16/CCITT-FALSE of each nibble
+static const uint16_t frame_crc_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+
+// ############################## [ Local Functions ] ##############################
+
+static void frame_put16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static void frame_put32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+static uint16_t frame_get16(const uint8_t *src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static uint32_t frame_get32(const uint8_t *src)
+{
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+// Drops bytes from the front of the decoder's buffer
+static void frame_drop(telemetry_decoder_t *dec, size_t n)
+{
+    dec->len -= n;
+    memmove(dec->buf, dec->buf + n, dec->len);
+}
+
+// Unpacks a frame that passed its CRC
+static void frame_decode(const uint8_t *src, telemetry_frame_t *frame)
+{
+    frame->node = src[3];
+    frame->seq = frame_get16(&src[4]);
+    frame->time_ms = frame_get32(&src[6]);
+    frame->count = src[10];
+
+    const uint8_t *ev = &src[TELEMETRY_HEADER_LEN];
+    for (uint8_t i = 0; i < frame->count; i++, ev += TELEMETRY_EVENT_LEN)
+    {
+        frame->events[i].type = ev[0];
+        frame->events[i].arg = ev[1];
+        frame->events[i].time_ms = frame_get32(&ev[2]);
+        frame->events[i].value = (int32_t)frame_get32(&ev[6]);
+    }
+}
+
+// Takes every complete frame off the front of the buffer, dropping bytes
+// until a sync where there is noise
+static uint32_t frame_scan(telemetry_decoder_t *dec, telemetry_frame_fn_t fn, void *ctx)
+{
+    uint32_t frames = 0;
+
+    while (dec->len > 0)
+    {
+        // Skip straight to the next possible start
+        if (dec->buf[0] != TELEMETRY_SYNC0)
+        {
+            const uint8_t *sync = memchr(dec->buf, TELEMETRY_SYNC0, dec->len);
+            size_t n = sync != NULL ? (size_t)(sync - dec->buf) : dec->len;
+
+            dec->skipped += n;
+            frame_drop(dec, n);
+            continue;
+        }
+
+        if (dec->len < 2)
+        {
+            break;
+        }
+
+        if (dec->buf[1] != TELEMETRY_SYNC1)
+        {
+            dec->skipped++;
+            frame_drop(dec, 1);
+            continue;
+        }
+
+        if (dec->len < TELEMETRY_HEADER_LEN)
+        {
+            break;
+        }
+
+        uint8_t count = dec->buf[10];
+        if (dec->buf[2] != TELEMETRY_VERSION || count == 0 || count > TELEMETRY_MAX_EVENTS)
+        {
+            dec->bad_headers++;
+            dec->skipped++;
+            frame_drop(dec, 1);
+            continue;
+        }
+
+        size_t need = TELEMETRY_FRAME_LEN(count);
+        if (dec->len < need)
+        {
+            break;
+        }
+
+        // A bad CRC may be a sync inside noise, so look again from the next byte
+        uint16_t crc = telemetry_crc16(0xFFFF, &dec->buf[2], need - 2 - TELEMETRY_CRC_LEN);
+        if (crc != frame_get16(&dec->buf[need - TELEMETRY_CRC_LEN]))
+        {
+            dec->crc_errors++;
+            dec->skipped++;
+            frame_drop(dec, 1);
+            continue;
+        }
+
+        telemetry_frame_t frame;
+        frame_decode(dec->buf, &frame);
+        frame_drop(dec, need);
+
+        dec->frames++;
+        frames++;
+
+        if (fn != NULL)
+        {
+            fn(ctx, &frame);
+        }
+    }
+
+    return frames;
+}
+
+
+// ############################## [ Functions ] ####################################
+
+uint16_t telemetry_crc16(uint16_t crc, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = (uint16_t)((crc << 4) ^ frame_crc_table[(crc >> 12) ^ (src[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ frame_crc_table[(crc >> 12) ^ (src[i] & 0x0F)]);
+    }
+
+    return crc;
+}
+
+size_t telemetry_frame_encode(uint8_t *dst, const telemetry_frame_t *frame)
+{
+    if (frame->count == 0 || frame->count > TELEMETRY_MAX_EVENTS)
+    {
+        return 0;
+    }
+
+    dst[0] = TELEMETRY_SYNC0;
+    dst[1] = TELEMETRY_SYNC1;
+    dst[2] = TELEMETRY_VERSION;
+    dst[3] = frame->node;
+    frame_put16(&dst[4], frame->seq);
+    frame_put32(&dst[6], frame->time_ms);
+    dst[10] = frame->count;
+
+    uint8_t *ev = &dst[TELEMETRY_HEADER_LEN];
+    for (uint8_t i = 0; i < frame->count; i++, ev += TELEMETRY_EVENT_LEN)
+    {
+        ev[0] = frame->events[i].type;
+        ev[1] = frame->events[i].arg;
+        frame_put32(&ev[2], frame->events[i].time_ms);
+        frame_put32(&ev[6], (uint32_t)frame->events[i].value);
+    }
+
+    size_t len = TELEMETRY_FRAME_LEN(frame->count);
+    frame_put16(&dst[len - TELEMETRY_CRC_LEN], telemetry_crc16(0xFFFF, &dst[2], len - 2 - TELEMETRY_CRC_LEN));
+
+    return len;
+}
+
+void telemetry_decoder_init(telemetry_decoder_t *dec)
+{
+    dec->len = 0;
+    dec->frames = 0;
+    dec->crc_errors = 0;
+    dec->bad_headers = 0;
+    dec->skipped = 0;
+}
+
+uint32_t telemetry_decoder_feed(telemetry_decoder_t *dec, const uint8_t *src, size_t len,
+                                telemetry_frame_fn_t fn, void *ctx)
+{
+    uint32_t frames = 0;
+
+    // The scan always leaves less than a whole frame, so there is room for
+    // at least one more byte each time round
+    while (len > 0)
+    {
+        size_t n = sizeof(dec->buf) - dec->len;
+        if (n > len)
+        {
+            n = len;
+        }
+
+        memcpy(dec->buf + dec->len, src, n);
+        dec->len += n;
+        src += n;
+        len -= n;
+
+        frames += frame_scan(dec, fn, ctx);
+    }
+
+    return frames;
+}
+
+void telemetry_blob_pack(telemetry_event_t *ev, const uint8_t *src, size_t len)
+{
+    uint8_t bytes[TELEMETRY_BLOB_BYTES] = {0};
+
+    memcpy(bytes, src, len);
+
+    ev->arg = (uint8_t)len;
+    ev->time_ms = frame_get32(&bytes[0]);
+    ev->value = (int32_t)frame_get32(&bytes[4]);
+}
+
+size_t telemetry_blob_unpack(const telemetry_event_t *ev, uint8_t *dst)
+{
+    if (ev->type != TELEMETRY_CAPTURE || ev->arg == 0 || ev->arg > TELEMETRY_BLOB_BYTES)
+    {
+        return 0;
+    }
+
+    frame_put32(&dst[0], ev->time_ms);
+    frame_put32(&dst[4], (uint32_t)ev->value);
+
+    return ev->arg;
+}
+
+const char *telemetry_type_name(uint8_t type)
+{
+    switch (type)
+    {
+        case TELEMETRY_BOOT:
+            return "boot";
+        case TELEMETRY_ALERT:
+            return "alert";
+        case TELEMETRY_RAIN:
+            return "rain";
+        case TELEMETRY_SOIL:
+            return "soil";
+        case TELEMETRY_SEISMIC:
+            return "seismic";
+        case TELEMETRY_LOST:
+            return "lost";
+        case TELEMETRY_CAPTURE:
+            return "capture";
+        case TELEMETRY_PHASE:
+            return "phase";
+        case TELEMETRY_EVIDENCE:
+            return "evidence";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,227 @@
+/**
+ * @file    waveform.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   Accelerometer waveform blocks and captures, see waveform.h
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "waveform.h"
+#include "bitpack.h"
+
+// ############################## [ Local Functions ] ##############################
+
+static void wave_put16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static void wave_put32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+static uint16_t wave_get16(const uint8_t *src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static uint32_t wave_get32(const uint8_t *src)
+{
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+// The changes of one axis of a block, the axis picked by its offset in the sample
+static void wave_pack_axis(bits_writer_t *w, const waveform_sample_t *samples, uint32_t n, size_t axis,
+                           uint32_t width)
+{
+    const int16_t *prev = (const int16_t *)((const uint8_t *)&samples[0] + axis);
+
+    for (uint32_t i = 1; i < n; i++)
+    {
+        const int16_t *cur = (const int16_t *)((const uint8_t *)&samples[i] + axis);
+        bits_write(w, bits_zigzag((int32_t)*cur - *prev), width);
+        prev = cur;
+    }
+}
+
+static void wave_unpack_axis(bits_reader_t *r, waveform_sample_t *samples, uint32_t n, size_t axis,
+                             uint32_t width)
+{
+    int16_t *prev = (int16_t *)((uint8_t *)&samples[0] + axis);
+
+    for (uint32_t i = 1; i < n; i++)
+    {
+        int16_t *cur = (int16_t *)((uint8_t *)&samples[i] + axis);
+        *cur = (int16_t)(*prev + bits_unzigzag(bits_read(r, width)));
+        prev = cur;
+    }
+}
+
+
+// ############################## [ Functions ] ####################################
+
+size_t waveform_block_encode(uint8_t *dst, const waveform_sample_t *samples, uint32_t n)
+{
+    uint32_t range[3] = { 0, 0, 0 };
+
+    // The largest change on each axis sets its width
+    for (uint32_t i = 1; i < n; i++)
+    {
+        range[0] |= bits_zigzag((int32_t)samples[i].x - samples[i - 1].x);
+        range[1] |= bits_zigzag((int32_t)samples[i].y - samples[i - 1].y);
+        range[2] |= bits_zigzag((int32_t)samples[i].z - samples[i - 1].z);
+    }
+
+    uint32_t wx = bits_width(range[0]);
+    uint32_t wy = bits_width(range[1]);
+    uint32_t wz = bits_width(range[2]);
+
+    dst[0] = (uint8_t)n;
+    wave_put16(&dst[1], (uint16_t)(wx | wy << 5 | wz << 10));
+    wave_put16(&dst[3], (uint16_t)samples[0].x);
+    wave_put16(&dst[5], (uint16_t)samples[0].y);
+    wave_put16(&dst[7], (uint16_t)samples[0].z);
+
+    bits_writer_t w;
+    bits_writer_init(&w, &dst[WAVEFORM_BLOCK_HEADER]);
+    wave_pack_axis(&w, samples, n, offsetof(waveform_sample_t, x), wx);
+    wave_pack_axis(&w, samples, n, offsetof(waveform_sample_t, y), wy);
+    wave_pack_axis(&w, samples, n, offsetof(waveform_sample_t, z), wz);
+
+    return (size_t)(bits_flush(&w) - dst);
+}
+
+size_t waveform_block_len(const uint8_t *src)
+{
+    uint32_t n = src[0];
+    uint16_t widths = wave_get16(&src[1]);
+    uint32_t bits = (widths & 0x1F) + ((widths >> 5) & 0x1F) + ((widths >> 10) & 0x1F);
+
+    if (n == 0 || n > WAVEFORM_BLOCK_SAMPLES || (widths & 0x1F) > 17 || ((widths >> 5) & 0x1F) > 17 ||
+        ((widths >> 10) & 0x1F) > 17 || (widths >> 15) != 0)
+    {
+        return 0;
+    }
+
+    return WAVEFORM_BLOCK_HEADER + ((n - 1) * bits + 7) / 8;
+}
+
+uint32_t waveform_block_decode(const uint8_t *src, waveform_sample_t *samples)
+{
+    size_t len = waveform_block_len(src);
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    uint32_t n = src[0];
+    uint16_t widths = wave_get16(&src[1]);
+
+    samples[0].x = (int16_t)wave_get16(&src[3]);
+    samples[0].y = (int16_t)wave_get16(&src[5]);
+    samples[0].z = (int16_t)wave_get16(&src[7]);
+
+    bits_reader_t r;
+    bits_reader_init(&r, &src[WAVEFORM_BLOCK_HEADER], src + len);
+    wave_unpack_axis(&r, samples, n, offsetof(waveform_sample_t, x), widths & 0x1F);
+    wave_unpack_axis(&r, samples, n, offsetof(waveform_sample_t, y), (widths >> 5) & 0x1F);
+    wave_unpack_axis(&r, samples, n, offsetof(waveform_sample_t, z), (widths >> 10) & 0x1F);
+
+    return n;
+}
+
+void waveform_header_encode(uint8_t *dst, const waveform_header_t *header)
+{
+    dst[0] = WAVEFORM_MAGIC0;
+    dst[1] = WAVEFORM_MAGIC1;
+    dst[2] = WAVEFORM_VERSION;
+    dst[3] = header->flags;
+    wave_put16(&dst[4], header->rate_hz);
+    wave_put16(&dst[6], header->lsb_per_g);
+    wave_put32(&dst[8], header->trigger_ms);
+    wave_put32(&dst[12], header->samples);
+    wave_put32(&dst[16], header->pre);
+    wave_put32(&dst[20], header->payload);
+}
+
+size_t waveform_capture_len(const uint8_t *src)
+{
+    if (src[0] != WAVEFORM_MAGIC0 || src[1] != WAVEFORM_MAGIC1 || src[2] != WAVEFORM_VERSION)
+    {
+        return 0;
+    }
+
+    return WAVEFORM_HEADER_LEN + wave_get32(&src[20]) + WAVEFORM_CRC_LEN;
+}
+
+bool waveform_header_decode(const uint8_t *src, size_t len, waveform_header_t *header)
+{
+    if (len < WAVEFORM_HEADER_LEN + WAVEFORM_CRC_LEN || waveform_capture_len(src) != len ||
+        wave_get16(&src[len - WAVEFORM_CRC_LEN]) != telemetry_crc16(0xFFFF, src, len - WAVEFORM_CRC_LEN))
+    {
+        return false;
+    }
+
+    header->flags = src[3];
+    header->rate_hz = wave_get16(&src[4]);
+    header->lsb_per_g = wave_get16(&src[6]);
+    header->trigger_ms = wave_get32(&src[8]);
+    header->samples = wave_get32(&src[12]);
+    header->pre = wave_get32(&src[16]);
+    header->payload = wave_get32(&src[20]);
+
+    return true;
+}
+
+int32_t waveform_decode(const uint8_t *src, size_t len, waveform_sample_fn_t fn, void *ctx,
+                        waveform_header_t *header)
+{
+    waveform_header_t h;
+    waveform_sample_t samples[WAVEFORM_BLOCK_SAMPLES];
+    uint32_t count = 0;
+
+    if (!waveform_header_decode(src, len, &h))
+    {
+        return -1;
+    }
+
+    const uint8_t *at = src + WAVEFORM_HEADER_LEN;
+    const uint8_t *end = at + h.payload;
+
+    while (at < end)
+    {
+        // A block can not run past the end of the blocks
+        size_t block_len = end - at >= WAVEFORM_BLOCK_HEADER ? waveform_block_len(at) : 0;
+        if (block_len == 0 || block_len > (size_t)(end - at))
+        {
+            return -1;
+        }
+
+        uint32_t n = waveform_block_decode(at, samples);
+        for (uint32_t i = 0; i < n && fn != NULL; i++)
+        {
+            fn(ctx, count + i, &samples[i]);
+        }
+
+        count += n;
+        at += block_len;
+    }
+
+    if (count != h.samples)
+    {
+        return -1;
+    }
+
+    if (header != NULL)
+    {
+        *header = h;
+    }
+
+    return (int32_t)count;
+}
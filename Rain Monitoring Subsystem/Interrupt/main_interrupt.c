@@ -7,146 +7,317 @@
 
 // ################################# [ Includes ] #################################
 
-#include "pico/stdlib.h"
-#include "hardware/i2c.h"
-#include "pico/sleep.h"
+#include "fusion.h"
+#include "fusion_config.h"
+#include "landslide_hal.h"
+#include "landslide_node.h"
+#include "node_log.h"
+#include "node_phase.h"
+#include "node_telemetry.h"
+#include "node_time.h"
+#include "node_wake.h"
+#include "node_warning.h"
+#include "rain_config.h"
+#include "rain_rate.h"
 #include <stdio.h>
-#include <math.h>
 
 // ############################# [ Global Variables ] #############################
 
-// I2C address of the accelerometer
-static const uint8_t ADXL343_ADDR = 0x53;
+// The gauge pin, the bucket size and the rainfall windows are set in
+// rain_config.h and the site profile
 
-// Pins Used on the Pi Pico
-const uint SDA_PIN_ACC = 4; // I2C SDA Pin for the accelerometer
-const uint SCL_PIN_ACC = 5; // I2C SCL Pin for the accelerometer
-i2c_inst_t *i2c_ACC = i2c0; // I2C bus for the accelerometer
-const uint LED_PIN = 25;    // LED Pin for the Pi Pico
-const uint TRIGGER = 10;    // LED Pin for the Pi Pico
+// Tips over the rainfall windows
+static rain_rate_t rain;
 
+// Rain evidence, graded into alerts
+static fusion_t fusion;
 
-const uint SDA_PIN_ZERO = 18;   // I2C SDA Pin for the Zero
-const uint SCL_PIN_ZERO = 19;   // I2C SCL Pin for the Zero
-i2c_inst_t *i2c_ZERO = i2c1;    // I2C bus for the Zero
-const uint WARNING_PIN = 3;     // Warning Pin for the Zero
-const uint ACK_PIN = 2;         // Acknowledge Pin for the Zero
+// Wakes on the gauge pin
+static node_wake_t wake;
 
+// RTC time at boot, the tips are dated from it
+static uint64_t boot_ms;
 
-// ############################## [ Function Prototypes ] ##########################
+#if RAIN_PULSE_COUNTER
 
-/**
- * @brief This sets up the warning pin and the acknowledge pin and sends a 
- * high signal to the warning pin. It then waits for the acknowledge pin to
- * go high before returning.
- * 
- * @param WARNING_PIN The pin to send the warning signal on
- * @param ACK_PIN The pin to wait for the acknowledge signal on
- * @return int 1 if successful 0 if failed
- */
-int issue_warning(uint WARNING_PIN, uint ACK_PIN);
+// Pulse count at the last read and when it was read
+static uint32_t tips_read;
+static uint32_t tips_read_ms;
 
+// Set from the interrupts that end the wait for tips
+static volatile bool tips_due;
 
-int main() 
+#endif
+
+
+// ############################## [ Local Functions ] ##############################
+
+// The tips are dated with the RTC, which keeps counting in sleep mode
+static uint32_t now_ms(void)
 {
-    // Initialize Pi Pico
-    stdio_init_all();
+    return (uint32_t)(node_time_ms() - boot_ms);
+}
 
-    // Setting up the LED
-    gpio_init(LED_PIN);
-    gpio_set_dir(LED_PIN, GPIO_OUT);
+// Largest of the windows' depth over their threshold (%)
+static uint32_t rain_pct(void)
+{
+    uint32_t pct = 0;
 
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
+    for (uint8_t w = 0; w < rain.config.windows; w++)
+    {
+        uint32_t warning = rain.config.window[w].warning_tips;
+
+        if (warning != 0 && rain_rate_tips(&rain, w) * 100 / warning > pct)
+        {
+            pct = rain_rate_tips(&rain, w) * 100 / warning;
+        }
+    }
 
-    // Setup the ack pin as an input
-    gpio_init(ACK_PIN);
-    gpio_set_dir(ACK_PIN, GPIO_IN);
+    return pct;
+}
 
-    // Setup the trigger pin as an input
-    gpio_init(TRIGGER);
-    gpio_set_dir(TRIGGER, GPIO_IN);
+// Adds tips spread evenly from one time to another, prints the rain in each
+// window and issues a warning if the evidence has reached the raise grade
+static void record_tips(uint32_t tips, uint32_t from_ms, uint32_t to_ms)
+{
+    // A window that has dropped back under its threshold can warn again
+    rain_rate_expire(&rain, from_ms);
+    fusion_rain(&fusion, rain_pct(), rain_rate_over(&rain));
 
-    int count = 0;
+    for (uint32_t i = 0; i < tips; i++)
+    {
+        uint32_t at_ms = from_ms + (uint32_t)((uint64_t)(to_ms - from_ms) * (i + 1) / tips);
+        rain_rate_tip(&rain, at_ms);
+    }
 
-    // Sets up the pico to be able to go into deep sleep.
-    sleep_run_from_xosc();
+    fusion_rain(&fusion, rain_pct(), rain_rate_over(&rain));
 
-    // Take measurements from the accelerometer and issue warnings as necessary
-    while (1) 
+    if (tips > 0)
+    {
+        // Print the rain in each window to the terminal
+        printf("Rain:");
+        for (uint8_t w = 0; w < rain.config.windows; w++)
+        {
+            uint32_t um = rain_rate_depth_um(&rain, w);
+            printf(" %lu.%lu mm/%lu min", (unsigned long)(um / 1000), (unsigned long)(um / 100 % 10),
+                   (unsigned long)(rain.config.window[w].len_s / 60));
+        }
+        printf("\n");
+        hal_stdio_flush();
+
+        node_telemetry_post(TELEMETRY_RAIN, (uint8_t)rain_rate_over(&rain), (int32_t)tips);
+        node_log_append(TELEMETRY_RAIN, (uint8_t)rain_rate_over(&rain), (int32_t)tips,
+                        (int32_t)rain_rate_intensity_um_h(&rain, 0));
+    }
+
+    // If the rain has just gone over a threshold
+    fusion_alert_t alert;
+    fusion_assess(&fusion, to_ms / 1000, &alert);
+    node_telemetry_evidence(FUSION_RAIN, &alert);
+
+    if (alert.raise)
     {
 
-        // Go to deep sleep until high signal is received on the trigger pin
-        sleep_goto_dormant_until_level_high(TRIGGER);
+        // Print warning to the terminal
+        printf("Warning: %s, %u%% confidence\n", fusion_grade_name(alert.grade), alert.confidence);
+        hal_stdio_flush();
 
-        // Print going to sleep to the terminal
-        printf("Going to sleep\n");
-        uart_default_tx_wait_blocking();
+        // Keep the numbers and send them before the warning pin wakes the
+        // Zero
+        node_log_alert(&alert);
+        node_telemetry_alert(&alert);
 
-        count++;
+        // Issue a warning
+        node_warning_raise();
+    }
+}
+
+#if RAIN_PULSE_COUNTER
 
-        // Print the count to the terminal
-        printf("Count: %d\n", count);
-        uart_default_tx_wait_blocking();
+// Fewest tips that could take a window over its threshold, 0 if none can
+static uint32_t tips_to_warning(void)
+{
+    uint32_t fewest = 0;
+
+    for (uint8_t w = 0; w < rain.config.windows; w++)
+    {
+        uint32_t warning = rain.config.window[w].warning_tips;
+        uint32_t tips = rain_rate_tips(&rain, w);
 
-        // Wait for the trigger pin to go low
-        while (gpio_get(TRIGGER) == 1)
+        if (warning != 0 && tips < warning && (fewest == 0 || warning - tips < fewest))
         {
-            // Set LED to flash quickly to indicate a measurement is being taken
-            gpio_put(LED_PIN, 1);
-            sleep_ms(100);
-            gpio_put(LED_PIN, 0);
-            sleep_ms(100);
+            fewest = warning - tips;
         }
+    }
+
+    return fewest;
+}
+
+// Ends the wait for tips
+static void tips_wake(void *ctx)
+{
+    (void)ctx;
+    tips_due = true;
+}
+
+// Waits until the counted tips have to be added. With the windows empty
+// the Pico goes dormant until a tip, the counter takes that tip as the Pico
+// wakes, in the wake's debounce time. Otherwise it sleeps on the RTC with
+// the counter running, until enough tips have come to take a window over
+// its threshold or for RAIN_IDLE_CHECK_MS, so the tips of a storm only wake
+// it at those times. A warning waiting for its ack flashes the LED from the
+// timer, which stops in sleep mode, so then it idles instead.
+static void wait_for_tips(void)
+{
+    if (rain_rate_empty(&rain))
+    {
+        node_wake_wait(&wake, 0);
+
+        // The RTC stopped while dormant, the tip came just now
+        tips_read_ms = now_ms();
+        return;
+    }
 
+    tips_due = false;
+    hal_pulse_counter_set_irq(tips_to_warning(), tips_wake, NULL);
 
-        // If the count is greater than 2
-        if (count > 2)
+    int timer = -1;
+    int64_t check_s = node_time_unix() + (RAIN_IDLE_CHECK_MS + 999) / 1000;
+
+    if (node_warning_pending())
+    {
+        timer = hal_timer_start(RAIN_IDLE_CHECK_MS * 1000, tips_wake, NULL);
+    }
+
+    while (!tips_due)
+    {
+        // Once the warning has been acked the rest of the wait can sleep
+        if (timer >= 0 && !node_warning_pending())
         {
+            hal_timer_stop(timer);
+            timer = -1;
+        }
+
+        // A threshold reached after the loop's check still ends the sleep
+        if (timer < 0)
+        {
+            if (node_time_sleep_until_irq(check_s, &tips_due))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        NODE_PHASE_BEGIN(PHASE_IDLE);
+        hal_wfi();
+        NODE_PHASE_END(PHASE_IDLE);
+    }
+
+    hal_timer_stop(timer);
+    hal_pulse_counter_set_irq(0, NULL, NULL);
+}
 
-            // Print warning to the terminal
-            printf("Warning\n");
-            uart_default_tx_wait_blocking();
+#else
 
-            // Issue a warning
-            issue_warning(WARNING_PIN, ACK_PIN);
+// Waits for the next debounced bucket tip. Dormant mode stops the RTC the
+// tips are dated with, so while the windows still hold rain the Pico only
+// sleeps on the RTC, woken by the tip or every RAIN_IDLE_CHECK_MS to drop
+// the tips that have left the windows. Once they are empty the time of the
+// next tip no longer matters and the Pico goes dormant.
+static void wait_for_tip(void)
+{
+    while (1)
+    {
+        uint32_t timeout_ms = rain_rate_empty(&rain) ? 0 : RAIN_IDLE_CHECK_MS;
 
-            // Reset the count
-            count = 0;
+        if (node_wake_wait(&wake, timeout_ms) == NODE_WAKE_EDGE)
+        {
+            return;
         }
 
+        rain_rate_expire(&rain, now_ms());
     }
-    
 }
 
+#endif
 
 
-int issue_warning(uint WARNING_PIN, uint ACK_PIN)
+int main() 
 {
+    // Initialize Pi Pico
+    hal_stdio_init();
+
+    // Setup the LED and warning pins as outputs and the ack pin as an input
+    node_setup_pins(NODE_LED_PIN, NODE_WARNING_PIN, NODE_ACK_PIN);
+
+    // The tips are dated with the RTC
+    node_time_init(NODE_TIME_START_UNIX);
+    boot_ms = node_time_ms();
 
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
+    // Batched events to the Zero over i2c1
+    node_telemetry_init(NODE_ZERO_I2C, NODE_ZERO_SDA_PIN, NODE_ZERO_SCL_PIN, NODE_ZERO_I2C_ADDR,
+                        TELEMETRY_NODE(NODE_TELEMETRY_ID, TELEMETRY_KIND_RAIN));
 
-    // Set the warning pin high
-    gpio_put(WARNING_PIN, 1);
+    // Every check and alert is kept in flash as well
+    node_log_init(TELEMETRY_KIND_RAIN);
 
-    // Wait for the ack pin to go high
-    while (gpio_get(ACK_PIN) == 0)
+    // Setup the trigger pin as an input
+    hal_gpio_init(RAIN_TRIGGER_PIN);
+    hal_gpio_set_dir(RAIN_TRIGGER_PIN, HAL_GPIO_IN);
+
+    rain_rate_config_t config = RAIN_RATE_CONFIG;
+    rain_rate_init(&rain, &config);
+
+    node_wake_config_t wake_config = RAIN_WAKE_CONFIG;
+    node_wake_init(&wake, &wake_config);
+
+    fusion_config_t fusion_config = FUSION_CONFIG;
+    fusion_init(&fusion, &fusion_config);
+
+    // Sets up the pico to be able to go into deep sleep.
+    hal_sleep_run_from_xosc();
+
+#if RAIN_PULSE_COUNTER
+
+    // Count the tips in hardware, on the clocks set up above
+    if (!hal_pulse_counter_init(RAIN_TRIGGER_PIN, RAIN_DEBOUNCE_US))
+    {
+        printf("Could not start the pulse counter\n");
+        hal_stdio_flush();
+    }
+
+    // Add the counted bucket tips and issue warnings as necessary
+    while (1)
     {
-        // Set LED to flash slowly to indicate warning has been issued
-        gpio_put(LED_PIN, 1);
-        sleep_ms(500);
-        gpio_put(LED_PIN, 0);
-        sleep_ms(500);
+        wait_for_tips();
+
+        uint32_t count = hal_pulse_counter_read();
+        uint32_t now = now_ms();
+
+        record_tips(count - tips_read, tips_read_ms, now);
+
+        tips_read = count;
+        tips_read_ms = now;
+
+        // The phase timings go to the Zero once a day
+        NODE_PHASE_POLL();
     }
 
-    // Set the warning pin back to high impedance
-    gpio_set_dir(WARNING_PIN, GPIO_IN);
+#else
 
-    // Turn off LED
-    gpio_put(LED_PIN, 0);
+    // Count the bucket tips and issue warnings as necessary
+    while (1) 
+    {
+        wait_for_tip();
 
-    return 1;
-}
\ No newline at end of file
+        uint32_t now = now_ms();
+        record_tips(1, now, now);
+
+        // The phase timings go to the Zero once a day
+        NODE_PHASE_POLL();
+    }
+
+#endif
+    
+}
@@ -7,135 +7,80 @@
 
 // ################################# [ Includes ] #################################
 
-#include "pico/stdlib.h"
-#include "hardware/i2c.h"
+#include "landslide_hal.h"
+#include "landslide_node.h"
+#include "node_warning.h"
+#include "rain_config.h"
+#include "rain_rate.h"
 #include <stdio.h>
-#include <math.h>
 
 // ############################# [ Global Variables ] #############################
 
-// I2C address of the accelerometer
-static const uint8_t ADXL343_ADDR = 0x53;
+// The gauge pin, the bucket size and the rainfall windows are set in
+// rain_config.h and the site profile
 
-// Pins Used on the Pi Pico
-const uint SDA_PIN_ACC = 4; // I2C SDA Pin for the accelerometer
-const uint SCL_PIN_ACC = 5; // I2C SCL Pin for the accelerometer
-i2c_inst_t *i2c_ACC = i2c0; // I2C bus for the accelerometer
-const uint LED_PIN = 25;    // LED Pin for the Pi Pico
-const uint TRIGGER = 10;    // LED Pin for the Pi Pico
-
-
-const uint SDA_PIN_ZERO = 18;   // I2C SDA Pin for the Zero
-const uint SCL_PIN_ZERO = 19;   // I2C SCL Pin for the Zero
-i2c_inst_t *i2c_ZERO = i2c1;    // I2C bus for the Zero
-const uint WARNING_PIN = 3;     // Warning Pin for the Zero
-const uint ACK_PIN = 2;         // Acknowledge Pin for the Zero
-
-
-// ############################## [ Function Prototypes ] ##########################
-
-/**
- * @brief This sets up the warning pin and the acknowledge pin and sends a 
- * high signal to the warning pin. It then waits for the acknowledge pin to
- * go high before returning.
- * 
- * @param WARNING_PIN The pin to send the warning signal on
- * @param ACK_PIN The pin to wait for the acknowledge signal on
- * @return int 1 if successful 0 if failed
- */
-int issue_warning(uint WARNING_PIN, uint ACK_PIN);
+// Tips over the rainfall windows
+static rain_rate_t rain;
 
 
 int main() 
 {
     // Initialize Pi Pico
-    stdio_init_all();
-
-    // Setting up the LED
-    gpio_init(LED_PIN);
-    gpio_set_dir(LED_PIN, GPIO_OUT);
+    hal_stdio_init();
 
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
-
-    // Setup the ack pin as an input
-    gpio_init(ACK_PIN);
-    gpio_set_dir(ACK_PIN, GPIO_IN);
+    // Setup the LED and warning pins as outputs and the ack pin as an input
+    node_setup_pins(NODE_LED_PIN, NODE_WARNING_PIN, NODE_ACK_PIN);
 
     // Setup the trigger pin as an input
-    gpio_init(TRIGGER);
-    gpio_set_dir(TRIGGER, GPIO_IN);
+    hal_gpio_init(RAIN_TRIGGER_PIN);
+    hal_gpio_set_dir(RAIN_TRIGGER_PIN, HAL_GPIO_IN);
+
+    rain_rate_config_t config = RAIN_RATE_CONFIG;
+    rain_rate_init(&rain, &config);
 
-    int count = 0;
+    // Windows over their threshold at the last tip
+    uint32_t over = 0;
 
-    // Take measurements from the accelerometer and issue warnings as necessary
+    // Count the bucket tips and issue warnings as necessary
     while (1) 
     {
         // Take a read of the trigger pin
-        uint trigger = gpio_get(TRIGGER);
+        uint trigger = hal_gpio_get(RAIN_TRIGGER_PIN);
 
-        // If the trigger pin is high, increment the count
+        // If the trigger pin is high, add a tip
         if (trigger == 1)
         {
-            count++;
+            uint32_t now = rain_rate_tip(&rain, (uint32_t)(hal_time_us_64() / 1000));
 
-            // Print the count to the terminal
-            printf("Count: %d\n", count);
+            // Print the rain in each window to the terminal
+            printf("Rain:");
+            for (uint8_t w = 0; w < config.windows; w++)
+            {
+                uint32_t um = rain_rate_depth_um(&rain, w);
+                printf(" %lu.%lu mm/%lu min", (unsigned long)(um / 1000), (unsigned long)(um / 100 % 10),
+                       (unsigned long)(config.window[w].len_s / 60));
+            }
+            printf("\n");
 
             // Wait for the trigger pin to go low
-            while (gpio_get(TRIGGER) == 1)
+            while (hal_gpio_get(RAIN_TRIGGER_PIN) == 1)
             {
                 // Set LED to flash quickly to indicate a measurement is being taken
-                gpio_put(LED_PIN, 1);
-                sleep_ms(100);
-                gpio_put(LED_PIN, 0);
-                sleep_ms(100);
+                hal_gpio_put(NODE_LED_PIN, 1);
+                hal_sleep_ms(RAIN_FLASH_MS);
+                hal_gpio_put(NODE_LED_PIN, 0);
+                hal_sleep_ms(RAIN_FLASH_MS);
             }
 
-        }
-
-        // If the count is greater than 2
-        if (count > 2)
-        {
-            // Issue a warning
-            issue_warning(WARNING_PIN, ACK_PIN);
+            // If a window has just gone over its threshold, issue a warning
+            if (now & ~over)
+            {
+                node_warning_raise();
+            }
 
-            // Reset the count
-            count = 0;
+            over = now;
         }
 
     }
     
 }
-
-
-
-int issue_warning(uint WARNING_PIN, uint ACK_PIN)
-{
-
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
-
-    // Set the warning pin high
-    gpio_put(WARNING_PIN, 1);
-
-    // Wait for the ack pin to go high
-    while (gpio_get(ACK_PIN) == 0)
-    {
-        // Set LED to flash slowly to indicate warning has been issued
-        gpio_put(LED_PIN, 1);
-        sleep_ms(500);
-        gpio_put(LED_PIN, 0);
-        sleep_ms(500);
-    }
-
-    // Set the warning pin back to high impedance
-    gpio_set_dir(WARNING_PIN, GPIO_IN);
-
-    // Turn off LED
-    gpio_put(LED_PIN, 0);
-
-    return 1;
-}
\ No newline at end of file
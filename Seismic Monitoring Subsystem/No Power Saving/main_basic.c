@@ -4,75 +4,72 @@
  * @brief   This program is for the seismic subsystem. It will use the ADXL343
  *          accelerometer to measure the relative acceleration of the system.
  *          If the acceleration exceeds a certain threshold, the system will
- *          issue a warning to the data analysis subsystem then wait until the
- *          warning is acknowledged.
+ *          issue a warning to the data analysis subsystem and keep sensing
+ *          while the warning waits to be acknowledged.
  * 
  *          This version of the program does not utilise any power saving strategies
  *          Instead it will run continuously read from the accelerometer and issue
  *          warnings as necessary.
+ *
+ *          The work is split over the two cores. Core 1 only polls the
+ *          accelerometer and pushes each new sample, with the time it was
+ *          read, into a lock free queue. It reads with the bare HAL bus
+ *          calls, which touch nothing of core 0's, and is not timed by
+ *          node_phase.h, whose state is core 0's. Core 0 takes the samples
+ *          off, runs the detector, raises the warning and then prints, so a
+ *          slow uart only delays the printing and never the sampling or the
+ *          warning. Both cores idle when they have nothing to do. Each
+ *          sample's line goes into the deferred log (node_dlog.h) and is
+ *          only printed once the queue is empty.
  *          
 */
 
 // ################################# [ Includes ] #################################
 
-#include "pico/stdlib.h"
-#include "hardware/i2c.h"
+#include "adxl343_power.h"
+#include "landslide_hal.h"
+#include "landslide_node.h"
+#include "node_dlog.h"
+#include "node_phase.h"
+#include "node_warning.h"
+#include "seismic_config.h"
+#include "seismic_detect.h"
+#include "spsc_queue.h"
+#include "sta_lta.h"
 #include <stdio.h>
-#include <math.h>
 
 // ############################# [ Global Variables ] #############################
 
-// I2C address of the accelerometer
-static const uint8_t ADXL343_ADDR = 0x53;
+// Pins, bus and address of the accelerometer, thresholds and window sizes
+// are set in seismic_config.h and the site profile
 
-// Registers Locations on the accelerometer
-static const uint8_t REG_DEVID = 0x00;
-static const uint8_t REG_POWER_CTL = 0x2D;
-static const uint8_t REG_DATAX0 = 0x32;
+// Event detector fed with the acceleration with gravity removed
+static seismic_hp_t seismic_hp;
+static sta_lta_t seismic_detector;
 
-// Constants to be used in the program for the accelerometer
-static const uint8_t DEVID = 0xE5;
-static const float SENSITIVITY_2G = 1.0 / 256;  // (g/LSB)
-static const float EARTH_GRAVITY = 9.80665;     // Earth's gravity in [m/s^2]
+// The accelerometer runs at its default rate, core 1 polls it twice a sample
+#define SAMPLE_RATE_HZ  ADXL343_RATE_HZ(ADXL343_RATE_100HZ)
+#define POLL_US         (1000000 / SAMPLE_RATE_HZ / 2)
 
-// Pins Used on the Pi Pico
-const uint SDA_PIN_ACC = 4; // I2C SDA Pin for the accelerometer
-const uint SCL_PIN_ACC = 5; // I2C SCL Pin for the accelerometer
-i2c_inst_t *i2c_ACC = i2c0; // I2C bus for the accelerometer
-const uint LED_PIN = 25;    // LED Pin for the Pi Pico
+// Samples core 0 can fall behind by, 640 ms at 100 Hz
+#define QUEUE_LEN       64
 
-const uint SDA_PIN_ZERO = 18;   // I2C SDA Pin for the Zero
-const uint SCL_PIN_ZERO = 19;   // I2C SCL Pin for the Zero
-i2c_inst_t *i2c_ZERO = i2c1;    // I2C bus for the Zero
-const uint WARNING_PIN = 3;     // Warning Pin for the Zero
-const uint ACK_PIN = 2;         // Acknowledge Pin for the Zero
+// A sample and when core 1 read it
+typedef struct
+{
+    uint64_t time_us;
+    adxl343_sample_t sample;
+} timed_sample_t;
 
+// From core 1 to core 0
+static timed_sample_t sample_slots[QUEUE_LEN];
+static spsc_queue_t sample_queue;
 
-// ############################## [ Function Prototypes ] ##########################
+// Longest time from a sample being read to it being through the detector
+static uint64_t max_latency_us;
 
-/**
- * @brief Allows the user to write to a register of a device on the I2C bus
- * 
- * @param i2c Pointer to I2C bus to use on the pico, will be either i2c or i2c1
- * @param addr The address of the device to write to
- * @param reg The register to write to
- * @param buf Pointer to the data to write
- * @param nbytes The number of bytes to write
- * @return int check if the write was successful 0 if fail 1 if success
-*/
-int reg_write(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes);
 
-/**
- * @brief Allows the user to read from a register of a device on the I2C bus
- * 
- * @param i2c Pointer to I2C bus to use on the pico, will be either i2c or i2c1
- * @param addr The address of the device to read from
- * @param reg The register to read from
- * @param buf Pointer to the buffer to store the data in
- * @param nbytes The number of bytes to read
- * @return int the number of bytes read or 0 if it failed 1 if success
- */
-int reg_read(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes);
+// ############################## [ Function Prototypes ] ##########################
 
 /**
  * @brief Sets up the accelerometer to be used and starts taking measurements
@@ -80,248 +77,212 @@ int reg_read(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf,
  * @param i2c The I2C bus to use
  * @param sda_pin The SDA pin to use
  * @param scl_pin The SCL pin to use
- * @param ADXL343_ADDR The address of the accelerometer
+ * @param addr The address of the accelerometer
  * @return int 1 if successful blocked in a while loop if failed
 */
-int accelerometer_setup(i2c_inst_t *i2c, const uint sda_pin, const uint scl_pin, const uint8_t ADXL343_ADDR);
+int accelerometer_setup(hal_i2c_t i2c, const uint sda_pin, const uint scl_pin, const uint8_t addr);
 
 /**
- * @brief Reads the accelerometer and returns if there is a landslide risk
+ * @brief Reads the accelerometer if it has a new sample and queues it for
+ * core 0
  * 
  * @param i2c The I2C bus to use
- * @param ADXL343_ADDR The address of the accelerometer
- * @return int 1 if there is a landslide risk 0 if there is not
+ * @param addr The address of the accelerometer
+ * @return int 1 if a sample was queued 0 if there was none or the queue is full
+*/
+int accelerometer_read(hal_i2c_t i2c, const uint8_t addr);
+
+/**
+ * @brief Core 1's loop, polls the accelerometer and idles between polls
 */
-int accelerometer_read(i2c_inst_t *i2c, const uint8_t ADXL343_ADDR);
+void acquisition_core1(void);
 
 /**
- * @brief This sets up the warning pin and the acknowledge pin and sends a 
- * high signal to the warning pin. It then waits for the acknowledge pin to
- * go high before returning.
+ * @brief Runs a sample through the detector and prints it
  * 
- * @param WARNING_PIN The pin to send the warning signal on
- * @param ACK_PIN The pin to wait for the acknowledge signal on
- * @return int 1 if successful 0 if failed
- */
-int issue_warning(uint WARNING_PIN, uint ACK_PIN);
+ * @param timed The sample and when it was read
+ * @return int 1 if there is a landslide risk 0 if there is not
+*/
+int sample_process(const timed_sample_t *timed);
+
 
 
 int main() 
 {
     // Initialize Pi Pico
-    stdio_init_all();
+    hal_stdio_init();
+    node_dlog_init();
 
-    // Setting up the LED
-    gpio_init(LED_PIN);
-    gpio_set_dir(LED_PIN, GPIO_OUT);
+    // Setup the LED and warning pins as outputs and the ack pin as an input
+    node_setup_pins(NODE_LED_PIN, NODE_WARNING_PIN, NODE_ACK_PIN);
 
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
+    // Initialize accelerometer
+    accelerometer_setup(SEISMIC_I2C, SEISMIC_SDA_PIN, SEISMIC_SCL_PIN, SEISMIC_ADXL343_ADDR);
 
-    // Setup the ack pin as an input
-    gpio_init(ACK_PIN);
-    gpio_set_dir(ACK_PIN, GPIO_IN);
+    // Initialize the STA/LTA event detector
+    sta_lta_config_t detector_config = SEISMIC_STA_LTA_CONFIG;
+    sta_lta_init(&seismic_detector, &detector_config);
 
-    // Initialize accelerometer
-    accelerometer_setup(i2c_ACC, SDA_PIN_ACC, SCL_PIN_ACC, ADXL343_ADDR);
+    // Core 1 takes the accelerometer from here on
+    spsc_init(&sample_queue, sample_slots, QUEUE_LEN, sizeof(timed_sample_t));
+    hal_core1_launch(&acquisition_core1);
 
-    // Take measurements from the accelerometer and issue warnings as necessary
+    // Check the samples and issue warnings as necessary
     while (1) 
     {
-        if (accelerometer_read(i2c_ACC, ADXL343_ADDR) == 1)
+        timed_sample_t timed;
+
+        if (!spsc_pop(&sample_queue, &timed))
         {
-            // Issue warning to the Zero
-            issue_warning(WARNING_PIN, ACK_PIN);
+            // Nothing to do until core 1 has a sample or the handshake an interrupt
+            NODE_PHASE_BEGIN(PHASE_IDLE);
+            hal_core_wait();
+            NODE_PHASE_END(PHASE_IDLE);
+            continue;
         }
-    }
-    
-}
-
-
-
-int reg_write(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf,const uint8_t nbytes) 
-{
-    
-    int return_val = 0;
 
-    // Create a buffer to hold the data to be written
-    uint8_t msg[nbytes + 1];
+        NODE_PHASE_BEGIN(PHASE_DETECT);
+        int risk = sample_process(&timed);
+        NODE_PHASE_END(PHASE_DETECT);
 
-    // Check to make sure caller is sending 1 or more bytes
-    if (nbytes < 1) 
-    {
-        // Send back a fail
-        return 0;
-    }
-
-    // Append register address to front of data packet
-    msg[0] = reg;
-
-    // Add the data to the data packet
-    for (int i = 0; i < nbytes; i++) 
-    {
-        msg[i + 1] = buf[i];
-    }
-
-    // Write data to register over I2C bus given
-    return_val = i2c_write_blocking(i2c, addr, msg, (nbytes + 1), false);
-
-    // Check for error from write
-    if (return_val == PICO_ERROR_GENERIC) 
-    {
-        // Output a print error
-        printf("Error writing to register %d, of device %d\r\n", reg, addr);
+        if (risk == 1)
+        {
+            // Issue warning to the Zero
+            node_warning_raise();
+            printf("Seismic event: warned %llu us after the sample was read, at most %llu us for any "
+                   "sample, %lu samples dropped\r\n", (unsigned long long)(hal_time_us_64() - timed.time_us),
+                   (unsigned long long)max_latency_us, (unsigned long)sample_queue.dropped);
+        }
 
-        // Return a fail
-        return 0;
+        // Send the log with nothing else waiting
+        if (spsc_count(&sample_queue) == 0)
+        {
+            node_dlog_drain();
+        }
     }
-
-    return 1;
+    
 }
 
 
 
-int reg_read(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes) 
+void acquisition_core1(void)
 {
+    uint64_t next_us = hal_time_us_64();
 
-    // Variable to return the number of bytes read
-    int num_bytes_read = 0;
-
-    // Check to make sure caller is asking for 1 or more bytes
-    if (nbytes < 1) 
+    while (1)
     {
-        return 0;
-    }
-
-    // Issue a write command to tell the device to send the data
-    i2c_write_blocking(i2c, addr, &reg, 1, true);
-
-    // Read the data from the device
-    num_bytes_read = i2c_read_blocking(i2c, addr, buf, nbytes, false);
+        if (accelerometer_read(SEISMIC_I2C, SEISMIC_ADXL343_ADDR) == 1)
+        {
+            hal_core_signal();
+        }
 
-    // Check for a read error
-    if (num_bytes_read == PICO_ERROR_GENERIC) 
-    {   
-        // Output a print error
-        printf("Error reading from register %d, of device %d\r\n", reg, addr);
+        // Polls keep to the sample rate however long the read took
+        next_us += POLL_US;
+        if (next_us < hal_time_us_64())
+        {
+            next_us = hal_time_us_64();
+        }
 
-        // Return a fail
-        return 0;
+        hal_sleep_until_us(next_us);
     }
-
-    // Return the number of bytes read
-    return num_bytes_read;
 }
 
 
 
-int accelerometer_setup(i2c_inst_t *i2c, const uint sda_pin, const uint scl_pin, const uint8_t ADXL343_ADDR)
+int accelerometer_setup(hal_i2c_t i2c, const uint sda_pin, const uint scl_pin, const uint8_t addr)
 {
     // Buffer to store raw reads
     uint8_t data[6];
 
-    // Initialize I2C at 400kHz
-    i2c_init(i2c, 400 * 1000);
+    // Initialize I2C, at 400kHz by default
+    hal_i2c_init(i2c, SEISMIC_I2C_BAUD);
 
     // Set GPIO pins to I2C mode
-    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
-    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    hal_gpio_set_function(sda_pin, HAL_GPIO_FUNC_I2C);
+    hal_gpio_set_function(scl_pin, HAL_GPIO_FUNC_I2C);
 
     // Read device ID to make sure that we can communicate with the ADXL343
-    reg_read(i2c, ADXL343_ADDR, REG_DEVID, data, 1);
-    if (data[0] != DEVID) 
+    reg_read(i2c, addr, ADXL343_REG_DEVID, data, 1);
+    if (data[0] != ADXL343_DEVID) 
     {
         printf("ERROR: Could not communicate with ADXL343\r\n");
 
         while (true)
         {
             // Set LED to flash rapidly to indicate error
-            gpio_put(LED_PIN, 1);
-            sleep_ms(100);
-            gpio_put(LED_PIN, 0);
-            sleep_ms(100);
+            hal_gpio_put(NODE_LED_PIN, 1);
+            hal_sleep_ms(100);
+            hal_gpio_put(NODE_LED_PIN, 0);
+            hal_sleep_ms(100);
         }
     }
 
-    // Tell ADXL343 to start taking measurements by setting Measure bit to high
-    data[0] |= (1 << 3);
-    reg_write(i2c, ADXL343_ADDR, REG_POWER_CTL, &data[0], 1);
+    // Measure at the default rate at normal power for as long as it runs.
+    // Setting the Measure bit on top of the DEVID read back also set SLEEP
+    // and LINK, which drop the part to 4 Hz.
+    adxl343_power_config_t power_config = SEISMIC_POWER_CONFIG(ADXL343_POWER_STANDBY);
+    adxl343_power_init(i2c, addr, &power_config);
+    adxl343_power_measure(ADXL343_RATE_100HZ, 0);
 
     return 1;
 }
 
 
 
-int accelerometer_read(i2c_inst_t *i2c, const uint8_t ADXL343_ADDR)
+int accelerometer_read(hal_i2c_t i2c, const uint8_t addr)
 {
-    // Buffer to store raw reads
-    uint8_t data[6];
-
-    // Variables to store raw accelerometer readings
-    int16_t acc_x;
-    int16_t acc_y;
-    int16_t acc_z;
-    float acc_x_f;
-    float acc_y_f;
-    float acc_z_f;
-
-    // Read raw accelerometer data
-    reg_read(i2c, ADXL343_ADDR, REG_DATAX0, data, 6);
-
-    // Convert raw data to signed 16-bit integers
-    acc_x = (data[1] << 8) | data[0];
-    acc_y = (data[3] << 8) | data[2];
-    acc_z = (data[5] << 8) | data[4];
-
-    // Convert raw data to g's
-    acc_x_f = acc_x * SENSITIVITY_2G;
-    acc_y_f = acc_y * SENSITIVITY_2G;
-    acc_z_f = acc_z * SENSITIVITY_2G;
-
-    // Calculate the magnitude of the acceleration vector
-    float acc_mag = sqrt(acc_x_f * acc_x_f + acc_y_f * acc_y_f + acc_z_f * acc_z_f);
-
-    // Print the magnitude of the acceleration vector
-    printf("Acceleration: %f g\r\n", acc_mag);
+    // Buffer to store INT_SOURCE, DATA_FORMAT and the raw reads
+    uint8_t data[8];
+    timed_sample_t timed;
+
+    // Read the interrupt source and raw accelerometer data in one go. Not
+    // reg_read(), which prints on a failed read, a failed poll is only
+    // tried again on the next one.
+    uint8_t reg = ADXL343_REG_INT_SOURCE;
+    if (hal_i2c_write_blocking(i2c, addr, &reg, 1, true) != 1 ||
+        hal_i2c_read_blocking(i2c, addr, data, sizeof(data), false) != (int)sizeof(data))
+    {
+        return 0;
+    }
+    timed.time_us = hal_time_us_64();
 
-    // if acceleration is above 2g
-    if (acc_mag > 2.0) 
+    // Only new samples go into the detector so its windows are in time
+    if (!(data[0] & ADXL343_INT_DATA_READY))
     {
-        return 1;
-    } 
+        return 0;
+    }
 
-    return 0;
+    // Convert raw data to signed 16-bit integers
+    adxl343_unpack(&data[2], &timed.sample);
 
+    // Core 1 does nothing else, it drops the sample if core 0 is that far behind
+    return spsc_push(&sample_queue, &timed) ? 1 : 0;
 }
 
 
 
-int issue_warning(uint WARNING_PIN, uint ACK_PIN)
+int sample_process(const timed_sample_t *timed)
 {
+    const adxl343_sample_t *sample = &timed->sample;
+    int risk = 0;
 
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
-
-    // Set the warning pin high
-    gpio_put(WARNING_PIN, 1);
-
-    // Wait for the ack pin to go high
-    while (gpio_get(ACK_PIN) == 0)
+    // Warn when the short term energy jumps above the background, once per
+    // event instead of once per sample over 2g
+    if (sta_lta_update(&seismic_detector, seismic_hp_energy(&seismic_hp, sample)) == STA_LTA_TRIGGER)
     {
-        // Set LED to flash slowly to indicate warning has been issued
-        gpio_put(LED_PIN, 1);
-        sleep_ms(500);
-        gpio_put(LED_PIN, 0);
-        sleep_ms(500);
+        risk = 1;
     }
 
-    // Set the warning pin back to high impedance
-    gpio_set_dir(WARNING_PIN, GPIO_IN);
+    uint64_t latency_us = hal_time_us_64() - timed->time_us;
+    if (latency_us > max_latency_us)
+    {
+        max_latency_us = latency_us;
+    }
 
-    // Turn off LED
-    gpio_put(LED_PIN, 0);
+    // Log the raw axes, SEISMIC_LSB_PER_G to the g. They are printed once
+    // core 0 has caught up with core 1, so no conversion or square root is
+    // taken per sample.
+    NODE_DLOG(DLOG_ACCEL_AXES, (int32_t)sample->x, (int32_t)sample->y, (int32_t)sample->z);
 
-    return 1;
-}
\ No newline at end of file
+    return risk;
+}
@@ -4,354 +4,239 @@
  * @brief   This program is for the seismic subsystem. It will use the ADXL343
  *          accelerometer to measure the relative acceleration of the system.
  *          If the acceleration exceeds a certain threshold, the system will
- *          issue a warning to the data analysis subsystem then wait until the
- *          warning is acknowledged.
+ *          issue a warning to the data analysis subsystem and keep sensing
+ *          while the warning waits to be acknowledged.
  * 
  *          This version of the program utilizes the pico's deep sleep mode to 
- *          save power. It is woken up from this state by a high level on the
- *          trigger_pin.
+ *          save power. It is woken up from this state by a debounced rising
+ *          edge on the trigger pin, once the pin has been quiet since the last
+ *          check (node_wake.h).
  *          
 */
 
 // ################################# [ Includes ] #################################
 
-#include "pico/stdlib.h"
-#include "pico/sleep.h"
-#include "hardware/i2c.h"
+#include "adxl343_power.h"
+#include "fusion.h"
+#include "fusion_config.h"
+#include "landslide_hal.h"
+#include "landslide_node.h"
+#include "node_dlog.h"
+#include "node_log.h"
+#include "node_phase.h"
+#include "node_telemetry.h"
+#include "node_wake.h"
+#include "seismic_capture.h"
+#include "node_warning.h"
+#include "seismic_config.h"
+#include "seismic_risk.h"
 #include <stdio.h>
-#include <math.h>
 
 // ############################# [ Global Variables ] #############################
 
-// I2C address of the accelerometer
-static const uint8_t ADXL343_ADDR = 0x53;
+// Pins, bus and address of the accelerometer, the window checked after each
+// trigger and the thresholds are set in seismic_config.h and the site profile
 
-// Registers Locations on the accelerometer
-static const uint8_t REG_DEVID = 0x00;
-static const uint8_t REG_POWER_CTL = 0x2D;
-static const uint8_t REG_DATAX0 = 0x32;
+// Wakes on the trigger pin
+static node_wake_t wake;
 
-// Constants to be used in the program for the accelerometer
-static const uint8_t DEVID = 0xE5; 
-static const float SENSITIVITY_2G = 1.0 / 256;  // (g/LSB)
-static const float EARTH_GRAVITY = 9.80665;     // Earth's gravity in [m/s^2]
-
-// Pins Used on the Pi Pico
-const uint SDA_PIN_ACC = 4; // I2C SDA Pin for the accelerometer
-const uint SCL_PIN_ACC = 5; // I2C SCL Pin for the accelerometer
-i2c_inst_t *i2c_ACC = i2c0; // I2C bus for the accelerometer
-const uint LED_PIN = 25;    // LED Pin for the Pi Pico
-
-const uint SDA_PIN_ZERO = 18;   // I2C SDA Pin for the Zero
-const uint SCL_PIN_ZERO = 19;   // I2C SCL Pin for the Zero
-i2c_inst_t *i2c_ZERO = i2c1;    // I2C bus for the Zero
-const uint WARNING_PIN = 3;     // Warning Pin for the Zero
-const uint ACK_PIN = 2;         // Acknowledge Pin for the Zero
-
-const uint trigger_pin = 10;     // Trigger Pin for the Vibration Sensor
+// Vibration evidence, graded into alerts
+static fusion_t fusion;
 
 
 // ############################## [ Function Prototypes ] ##########################
 
 /**
- * @brief Allows the user to write to a register of a device on the I2C bus
- * 
- * @param i2c Pointer to I2C bus to use on the pico, will be either i2c or i2c1
- * @param addr The address of the device to write to
- * @param reg The register to write to
- * @param buf Pointer to the data to write
- * @param nbytes The number of bytes to write
- * @return int check if the write was successful 0 if fail 1 if success
-*/
-int reg_write(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes);
-
-/**
- * @brief Allows the user to read from a register of a device on the I2C bus
- * 
- * @param i2c Pointer to I2C bus to use on the pico, will be either i2c or i2c1
- * @param addr The address of the device to read from
- * @param reg The register to read from
- * @param buf Pointer to the buffer to store the data in
- * @param nbytes The number of bytes to read
- * @return int the number of bytes read or 0 if it failed 1 if success
- */
-int reg_read(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes);
-
-/**
- * @brief Sets up the accelerometer to be used and starts taking measurements
+ * @brief Sets up the accelerometer to be used and puts it in standby until
+ * a check
  * 
  * @param i2c The I2C bus to use
  * @param sda_pin The SDA pin to use
  * @param scl_pin The SCL pin to use
- * @param ADXL343_ADDR The address of the accelerometer
+ * @param addr The address of the accelerometer
  * @return int 1 if successful blocked in a while loop if failed
 */
-int accelerometer_setup(i2c_inst_t *i2c, const uint sda_pin, const uint scl_pin, const uint8_t ADXL343_ADDR);
-
-/**
- * @brief Reads the accelerometer and returns if there is a landslide risk
- * 
- * @param i2c The I2C bus to use
- * @param ADXL343_ADDR The address of the accelerometer
- * @return int 1 if there is a landslide risk 0 if there is not
-*/
-int accelerometer_read(i2c_inst_t *i2c, const uint8_t ADXL343_ADDR);
+int accelerometer_setup(hal_i2c_t i2c, const uint sda_pin, const uint scl_pin, const uint8_t addr);
 
-/**
- * @brief This sets up the warning pin and the acknowledge pin and sends a 
- * high signal to the warning pin. It then waits for the acknowledge pin to
- * go high before returning.
- * 
- * @param WARNING_PIN The pin to send the warning signal on
- * @param ACK_PIN The pin to wait for the acknowledge signal on
- * @return int 1 if successful 0 if failed
- */
-int issue_warning(uint WARNING_PIN, uint ACK_PIN);
 
 
 int main() 
 {
     // Initialize Pi Pico
-    stdio_init_all();
+    hal_stdio_init();
+    node_dlog_init();
 
-    // Setting up the LED
-    gpio_init(LED_PIN);
-    gpio_set_dir(LED_PIN, GPIO_OUT);
+    // Setup the LED and warning pins as outputs and the ack pin as an input
+    node_setup_pins(NODE_LED_PIN, NODE_WARNING_PIN, NODE_ACK_PIN);
 
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
+    // Initialize accelerometer
+    accelerometer_setup(SEISMIC_I2C, SEISMIC_SDA_PIN, SEISMIC_SCL_PIN, SEISMIC_ADXL343_ADDR);
 
-    // Setup the ack pin as an input
-    gpio_init(ACK_PIN);
-    gpio_set_dir(ACK_PIN, GPIO_IN);
+    // Batched events to the Zero over i2c1
+    node_telemetry_init(NODE_ZERO_I2C, NODE_ZERO_SDA_PIN, NODE_ZERO_SCL_PIN, NODE_ZERO_I2C_ADDR,
+                        TELEMETRY_NODE(NODE_TELEMETRY_ID, TELEMETRY_KIND_SEISMIC));
 
-    // Initialize accelerometer
-    accelerometer_setup(i2c_ACC, SDA_PIN_ACC, SCL_PIN_ACC, ADXL343_ADDR);
+    // Every check and alert is kept in flash as well
+    node_log_init(TELEMETRY_KIND_SEISMIC);
+
+    // Samples after a trigger are batched in the accelerometer's FIFO
+    seismic_risk_init(SEISMIC_I2C, SEISMIC_ADXL343_ADDR, SEISMIC_INT_PIN);
+
+    // Setup the trigger pin as an input
+    hal_gpio_init(SEISMIC_TRIGGER_PIN);
+    hal_gpio_set_dir(SEISMIC_TRIGGER_PIN, HAL_GPIO_IN);
+
+    node_wake_config_t wake_config = SEISMIC_WAKE_CONFIG;
+    node_wake_init(&wake, &wake_config);
+
+    fusion_config_t fusion_config = FUSION_CONFIG;
+    fusion_init(&fusion, &fusion_config);
 
     // Sets up the pico to be able to go into deep sleep.
-    sleep_run_from_xosc();
+    hal_sleep_run_from_xosc();
 
     // Take measurements from the accelerometer and issue warnings as necessary
     while (1) 
     {   
+        // The phase timings go to the Zero once a day
+        NODE_PHASE_POLL();
 
-        // Print message saying that the Pi Pico is going to sleep
+        // Send the last wake's log, then print message saying that the Pi Pico
+        // is going to sleep
+        node_dlog_drain();
         printf("Going to sleep until vibration is detected\r\n");
-        uart_default_tx_wait_blocking();
+        hal_stdio_flush();
         
-        // Go to deep sleep until high signal is received on the trigger pin
-        sleep_goto_dormant_until_level_high(trigger_pin);
-
-        // Print message saying that the Pi Pico is awake
-        printf("Vibration detected, checking for landslide risk\r\n");
-        uart_default_tx_wait_blocking();
-
-        // Takes 200 measurements from the accelerometer and issues a warning if necessary
-        for (int i = 0; i < 200; i++)
+        // Go to deep sleep until the trigger pin has a new rising edge, or
+        // check again if it never goes quiet
+        node_wake_reason_t reason = node_wake_wait(&wake, 0);
+
+        // Print message saying that the Pi Pico is awake and why
+        printf("Vibration detected (%s, %lu wakes, %lu glitches, %lu hold-offs), checking for landslide risk\r\n",
+               node_wake_reason_name(reason), (unsigned long)wake.last_wakes,
+               (unsigned long)wake.last_glitches, (unsigned long)wake.last_holdoffs);
+        hal_stdio_flush();
+
+        // Takes SEISMIC_RISK_WINDOW measurements from the accelerometer and issues a warning if necessary
+        seismic_risk_report_t report;
+        int risk = seismic_risk_check(SEISMIC_RISK_WINDOW, &report);
+
+        // The check's high pass peak adds to the vibration energy. The
+        // detector decides: a risk is full evidence, which alone reaches the
+        // raise grade, and no risk stays under it
+        uint32_t now_s = (uint32_t)(hal_time_us_64() / 1000000);
+        uint32_t dynamic_mg = report.dynamic_mg;
+        if (risk && dynamic_mg < FUSION_SEISMIC_FULL_MG)
         {
-            if (accelerometer_read(i2c_ACC, ADXL343_ADDR) == 1)
-            {
-                // Issue warning to the Zero
-                issue_warning(WARNING_PIN, ACK_PIN);
-
-                // Break out of the loop
-                break;
-            }
+            dynamic_mg = FUSION_SEISMIC_FULL_MG;
         }
-        
-    }
-    
-}
-
-
-
-int reg_write(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf,const uint8_t nbytes) 
-{
-    
-    int return_val = 0;
-
-    // Create a buffer to hold the data to be written
-    uint8_t msg[nbytes + 1];
-
-    // Check to make sure caller is sending 1 or more bytes
-    if (nbytes < 1) 
-    {
-        // Send back a fail
-        return 0;
-    }
-
-    // Append register address to front of data packet
-    msg[0] = reg;
-
-    // Add the data to the data packet
-    for (int i = 0; i < nbytes; i++) 
-    {
-        msg[i + 1] = buf[i];
-    }
-
-    // Write data to register over I2C bus given
-    return_val = i2c_write_blocking(i2c, addr, msg, (nbytes + 1), false);
-
-    // Check for error from write
-    if (return_val == PICO_ERROR_GENERIC) 
-    {
-        // Output a print error
-        printf("Error writing to register %d, of device %d\r\n", reg, addr);
-        uart_default_tx_wait_blocking();
-
-        // Return a fail
-        return 0;
-    }
-
-    return 1;
-}
+        else if (!risk && dynamic_mg >= FUSION_SEISMIC_FULL_MG)
+        {
+            dynamic_mg = FUSION_SEISMIC_FULL_MG - 1;
+        }
+        fusion_seismic(&fusion, now_s, dynamic_mg);
+        node_telemetry_post(TELEMETRY_SEISMIC, (uint8_t)reason, (int32_t)dynamic_mg);
 
+        fusion_alert_t alert;
+        fusion_assess(&fusion, now_s, &alert);
+        node_telemetry_evidence(FUSION_SEISMIC, &alert);
 
+        // Send the numbers and raise the warning at the decision, the
+        // samples after the trigger are still coming in for the capture
+        if (alert.raise)
+        {
+            node_telemetry_alert(&alert);
+            node_warning_raise();
+        }
 
-int reg_read(i2c_inst_t *i2c, const uint addr, const uint8_t reg, uint8_t *buf, const uint8_t nbytes) 
-{
+        // The rest of the capture, before the flash writes below stop the
+        // interrupts that read it
+        seismic_risk_finish();
 
-    // Variable to return the number of bytes read
-    int num_bytes_read = 0;
+        // One line per trigger instead of one per sample, and only sent
+        // before the next sleep, keeps the uart from delaying the alert
+        NODE_DLOG(DLOG_SEISMIC_CHECK, report.checked, report.reads, DLOG_U64(report.awake_us),
+                  (uint32_t)(report.awake_us ? report.checked * 1000000ull / report.awake_us : 0),
+                  DLOG_F(report.peak_g));
+        node_log_append(TELEMETRY_SEISMIC, (uint8_t)reason, (int32_t)dynamic_mg, (int32_t)report.checked);
 
-    // Check to make sure caller is asking for 1 or more bytes
-    if (nbytes < 1) 
-    {
-        return 0;
-    }
+        if (alert.raise)
+        {
+            printf("Warning: %s, %u%% confidence\r\n", fusion_grade_name(alert.grade), alert.confidence);
+            hal_stdio_flush();
 
-    // Issue a write command to tell the device to send the data
-    i2c_write_blocking(i2c, addr, &reg, 1, true);
+            // Keep the numbers in flash as well
+            node_log_alert(&alert);
+        }
 
-    // Read the data from the device
-    num_bytes_read = i2c_read_blocking(i2c, addr, buf, nbytes, false);
+#if SEISMIC_CAPTURE
+        // The waveform round the trigger goes after the alert, so the alert
+        // is not queued behind it
+        size_t capture_len;
+        const uint8_t *capture = seismic_capture_get(&capture_len);
+        if (capture != NULL)
+        {
+            waveform_header_t header;
+            waveform_header_decode(capture, capture_len, &header);
 
-    // Check for a read error
-    if (num_bytes_read == PICO_ERROR_GENERIC) 
-    {   
-        // Output a print error
-        printf("Error reading from register %d, of device %d\r\n", reg, addr);
-        uart_default_tx_wait_blocking();
+            // A full ring dropped samples, the capture stops at the first
+            // one lost after the trigger
+            if (adxl343_fifo_stats()->overruns > 0)
+            {
+                printf("Sending the waveform round the trigger, %lu bytes, %lu samples lost%s\r\n",
+                       (unsigned long)capture_len, (unsigned long)adxl343_fifo_stats()->overruns,
+                       (header.flags & WAVEFORM_TRUNCATED) ? ", cut short" : "");
+            }
+            else
+            {
+                printf("Sending the waveform round the trigger, %lu bytes\r\n", (unsigned long)capture_len);
+            }
+            hal_stdio_flush();
 
-        // Return a fail
-        return 0;
+            node_telemetry_blob(capture, capture_len);
+            seismic_capture_arm();
+        }
+#endif
+        
     }
-
-    // Return the number of bytes read
-    return num_bytes_read;
+    
 }
 
 
 
-int accelerometer_setup(i2c_inst_t *i2c, const uint sda_pin, const uint scl_pin, const uint8_t ADXL343_ADDR)
+int accelerometer_setup(hal_i2c_t i2c, const uint sda_pin, const uint scl_pin, const uint8_t addr)
 {
     // Buffer to store raw reads
     uint8_t data[6];
 
-    // Initialize I2C at 400kHz
-    i2c_init(i2c, 400 * 1000);
+    // Initialize I2C, at 400kHz by default
+    hal_i2c_init(i2c, SEISMIC_I2C_BAUD);
 
     // Set GPIO pins to I2C mode
-    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
-    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    hal_gpio_set_function(sda_pin, HAL_GPIO_FUNC_I2C);
+    hal_gpio_set_function(scl_pin, HAL_GPIO_FUNC_I2C);
 
     // Read device ID to make sure that we can communicate with the ADXL343
-    reg_read(i2c, ADXL343_ADDR, REG_DEVID, data, 1);
-    if (data[0] != DEVID) 
+    reg_read(i2c, addr, ADXL343_REG_DEVID, data, 1);
+    if (data[0] != ADXL343_DEVID) 
     {
         printf("ERROR: Could not communicate with ADXL343\r\n");
-        uart_default_tx_wait_blocking();
+        hal_stdio_flush();
 
         while (true)
         {
             // Set LED to flash rapidly to indicate error
-            gpio_put(LED_PIN, 1);
-            sleep_ms(100);
-            gpio_put(LED_PIN, 0);
-            sleep_ms(100);
+            hal_gpio_put(NODE_LED_PIN, 1);
+            hal_sleep_ms(100);
+            hal_gpio_put(NODE_LED_PIN, 0);
+            hal_sleep_ms(100);
         }
     }
 
-    // Tell ADXL343 to start taking measurements by setting Measure bit to high
-    data[0] |= (1 << 3);
-    reg_write(i2c, ADXL343_ADDR, REG_POWER_CTL, &data[0], 1);
+    // Standby between checks, the vibration sensor wakes the node and each
+    // check measures at full rate (seismic_risk.h)
+    adxl343_power_config_t power_config = SEISMIC_POWER_CONFIG(ADXL343_POWER_STANDBY);
+    adxl343_power_init(i2c, addr, &power_config);
 
     return 1;
 }
-
-
-
-int accelerometer_read(i2c_inst_t *i2c, const uint8_t ADXL343_ADDR)
-{
-    // Buffer to store raw reads
-    uint8_t data[6];
-
-    // Variables to store raw accelerometer readings
-    int16_t acc_x;
-    int16_t acc_y;
-    int16_t acc_z;
-    float acc_x_f;
-    float acc_y_f;
-    float acc_z_f;
-
-    // Read raw accelerometer data
-    reg_read(i2c, ADXL343_ADDR, REG_DATAX0, data, 6);
-
-    // Convert raw data to signed 16-bit integers
-    acc_x = (data[1] << 8) | data[0];
-    acc_y = (data[3] << 8) | data[2];
-    acc_z = (data[5] << 8) | data[4];
-
-    // Convert raw data to g's
-    acc_x_f = acc_x * SENSITIVITY_2G;
-    acc_y_f = acc_y * SENSITIVITY_2G;
-    acc_z_f = acc_z * SENSITIVITY_2G;
-
-    // Calculate the magnitude of the acceleration vector
-    float acc_mag = sqrt(acc_x_f * acc_x_f + acc_y_f * acc_y_f + acc_z_f * acc_z_f);
-
-    // Print the magnitude of the acceleration vector
-    printf("Acceleration: %f g\r\n", acc_mag);
-    uart_default_tx_wait_blocking();
-
-    // if acceleration is above 2g
-    if (acc_mag > 2.0) 
-    {
-        return 1;
-    } 
-
-    return 0;
-
-}
-
-
-
-int issue_warning(uint WARNING_PIN, uint ACK_PIN)
-{
-
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
-
-    // Set the warning pin high
-    gpio_put(WARNING_PIN, 1);
-
-    // Wait for the ack pin to go high
-    while (gpio_get(ACK_PIN) == 0)
-    {
-        // Set LED to flash slowly to indicate warning has been issued
-        gpio_put(LED_PIN, 1);
-        sleep_ms(500);
-        gpio_put(LED_PIN, 0);
-        sleep_ms(500);
-    }
-
-    // Set the warning pin back to high impedance
-    gpio_set_dir(WARNING_PIN, GPIO_IN);
-
-    // Turn off LED
-    gpio_put(LED_PIN, 0);
-
-    return 1;
-}
\ No newline at end of file
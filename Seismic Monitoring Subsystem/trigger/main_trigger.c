@@ -0,0 +1,277 @@
+/**
+ * @file    main_trigger.c
+ * @author  B929164 (Ajay Varghese)
+ * @brief   This program is for the seismic subsystem. It will use the ADXL343
+ *          accelerometer to measure the relative acceleration of the system.
+ *          If the acceleration exceeds a certain threshold, the system will
+ *          issue a warning to the data analysis subsystem and keep sensing
+ *          while the warning waits to be acknowledged.
+ *
+ *          This version of the program needs no vibration sensor. The
+ *          accelerometer watches for activity itself at a low power output
+ *          data rate and raises INT1, which wakes the pico from deep sleep.
+ *          Each activity is then checked the same way as the interrupt
+ *          version, through the FIFO engine at the full rate
+ *          (seismic_risk.h), and the engine puts the accelerometer back to
+ *          watching after it. Activity and inactivity are linked, so once it
+ *          has moved the accelerometer only wakes the pico again when it has
+ *          been at rest for SEISMIC_INACT_S. At rest it drops to the
+ *          SEISMIC_SLEEP_WAKEUP rate until the next activity (auto sleep).
+ *
+*/
+
+// ################################# [ Includes ] #################################
+
+#include "adxl343_power.h"
+#include "fusion.h"
+#include "fusion_config.h"
+#include "landslide_hal.h"
+#include "landslide_node.h"
+#include "node_dlog.h"
+#include "node_log.h"
+#include "node_phase.h"
+#include "node_telemetry.h"
+#include "node_wake.h"
+#include "seismic_capture.h"
+#include "node_warning.h"
+#include "seismic_config.h"
+#include "seismic_risk.h"
+#include <stdio.h>
+
+// ############################# [ Global Variables ] #############################
+
+// Pins, bus and address of the accelerometer and the activity thresholds are
+// set in seismic_config.h and the site profile
+
+// Vibration evidence, graded into alerts
+static fusion_t fusion;
+
+
+// ############################## [ Function Prototypes ] ##########################
+
+/**
+ * @brief Sets up the accelerometer to watch for activity and inactivity on
+ * INT1 and starts taking measurements
+ *
+ * @param i2c The I2C bus to use
+ * @param sda_pin The SDA pin to use
+ * @param scl_pin The SCL pin to use
+ * @param addr The address of the accelerometer
+ * @return int 1 if successful blocked in a while loop if failed
+*/
+int accelerometer_setup(hal_i2c_t i2c, const uint sda_pin, const uint scl_pin, const uint8_t addr);
+
+
+
+int main()
+{
+    // Initialize Pi Pico
+    hal_stdio_init();
+    node_dlog_init();
+
+    // Setup the LED and warning pins as outputs and the ack pin as an input
+    node_setup_pins(NODE_LED_PIN, NODE_WARNING_PIN, NODE_ACK_PIN);
+
+    // Initialize accelerometer
+    accelerometer_setup(SEISMIC_I2C, SEISMIC_SDA_PIN, SEISMIC_SCL_PIN, SEISMIC_ADXL343_ADDR);
+
+    // Batched events to the Zero over i2c1
+    node_telemetry_init(NODE_ZERO_I2C, NODE_ZERO_SDA_PIN, NODE_ZERO_SCL_PIN, NODE_ZERO_I2C_ADDR,
+                        TELEMETRY_NODE(NODE_TELEMETRY_ID, TELEMETRY_KIND_SEISMIC));
+
+    // Every check and alert is kept in flash as well
+    node_log_init(TELEMETRY_KIND_SEISMIC);
+
+    // Samples after an activity are batched in the accelerometer's FIFO,
+    // its watermark comes on INT1 as well
+    seismic_risk_init(SEISMIC_I2C, SEISMIC_ADXL343_ADDR, SEISMIC_INT_PIN);
+
+    fusion_config_t fusion_config = FUSION_CONFIG;
+    fusion_init(&fusion, &fusion_config);
+
+    // Sets up the pico to be able to go into deep sleep.
+    hal_sleep_run_from_xosc();
+
+    // Take measurements from the accelerometer and issue warnings as necessary
+    while (1)
+    {
+        // The phase timings go to the Zero once a day
+        NODE_PHASE_POLL();
+
+        // Send the last wake's log, then print message saying that the Pi Pico
+        // is going to sleep
+        node_dlog_drain();
+        printf("Going to sleep until the accelerometer sees activity\r\n");
+        hal_stdio_flush();
+
+        // Dormant mode would stop the timer that flashes the LED and runs
+        // the warning's timeouts, and the ack's interrupt with it. While a
+        // warning waits for its ack, idle until INT1 goes high instead, its
+        // rising edge interrupt (the FIFO engine's) wakes the core.
+        while (node_warning_pending() && hal_gpio_get(SEISMIC_INT_PIN) == 0)
+        {
+            NODE_PHASE_BEGIN(PHASE_IDLE);
+            hal_wfi();
+            NODE_PHASE_END(PHASE_IDLE);
+        }
+
+        // Go to deep sleep until INT1 goes high, it stays high until
+        // INT_SOURCE is read
+        if (hal_gpio_get(SEISMIC_INT_PIN) == 0)
+        {
+            NODE_PHASE_BEGIN(PHASE_DORMANT);
+            hal_sleep_goto_dormant_until_level_high(SEISMIC_INT_PIN);
+            NODE_PHASE_WAKE(PHASE_DORMANT);
+        }
+
+        // Reading INT_SOURCE lets INT1 go low again
+        uint8_t source = 0;
+        NODE_PHASE_BEGIN(PHASE_I2C_READ);
+        reg_read(SEISMIC_I2C, SEISMIC_ADXL343_ADDR, ADXL343_REG_INT_SOURCE, &source, 1);
+        NODE_PHASE_END(PHASE_I2C_READ);
+
+        if (source & ADXL343_INT_INACTIVITY)
+        {
+            // At rest again, the next activity is a new one
+            printf("Accelerometer at rest, watching for activity\r\n");
+            node_telemetry_post(TELEMETRY_SEISMIC, (uint8_t)NODE_WAKE_INACTIVITY, 0);
+            node_log_append(TELEMETRY_SEISMIC, (uint8_t)NODE_WAKE_INACTIVITY, 0, 0);
+        }
+
+        if (!(source & ADXL343_INT_ACTIVITY))
+        {
+            continue;
+        }
+
+        node_wake_reason_t reason = NODE_WAKE_ACTIVITY;
+        printf("Activity detected, checking for landslide risk\r\n");
+        hal_stdio_flush();
+
+        // Takes SEISMIC_RISK_WINDOW measurements from the accelerometer and issues a warning if necessary
+        seismic_risk_report_t report;
+        int risk = seismic_risk_check(SEISMIC_RISK_WINDOW, &report);
+
+        // The check's high pass peak adds to the vibration energy. The
+        // detector decides: a risk is full evidence, which alone reaches the
+        // raise grade, and no risk stays under it
+        uint32_t now_s = (uint32_t)(hal_time_us_64() / 1000000);
+        uint32_t dynamic_mg = report.dynamic_mg;
+        if (risk && dynamic_mg < FUSION_SEISMIC_FULL_MG)
+        {
+            dynamic_mg = FUSION_SEISMIC_FULL_MG;
+        }
+        else if (!risk && dynamic_mg >= FUSION_SEISMIC_FULL_MG)
+        {
+            dynamic_mg = FUSION_SEISMIC_FULL_MG - 1;
+        }
+        fusion_seismic(&fusion, now_s, dynamic_mg);
+        node_telemetry_post(TELEMETRY_SEISMIC, (uint8_t)reason, (int32_t)dynamic_mg);
+
+        fusion_alert_t alert;
+        fusion_assess(&fusion, now_s, &alert);
+        node_telemetry_evidence(FUSION_SEISMIC, &alert);
+
+        // Send the numbers and raise the warning at the decision, the
+        // samples after the activity are still coming in for the capture
+        if (alert.raise)
+        {
+            node_telemetry_alert(&alert);
+            node_warning_raise();
+        }
+
+        // The rest of the capture, before the flash writes below stop the
+        // interrupts that read it
+        seismic_risk_finish();
+
+        // One line per activity, only sent before the next sleep
+        NODE_DLOG(DLOG_SEISMIC_CHECK, report.checked, report.reads, DLOG_U64(report.awake_us),
+                  (uint32_t)(report.awake_us ? report.checked * 1000000ull / report.awake_us : 0),
+                  DLOG_F(report.peak_g));
+        node_log_append(TELEMETRY_SEISMIC, (uint8_t)reason, (int32_t)dynamic_mg, (int32_t)report.checked);
+
+        if (alert.raise)
+        {
+            printf("Warning: %s, %u%% confidence\r\n", fusion_grade_name(alert.grade), alert.confidence);
+            hal_stdio_flush();
+
+            // Keep the numbers in flash as well
+            node_log_alert(&alert);
+        }
+
+#if SEISMIC_CAPTURE
+        // The waveform round the activity goes after the alert, so the alert
+        // is not queued behind it
+        size_t capture_len;
+        const uint8_t *capture = seismic_capture_get(&capture_len);
+        if (capture != NULL)
+        {
+            waveform_header_t header;
+            waveform_header_decode(capture, capture_len, &header);
+
+            // A full ring dropped samples, the capture stops at the first
+            // one lost after the trigger
+            if (adxl343_fifo_stats()->overruns > 0)
+            {
+                printf("Sending the waveform round the activity, %lu bytes, %lu samples lost%s\r\n",
+                       (unsigned long)capture_len, (unsigned long)adxl343_fifo_stats()->overruns,
+                       (header.flags & WAVEFORM_TRUNCATED) ? ", cut short" : "");
+            }
+            else
+            {
+                printf("Sending the waveform round the activity, %lu bytes\r\n", (unsigned long)capture_len);
+            }
+            hal_stdio_flush();
+
+            node_telemetry_blob(capture, capture_len);
+            seismic_capture_arm();
+        }
+#endif
+    }
+
+}
+
+
+
+int accelerometer_setup(hal_i2c_t i2c, const uint sda_pin, const uint scl_pin, const uint8_t addr)
+{
+    // Buffer to store raw reads
+    uint8_t data[6];
+
+    // Initialize I2C, at 400kHz by default
+    hal_i2c_init(i2c, SEISMIC_I2C_BAUD);
+
+    // Set GPIO pins to I2C mode
+    hal_gpio_set_function(sda_pin, HAL_GPIO_FUNC_I2C);
+    hal_gpio_set_function(scl_pin, HAL_GPIO_FUNC_I2C);
+
+    // Read device ID to make sure that we can communicate with the ADXL343
+    reg_read(i2c, addr, ADXL343_REG_DEVID, data, 1);
+    if (data[0] != ADXL343_DEVID)
+    {
+        printf("ERROR: Could not communicate with ADXL343\r\n");
+        hal_stdio_flush();
+
+        while (true)
+        {
+            // Set LED to flash rapidly to indicate error
+            hal_gpio_put(NODE_LED_PIN, 1);
+            hal_sleep_ms(100);
+            hal_gpio_put(NODE_LED_PIN, 0);
+            hal_sleep_ms(100);
+        }
+    }
+
+    // Watching between checks at the low power rate, every axis AC coupled
+    // so gravity is left out. Each check measures at full rate and the FIFO
+    // engine puts it back to watching (seismic_risk.h)
+    adxl343_power_config_t power_config = SEISMIC_POWER_CONFIG(ADXL343_POWER_WATCH);
+    adxl343_power_init(i2c, addr, &power_config);
+
+    // Watch for activity and inactivity on INT1, linked
+    adxl343_power_watch();
+
+    // Clear anything raised while it was set up
+    reg_read(i2c, addr, ADXL343_REG_INT_SOURCE, data, 1);
+
+    return 1;
+}
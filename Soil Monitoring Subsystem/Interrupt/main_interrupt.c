@@ -3,8 +3,8 @@
  * @author  B929164 (Ajay Varghese)
  * @brief   This program is for the Soil Monitoring subsystem. It will be used to
  *          monitor the soil moisture. If the soil moisture is above a certain
- *          threshold, it will send a warning to the Zero. The program will wait
- *          for the Zero to acknowledge the warning before continuing. The soil
+ *          threshold, it will send a warning to the Zero. The program keeps
+ *          taking readings while the Zero acknowledges the warning. The soil
  *          moisture sensor will be connected to the Pi Pico via UART.
  * 
  *          This version of the program utilizes the pico's deep sleep mode to 
@@ -14,284 +14,186 @@
 
 // ################################# [ Includes ] #################################
 
-#include "pico/stdlib.h"
-#include "hardware/uart.h"
-#include "hardware/i2c.h"
-#include "pico/sleep.h"
+#include "fusion.h"
+#include "fusion_config.h"
+#include "landslide_hal.h"
+#include "landslide_node.h"
+#include "node_dlog.h"
+#include "node_log.h"
+#include "node_phase.h"
+#include "node_telemetry.h"
+#include "node_warning.h"
+#include "node_time.h"
+#include "soil_config.h"
+#include "soil_probe.h"
+#include "soil_schedule.h"
 #include <stdio.h>
-#include <stdlib.h>
 
 // ############################# [ Global Variables ] #############################
 
-// Pins Used on the Pi Pico
-const uint UART_TX_SOIL = 4;    // UART TX Pin for the Soil Sensor
-const uint UART_RX_SOIL = 5;    // UART RX Pin for the Soil Sensor
-uart_inst_t *uart_SOIL = uart1; // UART bus for the Soil Sensor
+// Probe UART, timings and the moisture threshold are set in soil_config.h
+// and the site profile
 
+// Sets the time asleep from how fast the moisture is changing
+static soil_schedule_t schedule;
 
-const uint LED_PIN = 25;        // LED Pin for the Pi Pico
+// Moisture evidence, graded into alerts
+static fusion_t fusion;
 
-const uint SDA_PIN_ZERO = 18;   // I2C SDA Pin for the Zero
-const uint SCL_PIN_ZERO = 19;   // I2C SCL Pin for the Zero
-i2c_inst_t *i2c_ZERO = i2c1;    // I2C bus for the Zero
-const uint WARNING_PIN = 3;     // Warning Pin for the Zero
-const uint ACK_PIN = 2;         // Acknowledge Pin for the Zero
-
-
-// ############################## [ Function Prototypes ] ##########################
-
-/**
- * @brief This sets up the warning pin and the acknowledge pin and sends a 
- * high signal to the warning pin. It then waits for the acknowledge pin to
- * go high before returning.
- * 
- * @param WARNING_PIN The pin to send the warning signal on
- * @param ACK_PIN The pin to wait for the acknowledge signal on
- * @return int 1 if successful 0 if failed
- */
-int issue_warning(uint WARNING_PIN, uint ACK_PIN);
-
-/**
- * @brief Set the up soil sensor object
- * 
- * @param UART_TX_SOIL The UART TX pin that the RX pin of the soil sensor is connected to
- * @param UART_RX_SOIL The UART RX pin that the TX pin of the soil sensor is connected to
- * @param uart_SOIL    The UART bus that the soil sensor is connected to
- * @return int         1 if successful 0 if failed
- */
-int setup_soil_sensor(uint UART_TX_SOIL, uint UART_RX_SOIL, uart_inst_t *uart_SOIL);
-
-/**
- * @brief Get the soil moisture object
- * 
- * @param UART_TX_SOIL The UART TX pin that the RX pin of the soil sensor is connected to
- * @param UART_RX_SOIL The UART RX pin that the TX pin of the soil sensor is connected to
- * @param uart_SOIL    The UART bus that the soil sensor is connected to
- * @return int         The soil moisture value or -1 if failed
- */
-int get_soil_moisture(uint UART_TX_SOIL, uint UART_RX_SOIL, uart_inst_t *uart_SOIL);
 
+// ############################## [ Local Functions ] ##############################
 
+// Runs from the RTC alarm interrupt, the readings are taken once the Pico is
+// back in main() where the UART interrupt can run while they wait
 static void sleep_callback(void) 
 {
+    // Nothing to do, the alarm only wakes the Pico
+}
 
-    // for loop that takes 10 readings
-    for (int i = 0; i < 10; i++)
+// Takes up to SOIL_READINGS_PER_WAKE readings, stopping at the first one over
+// the threshold. Returns 1 and sets moisture to their mean if any were read.
+static int take_readings(int *moisture)
+{
+    int sum = 0;
+    int count = 0;
+
+    // for loop that takes SOIL_READINGS_PER_WAKE readings
+    for (int i = 0; i < SOIL_READINGS_PER_WAKE; i++)
     {
-        // Get the soil moisture if reading fails, try again
-        int soil_moisture = -1;
-        while (soil_moisture == -1)
+        // Get the soil moisture, skipping the reading if the probe doesn't
+        // answer properly
+        int soil_moisture;
+        if (soil_probe_read(&soil_moisture, SOIL_PROBE_TIMEOUT_MS, SOIL_PROBE_ATTEMPTS) != SOIL_PROBE_OK)
         {
-            soil_moisture = get_soil_moisture(UART_TX_SOIL, UART_RX_SOIL, uart_SOIL);
+            printf("Error reading soil moisture\r\n");
+            hal_stdio_flush();
+            continue;
         }
 
-        // print the soil moisture
-        printf("Soil Moisture: %d\r\n", soil_moisture);
-        uart_default_tx_wait_blocking();
+        // log the soil moisture with the time it was read, it is printed
+        // before the next sleep
+        uint64_t ms = node_time_ms();
+        NODE_DLOG(DLOG_SOIL_READING, DLOG_U64(ms / 1000), (uint32_t)(ms % 1000), (uint32_t)soil_moisture);
 
-        // Check if the soil moisture is above the threshold
-        if (soil_moisture > 50)
+        // Check if the soil moisture is above the threshold, the schedule
+        // and the fusion only need this reading
+        if (soil_moisture > SOIL_MOISTURE_THRESHOLD)
         {
-            // Issue a warning
-            issue_warning(WARNING_PIN, ACK_PIN);
-            break;
+            *moisture = soil_moisture;
+            return 1;
         }
-    }
-
-}
-
-static void rtc_sleep(void) {
-    // Start on Friday 5th of June 2020 15:45:00
-    datetime_t t = {
-            .year  = 2020,
-            .month = 06,
-            .day   = 05,
-            .dotw  = 5, // 0 is Sunday, so 5 is Friday
-            .hour  = 15,
-            .min   = 45,
-            .sec   = 00
-    };
-
-    // Alarm 10 seconds later
-    datetime_t t_alarm = {
-            .year  = 2020,
-            .month = 06,
-            .day   = 05,
-            .dotw  = 5, // 0 is Sunday, so 5 is Friday
-            .hour  = 15,
-            .min   = 45,
-            .sec   = 10
-    };
-
-    // Start the RTC
-    rtc_init();
-    rtc_set_datetime(&t);
-
-    printf("Sleeping for 10 seconds\n");
-    uart_default_tx_wait_blocking();
-
-    sleep_goto_sleep_until(&t_alarm, &sleep_callback);
-}
 
+        sum += soil_moisture;
+        count++;
+    }
 
-int main() 
-{
-    // Initialize Pi Pico
-    stdio_init_all();
-
-    // Sets up the pico to be able to go into deep sleep.
-    sleep_run_from_xosc();
-
-    // Setting up the LED
-    gpio_init(LED_PIN);
-    gpio_set_dir(LED_PIN, GPIO_OUT);
-
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
-
-    // Setup the ack pin as an input
-    gpio_init(ACK_PIN);
-    gpio_set_dir(ACK_PIN, GPIO_IN);
-
-    // Setup the soil sensor
-    setup_soil_sensor(UART_TX_SOIL, UART_RX_SOIL, uart_SOIL);
-
-    // Get the soil moisture forever
-    while(1)
+    if (count == 0)
     {
-        // Print message saying that the Pi Pico is going to sleep
-        printf("Going to sleep until next interrupt\r\n");
-        uart_default_tx_wait_blocking();
-
-        // Go to deep sleep until high signal is received on the trigger pin
-        rtc_sleep();
-
+        return 0;
     }
-    
-}
 
+    *moisture = sum / count;
+    return 1;
+}
 
+static void rtc_sleep(uint32_t seconds) {
+    printf("Sleeping for %u seconds\n", (unsigned)seconds);
+    hal_stdio_flush();
 
-int issue_warning(uint WARNING_PIN, uint ACK_PIN)
-{
-
-    // Setup the warning pin as an output
-    gpio_init(WARNING_PIN);
-    gpio_set_dir(WARNING_PIN, GPIO_OUT);
-
-    // Set the warning pin high
-    gpio_put(WARNING_PIN, 1);
-
-    // Wait for the ack pin to go high
-    while (gpio_get(ACK_PIN) == 0)
+    // Sleep mode stops the timer the warning handshake runs on, so idle
+    // instead while a warning waits for its ack
+    if (node_warning_pending())
     {
-        // Set LED to flash slowly to indicate warning has been issued
-        gpio_put(LED_PIN, 1);
-        busy_wait_ms(500);
-        gpio_put(LED_PIN, 0);
-        busy_wait_ms(500);
+        NODE_PHASE_BEGIN(PHASE_IDLE);
+        hal_sleep_ms(seconds * 1000);
+        NODE_PHASE_END(PHASE_IDLE);
+        return;
     }
 
-    // Set the warning pin back to high impedance
-    gpio_set_dir(WARNING_PIN, GPIO_IN);
-
-    // Turn off LED
-    gpio_put(LED_PIN, 0);
-
-    return 1;
+    // The alarm is worked out from the time the RTC has kept since power up
+    node_time_sleep(seconds, &sleep_callback);
 }
 
 
-
-int setup_soil_sensor(uint UART_TX_SOIL, uint UART_RX_SOIL, uart_inst_t *uart_SOIL)
+int main() 
 {
-    // Set up the UART bus
-    uart_init(uart_SOIL, 9600);
-    gpio_set_function(UART_TX_SOIL, GPIO_FUNC_UART);
-    gpio_set_function(UART_RX_SOIL, GPIO_FUNC_UART);
+    // Initialize Pi Pico
+    hal_stdio_init();
+    node_dlog_init();
 
-    // Wait for the soil sensor to boot up
-    busy_wait_ms(2000);
+    // Sets up the pico to be able to go into deep sleep.
+    hal_sleep_run_from_xosc();
 
-    // Send a l to the soil sensor to set it up
-    uart_putc_raw(uart_SOIL, 'l');
+    // Start the RTC, it keeps the time through every sleep from here on
+    node_time_init(NODE_TIME_START_UNIX);
 
-    return 1;
-}
+    // Setup the LED and warning pins as outputs and the ack pin as an input
+    node_setup_pins(NODE_LED_PIN, NODE_WARNING_PIN, NODE_ACK_PIN);
 
-int get_soil_moisture(uint UART_TX_SOIL, uint UART_RX_SOIL, uart_inst_t *uart_SOIL)
-{
-    // Send the command to get the soil moisture
-    uart_putc_raw(uart_SOIL, 'w');
-
-    // Wait for the response
-    busy_wait_ms(100);
+    // Batched events to the Zero over i2c1
+    node_telemetry_init(NODE_ZERO_I2C, NODE_ZERO_SDA_PIN, NODE_ZERO_SCL_PIN, NODE_ZERO_I2C_ADDR,
+                        TELEMETRY_NODE(NODE_TELEMETRY_ID, TELEMETRY_KIND_SOIL));
 
-    // Get the response
-    char soil_moisture[8];
+    // Every reading and alert is kept in flash as well
+    node_log_init(TELEMETRY_KIND_SOIL);
 
-    int soil_moisture_val = 0;
+    // Setup the soil sensor, its answers are read in by the UART interrupt
+    soil_probe_init(SOIL_UART, SOIL_UART_TX_PIN, SOIL_UART_RX_PIN, SOIL_UART_BAUD, SOIL_PROBE_BOOT_MS);
 
-    // Keep reading until a "=" is found
-    while (uart_getc(uart_SOIL) != '=')
-    {
-        // Do nothing
-    }
+    // Start at the shortest interval
+    soil_schedule_config_t schedule_config = SOIL_SCHEDULE_CONFIG;
+    soil_schedule_init(&schedule, &schedule_config);
 
-    // Read in the next character will be the first digit of the soil moisture
-    soil_moisture[0] = uart_getc(uart_SOIL);
+    fusion_config_t fusion_config = FUSION_CONFIG;
+    fusion_init(&fusion, &fusion_config);
 
-    // Read in the next character will be the second digit of the soil moisture or a newline
-    soil_moisture[1] = uart_getc(uart_SOIL);
-
-    // Check if the character is a newline
-    if (soil_moisture[1]== '\n')
+    // Get the soil moisture forever
+    while(1)
     {
-        // Add the null terminator
-        soil_moisture[1] = '\0';
+        // The phase timings go to the Zero once a day
+        NODE_PHASE_POLL();
 
-        // Return the soil moisture
-        return atoi(soil_moisture);
-    }
+        // Send the last wake's log, then print message saying that the Pi
+        // Pico is going to sleep
+        node_dlog_drain();
+        printf("Going to sleep until next interrupt\r\n");
+        hal_stdio_flush();
 
-    // Read in the next character will be the third digit of the soil moisture or a newline
-    soil_moisture[2] = uart_getc(uart_SOIL);
+        // Go to sleep until the RTC alarm, then take the readings
+        rtc_sleep(soil_schedule_interval(&schedule));
 
-    // Check if the character is a newline
-    if (soil_moisture[2]== '\n')
-    {
-        // Add the null terminator
-        soil_moisture[2] = '\0';
+        // The next interval depends on how fast the moisture is changing,
+        // if nothing could be read it stays the same
+        int soil_moisture;
+        if (take_readings(&soil_moisture))
+        {
+            soil_schedule_next(&schedule, soil_moisture);
+
+            // The moisture and how fast it is rising are graded together
+            uint32_t now_s = (uint32_t)(node_time_ms() / 1000);
+            fusion_soil(&fusion, now_s, soil_moisture);
+            node_telemetry_post(TELEMETRY_SOIL, 0, soil_moisture);
+            node_log_append(TELEMETRY_SOIL, 0, soil_moisture, fusion.trend);
+
+            fusion_alert_t alert;
+            fusion_assess(&fusion, now_s, &alert);
+            node_telemetry_evidence(FUSION_SOIL, &alert);
+
+            if (alert.raise)
+            {
+                printf("Warning: %s, %u%% confidence\r\n", fusion_grade_name(alert.grade), alert.confidence);
+                hal_stdio_flush();
+
+                // Keep the numbers and send them before the warning pin
+                // wakes the Zero
+                node_log_alert(&alert);
+                node_telemetry_alert(&alert);
+
+                // Issue a warning
+                node_warning_raise();
+            }
+        }
 
-        // Return the soil moisture
-        return atoi(soil_moisture);
-    }
-    else if (soil_moisture[2]== '0')
-    {
-        // Add the null terminator
-        soil_moisture[3] = '\0';
-        
-        return atoi(soil_moisture);
     }
     
-
-    // Read in the next character
-    soil_moisture[3] = uart_getc(uart_SOIL);
-
-    // Check if the character is a newline
-    if (soil_moisture[3]== '\n')
-    {
-        // Add the null terminator
-        soil_moisture[3] = '\0';
-
-        // Return the soil moisture
-        return atoi(soil_moisture);
-    }
-
-    // Print error
-    printf("Error reading soil moisture\r\n");
-
-    // Return error
-    return -1;
-}
\ No newline at end of file
+}